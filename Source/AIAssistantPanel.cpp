@@ -17,6 +17,9 @@ AIAssistantPanel::AIAssistantPanel(AutoMixAssistant& mixAssistant,
 
 AIAssistantPanel::~AIAssistantPanel() {
     stopTimer();
+    // Its callbacks refer to this panel
+    patternSuggestionEngine.cancelBatch();
+    mixer.getMixAnalyzer().setActive(false);
 }
 
 void AIAssistantPanel::paint(juce::Graphics& g) {
@@ -174,6 +177,9 @@ void AIAssistantPanel::setupUI() {
 void AIAssistantPanel::modeChanged() {
     currentMode = static_cast<AIMode>(aiModeSelector.getSelectedId() - 1);
 
+    // The mix is measured in the background only while its suggestions are on show
+    mixer.getMixAnalyzer().setActive(currentMode == AIMode::MixAssistant);
+
     mixSuggestionView.setVisible(false);
     blendLabel.setVisible(false);
     blendSlider.setVisible(false);
@@ -226,18 +232,47 @@ void AIAssistantPanel::analyzeMix() {
 
 void AIAssistantPanel::generatePatternSuggestions() {
     try {
-        juce::String genre = genreSelector.getText();
-        int complexity = static_cast<int>(complexitySlider.getValue());
-
-        currentPatternSuggestions.clear();
-
-        for (int i = 0; i < 5; ++i) {
-            PatternSuggestionEngine::PatternSuggestion suggestion;
-            suggestion.name = genre + " Pattern " + juce::String(i + 1) + " (Complexity: " + juce::String(complexity) + ")";
-            currentPatternSuggestions.add(suggestion);
+        const juce::String genre = genreSelector.getText();
+
+        PatternSuggestionEngine::SuggestionParams params;
+        switch (genreSelector.getSelectedId()) {
+            case 2:  params.genre = PatternSuggestionEngine::Genre::Electronic; break;
+            case 3:  params.genre = PatternSuggestionEngine::Genre::Jazz; break;
+            case 4:  params.genre = PatternSuggestionEngine::Genre::HipHop; break;
+            case 5:  params.genre = PatternSuggestionEngine::Genre::Latin; break;
+            default: params.genre = PatternSuggestionEngine::Genre::Rock; break;
         }
+        params.complexity = static_cast<float>(complexitySlider.valueToProportionOfLength(complexitySlider.getValue()));
 
+        PatternSuggestionEngine::BatchRequest request;
+        request.variations.add(params);
+        request.numCandidates = INIConfig::Defaults::DEFAULT_NUM_SUGGESTIONS;
+
+        currentPatternSuggestions.clear();
         patternSuggestionsView.updateContent();
+
+        // Candidates are listed as they finish and put in order once the batch is ranked
+        auto toSuggestion = [genre](const PatternSuggestionEngine::Candidate& candidate) {
+            auto suggestion = candidate.toSuggestion();
+            suggestion.name = genre + " " + suggestion.name;
+            return suggestion;
+        };
+
+        patternSuggestionEngine.generateBatchAsync(request,
+            [this, toSuggestion](const PatternSuggestionEngine::Candidate& candidate) {
+                currentPatternSuggestions.add(toSuggestion(candidate));
+                patternSuggestionsView.updateContent();
+                return true;
+            },
+            [this, toSuggestion](const juce::Array<PatternSuggestionEngine::Candidate>& ranked) {
+                currentPatternSuggestions.clear();
+                for (const auto& candidate : ranked) {
+                    currentPatternSuggestions.add(toSuggestion(candidate));
+                }
+                patternSuggestionsView.deselectAllRows();
+                patternSuggestionsView.updateContent();
+                patternSuggestionsView.repaint();
+            });
     } catch (const std::exception& e) {
         ErrorHandler::getInstance().reportError(ErrorHandler::ErrorLevel::Error,
             "Pattern suggestion generation failed: " + juce::String(e.what()), "AIAssistantPanel");
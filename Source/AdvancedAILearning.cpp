@@ -1,5 +1,6 @@
 #include "AdvancedAILearning.h"
 #include "INIConfig.h"
+#include "MidiEngine.h"
 #include <algorithm>
 #include <cmath>
 
@@ -13,7 +14,6 @@ AdvancedAILearning::AdvancedAILearning() {
     }
     
     realTimeState.isActive = false;
-    recentMidiBuffer.ensureStorageAllocated(MAX_MIDI_BUFFER_SIZE);
 }
 
 void AdvancedAILearning::updateUserProfile(const juce::MidiMessageSequence& userInput,
@@ -28,41 +28,25 @@ void AdvancedAILearning::updateUserProfile(const juce::MidiMessageSequence& user
             userProfile.favoriteGenres.add(genre);
         }
 
-        float totalVelocity = 0.0f;
-        int noteCount = 0;
-        juce::Array<double> timings;
+        RunningStatistics velocities;
+        RunningStatistics timings;
 
         for (int i = 0; i < userInput.getNumEvents(); ++i) {
             auto event = userInput.getEventPointer(i);
             if (event->message.isNoteOn()) {
-                totalVelocity += event->message.getVelocity();
-                noteCount++;
+                velocities.add(event->message.getVelocity());
                 timings.add(event->message.getTimeStamp());
-                
-                int note = event->message.getNoteNumber();
-                if (!userProfile.commonDrumNotes.contains(note)) {
-                    userProfile.commonDrumNotes.add(note);
-                }
+                rememberDrumNote(event->message.getNoteNumber());
             }
         }
 
-        if (noteCount > 0) {
-            float avgVelocity = totalVelocity / noteCount;
+        if (!velocities.isEmpty()) {
+            float avgVelocity = static_cast<float>(velocities.getMean());
             userProfile.averageVelocity = userProfile.averageVelocity * (1.0f - userProfile.adaptationRate) +
                                         avgVelocity * userProfile.adaptationRate;
 
-            if (timings.size() > 1) {
-                float timingVariance = 0.0f;
-                double avgTiming = 0.0;
-                for (auto timing : timings) {
-                    avgTiming += timing;
-                }
-                avgTiming /= timings.size();
-
-                for (auto timing : timings) {
-                    timingVariance += std::pow(timing - avgTiming, 2);
-                }
-                timingVariance = std::sqrt(timingVariance / timings.size());
+            if (timings.getCount() > 1) {
+                float timingVariance = static_cast<float>(timings.getStandardDeviation());
 
                 float consistency = juce::jlimit(0.0f, 1.0f, 1.0f - (timingVariance / 100.0f));
                 userProfile.timingConsistency = userProfile.timingConsistency * (1.0f - userProfile.adaptationRate) +
@@ -91,12 +75,7 @@ void AdvancedAILearning::learnFromUserFeedback(const juce::String& patternId,
         stats.userRatings.add(rating);
         stats.isFavorite = isFavorite;
         stats.lastUsed = juce::Time::getCurrentTime();
-
-        float totalRating = 0.0f;
-        for (auto r : stats.userRatings) {
-            totalRating += r;
-        }
-        stats.averageRating = totalRating / stats.userRatings.size();
+        stats.averageRating = static_cast<float>(stats.userRatings.getMean());
 
         float complexityFromRating = rating / 5.0f;
         userProfile.preferredComplexity = userProfile.preferredComplexity * 0.9f +
@@ -113,43 +92,71 @@ void AdvancedAILearning::adaptToRealTimePerformance(const juce::Array<juce::Midi
     if (!realTimeState.isActive) return;
 
     try {
+        // The call is one window, however much of the previous one is still open
+        windowLength = timeWindow;
         for (const auto& msg : recentInput) {
-            recentMidiBuffer.add(msg);
-            if (recentMidiBuffer.size() > MAX_MIDI_BUFFER_SIZE) {
-                recentMidiBuffer.removeRange(0, recentMidiBuffer.size() - MAX_MIDI_BUFFER_SIZE);
+            if (msg.isNoteOn()) {
+                observeNote(msg.getTimeStamp(), msg.getNoteNumber(), msg.getVelocity());
             }
         }
+        scoreWindow();
 
-        float performanceScore = calculatePerformanceScore(recentInput, timeWindow);
-        realTimeState.recentPerformanceScores.add(performanceScore);
-        
-        if (realTimeState.recentPerformanceScores.size() > 20) {
-            realTimeState.recentPerformanceScores.removeRange(0, 1);
-        }
+    } catch (const std::exception& e) {
+        ErrorHandler::getInstance().reportError(ErrorHandler::ErrorLevel::Error,
+            "Failed to adapt to real-time performance: " + juce::String(e.what()), "AdvancedAILearning");
+    }
+}
 
-        if (performanceScore > 0.7f) {
-            realTimeState.consecutiveGoodBeats++;
-            realTimeState.consecutiveMissedBeats = 0;
-        } else if (performanceScore < 0.3f) {
-            realTimeState.consecutiveMissedBeats++;
-            realTimeState.consecutiveGoodBeats = 0;
-        }
+void AdvancedAILearning::processNote(double timeSeconds, int noteNumber, int velocity) {
+    if (!realTimeState.isActive) return;
+
+    if (windowStart >= 0.0 && timeSeconds - windowStart >= windowLength) {
+        scoreWindow();
+    }
+    observeNote(timeSeconds, noteNumber, velocity);
+}
+
+int AdvancedAILearning::processInputTap(MidiEngine& engine) {
+    int numNotes = 0;
 
-        adaptComplexityPreference(performanceScore);
-        adaptTempoPreference(recentInput);
+    MidiEngine::InputNote note;
+    while (engine.popInputNote(note)) {
+        processNote(note.time, note.note, note.velocity);
+        ++numNotes;
+    }
+    return numNotes;
+}
+
+void AdvancedAILearning::analyzePlayingStyle(const juce::Array<juce::MidiMessage>& midiData,
+                                           double timeSpan) {
+    RunningStatistics velocities;
+    RunningStatistics intervals;
+    double previousTime = -1.0;
+
+    for (const auto& msg : midiData) {
+        if (!msg.isNoteOn()) continue;
 
-        float avgScore = 0.0f;
-        for (auto score : realTimeState.recentPerformanceScores) {
-            avgScore += score;
+        velocities.add(msg.getVelocity());
+        rememberDrumNote(msg.getNoteNumber());
+
+        const double interval = msg.getTimeStamp() - previousTime;
+        if (previousTime >= 0.0 && interval >= MIN_NOTE_INTERVAL && interval <= MAX_NOTE_INTERVAL) {
+            intervals.add(interval);
         }
-        avgScore /= realTimeState.recentPerformanceScores.size();
-        
-        realTimeState.adaptationConfidence = juce::jlimit(0.0, 1.0, 
-            static_cast<double>(avgScore * 0.7 + realTimeState.consecutiveGoodBeats * 0.1));
+        previousTime = msg.getTimeStamp();
+    }
 
-    } catch (const std::exception& e) {
-        ErrorHandler::getInstance().reportError(ErrorHandler::ErrorLevel::Error,
-            "Failed to adapt to real-time performance: " + juce::String(e.what()), "AdvancedAILearning");
+    if (velocities.isEmpty()) return;
+
+    const float rate = userProfile.adaptationRate;
+    userProfile.averageVelocity = userProfile.averageVelocity * (1.0f - rate)
+                                + static_cast<float>(velocities.getMean()) * rate;
+
+    // Spread of the gaps against the gap an even pulse over the span would leave
+    if (intervals.getCount() > 1 && timeSpan > 0.0) {
+        const double expectedInterval = timeSpan / static_cast<double>(velocities.getCount());
+        const auto consistency = static_cast<float>(juce::jlimit(0.0, 1.0, 1.0 - intervals.getStandardDeviation() / expectedInterval));
+        userProfile.timingConsistency = userProfile.timingConsistency * (1.0f - rate) + consistency * rate;
     }
 }
 
@@ -192,7 +199,7 @@ AdvancedAILearning::generatePersonalizedPatterns(const PatternSuggestionEngine::
             complexityVariation = juce::jlimit(0.0f, 1.0f, complexityVariation);
 
             if (!genreLearningData->learnedPatterns.isEmpty()) {
-                int patternIndex = i % genreLearningData->learnedPatterns.size();
+                int patternIndex = i % genreLearningData->learnedPatterns.getSize();
                 suggestion.pattern = generateVariation(genreLearningData->learnedPatterns[patternIndex],
                                                      complexityVariation);
             } else {
@@ -225,7 +232,12 @@ AdvancedAILearning::generatePersonalizedPatterns(const PatternSuggestionEngine::
 void AdvancedAILearning::enableRealTimeAdaptation(bool enable) {
     realTimeState.isActive = enable;
     if (enable) {
-        realTimeState.recentPerformanceScores.clear();
+        realTimeState.averagePerformanceScore = 0.5f;
+        performanceAverage.reset();
+        windowVelocities.reset();
+        windowIntervals.reset();
+        windowStart = -1.0;
+        lastNoteTime = -1.0;
         realTimeState.consecutiveGoodBeats = 0;
         realTimeState.consecutiveMissedBeats = 0;
         realTimeState.adaptationConfidence = 0.5;
@@ -239,10 +251,7 @@ void AdvancedAILearning::updateGenreLearning(PatternSuggestionEngine::Genre genr
         genreData->learnedPatterns.add(pattern);
         genreData->totalExposure++;
         genreData->userPreferenceScore = genreData->userPreferenceScore * LEARNING_DECAY_RATE + 0.1f;
-
-        if (genreData->learnedPatterns.size() > 50) {
-            genreData->learnedPatterns.removeRange(0, 10);
-        }
+        genreData->complexityDistribution.add(userProfile.preferredComplexity);
     }
 }
 
@@ -274,47 +283,82 @@ float AdvancedAILearning::calculatePatternCompatibility(const juce::MidiMessageS
     return juce::jlimit(0.0f, 1.0f, compatibility);
 }
 
-float AdvancedAILearning::calculatePerformanceScore(const juce::Array<juce::MidiMessage>& midiData,
-                                                   double timeWindow) const {
-    if (midiData.isEmpty()) return 0.5f;
+void AdvancedAILearning::observeNote(double timeSeconds, int noteNumber, int velocity) {
+    sessionVelocities.add(velocity);
+    velocityAverage.add(velocity);
+    windowVelocities.add(velocity);
+    rememberDrumNote(noteNumber);
 
-    float velocityScore = 0.5f;
-    float timingScore = 0.5f;
-    
-    float totalVelocity = 0.0f;
-    int noteCount = 0;
-    juce::Array<double> timings;
+    const double interval = timeSeconds - lastNoteTime;
+    if (lastNoteTime >= 0.0 && interval >= MIN_NOTE_INTERVAL && interval <= MAX_NOTE_INTERVAL) {
+        intervalAverage.add(interval);
+        windowIntervals.add(interval);
+    }
+    if (lastNoteTime < 0.0 || interval >= MIN_NOTE_INTERVAL) {
+        lastNoteTime = timeSeconds;
+    }
+    if (windowStart < 0.0) {
+        windowStart = timeSeconds;
+    }
 
-    for (const auto& msg : midiData) {
-        if (msg.isNoteOn()) {
-            totalVelocity += msg.getVelocity();
-            noteCount++;
-            timings.add(msg.getTimeStamp());
-        }
+    // Positive while playing behind the expected pulse or louder than usual
+    const double expectedInterval = 60.0 / INIConfig::Defaults::DEFAULT_TEMPO;
+    if (!intervalAverage.isEmpty()) {
+        realTimeState.tempoTrend = static_cast<float>((intervalAverage.getValue() - expectedInterval) / expectedInterval);
     }
+    realTimeState.velocityTrend = static_cast<float>((velocityAverage.getValue() - userProfile.averageVelocity) / 127.0);
+    realTimeState.currentEnergyLevel = static_cast<float>(juce::jlimit(0.0, 1.0, velocityAverage.getValue() / 127.0));
+}
 
-    if (noteCount > 0) {
-        float avgVelocity = totalVelocity / noteCount;
-        float velocityDiff = std::abs(avgVelocity - userProfile.averageVelocity);
-        velocityScore = juce::jlimit(0.0f, 1.0f, 1.0f - (velocityDiff / 127.0f));
+void AdvancedAILearning::scoreWindow() {
+    const float performanceScore = calculatePerformanceScore();
+    performanceAverage.add(performanceScore);
+    realTimeState.averagePerformanceScore = static_cast<float>(performanceAverage.getValue());
 
-        if (timings.size() > 1) {
-            float expectedInterval = timeWindow / timings.size();
-            float timingVariance = 0.0f;
-            
-            for (int i = 1; i < timings.size(); ++i) {
-                float actualInterval = timings[i] - timings[i-1];
-                timingVariance += std::abs(actualInterval - expectedInterval);
-            }
-            
-            timingVariance /= (timings.size() - 1);
-            timingScore = juce::jlimit(0.0f, 1.0f, 1.0f - (timingVariance / expectedInterval));
-        }
+    if (performanceScore > 0.7f) {
+        realTimeState.consecutiveGoodBeats++;
+        realTimeState.consecutiveMissedBeats = 0;
+    } else if (performanceScore < 0.3f) {
+        realTimeState.consecutiveMissedBeats++;
+        realTimeState.consecutiveGoodBeats = 0;
+    }
+
+    adaptComplexityPreference(performanceScore);
+
+    realTimeState.adaptationConfidence = juce::jlimit(0.0, 1.0,
+        static_cast<double>(realTimeState.averagePerformanceScore * 0.7 + realTimeState.consecutiveGoodBeats * 0.1));
+
+    windowVelocities.reset();
+    windowIntervals.reset();
+    windowStart = -1.0;
+}
+
+float AdvancedAILearning::calculatePerformanceScore() const {
+    if (windowVelocities.isEmpty()) return 0.5f;
+
+    float velocityScore = 0.5f;
+    float timingScore = 0.5f;
+
+    float velocityDiff = std::abs(static_cast<float>(windowVelocities.getMean()) - userProfile.averageVelocity);
+    velocityScore = juce::jlimit(0.0f, 1.0f, 1.0f - (velocityDiff / 127.0f));
+
+    // An even pulse scores 1; gaps that spread as wide as they are long score 0
+    if (windowIntervals.getCount() > 1 && windowIntervals.getMean() > 0.0) {
+        const double spread = windowIntervals.getStandardDeviation() / windowIntervals.getMean();
+        timingScore = static_cast<float>(juce::jlimit(0.0, 1.0, 1.0 - spread));
     }
 
     return (velocityScore + timingScore) * 0.5f;
 }
 
+void AdvancedAILearning::rememberDrumNote(int noteNumber) {
+    if (noteNumber < 0 || noteNumber >= INIConfig::MIDI::NUM_NOTE_NUMBERS) return;
+
+    if (noteCounts.add(noteNumber) == 0) {
+        userProfile.commonDrumNotes.add(noteNumber);
+    }
+}
+
 void AdvancedAILearning::adaptComplexityPreference(float performanceScore) {
     if (performanceScore > 0.8f && realTimeState.consecutiveGoodBeats > 5) {
         userProfile.preferredComplexity = juce::jlimit(0.0f, 1.0f, 
@@ -325,28 +369,6 @@ void AdvancedAILearning::adaptComplexityPreference(float performanceScore) {
     }
 }
 
-void AdvancedAILearning::adaptTempoPreference(const juce::Array<juce::MidiMessage>& midiData) {
-    if (midiData.size() < 2) return;
-
-    juce::Array<double> intervals;
-    for (int i = 1; i < midiData.size(); ++i) {
-        if (midiData[i].isNoteOn() && midiData[i-1].isNoteOn()) {
-            intervals.add(midiData[i].getTimeStamp() - midiData[i-1].getTimeStamp());
-        }
-    }
-
-    if (!intervals.isEmpty()) {
-        double avgInterval = 0.0;
-        for (auto interval : intervals) {
-            avgInterval += interval;
-        }
-        avgInterval /= intervals.size();
-
-        double expectedInterval = 60.0 / INIConfig::Defaults::DEFAULT_TEMPO;
-        realTimeState.tempoTrend = (avgInterval - expectedInterval) / expectedInterval;
-    }
-}
-
 AdvancedAILearning::GenreLearningData* 
 AdvancedAILearning::findOrCreateGenreLearning(PatternSuggestionEngine::Genre genre) {
     for (auto& data : genreLearning) {
@@ -357,6 +379,10 @@ AdvancedAILearning::findOrCreateGenreLearning(PatternSuggestionEngine::Genre gen
     return nullptr;
 }
 
+juce::Array<AdvancedAILearning::GenreLearningData> AdvancedAILearning::getGenreLearningData() const {
+    return genreLearning;
+}
+
 juce::MidiMessageSequence 
 AdvancedAILearning::generateVariation(const juce::MidiMessageSequence& basePattern,
                                     float variationAmount) const {
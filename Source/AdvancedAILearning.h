@@ -3,12 +3,20 @@
 #include "MidiAnalysisTypes.h"
 #include "PatternSuggestionEngine.h"
 #include "ErrorHandling.h"
+#include "OnlineStatistics.h"
 #include <unordered_map>
 #include <vector>
 #include <memory>
 
+class MidiEngine;
+
+// Learning is kept in running estimators rather than in the events it was learnt from,
+// so memory stays bounded and each note costs the same however long it has been playing.
 class AdvancedAILearning {
 public:
+    static constexpr int MAX_LEARNED_PATTERNS = 16;
+    static constexpr int COMPLEXITY_BINS = 10;
+
     struct UserPerformanceProfile {
         float averageVelocity = 80.0f;
         float timingConsistency = 0.8f;
@@ -24,7 +32,7 @@ public:
     struct PatternUsageStats {
         int timesUsed = 0;
         float averageRating = 0.0f;
-        juce::Array<float> userRatings;
+        RunningStatistics userRatings;
         double totalPlayTime = 0.0;
         juce::Time lastUsed;
         bool isFavorite = false;
@@ -32,12 +40,14 @@ public:
 
     struct GenreLearningData {
         PatternSuggestionEngine::Genre genre;
-        juce::Array<juce::MidiMessageSequence> learnedPatterns;
+        // A uniform sample of everything played in the genre
+        ReservoirSample<juce::MidiMessageSequence, MAX_LEARNED_PATTERNS> learnedPatterns;
         juce::Array<MidiGrooveAnalysis> grooveVariations;
         float userPreferenceScore = 0.5f;
         int totalExposure = 0;
         std::unordered_map<int, float> instrumentPreferences;
-        juce::Array<float> complexityDistribution;
+        // Preferred complexity at each exposure
+        FixedHistogram<COMPLEXITY_BINS> complexityDistribution { 0.0, 1.0 };
         
         GenreLearningData() = default;
         GenreLearningData(const GenreLearningData& other) 
@@ -68,7 +78,7 @@ public:
         float currentEnergyLevel = 0.5f;
         float tempoTrend = 0.0f;
         float velocityTrend = 0.0f;
-        juce::Array<float> recentPerformanceScores;
+        float averagePerformanceScore = 0.5f;
         int consecutiveGoodBeats = 0;
         int consecutiveMissedBeats = 0;
         double adaptationConfidence = 0.5;
@@ -88,6 +98,12 @@ public:
     void adaptToRealTimePerformance(const juce::Array<juce::MidiMessage>& recentInput,
                                    double timeWindow = 2.0);
 
+    // One note-on of a live performance; times only have to increase. Every timeWindow
+    // of playing is scored as adaptToRealTimePerformance() scores one call.
+    void processNote(double timeSeconds, int noteNumber, int velocity);
+    // Everything the engine's input tap has collected since the last call; the number of notes
+    int processInputTap(MidiEngine& engine);
+
     PatternSuggestionEngine::SuggestionParams getPersonalizedSuggestionParams(
         PatternSuggestionEngine::Genre genre) const;
 
@@ -119,30 +135,43 @@ private:
     juce::Array<GenreLearningData> genreLearning;
     RealTimeAdaptation realTimeState;
 
-    juce::Array<juce::MidiMessage> recentMidiBuffer;
-    static constexpr int MAX_MIDI_BUFFER_SIZE = 1000;
+    // Live input: notes over the whole session, trends, and the window being scored
+    RunningStatistics sessionVelocities;
+    ExponentialAverage velocityAverage { TREND_SMOOTHING };
+    ExponentialAverage intervalAverage { TREND_SMOOTHING };
+    ExponentialAverage performanceAverage { SCORE_SMOOTHING };
+    FixedHistogram<INIConfig::MIDI::NUM_NOTE_NUMBERS> noteCounts;
+    RunningStatistics windowVelocities;
+    RunningStatistics windowIntervals;
+    double windowStart = -1.0;
+    double windowLength = 2.0;
+    double lastNoteTime = -1.0;
+
     static constexpr double LEARNING_DECAY_RATE = 0.95;
     static constexpr float MIN_ADAPTATION_CONFIDENCE = 0.3f;
+    static constexpr double TREND_SMOOTHING = 0.1;
+    static constexpr double SCORE_SMOOTHING = 0.1;
+    // Closer note-ons are one hit on several drums, further ones a pause
+    static constexpr double MIN_NOTE_INTERVAL = 0.03;
+    static constexpr double MAX_NOTE_INTERVAL = 2.0;
 
     void updateGenreLearning(PatternSuggestionEngine::Genre genre,
                            const juce::MidiMessageSequence& pattern);
 
-    void analyzeVelocityPatterns(const juce::Array<juce::MidiMessage>& midiData);
-    void analyzeTimingPatterns(const juce::Array<juce::MidiMessage>& midiData);
-    void analyzeInstrumentUsage(const juce::Array<juce::MidiMessage>& midiData);
-
-    float calculatePerformanceScore(const juce::Array<juce::MidiMessage>& midiData,
-                                  double timeWindow) const;
+    // Adds a note to the session, window and trend estimators
+    void observeNote(double timeSeconds, int noteNumber, int velocity);
+    // Scores the window, adapts to the score and starts the next window
+    void scoreWindow();
+    float calculatePerformanceScore() const;
+    void rememberDrumNote(int noteNumber);
 
     void adaptComplexityPreference(float performanceScore);
-    void adaptTempoPreference(const juce::Array<juce::MidiMessage>& midiData);
 
     GenreLearningData* findOrCreateGenreLearning(PatternSuggestionEngine::Genre genre);
 
     juce::MidiMessageSequence generateVariation(const juce::MidiMessageSequence& basePattern,
                                                float variationAmount) const;
 
-    void pruneOldData();
     void normalizePreferences();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AdvancedAILearning)
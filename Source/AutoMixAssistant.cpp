@@ -1,6 +1,9 @@
 #include "AutoMixAssistant.h"
 #include "INIConfig.h"
 #include "SFZEngine.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
 
 AutoMixAssistant::AutoMixAssistant(Mixer& mixerRef, SFZEngine& sfzEngineRef)
     : mixer(mixerRef), sfzEngine(sfzEngineRef) {
@@ -169,31 +172,43 @@ bool AutoMixAssistant::createSpace() noexcept {
     };
 
     juce::Array<ChannelFreqInfo> channelInfo;
+    const auto* measured = getMeasuredMix();
 
     for (int channel = 0; channel < INIConfig::Defaults::MAX_PLAYERS; ++channel) {
         if (mixer.isChannelMuted(channel)) continue;
 
-        auto levels = mixer.getChannelLevels(channel);
-        if (levels.left < 0.01f && levels.right < 0.01f) continue;
-
         ChannelFreqInfo info;
         info.channel = channel;
 
-        if (channel == 0 || channel == 1) {
-            info.lowEnergy = 0.8f;
-            info.midEnergy = 0.2f;
-            info.highEnergy = 0.1f;
-            info.dominantBand = 0;
-        } else if (channel == 2 || channel == 3) {
-            info.lowEnergy = 0.2f;
-            info.midEnergy = 0.7f;
-            info.highEnergy = 0.5f;
-            info.dominantBand = 1;
+        if (measured != nullptr) {
+            const auto& spectrum = measured->channels[static_cast<size_t>(channel)];
+            if (!spectrum.active) continue;
+
+            const auto shares = getMixerBandShares(spectrum);
+            info.lowEnergy = shares[0];
+            info.midEnergy = shares[1];
+            info.highEnergy = shares[2];
+            info.dominantBand = static_cast<float>(getDominantBand(shares));
         } else {
-            info.lowEnergy = 0.1f;
-            info.midEnergy = 0.3f;
-            info.highEnergy = 0.8f;
-            info.dominantBand = 2;
+            auto levels = mixer.getChannelLevels(channel);
+            if (levels.left < 0.01f && levels.right < 0.01f) continue;
+
+            if (channel == 0 || channel == 1) {
+                info.lowEnergy = 0.8f;
+                info.midEnergy = 0.2f;
+                info.highEnergy = 0.1f;
+                info.dominantBand = 0;
+            } else if (channel == 2 || channel == 3) {
+                info.lowEnergy = 0.2f;
+                info.midEnergy = 0.7f;
+                info.highEnergy = 0.5f;
+                info.dominantBand = 1;
+            } else {
+                info.lowEnergy = 0.1f;
+                info.midEnergy = 0.3f;
+                info.highEnergy = 0.8f;
+                info.dominantBand = 2;
+            }
         }
 
         channelInfo.add(info);
@@ -213,6 +228,48 @@ bool AutoMixAssistant::createSpace() noexcept {
 }
 
 bool AutoMixAssistant::preventFrequencyMasking() noexcept {
+    if (const auto* measured = getMeasuredMix()) {
+        for (int ch1 = 0; ch1 < INIConfig::Defaults::MAX_PLAYERS - 1; ++ch1) {
+            if (mixer.isChannelMuted(ch1)) continue;
+
+            for (int ch2 = ch1 + 1; ch2 < INIConfig::Defaults::MAX_PLAYERS; ++ch2) {
+                if (mixer.isChannelMuted(ch2)) continue;
+
+                // Zero unless both are playing
+                const float overlap = measured->masking[static_cast<size_t>(ch1)][static_cast<size_t>(ch2)];
+                if (overlap < INIConfig::Audio::MIX_ANALYSIS_MASKING_THRESHOLD) continue;
+
+                float currentPan1 = mixer.getChannelPan(ch1);
+                float currentPan2 = mixer.getChannelPan(ch2);
+
+                if (std::abs(currentPan1 - currentPan2) < 0.2f) {
+                    mixer.setChannelPan(ch1, currentPan1 - 0.1f);
+                    mixer.setChannelPan(ch2, currentPan2 + 0.1f);
+                }
+
+                // Only the band they share most is changed, and whichever carries less of it makes room
+                const auto shares1 = getMixerBandShares(measured->channels[static_cast<size_t>(ch1)]);
+                const auto shares2 = getMixerBandShares(measured->channels[static_cast<size_t>(ch2)]);
+
+                int band = 0;
+                for (int candidate = 1; candidate < NUM_MIXER_BANDS; ++candidate) {
+                    if (juce::jmin(shares1[static_cast<size_t>(candidate)], shares2[static_cast<size_t>(candidate)])
+                        > juce::jmin(shares1[static_cast<size_t>(band)], shares2[static_cast<size_t>(band)])) {
+                        band = candidate;
+                    }
+                }
+
+                const bool firstOwnsBand = shares1[static_cast<size_t>(band)] >= shares2[static_cast<size_t>(band)];
+                const int owner = firstOwnsBand ? ch1 : ch2;
+                const int other = firstOwnsBand ? ch2 : ch1;
+                const auto eqBand = static_cast<Mixer::EQBand>(band);
+
+                mixer.setChannelEQ(owner, eqBand, mixer.getChannelEQ(owner, eqBand) + 1.0f);
+                mixer.setChannelEQ(other, eqBand, mixer.getChannelEQ(other, eqBand) - 1.0f);
+            }
+        }
+        return true;
+    }
 
     for (int ch1 = 0; ch1 < INIConfig::Defaults::MAX_PLAYERS - 1; ++ch1) {
         if (mixer.isChannelMuted(ch1)) continue;
@@ -327,29 +384,51 @@ void AutoMixAssistant::initializePresets() noexcept {
 AutoMixAssistant::MixAnalysis AutoMixAssistant::analyzeCurrentMix() noexcept {
     MixAnalysis analysis;
 
+    // Kick and snare low, toms in the middle, cymbals high, unless the analyzer says otherwise
     for (int ch = 0; ch < INIConfig::Defaults::MAX_PLAYERS; ++ch) {
-        auto levels = mixer.getChannelLevels(ch);
-        float level = (levels.left + levels.right) * 0.5f;
+        analysis.channelBand[ch] = ch < 2 ? 0 : (ch < 4 ? 1 : 2);
+    }
 
-        if (ch < 2) {
-            analysis.frequencyBalance.low += level;
-        } else if (ch < 4) {
-            analysis.frequencyBalance.mid += level;
-        } else {
-            analysis.frequencyBalance.high += level;
+    if (const auto* measured = getMeasuredMix()) {
+        const auto masterShares = getMixerBandShares(measured->master);
+        analysis.frequencyBalance.low = masterShares[0];
+        analysis.frequencyBalance.mid = masterShares[1];
+        analysis.frequencyBalance.high = masterShares[2];
+        analysis.correlation = measured->master.correlation;
+
+        for (int ch = 0; ch < INIConfig::Defaults::MAX_PLAYERS; ++ch) {
+            const auto& spectrum = measured->channels[static_cast<size_t>(ch)];
+            analysis.channelActivity[ch] = spectrum.active;
+
+            if (spectrum.active) {
+                analysis.channelBand[ch] = getDominantBand(getMixerBandShares(spectrum));
+            }
         }
+    } else {
+        for (int ch = 0; ch < INIConfig::Defaults::MAX_PLAYERS; ++ch) {
+            auto levels = mixer.getChannelLevels(ch);
+            float level = (levels.left + levels.right) * 0.5f;
 
-        analysis.channelActivity[ch] = level > 0.01f;
-    }
+            if (ch < 2) {
+                analysis.frequencyBalance.low += level;
+            } else if (ch < 4) {
+                analysis.frequencyBalance.mid += level;
+            } else {
+                analysis.frequencyBalance.high += level;
+            }
+
+            analysis.channelActivity[ch] = level > 0.01f;
+        }
 
-    float total = analysis.frequencyBalance.low +
-                  analysis.frequencyBalance.mid +
-                  analysis.frequencyBalance.high;
+        float total = analysis.frequencyBalance.low +
+                      analysis.frequencyBalance.mid +
+                      analysis.frequencyBalance.high;
 
-    if (total > 0.0f) {
-        analysis.frequencyBalance.low /= total;
-        analysis.frequencyBalance.mid /= total;
-        analysis.frequencyBalance.high /= total;
+        if (total > 0.0f) {
+            analysis.frequencyBalance.low /= total;
+            analysis.frequencyBalance.mid /= total;
+            analysis.frequencyBalance.high /= total;
+        }
     }
 
     analysis.stereoWidth = calculateStereoWidth();
@@ -376,22 +455,19 @@ AutoMixAssistant::MixSuggestion AutoMixAssistant::generateSuggestions(const MixA
     float lowError = analysis.frequencyBalance.low - idealLow;
     float midError = analysis.frequencyBalance.mid - idealMid;
     float highError = analysis.frequencyBalance.high - idealHigh;
+    const float bandErrors[NUM_MIXER_BANDS] = { lowError, midError, highError };
 
     for (int ch = 0; ch < INIConfig::Defaults::MAX_PLAYERS; ++ch) {
         suggestion.channelVolumes[ch] = mixer.getChannelVolume(ch);
 
-        if (ch < 2 && lowError > 0.1f) {
-            suggestion.channelVolumes[ch] *= 0.9f;
-        } else if (ch >= 2 && ch < 4 && midError > 0.1f) {
-            suggestion.channelVolumes[ch] *= 0.9f;
-        } else if (ch >= 4 && highError > 0.1f) {
+        if (bandErrors[analysis.channelBand[ch]] > 0.1f) {
             suggestion.channelVolumes[ch] *= 0.9f;
         }
     }
 
     if (analysis.stereoWidth < 0.3f) {
         for (int ch = 0; ch < INIConfig::Defaults::MAX_PLAYERS; ++ch) {
-            if (ch >= 4) {
+            if (analysis.channelBand[ch] == 2) {
                 suggestion.channelPans[ch] = (ch % 2) ? 0.3f : -0.3f;
             } else {
                 suggestion.channelPans[ch] = 0.0f;
@@ -408,13 +484,8 @@ AutoMixAssistant::MixSuggestion AutoMixAssistant::generateSuggestions(const MixA
             suggestion.eqSettings[ch][band] = 0.0f;
         }
 
-        if (ch < 2) {
-            suggestion.eqSettings[ch][0] = -lowError * 5.0f;
-        } else if (ch < 4) {
-            suggestion.eqSettings[ch][1] = -midError * 5.0f;
-        } else {
-            suggestion.eqSettings[ch][2] = -highError * 5.0f;
-        }
+        const int band = analysis.channelBand[ch];
+        suggestion.eqSettings[ch][band] = -bandErrors[band] * 5.0f;
     }
 
     if (analysis.dynamicRange < 0.3f) {
@@ -451,10 +522,19 @@ float AutoMixAssistant::calculateConfidence(const MixAnalysis& analysis) const n
         confidence *= 0.8f;
     }
 
+    // Out of phase, so the suggestion would not survive a mono fold-down
+    if (analysis.correlation < 0.0f) {
+        confidence *= 0.8f;
+    }
+
     return juce::jmax(0.0f, confidence);
 }
 
 float AutoMixAssistant::calculateStereoWidth() const noexcept {
+    if (const auto* measured = getMeasuredMix()) {
+        return juce::jlimit(0.0f, 1.0f, measured->master.stereoWidth);
+    }
+
     float leftSum = 0.0f;
     float rightSum = 0.0f;
     float monoSum = 0.0f;
@@ -480,6 +560,15 @@ float AutoMixAssistant::calculateStereoWidth() const noexcept {
 }
 
 float AutoMixAssistant::calculateDynamicRange() const noexcept {
+    if (const auto* measured = getMeasuredMix()) {
+        const auto& master = measured->master;
+        if (!master.active) return 0.0f;
+
+        const float minCrest = INIConfig::Audio::MIX_ANALYSIS_MIN_CREST_DB;
+        const float maxCrest = INIConfig::Audio::MIX_ANALYSIS_MAX_CREST_DB;
+        return juce::jlimit(0.0f, 1.0f, (master.crestFactor - minCrest) / (maxCrest - minCrest));
+    }
+
     float minLevel = 1.0f;
     float maxLevel = 0.0f;
 
@@ -501,6 +590,32 @@ float AutoMixAssistant::calculateDynamicRange() const noexcept {
     return juce::jlimit(0.0f, 1.0f, range);
 }
 
+const MixAnalyzer::Snapshot* AutoMixAssistant::getMeasuredMix() const noexcept {
+    // A snapshot left from before the analyzer was stopped no longer describes the mix
+    auto& analyzer = mixer.getMixAnalyzer();
+    if (!analyzer.isActive()) return nullptr;
+
+    const auto& snapshot = analyzer.getLatestSnapshot();
+    return snapshot.isValid() ? &snapshot : nullptr;
+}
+
+std::array<float, AutoMixAssistant::NUM_MIXER_BANDS>
+AutoMixAssistant::getMixerBandShares(const MixAnalyzer::ChannelSpectrum& spectrum) noexcept {
+    std::array<float, NUM_MIXER_BANDS> shares{};
+
+    for (int band = 0; band < MixAnalyzer::NUM_BANDS; ++band) {
+        const float lowerEdge = MixAnalyzer::getBandEdge(band);
+        const int mixerBand = lowerEdge < INIConfig::Audio::MIX_ANALYSIS_LOW_MID_HZ ? 0
+                            : (lowerEdge < INIConfig::Audio::MIX_ANALYSIS_MID_HIGH_HZ ? 1 : 2);
+        shares[static_cast<size_t>(mixerBand)] += spectrum.getBandShare(band);
+    }
+    return shares;
+}
+
+int AutoMixAssistant::getDominantBand(const std::array<float, NUM_MIXER_BANDS>& shares) noexcept {
+    return static_cast<int>(std::distance(shares.begin(), std::max_element(shares.begin(), shares.end())));
+}
+
 bool AutoMixAssistant::adaptMixToRoom(const RoomAnalysis& roomAnalysis) noexcept {
 
     for (int ch = 0; ch < INIConfig::Defaults::MAX_PLAYERS; ++ch) {
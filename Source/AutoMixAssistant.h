@@ -1,11 +1,15 @@
 #pragma once
 #include <JuceHeader.h>
+#include <array>
 #include "Mixer.h"
 #include "INIConfig.h"
 #include "ErrorHandling.h"
 
 class SFZEngine;
 
+// Suggests and applies mix changes from what the mixer's MixAnalyzer measures. Until the
+// analyzer has published a snapshot (it runs only while something has activated it) the
+// suggestions fall back to guesses from the channel settings and meters.
 class AutoMixAssistant {
 public:
     struct MixSuggestion {
@@ -82,11 +86,17 @@ private:
         } frequencyBalance;
 
         float stereoWidth = INIConfig::Validation::MIN_VOLUME;
+        // Of the master; below zero its sides cancel when summed to mono
+        float correlation = 1.0f;
         float dynamicRange = INIConfig::Validation::MIN_VOLUME;
         int activeChannels = INIConfig::Validation::MIN_PLAYER_INDEX;
         bool channelActivity[INIConfig::Defaults::MAX_PLAYERS] = {false};
+        // The mixer EQ band that carries most of each channel
+        int channelBand[INIConfig::Defaults::MAX_PLAYERS] = {0};
     };
 
+    static constexpr int NUM_MIXER_BANDS = 3;
+
     struct UserPreferences {
         float volumeTendencies[INIConfig::Defaults::MAX_PLAYERS] = {INIConfig::Validation::MIN_VOLUME};
         float panTendencies[INIConfig::Defaults::MAX_PLAYERS] = {INIConfig::Validation::MIN_VOLUME};
@@ -102,6 +112,12 @@ private:
     float calculateConfidence(const MixAnalysis& analysis) const noexcept;
     float calculateStereoWidth() const noexcept;
     float calculateDynamicRange() const noexcept;
+
+    // The analyzer's latest measurement, or nullptr until it has made one
+    const MixAnalyzer::Snapshot* getMeasuredMix() const noexcept;
+    // A measured spectrum folded into the mixer's low, mid and high bands, as shares of its energy
+    static std::array<float, NUM_MIXER_BANDS> getMixerBandShares(const MixAnalyzer::ChannelSpectrum& spectrum) noexcept;
+    static int getDominantBand(const std::array<float, NUM_MIXER_BANDS>& shares) noexcept;
     
     // Error handling utilities
     void setError(const juce::String& message) const noexcept;
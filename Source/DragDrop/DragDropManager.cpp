@@ -42,3 +42,114 @@ void MidiFileDragTarget::fileDragExit(const juce::StringArray& files) {
 void MidiFileDragTarget::updateVisualFeedback(bool hovering) {
     isDragHovering = hovering;
 }
+
+// Finds the files as well as importing them, so a deep folder never holds up the message thread
+class SampleFolderDragTarget::ImportThread : public juce::Thread {
+public:
+    ImportThread(SampleFolderDragTarget& target, const juce::String& kitNameToUse, const juce::StringArray& pathsToImport)
+        : juce::Thread("OTTO Sample Import"), owner(&target), importer(target.importer),
+          number(target.importNumber), kitName(kitNameToUse), paths(pathsToImport) {
+    }
+
+    ~ImportThread() override {
+        stopThread(INIConfig::LayoutConstants::sampleImportThreadStopTimeoutMs);
+    }
+
+    void run() override {
+        const auto files = SampleKitImporter::findAudioFiles(paths, [this] { return !threadShouldExit(); });
+        if (threadShouldExit()) return;
+
+        auto result = importer.importKit(kitName, files, [this](int done, int total) {
+            juce::MessageManager::callAsync([target = owner, number = number, done, total]() {
+                if (auto* strongTarget = target.get()) strongTarget->handleProgress(number, done, total);
+            });
+            return !threadShouldExit();
+        });
+
+        juce::MessageManager::callAsync([target = owner, number = number, result = std::move(result)]() {
+            if (auto* strongTarget = target.get()) strongTarget->handleFinished(number, result);
+        });
+    }
+
+private:
+    juce::WeakReference<SampleFolderDragTarget> owner;
+    SampleKitImporter& importer;
+    const int number;
+    juce::String kitName;
+    juce::StringArray paths;
+};
+
+SampleFolderDragTarget::SampleFolderDragTarget(const juce::File& drumkitsFolder)
+    : importer(drumkitsFolder) {
+}
+
+SampleFolderDragTarget::~SampleFolderDragTarget() {
+    cancelImport();
+}
+
+bool SampleFolderDragTarget::isInterestedInFileDrag(const juce::StringArray& files) {
+    if (isImporting()) return false;
+
+    for (const auto& path : files) {
+        const juce::File file(path);
+        if (file.isDirectory() || SampleKitImporter::isAudioFile(file)) return true;
+    }
+    return false;
+}
+
+void SampleFolderDragTarget::filesDropped(const juce::StringArray& files, int x, int y) {
+    juce::ignoreUnused(x, y);
+    updateVisualFeedback(false);
+
+    if (isImporting() || files.isEmpty()) return;
+
+    // Loose files are named after the folder they came from
+    const juce::File first(files[0]);
+    const auto folderName = first.isDirectory() ? first.getFileName() : first.getParentDirectory().getFileName();
+
+    progress = 0.0;
+    ++importNumber;
+    importThread = std::make_unique<ImportThread>(*this, importer.findKitName(folderName), files);
+    importThread->startThread();
+}
+
+void SampleFolderDragTarget::fileDragEnter(const juce::StringArray& files, int x, int y) {
+    juce::ignoreUnused(files, x, y);
+    updateVisualFeedback(true);
+}
+
+void SampleFolderDragTarget::fileDragExit(const juce::StringArray& files) {
+    juce::ignoreUnused(files);
+    updateVisualFeedback(false);
+}
+
+void SampleFolderDragTarget::cancelImport() {
+    // Waits for the file each worker is on; the kit is left as it was
+    importThread.reset();
+    ++importNumber;
+    progress = 0.0;
+}
+
+void SampleFolderDragTarget::handleProgress(int number, int done, int total) {
+    if (number != importNumber) return;
+
+    progress = total > 0 ? static_cast<double>(done) / total : 1.0;
+    if (onImportProgress) {
+        onImportProgress(done, total);
+    }
+}
+
+void SampleFolderDragTarget::handleFinished(int number, const SampleKitImporter::Result& result) {
+    if (number != importNumber) return;
+
+    importThread.reset();
+    progress = result.succeeded() ? 1.0 : 0.0;
+
+    if (onImportFinished) {
+        onImportFinished(result);
+    }
+}
+
+void SampleFolderDragTarget::updateVisualFeedback(bool hovering) {
+    isDragHovering = hovering;
+}
@@ -2,6 +2,9 @@
 #include <JuceHeader.h>
 #include "../ColorScheme.h"
 #include "../FontManager.h"
+#include "../SampleKitImporter.h"
+#include <functional>
+#include <memory>
 
 class PatternDragSource : public juce::DragAndDropContainer {
 public:
@@ -35,3 +38,43 @@ private:
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiFileDragTarget)
 };
+
+// Takes a drop of audio files or folders and imports them as a kit on a background
+// thread, named after the dropped folder. Progress and the result are reported on the
+// message thread; nothing more is accepted until the import is over.
+class SampleFolderDragTarget : public juce::FileDragAndDropTarget {
+public:
+    explicit SampleFolderDragTarget(const juce::File& drumkitsFolder);
+    ~SampleFolderDragTarget() override;
+
+    bool isInterestedInFileDrag(const juce::StringArray& files) override;
+    void filesDropped(const juce::StringArray& files, int x, int y) override;
+    void fileDragEnter(const juce::StringArray& files, int x, int y) override;
+    void fileDragExit(const juce::StringArray& files) override;
+
+    bool isImporting() const { return importThread != nullptr; }
+    void cancelImport();
+
+    // From 0 to 1 while importing, for a juce::ProgressBar
+    double& getProgress() { return progress; }
+
+    std::function<void(int, int)> onImportProgress;
+    std::function<void(const SampleKitImporter::Result&)> onImportFinished;
+
+private:
+    class ImportThread;
+
+    SampleKitImporter importer;
+    std::unique_ptr<ImportThread> importThread;
+    double progress = 0.0;
+    // Reports from an import that was cancelled arrive late and are told apart by this
+    int importNumber = 0;
+    bool isDragHovering = false;
+
+    void handleProgress(int number, int done, int total);
+    void handleFinished(int number, const SampleKitImporter::Result& result);
+    void updateVisualFeedback(bool hovering);
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE(SampleFolderDragTarget)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleFolderDragTarget)
+};
@@ -746,7 +746,9 @@ DrumKitEditorContent::DrumKitEditorContent(SFZEngine& sfz,
       iniManager(ini),
       newKitButton("New"),
       saveKitButton("Save"),
-      loadKitButton("Load")
+      loadKitButton("Load"),
+      sampleFolderTarget(sfz.getSFZFolder()),
+      importProgressBar(sampleFolderTarget.getProgress())
 {
     setupComponents();
     connectCallbacks();
@@ -793,6 +795,11 @@ void DrumKitEditorContent::setupComponents()
     kitNameEditor.setColour(juce::TextEditor::outlineColourId, juce::Colour(0xFF4A4A4A));
     kitNameEditor.setColour(juce::TextEditor::focusedOutlineColourId, juce::Colour(0xFF4A90E2));
     addAndMakeVisible(kitNameEditor);
+
+    // Shown only while a dropped kit is being imported
+    importProgressBar.setColour(juce::ProgressBar::backgroundColourId, juce::Colour(0xFF2A2A2A));
+    importProgressBar.setColour(juce::ProgressBar::foregroundColourId, juce::Colour(0xFF4A90E2));
+    addChildComponent(importProgressBar);
 }
 
 void DrumKitEditorContent::setupMainButtons()
@@ -889,6 +896,16 @@ void DrumKitEditorContent::connectCallbacks()
             padData[selectedPadIndex].velocityCurve = amount;
         }
     };
+
+    sampleFolderTarget.onImportProgress = [this](int done, int total)
+    {
+        importProgressBar.setTextToDisplay("Importing " + juce::String(done) + " / " + juce::String(total));
+    };
+
+    sampleFolderTarget.onImportFinished = [this](const SampleKitImporter::Result& result)
+    {
+        handleSampleImportFinished(result);
+    };
 }
 
 void DrumKitEditorContent::paint(juce::Graphics& g)
@@ -920,6 +937,9 @@ void DrumKitEditorContent::resized()
     saveKitButton.setBounds(topBar.removeFromRight(buttonWidth));
     topBar.removeFromRight(spacing);
     newKitButton.setBounds(topBar.removeFromRight(buttonWidth));
+    topBar.removeFromRight(margin);
+
+    importProgressBar.setBounds(topBar);
 
     bounds.removeFromTop(spacing);
 
@@ -984,6 +1004,66 @@ void DrumKitEditorContent::buttonClicked(juce::Button* button)
         loadKit();
 }
 
+bool DrumKitEditorContent::isInterestedInFileDrag(const juce::StringArray& files)
+{
+    return sampleFolderTarget.isInterestedInFileDrag(files);
+}
+
+void DrumKitEditorContent::filesDropped(const juce::StringArray& files, int x, int y)
+{
+    sampleFolderTarget.filesDropped(files, x, y);
+
+    if (sampleFolderTarget.isImporting())
+    {
+        importProgressBar.setTextToDisplay("Importing");
+        importProgressBar.setVisible(true);
+    }
+}
+
+void DrumKitEditorContent::fileDragEnter(const juce::StringArray& files, int x, int y)
+{
+    sampleFolderTarget.fileDragEnter(files, x, y);
+}
+
+void DrumKitEditorContent::fileDragExit(const juce::StringArray& files)
+{
+    sampleFolderTarget.fileDragExit(files);
+}
+
+void DrumKitEditorContent::handleSampleImportFinished(const SampleKitImporter::Result& result)
+{
+    importProgressBar.setVisible(false);
+
+    for (const auto& unreadable : result.unreadable)
+    {
+        DBG("DrumKitEditorContent: Could not import sample " + unreadable);
+    }
+
+    if (!result.succeeded())
+    {
+        return;
+    }
+
+    // The new kit joins the list before it is loaded
+    const auto kitName = result.sfzFile.getParentDirectory().getFileName();
+    sfzEngine.scanDrumkitsFolder();
+    sfzEngine.loadDrumkit(kitName, result.sfzFile.getFileNameWithoutExtension());
+
+    // The imported SFZ file keeps a region to a line, so the pads are filled from the result
+    newKit();
+    kitNameEditor.setText(kitName);
+
+    for (const auto& sample : result.samples)
+    {
+        // Each pad shows its drum's top velocity layer
+        if (sample.hiVel == INIConfig::Validation::MAX_MIDI_VELOCITY)
+        {
+            handleSampleAssignment(sample.note - INIConfig::LayoutConstants::sfzBaseMidiNote,
+                                   result.sfzFile.getParentDirectory().getChildFile(sample.sampleName));
+        }
+    }
+}
+
 void DrumKitEditorContent::handlePadSelection(int padNumber)
 {
     if (padNumber >= 0 && padNumber < INIConfig::LayoutConstants::drumKitEditorPadCount)
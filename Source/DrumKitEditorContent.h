@@ -7,6 +7,7 @@
 #include "INIDataManager.h"
 #include "ComponentState.h"
 #include "INIConfig.h"
+#include "DragDrop/DragDropManager.h"
 
 class DrumKitWaveformDisplay : public juce::Component,
                               public juce::FileDragAndDropTarget,
@@ -195,8 +196,11 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleBrowser)
 };
 
+// Folders and loose samples dropped anywhere the pads and waveform do not take them
+// are imported as a new kit, which is loaded once the import finishes
 class DrumKitEditorContent : public juce::Component,
-                            public juce::Button::Listener
+                            public juce::Button::Listener,
+                            public juce::FileDragAndDropTarget
 {
 public:
     DrumKitEditorContent(SFZEngine& sfzEngine,
@@ -211,6 +215,11 @@ public:
 
     void buttonClicked(juce::Button* button) override;
 
+    bool isInterestedInFileDrag(const juce::StringArray& files) override;
+    void filesDropped(const juce::StringArray& files, int x, int y) override;
+    void fileDragEnter(const juce::StringArray& files, int x, int y) override;
+    void fileDragExit(const juce::StringArray& files) override;
+
     void saveKit();
     void loadKit();
     void newKit();
@@ -232,6 +241,9 @@ private:
     juce::Label kitNameLabel;
     juce::TextEditor kitNameEditor;
 
+    SampleFolderDragTarget sampleFolderTarget;
+    juce::ProgressBar importProgressBar;
+
     int selectedPadIndex = INIConfig::MIDI::INACTIVE_PATTERN;
 
     struct PadSampleData {
@@ -253,6 +265,7 @@ private:
 
     void exportKitAsSFZ(const juce::File& destination);
     void importKitFromSFZ(const juce::File& source);
+    void handleSampleImportFinished(const SampleKitImporter::Result& result);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DrumKitEditorContent)
 };
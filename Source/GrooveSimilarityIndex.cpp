@@ -0,0 +1,327 @@
+#include "GrooveSimilarityIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <utility>
+
+namespace {
+    // Every feature is normalized to 0..1 and then scaled by how much it should count
+    constexpr float tempoWeight = 3.0f;
+    constexpr float swingWeight = 2.0f;
+    constexpr float tightnessWeight = 1.0f;
+    constexpr float velocityWeight = 1.5f;
+    constexpr float velocityRangeWeight = 0.5f;
+    constexpr float velocityVariationWeight = 0.5f;
+    constexpr float timingDeviationWeight = 0.5f;
+    constexpr float densityWeight = 1.0f;
+    constexpr float meterWeight = 2.0f;
+    constexpr float distributionWeight = 0.5f;
+    constexpr float microTimingWeight = 0.25f;
+
+    float normalize(float value, float minimum, float maximum) {
+        return juce::jlimit(0.0f, 1.0f, (value - minimum) / (maximum - minimum));
+    }
+}
+
+// The closest rows offered so far, kept as a max-heap on distance so the worst is on top
+class GrooveSimilarityIndex::Selection {
+public:
+    explicit Selection(int size) : capacity(static_cast<size_t>(size)) {
+        best.reserve(capacity);
+    }
+
+    void offer(float distance, int index) {
+        if (best.size() < capacity) {
+            best.emplace_back(distance, index);
+            std::push_heap(best.begin(), best.end());
+        } else if (distance < best.front().first) {
+            std::pop_heap(best.begin(), best.end());
+            best.back() = { distance, index };
+            std::push_heap(best.begin(), best.end());
+        }
+    }
+
+    juce::Array<Match> getMatches(float queryNorm) {
+        std::sort_heap(best.begin(), best.end());
+
+        juce::Array<Match> matches;
+        matches.ensureStorageAllocated(static_cast<int>(best.size()));
+        for (const auto& [distance, index] : best) {
+            // Rounding can take a squared distance a little below zero
+            const float distanceToQuery = std::sqrt(juce::jmax(0.0f, distance + queryNorm));
+            matches.add({ index, juce::jlimit(0.0f, 1.0f, 1.0f - distanceToQuery) });
+        }
+        return matches;
+    }
+
+private:
+    size_t capacity;
+    std::vector<std::pair<float, int>> best;
+};
+
+void GrooveSimilarityIndex::getFeatures(const MidiGrooveAnalysis& groove, float* features) {
+    const float maxVelocity = static_cast<float>(INIConfig::Validation::MAX_MIDI_VELOCITY);
+    const float meter = groove.timeSignatureDenominator > 0
+                      ? static_cast<float>(groove.timeSignatureNumerator) / static_cast<float>(groove.timeSignatureDenominator)
+                      : 1.0f;
+
+    features[0] = tempoWeight * normalize(groove.tempo, INIConfig::LayoutConstants::midiFileManagerTempoEstimateMin,
+                                          INIConfig::LayoutConstants::midiFileManagerTempoEstimateMax);
+    features[1] = swingWeight * normalize(groove.averageSwing, INIConfig::LayoutConstants::midiFileManagerSwingMin,
+                                          INIConfig::LayoutConstants::midiFileManagerSwingMax);
+    features[2] = tightnessWeight * normalize(groove.grooveTightness, 0.0f, 1.0f);
+    features[3] = velocityWeight * normalize(groove.averageVelocity, 0.0f, maxVelocity);
+    features[4] = velocityRangeWeight * normalize(groove.velocityRange, 0.0f, maxVelocity);
+    features[5] = velocityVariationWeight * normalize(groove.velocityVariation, 0.0f, maxVelocity / 2.0f);
+    features[6] = timingDeviationWeight * normalize(groove.timingDeviation, 0.0f, 1.0f);
+    features[7] = densityWeight * normalize(groove.noteDensity, 0.0f, INIConfig::MIDI::GROOVE_MAX_NOTE_DENSITY);
+    features[8] = meterWeight * normalize(meter, 0.0f, 2.0f);
+
+    // Share of the hits on each note, lowest first, folded into a fixed number of bins
+    const int numBins = INIConfig::MIDI::GROOVE_DISTRIBUTION_BINS;
+    float* distribution = features + numScalarFeatures;
+    std::fill(distribution, distribution + numBins, 0.0f);
+
+    const int numNotes = groove.noteDistribution.size();
+    float totalHits = 0.0f;
+    for (int i = 0; i < numNotes; ++i) {
+        const float hits = static_cast<float>(juce::jmax(0, groove.noteDistribution[i]));
+        distribution[numNotes <= numBins ? i : i * numBins / numNotes] += hits;
+        totalHits += hits;
+    }
+
+    if (totalHits > 0.0f) {
+        for (int bin = 0; bin < numBins; ++bin) {
+            distribution[bin] *= distributionWeight / totalHits;
+        }
+    }
+
+    // Average offset over each stretch of the pattern; no timing data reads as dead on the grid
+    const int numTimingBins = INIConfig::MIDI::GROOVE_MICRO_TIMING_BINS;
+    float* microTiming = distribution + numBins;
+
+    const int numTimings = groove.microTiming.size();
+    for (int bin = 0; bin < numTimingBins; ++bin) {
+        float offset = 0.0f;
+
+        if (numTimings > 0) {
+            const int first = bin * numTimings / numTimingBins;
+            const int last = juce::jmax(first + 1, (bin + 1) * numTimings / numTimingBins);
+            for (int i = first; i < last; ++i) {
+                offset += groove.microTiming[i];
+            }
+            offset /= static_cast<float>(last - first);
+        }
+
+        microTiming[bin] = microTimingWeight * normalize(offset, -0.5f, 0.5f);
+    }
+}
+
+float GrooveSimilarityIndex::getScore(const MidiGrooveAnalysis& a, const MidiGrooveAnalysis& b) {
+    float difference[numFeatures];
+    float other[numFeatures];
+    getFeatures(a, difference);
+    getFeatures(b, other);
+
+    juce::FloatVectorOperations::subtract(difference, other, numFeatures);
+    const float distance = std::sqrt(std::inner_product(difference, difference + numFeatures, difference, 0.0f));
+    return juce::jlimit(0.0f, 1.0f, 1.0f - distance);
+}
+
+void GrooveSimilarityIndex::clear() {
+    pending.clear();
+    build();
+}
+
+void GrooveSimilarityIndex::reserve(int numGrooves) {
+    pending.reserve(static_cast<size_t>(numGrooves) * numFeatures);
+}
+
+void GrooveSimilarityIndex::add(const MidiGrooveAnalysis& groove) {
+    pending.resize(pending.size() + numFeatures);
+    getFeatures(groove, pending.data() + pending.size() - numFeatures);
+}
+
+void GrooveSimilarityIndex::build(bool useCoarseLists) {
+    numRows = static_cast<int>(pending.size() / numFeatures);
+    const auto stride = static_cast<size_t>(numRows);
+
+    columns.assign(stride * numFeatures, 0.0f);
+    norms.assign(stride, 0.0f);
+    rowIndices.resize(stride);
+    std::iota(rowIndices.begin(), rowIndices.end(), 0);
+
+    for (size_t row = 0; row < stride; ++row) {
+        const float* features = pending.data() + row * numFeatures;
+        for (size_t feature = 0; feature < static_cast<size_t>(numFeatures); ++feature) {
+            columns[feature * stride + row] = features[feature];
+            norms[row] += features[feature] * features[feature];
+        }
+    }
+
+    centroidColumns.clear();
+    centroidNorms.clear();
+    listStarts.clear();
+
+    if (useCoarseLists && numRows > 0) {
+        buildCoarseLists();
+    }
+}
+
+juce::Array<GrooveSimilarityIndex::Match> GrooveSimilarityIndex::findNearest(const MidiGrooveAnalysis& target,
+                                                                           int maxMatches, int excludeIndex) const {
+    if (maxMatches <= 0 || numRows == 0) return {};
+
+    float query[numFeatures];
+    getFeatures(target, query);
+    const float queryNorm = std::inner_product(query, query + numFeatures, query, 0.0f);
+
+    Selection selection(maxMatches);
+
+    if (!usesCoarseLists()) {
+        scanRows(0, numRows, query, excludeIndex, selection);
+        return selection.getMatches(queryNorm);
+    }
+
+    // Only the lists whose centroids are nearest the query are read
+    const int numLists = static_cast<int>(listStarts.size()) - 1;
+    std::vector<float> listDistances(static_cast<size_t>(numLists));
+    scan(centroidColumns.data(), centroidNorms.data(), numLists, 0, numLists, query, listDistances.data());
+
+    std::vector<int> lists(static_cast<size_t>(numLists));
+    std::iota(lists.begin(), lists.end(), 0);
+
+    const int numProbes = juce::jmin(INIConfig::MIDI::GROOVE_COARSE_PROBES, numLists);
+    std::partial_sort(lists.begin(), lists.begin() + numProbes, lists.end(), [&listDistances](int a, int b) {
+        return listDistances[static_cast<size_t>(a)] < listDistances[static_cast<size_t>(b)];
+    });
+
+    for (int probe = 0; probe < numProbes; ++probe) {
+        const auto list = static_cast<size_t>(lists[static_cast<size_t>(probe)]);
+        scanRows(listStarts[list], listStarts[list + 1], query, excludeIndex, selection);
+    }
+    return selection.getMatches(queryNorm);
+}
+
+void GrooveSimilarityIndex::scan(const float* matrix, const float* matrixNorms, int stride, int begin, int end,
+                                 const float* query, float* distances) {
+    // |x - q|^2 - |q|^2 = |x|^2 - 2 x.q, one multiply-add over the block per feature
+    const int count = end - begin;
+    juce::FloatVectorOperations::copy(distances, matrixNorms + begin, count);
+
+    for (int feature = 0; feature < numFeatures; ++feature) {
+        // Most distribution bins are empty
+        if (query[feature] == 0.0f) continue;
+
+        const float* column = matrix + static_cast<size_t>(feature) * static_cast<size_t>(stride) + static_cast<size_t>(begin);
+        juce::FloatVectorOperations::addWithMultiply(distances, column, -2.0f * query[feature], count);
+    }
+}
+
+void GrooveSimilarityIndex::scanRows(int begin, int end, const float* query, int excludeIndex, Selection& selection) const {
+    // Blocks small enough that the distances stay in cache between features
+    float distances[INIConfig::MIDI::GROOVE_SCAN_BLOCK];
+
+    for (int blockStart = begin; blockStart < end; blockStart += INIConfig::MIDI::GROOVE_SCAN_BLOCK) {
+        const int blockEnd = juce::jmin(end, blockStart + INIConfig::MIDI::GROOVE_SCAN_BLOCK);
+        scan(columns.data(), norms.data(), numRows, blockStart, blockEnd, query, distances);
+
+        for (int row = blockStart; row < blockEnd; ++row) {
+            const int index = rowIndices[static_cast<size_t>(row)];
+            if (index != excludeIndex) {
+                selection.offer(distances[row - blockStart], index);
+            }
+        }
+    }
+}
+
+void GrooveSimilarityIndex::buildCoarseLists() {
+    const int numLists = juce::jmax(1, static_cast<int>(std::sqrt(static_cast<double>(numRows))));
+    const auto features = static_cast<size_t>(numFeatures);
+
+    // Seeded from grooves spread evenly through the library, so a build is repeatable
+    std::vector<float> centroids(static_cast<size_t>(numLists) * features);
+    for (int list = 0; list < numLists; ++list) {
+        const auto seed = static_cast<size_t>(static_cast<juce::int64>(list) * numRows / numLists);
+        std::copy_n(pending.data() + seed * features, features, centroids.data() + static_cast<size_t>(list) * features);
+    }
+
+    std::vector<int> nearest(static_cast<size_t>(numRows));
+    std::vector<float> listDistances(static_cast<size_t>(numLists));
+
+    auto assign = [&](int step) {
+        setCentroids(centroids, numLists);
+
+        for (int row = 0; row < numRows; row += step) {
+            scan(centroidColumns.data(), centroidNorms.data(), numLists, 0, numLists,
+                 pending.data() + static_cast<size_t>(row) * features, listDistances.data());
+            nearest[static_cast<size_t>(row)] = static_cast<int>(std::min_element(listDistances.begin(), listDistances.end())
+                                                                 - listDistances.begin());
+        }
+    };
+
+    // Trained on an even sample; a list left empty keeps its centroid
+    const int sampleStep = juce::jmax(1, numRows / (numLists * INIConfig::MIDI::GROOVE_COARSE_TRAINING_PER_LIST));
+
+    for (int iteration = 0; iteration < INIConfig::MIDI::GROOVE_COARSE_ITERATIONS; ++iteration) {
+        assign(sampleStep);
+
+        std::vector<float> sums(centroids.size(), 0.0f);
+        std::vector<int> counts(static_cast<size_t>(numLists), 0);
+
+        for (int row = 0; row < numRows; row += sampleStep) {
+            const auto list = static_cast<size_t>(nearest[static_cast<size_t>(row)]);
+            const float* source = pending.data() + static_cast<size_t>(row) * features;
+            std::transform(source, source + features, sums.data() + list * features, sums.data() + list * features, std::plus<float>());
+            ++counts[list];
+        }
+
+        for (size_t list = 0; list < static_cast<size_t>(numLists); ++list) {
+            if (counts[list] == 0) continue;
+
+            for (size_t feature = 0; feature < features; ++feature) {
+                centroids[list * features + feature] = sums[list * features + feature] / static_cast<float>(counts[list]);
+            }
+        }
+    }
+
+    assign(1);
+
+    // Rows regrouped so each list is one contiguous range of every column
+    listStarts.assign(static_cast<size_t>(numLists) + 1, 0);
+    for (int list : nearest) {
+        ++listStarts[static_cast<size_t>(list) + 1];
+    }
+    std::partial_sum(listStarts.begin(), listStarts.end(), listStarts.begin());
+
+    std::vector<int> next(listStarts.begin(), listStarts.end() - 1);
+    const auto stride = static_cast<size_t>(numRows);
+    const auto unsortedNorms = std::exchange(norms, std::vector<float>(stride));
+
+    for (size_t row = 0; row < stride; ++row) {
+        const auto target = static_cast<size_t>(next[static_cast<size_t>(nearest[row])]++);
+        rowIndices[target] = static_cast<int>(row);
+        norms[target] = unsortedNorms[row];
+
+        for (size_t feature = 0; feature < features; ++feature) {
+            columns[feature * stride + target] = pending[row * features + feature];
+        }
+    }
+}
+
+void GrooveSimilarityIndex::setCentroids(const std::vector<float>& centroids, int numLists) {
+    const auto stride = static_cast<size_t>(numLists);
+    const auto features = static_cast<size_t>(numFeatures);
+
+    centroidColumns.assign(stride * features, 0.0f);
+    centroidNorms.assign(stride, 0.0f);
+
+    for (size_t list = 0; list < stride; ++list) {
+        for (size_t feature = 0; feature < features; ++feature) {
+            const float value = centroids[list * features + feature];
+            centroidColumns[feature * stride + list] = value;
+            centroidNorms[list] += value * value;
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "INIConfig.h"
+#include "MidiAnalysisTypes.h"
+
+// Nearest-neighbour search over groove analyses. Each analysis becomes a fixed-length
+// vector of weighted, normalized features, so the distance between two grooves is the
+// L2 distance between their vectors. The vectors are stored a feature at a time, which
+// turns a query into a few vectorized multiply-adds per feature over whole blocks of
+// grooves, followed by a bounded selection of the closest. With coarse lists the
+// grooves are also clustered and a query only scans the clusters nearest to it, which
+// trades exactness for speed on very large libraries. Not thread-safe.
+class GrooveSimilarityIndex {
+public:
+    struct Match {
+        // Position in the order the grooves were added
+        int index = -1;
+        // 1 for an identical groove, falling towards 0 with distance
+        float score = 0.0f;
+    };
+
+    static constexpr int numScalarFeatures = 9;
+    static constexpr int numFeatures = numScalarFeatures
+                                     + INIConfig::MIDI::GROOVE_DISTRIBUTION_BINS
+                                     + INIConfig::MIDI::GROOVE_MICRO_TIMING_BINS;
+
+    GrooveSimilarityIndex() = default;
+
+    static void getFeatures(const MidiGrooveAnalysis& groove, float* features);
+    // The score findNearest() gives one groove as a match for the other
+    static float getScore(const MidiGrooveAnalysis& a, const MidiGrooveAnalysis& b);
+
+    void clear();
+    void reserve(int numGrooves);
+    // Searchable after the next build()
+    void add(const MidiGrooveAnalysis& groove);
+    void build(bool useCoarseLists = false);
+
+    int size() const { return numRows; }
+    bool usesCoarseLists() const { return !listStarts.empty(); }
+
+    // Closest first, leaving out excludeIndex
+    juce::Array<Match> findNearest(const MidiGrooveAnalysis& target, int maxMatches, int excludeIndex = -1) const;
+
+private:
+    class Selection;
+
+    // Features one after another per groove, as added
+    std::vector<float> pending;
+
+    // Feature f of row r is columns[f * numRows + r]; rows are grouped by coarse list
+    int numRows = 0;
+    std::vector<float> columns;
+    std::vector<float> norms;
+    std::vector<int> rowIndices;
+
+    // Coarse lists: centroid columns as above, and the rows of list l in [listStarts[l], listStarts[l + 1])
+    std::vector<float> centroidColumns;
+    std::vector<float> centroidNorms;
+    std::vector<int> listStarts;
+
+    // Squared distance from query to rows [begin, end) of a matrix laid out as above, less the query's own norm
+    static void scan(const float* matrix, const float* matrixNorms, int stride, int begin, int end,
+                     const float* query, float* distances);
+    void scanRows(int begin, int end, const float* query, int excludeIndex, Selection& selection) const;
+    void buildCoarseLists();
+    void setCentroids(const std::vector<float>& centroids, int numLists);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GrooveSimilarityIndex)
+};
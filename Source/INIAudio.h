@@ -43,6 +43,79 @@ namespace INIConfig {
        static const float DEFAULT_SAMPLERATE_REDUCTION = 1.0f;
        static const float DEFAULT_PRE_GAIN = 0.0f;
        static const float DEFAULT_POST_GAIN = 0.0f;
+
+       // Per-channel insert chain
+       static const int NUM_INSERT_SLOTS = 5;
+       static const float INSERT_EQ_LOW_FREQ = 80.0f;
+       static const float INSERT_EQ_MID_FREQ = 1000.0f;
+       static const float INSERT_EQ_HIGH_FREQ = 8000.0f;
+       static const float INSERT_EQ_Q = 0.7f;
+       static const float INSERT_EQ_MAX_GAIN = 18.0f;
+       static const float INSERT_TRANSIENT_FAST_MS = 1.0f;
+       static const float INSERT_TRANSIENT_SLOW_MS = 30.0f;
+       static const float INSERT_TRANSIENT_MAX_GAIN = 4.0f;
+       static const float DEFAULT_INSERT_COMP_THRESHOLD = -18.0f;
+       static const float DEFAULT_INSERT_COMP_RATIO = 4.0f;
+       static const float DEFAULT_INSERT_COMP_ATTACK = 5.0f;
+       static const float DEFAULT_INSERT_COMP_RELEASE = 80.0f;
+       static const float DEFAULT_INSERT_SAT_DRIVE = 2.0f;
+       static const float DEFAULT_INSERT_SAT_MIX = 1.0f;
+       static const float DEFAULT_INSERT_GATE_THRESHOLD = -50.0f;
+       static const float DEFAULT_INSERT_GATE_ATTACK = 0.5f;
+       static const float DEFAULT_INSERT_GATE_HOLD = 20.0f;
+       static const float DEFAULT_INSERT_GATE_RELEASE = 100.0f;
+       static const float DEFAULT_INSERT_GATE_RANGE = -60.0f;
+
+       // Parameter smoothing
+       static const double PARAMETER_SMOOTHING_SECONDS = 0.05;
+       static const int PARAMETER_SMOOTHING_SUBBLOCK = 32;
+
+       // Master true-peak limiter
+       static const float MIN_LIMITER_LOOKAHEAD_MS = 0.5f;
+       static const float MAX_LIMITER_LOOKAHEAD_MS = 20.0f;
+
+       // Offline (non-realtime) rendering
+       static const int OFFLINE_RENDER_BLOCK_SIZE = 8192;
+
+       // Background mix analysis for the auto-mix assistant
+       static const int MIX_ANALYSIS_DECIMATION = 2;
+       static const int MIX_ANALYSIS_FFT_ORDER = 10;
+       static const int MIX_ANALYSIS_NUM_BANDS = 8;
+       static const int MIX_ANALYSIS_INTERVAL_MS = 50;
+       static const double MIX_ANALYSIS_RING_SECONDS = 0.5;
+       static const float MIX_ANALYSIS_SMOOTHING = 0.3f;
+       static const float MIX_ANALYSIS_SILENCE_RMS = 1.0e-4f;
+       // Where the measured bands split into the mixer's low, mid and high EQ
+       static const float MIX_ANALYSIS_LOW_MID_HZ = 250.0f;
+       static const float MIX_ANALYSIS_MID_HIGH_HZ = 4000.0f;
+       // Spectral overlap above which two channels are moved apart
+       static const float MIX_ANALYSIS_MASKING_THRESHOLD = 0.5f;
+       // Master crest factors from a squashed mix (a sine) to an open, uncompressed one
+       static const float MIX_ANALYSIS_MIN_CREST_DB = 3.0f;
+       static const float MIX_ANALYSIS_MAX_CREST_DB = 20.0f;
+
+       // Sample kit import: what sorts loose one-shots onto drums and into velocity layers
+       static const int SAMPLE_IMPORT_MAX_THREADS = 8;
+       static const int SAMPLE_IMPORT_PROGRESS_INTERVAL_MS = 50;
+       static const int SAMPLE_IMPORT_CACHE_MAGIC = 0x4B53544F;
+       static const int SAMPLE_IMPORT_CACHE_VERSION = 1;
+       static const double SAMPLE_IMPORT_MAX_SECONDS = 10.0;
+       static const int SAMPLE_IMPORT_FFT_ORDER = 11;
+       static const int SAMPLE_IMPORT_ENVELOPE_HOP = 256;
+       static const double SAMPLE_IMPORT_ATTACK_SECONDS = 0.05;
+       static const double SAMPLE_IMPORT_CENTROID_SECONDS = 0.1;
+       static const float SAMPLE_IMPORT_SILENCE_PEAK = 1.0e-4f;
+       static const float SAMPLE_IMPORT_ONSET_THRESHOLD = 0.1f;
+       static const float SAMPLE_IMPORT_DECAY_FLOOR = 0.01f;
+       static const float SAMPLE_IMPORT_KICK_MAX_CENTROID = 200.0f;
+       static const float SAMPLE_IMPORT_TOM_MAX_CENTROID = 800.0f;
+       static const float SAMPLE_IMPORT_CYMBAL_MIN_CENTROID = 5000.0f;
+       static const float SAMPLE_IMPORT_PERC_MAX_DECAY = 0.06f;
+       static const float SAMPLE_IMPORT_RIDE_MIN_DECAY = 0.5f;
+       static const float SAMPLE_IMPORT_CRASH_MIN_DECAY = 1.5f;
+       static const float SAMPLE_IMPORT_TOM_PITCH_RATIO = 1.25f;
+       static const float SAMPLE_IMPORT_ROUND_ROBIN_DB = 1.5f;
+       static const int SAMPLE_IMPORT_MAX_VELOCITY_LAYERS = 16;
    } // namespace Audio
 
 } // namespace INIConfig
\ No newline at end of file
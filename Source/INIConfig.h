@@ -431,6 +431,28 @@ namespace INIConfig {
     /** @brief Cached MIDI file analysis data for performance optimization */
     static const juce::String MIDI_ANALYSIS_CACHE_FILE = "MidiAnalysisCache.ini";
 
+    /** @brief Binary groove analysis cache for the whole MIDI library, keyed by path, size and time */
+    static const juce::String MIDI_ANALYSIS_BINARY_CACHE_FILE = "MidiAnalysisCache.bin";
+
+    /** @brief Every library pattern compiled to flat note records in one memory-mapped file */
+    static const juce::String PATTERN_BANK_FILE = "PatternBank.bin";
+
+    /** @brief Measurements of an imported kit's samples, kept in the kit's own folder */
+    static const juce::String SAMPLE_KIT_CACHE_FILE = "SampleKit.bin";
+
+    // ========================================================================
+    // ASSETS FOLDERS
+    // ========================================================================
+
+    /** @brief Groove library shipped with the assets; cached paths inside it are stored relative to it */
+    static const juce::String MIDI_LIBRARY_FOLDER = "MidiFiles/Grooves";
+
+    /** @brief Drum kits shipped with the assets, one folder of SFZ files per kit */
+    static const juce::String DRUMKITS_FOLDER = "Drumkits";
+
+    /** @brief Analysis cache and pattern bank prebuilt for the assets by otto-batch-analyzer */
+    static const juce::String PREBUILT_CACHE_FOLDER = "Cache";
+
     // ========================================================================
     // LEGACY COMPATIBILITY FILES
     // ========================================================================
@@ -707,7 +729,7 @@ namespace INIConfig {
         static const juce::String DEFAULT_TIME_SIGNATURE = "4/4";
 
         static const int MAX_PLAYERS = 8;
-        static const int MAX_SCENES = 8;
+        static const int MAX_SCENES = 64;
         static const int MAX_COUNT_IN_BARS = 8;
         static const double BEATS_PER_BAR = 4.0;
         static const double MS_PER_MINUTE = 60000.0;
@@ -1880,6 +1902,13 @@ namespace LayoutConstants {
    constexpr int midiEngineMaxMidiChannels = 16;
    constexpr int midiEngineMaxMidiVelocity = 127;
    constexpr int midiEngineMetronomeChannel = 10;
+   constexpr int midiEngineEventTimerHz = 30;
+   constexpr int midiOutputThreadStopTimeoutMs = 1000;
+   constexpr int songArrangerThreadStopTimeoutMs = 1000;
+   constexpr int midiLibraryThreadStopTimeoutMs = 1000;
+   constexpr int patternPreloaderThreadStopTimeoutMs = 1000;
+   constexpr int mixAnalyzerThreadStopTimeoutMs = 1000;
+   constexpr int sampleImportThreadStopTimeoutMs = 10000;
 
    constexpr float velocityEditorSCurveFactor = 3.0f;
    constexpr int sampleEditControlsLabelWidthDivisor = 2;
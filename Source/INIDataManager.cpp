@@ -1705,6 +1705,8 @@ bool INIDataManager::createSamplePatternChains() {
        juce::StringArray chainLines;
        chainLines.add("chain_id=" + juce::String(i));
        chainLines.add("chain_name=Pattern Chain " + juce::String(i + 1));
+       chainLines.add("player_index=" + juce::String(i));
+       chainLines.add("chain_enabled=0");
        chainLines.add("pattern_count=4");
        chainLines.add("loop_enabled=1");
        chainLines.add("tempo_sync=1");
@@ -1713,6 +1715,7 @@ bool INIDataManager::createSamplePatternChains() {
            chainLines.add("pattern_" + juce::String(j) + "_id=" + juce::String(j));
            chainLines.add("pattern_" + juce::String(j) + "_bars=1");
            chainLines.add("pattern_" + juce::String(j) + "_repeat=1");
+           chainLines.add("pattern_" + juce::String(j) + "_fill=" + juce::String(INIConfig::MIDI::INACTIVE_PATTERN));
        }
 
        sectionData[sectionName] = chainLines;
@@ -1721,6 +1724,79 @@ bool INIDataManager::createSamplePatternChains() {
    return INIUtils::writeINIFile(file, sections, sectionData);
 }
 
+bool INIDataManager::loadPatternChains(juce::Array<SongArranger::Chain>& chains) {
+   auto file = getINIFilePath(INIConfig::PATTERN_CHAINS_FILE);
+   if (!file.existsAsFile()) {
+       return false;
+   }
+
+   std::map<juce::String, std::map<juce::String, juce::String>> data;
+   if (!INIUtils::readINIFile(file, data)) {
+       return false;
+   }
+
+   chains.clearQuick();
+   chains.resize(INIConfig::Defaults::MAX_PLAYERS);
+
+   try {
+       int chainCount = 0;
+       if (data.count("general") && data["general"].count("chain_count"))
+           chainCount = data["general"]["chain_count"].getIntValue();
+
+       // In chain order; the section map sorts chain_10 before chain_2
+       for (int i = 0; i < chainCount; ++i) {
+           juce::String sectionName = "chain_" + juce::String(i);
+           if (!data.count(sectionName))
+               continue;
+
+           auto& section = data[sectionName];
+           // Files from before chains played have no flag and only hold the samples
+           if (!section.count("chain_enabled") || !INIUtils::stringToBool(section["chain_enabled"]))
+               continue;
+
+           int playerIndex = i;
+           if (section.count("player_index"))
+               playerIndex = section["player_index"].getIntValue();
+           if (!INIConfig::isValidPlayerIndex(playerIndex))
+               continue;
+
+           SongArranger::Chain chain;
+
+           if (section.count("loop_enabled"))
+               chain.loop = INIUtils::stringToBool(section["loop_enabled"]);
+
+           int patternCount = 0;
+           if (section.count("pattern_count"))
+               patternCount = section["pattern_count"].getIntValue();
+
+           for (int j = 0; j < patternCount; ++j) {
+               juce::String prefix = "pattern_" + juce::String(j) + "_";
+               SongArranger::Step step;
+
+               if (section.count(prefix + "id"))
+                   step.patternIndex = section[prefix + "id"].getIntValue();
+               if (section.count(prefix + "bars"))
+                   step.bars = section[prefix + "bars"].getIntValue();
+               if (section.count(prefix + "repeat"))
+                   step.repeats = section[prefix + "repeat"].getIntValue();
+               if (section.count(prefix + "fill"))
+                   step.fillPatternIndex = section[prefix + "fill"].getIntValue();
+
+               if (INIConfig::isValidButtonIndex(step.patternIndex))
+                   chain.steps.add(step);
+           }
+
+           chains.set(playerIndex, chain);
+       }
+
+       return true;
+   }
+   catch (const std::exception& e) {
+       setError("Exception loading pattern chains: " + juce::String(e.what()));
+       return false;
+   }
+}
+
 bool INIDataManager::createSampleDrumKits() {
    auto file = getINIFilePath(INIConfig::DRUM_KITS_FILE);
 
@@ -34,6 +34,8 @@ public:
 
     bool createSamplePresets();
     bool createSamplePatternChains();
+    // Indexed by player; a player without an enabled chain gets one with no steps
+    bool loadPatternChains(juce::Array<SongArranger::Chain>& chains);
     bool createSampleDrumKits();
     bool createSampleMidiLayouts();
     bool createSampleChannelPresetGroups();
@@ -32,6 +32,57 @@ namespace INIConfig {
        static const int DEFAULT_FEEDBACK_TYPE = 0;
        static const int DEFAULT_SYSEX_DEVICE_ID = 0;
        static const int ALL_PLAYERS = -1;
+       static const int OMNI_CHANNEL = 0;
+       static const int NUM_CC_NUMBERS = 128;
+       static const int NUM_NOTE_NUMBERS = 128;
+       static const int MAX_CC_BINDINGS = 512;
+       static const int COMMAND_QUEUE_SIZE = 256;
+       static const int EVENT_QUEUE_SIZE = 128;
+       static const int AUTOMATION_QUEUE_SIZE = 64;
+       static const int MAX_SCHEDULED_LAUNCHES = 48;
+       static const int CLOCK_PPQN = 24;
+       static const double CLOCK_ACQUIRE_BANDWIDTH_HZ = 2.0;
+       static const double CLOCK_TRACK_BANDWIDTH_HZ = 0.25;
+       static const int CLOCK_LOCK_TICKS = 24;
+       static const int CLOCK_TIMEOUT_TICKS = 8;
+       static const int RECORD_QUEUE_SIZE = 4096;
+       static const int INPUT_TAP_QUEUE_SIZE = 1024;
+       static const int RETIRED_PATTERN_QUEUE_SIZE = 64;
+       static const int MIDI_OUT_QUEUE_SIZE = 1024;
+       static const int MIDI_OUT_POLL_MS = 1;
+       static const double MIDI_OUT_RESYNC_MS = 50.0;
+       static const double MIDI_OUT_CLOCK_SMOOTHING = 0.05;
+       static const int MAX_TEMPO_CHANGES = 64;
+       static const int MAX_METER_CHANGES = 32;
+       static const int MAX_METER_NUMERATOR = 32;
+       static const int MAX_METER_DENOMINATOR = 32;
+       static const int MAX_SECTION_EVENTS = 1024;
+       static const int SONG_SECTIONS_PER_PLAYER = 8;
+       static const int SONG_SECTION_QUEUE_SIZE = 16;
+       static const int SONG_PREFETCH_BARS = 4;
+       static const int SONG_ARRANGER_POLL_MS = 10;
+       static const juce::uint32 HUMANIZE_SEED = 0x4F54544Fu;
+       static const int LIBRARY_WATCH_POLL_MS = 100;
+       static const int LIBRARY_WATCH_BUFFER_SIZE = 16384;
+       static const int ANALYSIS_MAX_THREADS = 8;
+       static const int ANALYSIS_PROGRESS_INTERVAL_MS = 50;
+       static const int ANALYSIS_CACHE_MAGIC = 0x4147544F;
+       static const int ANALYSIS_CACHE_VERSION = 3;
+       static const int GROOVE_DISTRIBUTION_BINS = 16;
+       static const int GROOVE_MICRO_TIMING_BINS = 8;
+       static const float GROOVE_MAX_NOTE_DENSITY = 16.0f;
+       static const int GROOVE_SCAN_BLOCK = 1024;
+       static const int GROOVE_COARSE_PROBES = 8;
+       static const int GROOVE_COARSE_ITERATIONS = 6;
+       static const int GROOVE_COARSE_TRAINING_PER_LIST = 32;
+       static const juce::uint32 PATTERN_BANK_MAGIC = 0x4B425450u;
+       static const juce::uint32 PATTERN_BANK_VERSION = 4;
+       static const int PATTERN_BANK_TICKS_PER_BEAT = 960;
+       static const int PATTERN_PRELOAD_CAPACITY = 512;
+       static const int PATTERN_PRELOAD_NEIGHBOUR_GROUPS = 1;
+       static const int PATTERN_BATCH_MAX_THREADS = 8;
+       static const int PATTERN_BATCH_MAX_CANDIDATES = 1024;
+       static const int PATTERN_BATCH_WAIT_MS = 50;
    } // namespace MIDI
 
 } // namespace INIConfig
\ No newline at end of file
@@ -0,0 +1,376 @@
+#include "InsertEffectChain.h"
+#include <cmath>
+
+namespace InsertEffects {
+
+namespace {
+    float timeToCoefficient(float timeMs, double sampleRate) {
+        if (timeMs <= 0.0f || sampleRate <= 0.0)
+            return 0.0f;
+        return static_cast<float>(std::exp(-1000.0 / (static_cast<double>(timeMs) * sampleRate)));
+    }
+
+    float stereoPeak(float left, float right) noexcept {
+        return juce::jmax(std::abs(left), std::abs(right));
+    }
+}
+
+const std::array<ParameterInfo, NUM_PARAMETERS>& getParameterTable() {
+    static const std::array<ParameterInfo, NUM_PARAMETERS> table{{
+        {"eq_low", &ChainSettings::eqLowGain, -INIConfig::Audio::INSERT_EQ_MAX_GAIN, INIConfig::Audio::INSERT_EQ_MAX_GAIN},
+        {"eq_mid", &ChainSettings::eqMidGain, -INIConfig::Audio::INSERT_EQ_MAX_GAIN, INIConfig::Audio::INSERT_EQ_MAX_GAIN},
+        {"eq_high", &ChainSettings::eqHighGain, -INIConfig::Audio::INSERT_EQ_MAX_GAIN, INIConfig::Audio::INSERT_EQ_MAX_GAIN},
+        {"eq_mid_freq", &ChainSettings::eqMidFrequency, 200.0f, 5000.0f},
+        {"transient_attack", &ChainSettings::transientAttack, -1.0f, 1.0f},
+        {"transient_sustain", &ChainSettings::transientSustain, -1.0f, 1.0f},
+        {"comp_threshold", &ChainSettings::compThreshold, -60.0f, 0.0f},
+        {"comp_ratio", &ChainSettings::compRatio, 1.0f, 20.0f},
+        {"comp_attack", &ChainSettings::compAttack, 0.1f, 100.0f},
+        {"comp_release", &ChainSettings::compRelease, 5.0f, 1000.0f},
+        {"comp_makeup", &ChainSettings::compMakeup, 0.0f, 24.0f},
+        {"sat_drive", &ChainSettings::satDrive, 1.0f, 10.0f},
+        {"sat_mix", &ChainSettings::satMix, 0.0f, 1.0f},
+        {"gate_threshold", &ChainSettings::gateThreshold, -80.0f, 0.0f},
+        {"gate_attack", &ChainSettings::gateAttack, 0.01f, 50.0f},
+        {"gate_hold", &ChainSettings::gateHold, 0.0f, 500.0f},
+        {"gate_release", &ChainSettings::gateRelease, 5.0f, 2000.0f},
+        {"gate_range", &ChainSettings::gateRange, -80.0f, 0.0f}
+    }};
+    return table;
+}
+
+void sanitiseSettings(ChainSettings& settings) {
+    for (const auto& info : getParameterTable()) {
+        float& value = settings.*(info.member);
+        value = std::isfinite(value) ? juce::jlimit(info.minValue, info.maxValue, value) : info.minValue;
+    }
+
+    // The order must be a permutation of all insert types; fall back to the default otherwise
+    std::array<bool, NUM_SLOTS> seen{};
+    bool valid = true;
+    for (auto type : settings.order) {
+        const int index = static_cast<int>(type);
+        if (index < 0 || index >= NUM_SLOTS || seen[static_cast<size_t>(index)]) {
+            valid = false;
+            break;
+        }
+        seen[static_cast<size_t>(index)] = true;
+    }
+
+    if (!valid)
+        settings.order = ChainSettings().order;
+}
+
+Biquad Biquad::fromArray(const std::array<float, 6>& coefficients) {
+    Biquad biquad;
+    const float a0 = coefficients[3];
+    if (a0 == 0.0f || !std::isfinite(a0))
+        return biquad;
+
+    const float inverseA0 = 1.0f / a0;
+    biquad.b0 = coefficients[0] * inverseA0;
+    biquad.b1 = coefficients[1] * inverseA0;
+    biquad.b2 = coefficients[2] * inverseA0;
+    biquad.a1 = coefficients[4] * inverseA0;
+    biquad.a2 = coefficients[5] * inverseA0;
+    return biquad;
+}
+
+//==============================================================================
+EQProcessor::Parameters EQProcessor::compile(const ChainSettings& settings, double sampleRate) {
+    using Coeffs = juce::dsp::IIR::ArrayCoefficients<float>;
+
+    Parameters params;
+    const float gains[NUM_BANDS] = {settings.eqLowGain, settings.eqMidGain, settings.eqHighGain};
+
+    for (int band = 0; band < NUM_BANDS; ++band) {
+        // Flat bands are left out of the layout entirely
+        if (gains[band] == 0.0f)
+            continue;
+
+        const float gainFactor = juce::Decibels::decibelsToGain(gains[band]);
+        std::array<float, 6> raw;
+
+        if (band == 0)
+            raw = Coeffs::makeLowShelf(sampleRate, INIConfig::Audio::INSERT_EQ_LOW_FREQ, INIConfig::Audio::INSERT_EQ_Q, gainFactor);
+        else if (band == 1)
+            raw = Coeffs::makePeakFilter(sampleRate, settings.eqMidFrequency, INIConfig::Audio::INSERT_EQ_Q, gainFactor);
+        else
+            raw = Coeffs::makeHighShelf(sampleRate, INIConfig::Audio::INSERT_EQ_HIGH_FREQ, INIConfig::Audio::INSERT_EQ_Q, gainFactor);
+
+        params.bands[static_cast<size_t>(params.numBands)] = Biquad::fromArray(raw);
+        params.bandIndex[static_cast<size_t>(params.numBands)] = band;
+        ++params.numBands;
+    }
+
+    return params;
+}
+
+void EQProcessor::reset() noexcept {
+    for (auto& band : state)
+        for (auto& channel : band)
+            channel = FilterState();
+}
+
+void EQProcessor::process(const Parameters& params, float* left, float* right, int numSamples) noexcept {
+    for (int b = 0; b < params.numBands; ++b) {
+        const auto& c = params.bands[static_cast<size_t>(b)];
+        auto& bandState = state[static_cast<size_t>(params.bandIndex[static_cast<size_t>(b)])];
+        float* channels[2] = {left, right};
+
+        for (int ch = 0; ch < 2; ++ch) {
+            float* data = channels[ch];
+            float z1 = bandState[static_cast<size_t>(ch)].z1;
+            float z2 = bandState[static_cast<size_t>(ch)].z2;
+
+            for (int i = 0; i < numSamples; ++i) {
+                const float x = data[i];
+                const float y = c.b0 * x + z1;
+                z1 = c.b1 * x - c.a1 * y + z2;
+                z2 = c.b2 * x - c.a2 * y;
+                data[i] = y;
+            }
+
+            bandState[static_cast<size_t>(ch)].z1 = z1;
+            bandState[static_cast<size_t>(ch)].z2 = z2;
+        }
+    }
+}
+
+//==============================================================================
+TransientShaperProcessor::Parameters TransientShaperProcessor::compile(const ChainSettings& settings, double sampleRate) {
+    Parameters params;
+    params.fastCoeff = timeToCoefficient(INIConfig::Audio::INSERT_TRANSIENT_FAST_MS, sampleRate);
+    params.slowCoeff = timeToCoefficient(INIConfig::Audio::INSERT_TRANSIENT_SLOW_MS, sampleRate);
+    params.attackAmount = settings.transientAttack * (INIConfig::Audio::INSERT_TRANSIENT_MAX_GAIN - 1.0f);
+    params.sustainAmount = settings.transientSustain * (INIConfig::Audio::INSERT_TRANSIENT_MAX_GAIN - 1.0f);
+    return params;
+}
+
+void TransientShaperProcessor::reset() noexcept {
+    fastEnvelope = 0.0f;
+    slowEnvelope = 0.0f;
+}
+
+void TransientShaperProcessor::process(const Parameters& params, float* left, float* right, int numSamples) noexcept {
+    float fast = fastEnvelope;
+    float slow = slowEnvelope;
+
+    for (int i = 0; i < numSamples; ++i) {
+        const float level = stereoPeak(left[i], right[i]);
+        fast = level + params.fastCoeff * (fast - level);
+        slow = level + params.slowCoeff * (slow - level);
+
+        // Positive while the fast follower leads (attack), negative in the decay
+        const float difference = (fast - slow) / (juce::jmax(fast, slow) + 1.0e-6f);
+        const float amount = difference > 0.0f ? params.attackAmount : -params.sustainAmount;
+        const float gain = juce::jlimit(0.0f, INIConfig::Audio::INSERT_TRANSIENT_MAX_GAIN, 1.0f + amount * difference);
+
+        left[i] *= gain;
+        right[i] *= gain;
+    }
+
+    fastEnvelope = fast;
+    slowEnvelope = slow;
+}
+
+//==============================================================================
+CompressorProcessor::Parameters CompressorProcessor::compile(const ChainSettings& settings, double sampleRate) {
+    Parameters params;
+    params.thresholdDb = settings.compThreshold;
+    params.slope = 1.0f - 1.0f / juce::jmax(1.0f, settings.compRatio);
+    params.attackCoeff = timeToCoefficient(settings.compAttack, sampleRate);
+    params.releaseCoeff = timeToCoefficient(settings.compRelease, sampleRate);
+    params.makeupGain = juce::Decibels::decibelsToGain(settings.compMakeup);
+    return params;
+}
+
+void CompressorProcessor::reset() noexcept {
+    envelope = 0.0f;
+}
+
+void CompressorProcessor::process(const Parameters& params, float* left, float* right, int numSamples) noexcept {
+    float env = envelope;
+
+    for (int i = 0; i < numSamples; ++i) {
+        const float level = stereoPeak(left[i], right[i]);
+        const float coeff = level > env ? params.attackCoeff : params.releaseCoeff;
+        env = level + coeff * (env - level);
+
+        float gain = params.makeupGain;
+        const float overDb = juce::Decibels::gainToDecibels(env) - params.thresholdDb;
+        if (overDb > 0.0f)
+            gain *= juce::Decibels::decibelsToGain(-overDb * params.slope);
+
+        left[i] *= gain;
+        right[i] *= gain;
+    }
+
+    envelope = env;
+}
+
+//==============================================================================
+SaturationProcessor::Parameters SaturationProcessor::compile(const ChainSettings& settings, double) {
+    Parameters params;
+    params.drive = juce::jmax(1.0f, settings.satDrive);
+    params.normaliser = 1.0f / std::tanh(params.drive);
+    params.mix = settings.satMix;
+    return params;
+}
+
+void SaturationProcessor::process(const Parameters& params, float* left, float* right, int numSamples) noexcept {
+    for (int i = 0; i < numSamples; ++i) {
+        const float wetLeft = std::tanh(left[i] * params.drive) * params.normaliser;
+        const float wetRight = std::tanh(right[i] * params.drive) * params.normaliser;
+        left[i] += params.mix * (wetLeft - left[i]);
+        right[i] += params.mix * (wetRight - right[i]);
+    }
+}
+
+//==============================================================================
+GateProcessor::Parameters GateProcessor::compile(const ChainSettings& settings, double sampleRate) {
+    Parameters params;
+    params.threshold = juce::Decibels::decibelsToGain(settings.gateThreshold);
+    params.attackCoeff = timeToCoefficient(settings.gateAttack, sampleRate);
+    params.releaseCoeff = timeToCoefficient(settings.gateRelease, sampleRate);
+    params.floorGain = juce::Decibels::decibelsToGain(settings.gateRange);
+    params.holdSamples = static_cast<int>(settings.gateHold * 0.001 * sampleRate);
+    return params;
+}
+
+void GateProcessor::reset() noexcept {
+    gain = 0.0f;
+    holdCounter = 0;
+}
+
+void GateProcessor::process(const Parameters& params, float* left, float* right, int numSamples) noexcept {
+    float currentGain = juce::jmax(gain, params.floorGain);
+    int hold = holdCounter;
+
+    for (int i = 0; i < numSamples; ++i) {
+        float target = params.floorGain;
+
+        if (stereoPeak(left[i], right[i]) >= params.threshold) {
+            hold = params.holdSamples;
+            target = 1.0f;
+        } else if (hold > 0) {
+            --hold;
+            target = 1.0f;
+        }
+
+        const float coeff = target > currentGain ? params.attackCoeff : params.releaseCoeff;
+        currentGain = target + coeff * (currentGain - target);
+
+        left[i] *= currentGain;
+        right[i] *= currentGain;
+    }
+
+    gain = currentGain;
+    holdCounter = hold;
+}
+
+//==============================================================================
+InsertChain::InsertChain() {
+    publishLayout();
+}
+
+void InsertChain::prepare(double newSampleRate) {
+    {
+        const juce::SpinLock::ScopedLockType lock(settingsLock);
+        sampleRate = newSampleRate;
+    }
+
+    publishLayout();
+    reset();
+}
+
+void InsertChain::reset() noexcept {
+    for (int i = 0; i < NUM_SLOTS; ++i)
+        resetProcessor(static_cast<Type>(i));
+}
+
+void InsertChain::setSettings(const ChainSettings& newSettings) {
+    {
+        const juce::SpinLock::ScopedLockType lock(settingsLock);
+        settings = newSettings;
+        sanitiseSettings(settings);
+    }
+
+    publishLayout();
+}
+
+ChainSettings InsertChain::getSettings() const {
+    const juce::SpinLock::ScopedLockType lock(settingsLock);
+    return settings;
+}
+
+InsertChain::Layout InsertChain::compile(const ChainSettings& settings, double sampleRate) {
+    Layout layout;
+
+    for (auto type : settings.order) {
+        if (!settings.isEnabled(type))
+            continue;
+
+        layout.slots[static_cast<size_t>(layout.numActive++)] = type;
+        layout.activeMask |= 1u << static_cast<juce::uint32>(type);
+    }
+
+    layout.eq = EQProcessor::compile(settings, sampleRate);
+    layout.transient = TransientShaperProcessor::compile(settings, sampleRate);
+    layout.compressor = CompressorProcessor::compile(settings, sampleRate);
+    layout.saturation = SaturationProcessor::compile(settings, sampleRate);
+    layout.gate = GateProcessor::compile(settings, sampleRate);
+    return layout;
+}
+
+void InsertChain::publishLayout() {
+    // The lock serialises writers only; the audio thread never takes it
+    const juce::SpinLock::ScopedLockType lock(settingsLock);
+    layouts.getWriteBuffer() = compile(settings, sampleRate);
+    layouts.publish();
+}
+
+void InsertChain::resetProcessor(Type type) noexcept {
+    switch (type) {
+        case Type::EQ:              std::get<0>(processors).reset(); break;
+        case Type::TransientShaper: std::get<1>(processors).reset(); break;
+        case Type::Compressor:      std::get<2>(processors).reset(); break;
+        case Type::Saturation:      std::get<3>(processors).reset(); break;
+        case Type::Gate:            std::get<4>(processors).reset(); break;
+        default: break;
+    }
+}
+
+void InsertChain::processSlot(Type type, const Layout& layout, float* left, float* right, int numSamples) noexcept {
+    switch (type) {
+        case Type::EQ:              std::get<0>(processors).process(layout.eq, left, right, numSamples); break;
+        case Type::TransientShaper: std::get<1>(processors).process(layout.transient, left, right, numSamples); break;
+        case Type::Compressor:      std::get<2>(processors).process(layout.compressor, left, right, numSamples); break;
+        case Type::Saturation:      std::get<3>(processors).process(layout.saturation, left, right, numSamples); break;
+        case Type::Gate:            std::get<4>(processors).process(layout.gate, left, right, numSamples); break;
+        default: break;
+    }
+}
+
+void InsertChain::process(float* left, float* right, int numSamples) noexcept {
+    if (layouts.update()) {
+        // Inserts that were bypassed start again from a clean state
+        const juce::uint32 activeMask = layouts.read().activeMask;
+        const juce::uint32 newlyActive = activeMask & ~lastActiveMask;
+
+        for (int i = 0; i < NUM_SLOTS; ++i)
+            if ((newlyActive & (1u << static_cast<juce::uint32>(i))) != 0)
+                resetProcessor(static_cast<Type>(i));
+
+        lastActiveMask = activeMask;
+    }
+
+    const auto& layout = layouts.read();
+    if (layout.numActive == 0 || left == nullptr || right == nullptr)
+        return;
+
+    for (int slot = 0; slot < layout.numActive; ++slot)
+        processSlot(layout.slots[static_cast<size_t>(slot)], layout, left, right, numSamples);
+}
+
+} // namespace InsertEffects
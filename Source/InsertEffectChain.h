@@ -0,0 +1,204 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <tuple>
+#include "INIConfig.h"
+#include "LockFreeStructures.h"
+
+namespace InsertEffects {
+
+enum class Type {
+    EQ = 0,
+    TransientShaper,
+    Compressor,
+    Saturation,
+    Gate
+};
+
+static constexpr int NUM_SLOTS = INIConfig::Audio::NUM_INSERT_SLOTS;
+
+// Plain-value description of a chain, edited on the message thread and persisted.
+struct ChainSettings {
+    std::array<Type, NUM_SLOTS> order{{Type::EQ, Type::TransientShaper, Type::Compressor, Type::Saturation, Type::Gate}};
+    std::array<bool, NUM_SLOTS> enabled{};
+
+    float eqLowGain = 0.0f;
+    float eqMidGain = 0.0f;
+    float eqHighGain = 0.0f;
+    float eqMidFrequency = INIConfig::Audio::INSERT_EQ_MID_FREQ;
+
+    float transientAttack = 0.0f;
+    float transientSustain = 0.0f;
+
+    float compThreshold = INIConfig::Audio::DEFAULT_INSERT_COMP_THRESHOLD;
+    float compRatio = INIConfig::Audio::DEFAULT_INSERT_COMP_RATIO;
+    float compAttack = INIConfig::Audio::DEFAULT_INSERT_COMP_ATTACK;
+    float compRelease = INIConfig::Audio::DEFAULT_INSERT_COMP_RELEASE;
+    float compMakeup = 0.0f;
+
+    float satDrive = INIConfig::Audio::DEFAULT_INSERT_SAT_DRIVE;
+    float satMix = INIConfig::Audio::DEFAULT_INSERT_SAT_MIX;
+
+    float gateThreshold = INIConfig::Audio::DEFAULT_INSERT_GATE_THRESHOLD;
+    float gateAttack = INIConfig::Audio::DEFAULT_INSERT_GATE_ATTACK;
+    float gateHold = INIConfig::Audio::DEFAULT_INSERT_GATE_HOLD;
+    float gateRelease = INIConfig::Audio::DEFAULT_INSERT_GATE_RELEASE;
+    float gateRange = INIConfig::Audio::DEFAULT_INSERT_GATE_RANGE;
+
+    bool isEnabled(Type type) const { return enabled[static_cast<size_t>(type)]; }
+    void setEnabled(Type type, bool shouldBeEnabled) { enabled[static_cast<size_t>(type)] = shouldBeEnabled; }
+};
+
+struct ParameterInfo {
+    const char* key;
+    float ChainSettings::* member;
+    float minValue;
+    float maxValue;
+};
+
+static constexpr int NUM_PARAMETERS = 18;
+
+const std::array<ParameterInfo, NUM_PARAMETERS>& getParameterTable();
+void sanitiseSettings(ChainSettings& settings);
+
+struct Biquad {
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+    static Biquad fromArray(const std::array<float, 6>& coefficients);
+};
+
+class EQProcessor {
+public:
+    static constexpr int NUM_BANDS = 3;
+
+    struct Parameters {
+        std::array<Biquad, NUM_BANDS> bands;
+        std::array<int, NUM_BANDS> bandIndex{};
+        int numBands = 0;
+    };
+
+    static Parameters compile(const ChainSettings& settings, double sampleRate);
+    void reset() noexcept;
+    void process(const Parameters& params, float* left, float* right, int numSamples) noexcept;
+
+private:
+    struct FilterState { float z1 = 0.0f, z2 = 0.0f; };
+    std::array<std::array<FilterState, 2>, NUM_BANDS> state{};
+};
+
+class TransientShaperProcessor {
+public:
+    struct Parameters {
+        float fastCoeff = 0.0f;
+        float slowCoeff = 0.0f;
+        float attackAmount = 0.0f;
+        float sustainAmount = 0.0f;
+    };
+
+    static Parameters compile(const ChainSettings& settings, double sampleRate);
+    void reset() noexcept;
+    void process(const Parameters& params, float* left, float* right, int numSamples) noexcept;
+
+private:
+    float fastEnvelope = 0.0f;
+    float slowEnvelope = 0.0f;
+};
+
+class CompressorProcessor {
+public:
+    struct Parameters {
+        float thresholdDb = 0.0f;
+        float slope = 0.0f;
+        float attackCoeff = 0.0f;
+        float releaseCoeff = 0.0f;
+        float makeupGain = 1.0f;
+    };
+
+    static Parameters compile(const ChainSettings& settings, double sampleRate);
+    void reset() noexcept;
+    void process(const Parameters& params, float* left, float* right, int numSamples) noexcept;
+
+private:
+    float envelope = 0.0f;
+};
+
+class SaturationProcessor {
+public:
+    struct Parameters {
+        float drive = 1.0f;
+        float normaliser = 1.0f;
+        float mix = 1.0f;
+    };
+
+    static Parameters compile(const ChainSettings& settings, double sampleRate);
+    void reset() noexcept {}
+    void process(const Parameters& params, float* left, float* right, int numSamples) noexcept;
+};
+
+class GateProcessor {
+public:
+    struct Parameters {
+        float threshold = 0.0f;
+        float attackCoeff = 0.0f;
+        float releaseCoeff = 0.0f;
+        float floorGain = 0.0f;
+        int holdSamples = 0;
+    };
+
+    static Parameters compile(const ChainSettings& settings, double sampleRate);
+    void reset() noexcept;
+    void process(const Parameters& params, float* left, float* right, int numSamples) noexcept;
+
+private:
+    float gain = 0.0f;
+    int holdCounter = 0;
+};
+
+// Ordered stereo insert chain. The processor set is fixed at compile time (tuple order
+// matches Type), so the audio thread dispatches through a switch rather than virtual calls.
+// Edits are compiled into a Layout on the calling thread and handed over through a
+// triple buffer; bypassed inserts are simply absent from the layout.
+class InsertChain {
+public:
+    InsertChain();
+
+    void prepare(double newSampleRate);
+    void reset() noexcept;
+
+    void setSettings(const ChainSettings& newSettings);
+    ChainSettings getSettings() const;
+
+    void process(float* left, float* right, int numSamples) noexcept;
+
+private:
+    struct Layout {
+        std::array<Type, NUM_SLOTS> slots{};
+        int numActive = 0;
+        juce::uint32 activeMask = 0;
+
+        EQProcessor::Parameters eq;
+        TransientShaperProcessor::Parameters transient;
+        CompressorProcessor::Parameters compressor;
+        SaturationProcessor::Parameters saturation;
+        GateProcessor::Parameters gate;
+    };
+
+    using Processors = std::tuple<EQProcessor, TransientShaperProcessor, CompressorProcessor, SaturationProcessor, GateProcessor>;
+
+    static Layout compile(const ChainSettings& settings, double sampleRate);
+    void publishLayout();
+    void resetProcessor(Type type) noexcept;
+    void processSlot(Type type, const Layout& layout, float* left, float* right, int numSamples) noexcept;
+
+    Processors processors;
+    TripleBuffer<Layout> layouts;
+    juce::uint32 lastActiveMask = 0;
+
+    ChainSettings settings;
+    double sampleRate = static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE);
+    mutable juce::SpinLock settingsLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(InsertChain)
+};
+
+} // namespace InsertEffects
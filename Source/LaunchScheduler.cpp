@@ -0,0 +1,66 @@
+#include "LaunchScheduler.h"
+#include <cmath>
+
+double LaunchScheduler::quantizationToGridBeats(int quantization) noexcept {
+    if (quantization <= 0) return 0.0;
+
+    return INIConfig::Defaults::BEATS_PER_BAR / static_cast<double>(quantization);
+}
+
+double LaunchScheduler::getNextBoundary(double beat, double gridBeats) noexcept {
+    if (gridBeats <= 0.0) return beat;
+
+    // A launch requested right on a boundary goes out on that boundary
+    return std::ceil((beat - BOUNDARY_EPSILON) / gridBeats) * gridBeats;
+}
+
+bool LaunchScheduler::schedule(Kind kind, int playerIndex, int targetIndex, int quantization) noexcept {
+    // A new request replaces any pending one for the same scene slot or player
+    cancel(kind, playerIndex);
+
+    Launch launch;
+    launch.kind = kind;
+    launch.playerIndex = playerIndex;
+    launch.targetIndex = targetIndex;
+    launch.quantization = quantization;
+    return add(launch);
+}
+
+bool LaunchScheduler::scheduleAt(Kind kind, int playerIndex, int targetIndex, double launchBeat) noexcept {
+    Launch launch;
+    launch.kind = kind;
+    launch.playerIndex = playerIndex;
+    launch.targetIndex = targetIndex;
+    launch.launchBeat = juce::jmax(0.0, launchBeat);
+    return add(launch);
+}
+
+void LaunchScheduler::cancel(Kind kind, int playerIndex) noexcept {
+    int remaining = 0;
+    for (int i = 0; i < numLaunches; ++i) {
+        const auto& launch = launches[static_cast<size_t>(i)];
+        const bool matches = launch.kind == kind &&
+                             (playerIndex == INIConfig::MIDI::ALL_PLAYERS || launch.playerIndex == playerIndex);
+        if (!matches)
+            launches[static_cast<size_t>(remaining++)] = launch;
+    }
+    numLaunches = remaining;
+}
+
+void LaunchScheduler::resolve(double transportBeat, const TempoMap& tempoMap) noexcept {
+    for (int i = 0; i < numLaunches; ++i) {
+        auto& launch = launches[static_cast<size_t>(i)];
+        if (launch.launchBeat == UNRESOLVED)
+            launch.launchBeat = tempoMap.getNextGridBoundary(transportBeat, launch.quantization);
+    }
+}
+
+bool LaunchScheduler::add(const Launch& launch) noexcept {
+    if (numLaunches >= INIConfig::MIDI::MAX_SCHEDULED_LAUNCHES) {
+        DBG("LaunchScheduler: Too many pending launches");
+        return false;
+    }
+
+    launches[static_cast<size_t>(numLaunches++)] = launch;
+    return true;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <cmath>
+#include "INIConfig.h"
+#include "TempoMap.h"
+
+// Fixed-capacity list of launches (scene, clip, pattern, song section) waiting for a grid boundary.
+// Launches are kept in absolute transport beats; the engine asks for the sample offset
+// of the next one inside the current block, renders up to it and then fires everything
+// that is due, so launch timing does not depend on the host's buffer size. Grid
+// boundaries come from the tempo map, so bar launches follow meter changes.
+// Audio thread only.
+class LaunchScheduler {
+public:
+    enum class Kind : juce::uint8 { Scene, Clip, Pattern, Section };
+
+    struct Launch {
+        Kind kind = Kind::Clip;
+        int playerIndex = INIConfig::MIDI::ALL_PLAYERS;
+        int targetIndex = INIConfig::Defaults::ZERO_VALUE;
+        int quantization = INIConfig::Defaults::ZERO_VALUE;
+        double launchBeat = UNRESOLVED;
+    };
+
+    static constexpr double UNRESOLVED = -1.0;
+
+    LaunchScheduler() = default;
+
+    // quantization is a note division as used by MidiEngine::setQuantize
+    // (1 = bar, 4 = beat, 16 = sixteenth); 0 launches as soon as possible.
+    static double quantizationToGridBeats(int quantization) noexcept;
+    static double getNextBoundary(double beat, double gridBeats) noexcept;
+
+    // Queues a launch on the next grid boundary, resolved once the transport runs
+    bool schedule(Kind kind, int playerIndex, int targetIndex, int quantization) noexcept;
+    bool scheduleAt(Kind kind, int playerIndex, int targetIndex, double launchBeat) noexcept;
+    void cancel(Kind kind, int playerIndex = INIConfig::MIDI::ALL_PLAYERS) noexcept;
+    void clear() noexcept { numLaunches = 0; }
+
+    void resolve(double transportBeat, const TempoMap& tempoMap) noexcept;
+
+    // Samples from blockStartBeat to the earliest launch, or -1 if none falls inside numSamples.
+    // samplesUntil(beat) measures from blockStartBeat, so tempo ramps are followed exactly.
+    template <typename SamplesUntil>
+    int getNextLaunchOffset(double blockStartBeat, int numSamples, SamplesUntil&& samplesUntil) const {
+        int nextOffset = -1;
+        for (int i = 0; i < numLaunches; ++i) {
+            const auto& launch = launches[static_cast<size_t>(i)];
+            if (launch.launchBeat == UNRESOLVED) continue;
+
+            int offset = 0;
+            if (launch.launchBeat - blockStartBeat > BOUNDARY_EPSILON) {
+                const double samplesAhead = samplesUntil(launch.launchBeat);
+                offset = static_cast<int>(juce::jmin(std::ceil(samplesAhead - SAMPLE_EPSILON), static_cast<double>(numSamples)));
+            }
+
+            if (offset < numSamples && (nextOffset < 0 || offset < nextOffset))
+                nextOffset = offset;
+        }
+        return nextOffset;
+    }
+
+    // Removes every launch due at transportBeat and hands it to callback, in queue order
+    template <typename Callback>
+    void popDue(double transportBeat, Callback&& callback) {
+        int remaining = 0;
+        for (int i = 0; i < numLaunches; ++i) {
+            const auto launch = launches[static_cast<size_t>(i)];
+            if (isDue(launch, transportBeat))
+                callback(launch);
+            else
+                launches[static_cast<size_t>(remaining++)] = launch;
+        }
+        numLaunches = remaining;
+    }
+
+    int size() const noexcept { return numLaunches; }
+
+private:
+    static constexpr double BOUNDARY_EPSILON = 1.0e-9;
+    static constexpr double SAMPLE_EPSILON = 1.0e-6;
+
+    static bool isDue(const Launch& launch, double transportBeat) noexcept {
+        return launch.launchBeat != UNRESOLVED && launch.launchBeat <= transportBeat + BOUNDARY_EPSILON;
+    }
+
+    bool add(const Launch& launch) noexcept;
+
+    std::array<Launch, INIConfig::MIDI::MAX_SCHEDULED_LAUNCHES> launches{};
+    int numLaunches = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(LaunchScheduler)
+};
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <type_traits>
+
+// Single-writer / single-reader triple buffer. The writer fills the back buffer and
+// publishes it; the reader picks up the newest published value at the start of its
+// cycle. Neither side ever blocks or allocates, so it is safe to read on the audio thread.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+
+    T& getWriteBuffer() noexcept { return buffers[static_cast<size_t>(writeIndex)]; }
+
+    void publish() noexcept {
+        const int previous = middleIndex.exchange(writeIndex | DIRTY_FLAG, std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+
+    void write(const T& value) {
+        getWriteBuffer() = value;
+        publish();
+    }
+
+    // Returns true when a newer value was swapped in for the reader.
+    bool update() noexcept {
+        if ((middleIndex.load(std::memory_order_relaxed) & DIRTY_FLAG) == 0)
+            return false;
+
+        const int previous = middleIndex.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& read() const noexcept { return buffers[static_cast<size_t>(readIndex)]; }
+
+    // Writer side: true once the reader has swapped in the last published value, after
+    // which it never reads the older ones again.
+    bool isPublishedValueRead() const noexcept {
+        return (middleIndex.load(std::memory_order_acquire) & DIRTY_FLAG) == 0;
+    }
+
+private:
+    static constexpr int INDEX_MASK = 3;
+    static constexpr int DIRTY_FLAG = 4;
+
+    std::array<T, 3> buffers{};
+    int writeIndex = 0;
+    std::atomic<int> middleIndex{1};
+    int readIndex = 2;
+
+    JUCE_DECLARE_NON_COPYABLE(TripleBuffer)
+};
+
+// Bounded single-producer / single-consumer FIFO of plain messages. One slot is kept
+// free to tell a full queue from an empty one, so it holds Capacity - 1 items. push()
+// fails instead of blocking when the consumer has fallen behind.
+template <typename T, int Capacity>
+class SpscFifo {
+public:
+    static_assert(std::is_trivially_copyable<T>::value, "SpscFifo only carries plain messages");
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    SpscFifo() = default;
+
+    bool push(const T& item) noexcept {
+        const int write = writePosition.load(std::memory_order_relaxed);
+        const int next = (write + 1) & INDEX_MASK;
+        if (next == readPosition.load(std::memory_order_acquire))
+            return false;
+
+        items[static_cast<size_t>(write)] = item;
+        writePosition.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) noexcept {
+        const int read = readPosition.load(std::memory_order_relaxed);
+        if (read == writePosition.load(std::memory_order_acquire))
+            return false;
+
+        item = items[static_cast<size_t>(read)];
+        readPosition.store((read + 1) & INDEX_MASK, std::memory_order_release);
+        return true;
+    }
+
+    bool isEmpty() const noexcept {
+        return readPosition.load(std::memory_order_acquire) == writePosition.load(std::memory_order_acquire);
+    }
+
+    // Exact from the producer side: the consumer can only make room
+    bool isFull() const noexcept {
+        const int next = (writePosition.load(std::memory_order_relaxed) + 1) & INDEX_MASK;
+        return next == readPosition.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr int INDEX_MASK = Capacity - 1;
+
+    std::array<T, static_cast<size_t>(Capacity)> items{};
+    alignas(64) std::atomic<int> writePosition{0};
+    alignas(64) std::atomic<int> readPosition{0};
+
+    JUCE_DECLARE_NON_COPYABLE(SpscFifo)
+};
+
+// Bounded multi-producer / single-consumer FIFO of plain messages. Producers claim a
+// slot by compare-and-swap and each slot's sequence number tells the consumer when its
+// message is complete, so any number of threads may push at once. It holds Capacity
+// items; push() fails instead of blocking when it is full.
+template <typename T, int Capacity>
+class MpscFifo {
+public:
+    static_assert(std::is_trivially_copyable<T>::value, "MpscFifo only carries plain messages");
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    MpscFifo() noexcept {
+        for (unsigned int i = 0; i < static_cast<unsigned int>(Capacity); ++i)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool push(const T& item) noexcept {
+        unsigned int position = writePosition.load(std::memory_order_relaxed);
+        for (;;) {
+            auto& cell = cells[position & INDEX_MASK];
+            const auto ahead = static_cast<int>(cell.sequence.load(std::memory_order_acquire) - position);
+
+            if (ahead == 0) {
+                if (writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            } else if (ahead < 0) {
+                // The consumer has not freed this slot from the last lap yet
+                return false;
+            } else {
+                position = writePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        auto& cell = cells[position & INDEX_MASK];
+        cell.item = item;
+        cell.sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only
+    bool pop(T& item) noexcept {
+        auto& cell = cells[readPosition & INDEX_MASK];
+        if (cell.sequence.load(std::memory_order_acquire) != readPosition + 1)
+            return false;
+
+        item = cell.item;
+        cell.sequence.store(readPosition + static_cast<unsigned int>(Capacity), std::memory_order_release);
+        ++readPosition;
+        return true;
+    }
+
+private:
+    static constexpr unsigned int INDEX_MASK = static_cast<unsigned int>(Capacity) - 1;
+
+    struct Cell {
+        std::atomic<unsigned int> sequence{0};
+        T item{};
+    };
+
+    std::array<Cell, static_cast<size_t>(Capacity)> cells;
+    alignas(64) std::atomic<unsigned int> writePosition{0};
+    alignas(64) unsigned int readPosition = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(MpscFifo)
+};
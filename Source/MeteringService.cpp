@@ -0,0 +1,146 @@
+#include "MeteringService.h"
+#include <cmath>
+
+namespace {
+    // Four independent accumulators so the loop vectorises without a reduction dependency
+    float sumOfSquares(const float* data, int numSamples) noexcept {
+        float acc0 = 0.0f, acc1 = 0.0f, acc2 = 0.0f, acc3 = 0.0f;
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4) {
+            acc0 += data[i] * data[i];
+            acc1 += data[i + 1] * data[i + 1];
+            acc2 += data[i + 2] * data[i + 2];
+            acc3 += data[i + 3] * data[i + 3];
+        }
+
+        for (; i < numSamples; ++i)
+            acc0 += data[i] * data[i];
+
+        return (acc0 + acc1) + (acc2 + acc3);
+    }
+}
+
+//==============================================================================
+MeteringService::~MeteringService() {
+    stopTimer();
+    vblankAttachment.reset();
+}
+
+void MeteringService::reset() noexcept {
+    for (auto& detectors : channelDetectors)
+        for (auto& detector : detectors)
+            detector.reset();
+
+    for (auto& detector : masterDetectors)
+        detector.reset();
+}
+
+void MeteringService::beginFrame() noexcept {
+    // Channels skipped this block (muted, not soloed) read as silent rather than stale
+    auto& frame = frames.getWriteBuffer();
+    frame.channels.fill(MeterReading());
+    frame.master = MeterReading();
+}
+
+void MeteringService::measureChannel(int channel, const juce::AudioBuffer<float>& buffer) noexcept {
+    if (!juce::isPositiveAndBelow(channel, NUM_CHANNELS))
+        return;
+
+    measure(frames.getWriteBuffer().channels[static_cast<size_t>(channel)],
+            channelDetectors[static_cast<size_t>(channel)], buffer);
+}
+
+void MeteringService::measureMaster(const juce::AudioBuffer<float>& buffer) noexcept {
+    measure(frames.getWriteBuffer().master, masterDetectors, buffer);
+}
+
+void MeteringService::publishFrame() noexcept {
+    frames.getWriteBuffer().frameIndex = ++nextFrameIndex;
+    frames.publish();
+}
+
+void MeteringService::measure(MeterReading& reading, std::array<TruePeakDetector, 2>& detectors,
+                              const juce::AudioBuffer<float>& buffer) noexcept {
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = juce::jmin(2, buffer.getNumChannels());
+    if (numSamples <= 0 || numChannels <= 0)
+        return;
+
+    float peak[2] = {};
+    float rms[2] = {};
+    float truePeak[2] = {};
+
+    for (int ch = 0; ch < numChannels; ++ch) {
+        const float* data = buffer.getReadPointer(ch);
+        const auto range = juce::FloatVectorOperations::findMinAndMax(data, numSamples);
+
+        peak[ch] = juce::jmax(-range.getStart(), range.getEnd());
+        rms[ch] = std::sqrt(sumOfSquares(data, numSamples) / static_cast<float>(numSamples));
+        truePeak[ch] = juce::jmax(peak[ch], detectors[static_cast<size_t>(ch)].process(data, numSamples));
+    }
+
+    if (numChannels == 1) {
+        peak[1] = peak[0];
+        rms[1] = rms[0];
+        truePeak[1] = truePeak[0];
+    }
+
+    reading.peakLeft = peak[0];
+    reading.peakRight = peak[1];
+    reading.rmsLeft = rms[0];
+    reading.rmsRight = rms[1];
+    reading.truePeakLeft = truePeak[0];
+    reading.truePeakRight = truePeak[1];
+}
+
+//==============================================================================
+const MeteringService::MeterFrame& MeteringService::getLatestFrame() const {
+    if (frames.update())
+        latestFrame = frames.read();
+    return latestFrame;
+}
+
+void MeteringService::addListener(Listener* listener) {
+    listeners.add(listener);
+    updateRefreshSource();
+}
+
+void MeteringService::removeListener(Listener* listener) {
+    listeners.remove(listener);
+    updateRefreshSource();
+}
+
+void MeteringService::attachToDisplay(juce::Component* component) {
+    if (component == nullptr) {
+        detachFromDisplay();
+        return;
+    }
+
+    vblankAttachment = std::make_unique<juce::VBlankAttachment>(component, [this] { dispatchFrame(); });
+    updateRefreshSource();
+}
+
+void MeteringService::detachFromDisplay() {
+    vblankAttachment.reset();
+    updateRefreshSource();
+}
+
+void MeteringService::updateRefreshSource() {
+    // Fall back to a timer only while nothing is driving us from the display refresh
+    if (vblankAttachment == nullptr && !listeners.isEmpty()) {
+        if (!isTimerRunning())
+            startTimerHz(INIConfig::LayoutConstants::mixerTimerHz);
+    } else {
+        stopTimer();
+    }
+}
+
+void MeteringService::timerCallback() {
+    dispatchFrame();
+}
+
+void MeteringService::dispatchFrame() {
+    const auto& frame = getLatestFrame();
+    listeners.call([&frame](Listener& l) { l.meterFrameUpdated(frame); });
+}
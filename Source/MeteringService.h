@@ -0,0 +1,82 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <memory>
+#include "INIConfig.h"
+#include "LockFreeStructures.h"
+#include "TruePeakDetector.h"
+
+// Collects per-channel and master levels on the audio thread and hands one consistent
+// frame per block to the message thread. UI meters register as listeners and are all
+// driven from the same display refresh, so they always show the same frame.
+class MeteringService : private juce::Timer {
+public:
+    static constexpr int NUM_CHANNELS = INIConfig::Defaults::MAX_PLAYERS;
+    static constexpr int MASTER_CHANNEL = -1;
+
+    struct MeterReading {
+        float peakLeft = 0.0f;
+        float peakRight = 0.0f;
+        float rmsLeft = 0.0f;
+        float rmsRight = 0.0f;
+        float truePeakLeft = 0.0f;
+        float truePeakRight = 0.0f;
+    };
+
+    struct MeterFrame {
+        std::array<MeterReading, NUM_CHANNELS> channels{};
+        MeterReading master;
+        juce::uint32 frameIndex = 0;
+
+        const MeterReading& get(int channel) const {
+            return juce::isPositiveAndBelow(channel, NUM_CHANNELS) ? channels[static_cast<size_t>(channel)] : master;
+        }
+    };
+
+    class Listener {
+    public:
+        virtual ~Listener() = default;
+        virtual void meterFrameUpdated(const MeterFrame& frame) = 0;
+    };
+
+    MeteringService() = default;
+    ~MeteringService() override;
+
+    // Audio thread
+    void reset() noexcept;
+    void beginFrame() noexcept;
+    void measureChannel(int channel, const juce::AudioBuffer<float>& buffer) noexcept;
+    void measureMaster(const juce::AudioBuffer<float>& buffer) noexcept;
+    void publishFrame() noexcept;
+
+    // Message thread
+    const MeterFrame& getLatestFrame() const;
+
+    void addListener(Listener* listener);
+    void removeListener(Listener* listener);
+
+    void attachToDisplay(juce::Component* component);
+    void detachFromDisplay();
+
+private:
+    void timerCallback() override;
+    void dispatchFrame();
+    void updateRefreshSource();
+
+    static void measure(MeterReading& reading, std::array<TruePeakDetector, 2>& detectors,
+                        const juce::AudioBuffer<float>& buffer) noexcept;
+
+    // Reader side is only ever touched from the message thread
+    mutable TripleBuffer<MeterFrame> frames;
+    mutable MeterFrame latestFrame;
+    juce::uint32 nextFrameIndex = 0;
+
+    std::array<std::array<TruePeakDetector, 2>, NUM_CHANNELS> channelDetectors;
+    std::array<TruePeakDetector, 2> masterDetectors;
+
+    juce::ListenerList<Listener> listeners;
+    std::unique_ptr<juce::VBlankAttachment> vblankAttachment;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MeteringService)
+};
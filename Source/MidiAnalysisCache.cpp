@@ -0,0 +1,543 @@
+#include "MidiAnalysisCache.h"
+#include <cmath>
+#include <map>
+#include <vector>
+
+namespace {
+    void writeAnalysis(juce::OutputStream& stream, const MidiGrooveAnalysis& analysis) {
+        stream.writeFloat(analysis.averageSwing);
+        stream.writeFloat(analysis.averageVelocity);
+        stream.writeFloat(analysis.grooveTightness);
+        stream.writeInt(analysis.timeSignatureNumerator);
+        stream.writeInt(analysis.timeSignatureDenominator);
+        stream.writeFloat(analysis.tempo);
+        stream.writeInt(analysis.numberOfBars);
+        stream.writeFloat(analysis.velocityRange);
+        stream.writeFloat(analysis.velocityVariation);
+        stream.writeFloat(analysis.timingDeviation);
+        stream.writeFloat(analysis.noteDensity);
+
+        stream.writeInt(analysis.microTiming.size());
+        for (float timing : analysis.microTiming) {
+            stream.writeFloat(timing);
+        }
+
+        stream.writeInt(analysis.noteDistribution.size());
+        for (int count : analysis.noteDistribution) {
+            stream.writeInt(count);
+        }
+    }
+
+    // A count that claims more than the rest of the file is corruption, not a reason to allocate
+    bool readCount(juce::InputStream& stream, int itemSize, int& count) {
+        count = stream.readInt();
+        return count >= 0 && count <= stream.getNumBytesRemaining() / itemSize;
+    }
+
+    bool readAnalysis(juce::InputStream& stream, MidiGrooveAnalysis& analysis) {
+        analysis.averageSwing = stream.readFloat();
+        analysis.averageVelocity = stream.readFloat();
+        analysis.grooveTightness = stream.readFloat();
+        analysis.timeSignatureNumerator = stream.readInt();
+        analysis.timeSignatureDenominator = stream.readInt();
+        analysis.tempo = stream.readFloat();
+        analysis.numberOfBars = stream.readInt();
+        analysis.velocityRange = stream.readFloat();
+        analysis.velocityVariation = stream.readFloat();
+        analysis.timingDeviation = stream.readFloat();
+        analysis.noteDensity = stream.readFloat();
+
+        int count = 0;
+        if (!readCount(stream, static_cast<int>(sizeof(float)), count)) return false;
+        analysis.microTiming.ensureStorageAllocated(count);
+        for (int i = 0; i < count; ++i) {
+            analysis.microTiming.add(stream.readFloat());
+        }
+
+        if (!readCount(stream, static_cast<int>(sizeof(int)), count)) return false;
+        analysis.noteDistribution.ensureStorageAllocated(count);
+        for (int i = 0; i < count; ++i) {
+            analysis.noteDistribution.add(stream.readInt());
+        }
+        return true;
+    }
+}
+
+// One analyze() call. Workers claim files through nextIndex and each writes only the
+// slots it claimed; the calling thread reads them after every job has finished.
+struct MidiAnalysisCache::Batch {
+    juce::Array<MidiLibraryCatalog::Entry> entries;
+    std::vector<MidiGrooveAnalysis> results;
+    std::vector<juce::uint64> hashes;
+    std::vector<char> finished;
+    std::atomic<int> nextIndex{0};
+    std::atomic<int> numDone{0};
+    std::atomic<bool> cancelled{false};
+    juce::WaitableEvent fileDone;
+};
+
+class MidiAnalysisCache::AnalysisJob : public juce::ThreadPoolJob {
+public:
+    explicit AnalysisJob(Batch& batchToRun) : juce::ThreadPoolJob("Groove Analysis"), batch(batchToRun) {}
+
+    JobStatus runJob() override {
+        while (!shouldExit() && !batch.cancelled.load()) {
+            const int index = batch.nextIndex.fetch_add(1);
+            if (index >= batch.entries.size()) break;
+
+            const auto& file = batch.entries.getReference(index).file;
+            batch.results[static_cast<size_t>(index)] = analyzeFile(file);
+            batch.hashes[static_cast<size_t>(index)] = MidiLibraryCatalog::getContentHash(file);
+            batch.finished[static_cast<size_t>(index)] = 1;
+            batch.numDone.fetch_add(1);
+            batch.fileDone.signal();
+        }
+        return jobHasFinished;
+    }
+
+private:
+    Batch& batch;
+};
+
+MidiAnalysisCache::MidiAnalysisCache(const juce::File& file, const juce::File& root, const juce::File& prebuilt)
+    : cacheFile(file), libraryRoot(root), prebuiltFile(prebuilt) {
+}
+
+MidiAnalysisCache::~MidiAnalysisCache() {
+    save();
+}
+
+bool MidiAnalysisCache::analyze(const juce::Array<MidiLibraryCatalog::Entry>& entries, const ProgressCallback& progress) {
+    load();
+
+    Batch batch;
+    for (const auto& entry : entries) {
+        if (find(entry) == nullptr) {
+            batch.entries.add(entry);
+        }
+    }
+
+    const int total = entries.size();
+    const int numToAnalyze = batch.entries.size();
+    const int alreadyDone = total - numToAnalyze;
+
+    batch.results.resize(static_cast<size_t>(numToAnalyze));
+    batch.hashes.resize(static_cast<size_t>(numToAnalyze));
+    batch.finished.assign(static_cast<size_t>(numToAnalyze), 0);
+
+    // Reported before any work starts, so the caller can back out for free
+    bool cancelled = progress != nullptr && !progress(alreadyDone, total);
+
+    // The pool owns no jobs; every one is waited for before the batch goes out of scope
+    std::vector<std::unique_ptr<AnalysisJob>> jobs;
+    if (!cancelled && numToAnalyze > 0) {
+        auto& workers = getPool();
+        const int numJobs = juce::jmin(workers.getNumThreads(), numToAnalyze);
+
+        for (int i = 0; i < numJobs; ++i) {
+            jobs.push_back(std::make_unique<AnalysisJob>(batch));
+            workers.addJob(jobs.back().get(), false);
+        }
+    }
+
+    for (int done = 0; !cancelled && done < numToAnalyze;) {
+        batch.fileDone.wait(INIConfig::MIDI::ANALYSIS_PROGRESS_INTERVAL_MS);
+        done = batch.numDone.load();
+
+        if (progress != nullptr && !progress(alreadyDone + done, total)) {
+            cancelled = true;
+            batch.cancelled.store(true);
+        }
+    }
+
+    for (const auto& job : jobs) {
+        pool->waitForJobToFinish(job.get(), -1);
+    }
+
+    for (int i = 0; i < numToAnalyze; ++i) {
+        if (batch.finished[static_cast<size_t>(i)] == 0) continue;
+
+        const auto& entry = batch.entries.getReference(i);
+        records[entry.file.getFullPathName()] = { entry.size, entry.modified.toMilliseconds(),
+                                                  batch.hashes[static_cast<size_t>(i)],
+                                                  std::move(batch.results[static_cast<size_t>(i)]) };
+        dirty = true;
+    }
+
+    save();
+    return !cancelled;
+}
+
+MidiGrooveAnalysis MidiAnalysisCache::getAnalysis(const MidiLibraryCatalog::Entry& entry) {
+    if (const auto* cached = find(entry)) {
+        return *cached;
+    }
+
+    auto analysis = analyzeFile(entry.file);
+    records[entry.file.getFullPathName()] = { entry.size, entry.modified.toMilliseconds(),
+                                              MidiLibraryCatalog::getContentHash(entry.file), analysis };
+    dirty = true;
+    return analysis;
+}
+
+const MidiGrooveAnalysis* MidiAnalysisCache::find(const MidiLibraryCatalog::Entry& entry) {
+    load();
+
+    const auto found = records.find(entry.file.getFullPathName());
+    if (found == records.end()) return nullptr;
+
+    auto& record = found->second;
+    if (record.size != entry.size) return nullptr;
+    if (record.modified == entry.modified.toMilliseconds()) return &record.analysis;
+
+    // Matched by time from now on, so the file is read only once
+    if (record.hash == 0 || record.hash != MidiLibraryCatalog::getContentHash(entry.file)) return nullptr;
+
+    record.modified = entry.modified.toMilliseconds();
+    dirty = true;
+    return &record.analysis;
+}
+
+void MidiAnalysisCache::store(const MidiLibraryCatalog::Entry& entry, const MidiGrooveAnalysis& analysis) {
+    load();
+
+    // By time only, so that storing a whole library never reads it
+    const auto [found, inserted] = records.try_emplace(entry.file.getFullPathName());
+    auto& record = found->second;
+    if (!inserted && record.size == entry.size && record.modified == entry.modified.toMilliseconds()) return;
+
+    record = { entry.size, entry.modified.toMilliseconds(), 0, analysis };
+    dirty = true;
+}
+
+int MidiAnalysisCache::getNumAnalyses() {
+    load();
+    return static_cast<int>(records.size());
+}
+
+void MidiAnalysisCache::load() {
+    if (loaded) return;
+    loaded = true;
+
+    // Saved over by the first change, so the prebuilt cache itself is never written
+    const auto& source = cacheFile.existsAsFile() ? cacheFile : prebuiltFile;
+
+    juce::MemoryBlock data;
+    if (!source.existsAsFile() || !source.loadFileAsData(data)) return;
+
+    juce::MemoryInputStream stream(data, false);
+    if (!readRecords(stream)) {
+        DBG("MidiAnalysisCache: Discarding unreadable cache " + source.getFullPathName());
+        records.clear();
+    }
+}
+
+bool MidiAnalysisCache::readRecords(juce::InputStream& stream) {
+    if (stream.readInt() != INIConfig::MIDI::ANALYSIS_CACHE_MAGIC) return false;
+    if (stream.readInt() != INIConfig::MIDI::ANALYSIS_CACHE_VERSION) return false;
+
+    const int count = stream.readInt();
+    if (count < 0) return false;
+    records.reserve(static_cast<size_t>(count));
+
+    for (int i = 0; i < count; ++i) {
+        // A path relative to a root we were not given cannot be matched, but is read past
+        const auto file = MidiLibraryCatalog::resolvePortablePath(stream.readString(), libraryRoot);
+
+        Record record;
+        record.size = stream.readInt64();
+        record.modified = stream.readInt64();
+        record.hash = static_cast<juce::uint64>(stream.readInt64());
+        if (!readAnalysis(stream, record.analysis)) return false;
+
+        if (file != juce::File()) {
+            records[file.getFullPathName()] = std::move(record);
+        }
+    }
+
+    // Only a file written to the end carries the trailing magic
+    return stream.readInt() == INIConfig::MIDI::ANALYSIS_CACHE_MAGIC;
+}
+
+bool MidiAnalysisCache::save() {
+    if (!dirty) return true;
+
+    for (auto it = records.begin(); it != records.end();) {
+        if (juce::File(it->first).existsAsFile())
+            ++it;
+        else
+            it = records.erase(it);
+    }
+
+    if (cacheFile.getParentDirectory().createDirectory().failed()) {
+        DBG("MidiAnalysisCache: Could not create " + cacheFile.getParentDirectory().getFullPathName());
+        return false;
+    }
+
+    // Written beside the cache and moved over it, so a crash never leaves half a file behind
+    juce::TemporaryFile temporary(cacheFile);
+    {
+        juce::FileOutputStream stream(temporary.getFile());
+        if (!stream.openedOk()) return false;
+
+        stream.writeInt(INIConfig::MIDI::ANALYSIS_CACHE_MAGIC);
+        stream.writeInt(INIConfig::MIDI::ANALYSIS_CACHE_VERSION);
+        stream.writeInt(static_cast<int>(records.size()));
+
+        for (const auto& [path, record] : records) {
+            stream.writeString(MidiLibraryCatalog::getPortablePath(juce::File(path), libraryRoot));
+            stream.writeInt64(record.size);
+            stream.writeInt64(record.modified);
+            stream.writeInt64(static_cast<juce::int64>(record.hash));
+            writeAnalysis(stream, record.analysis);
+        }
+
+        stream.writeInt(INIConfig::MIDI::ANALYSIS_CACHE_MAGIC);
+        stream.flush();
+        if (stream.getStatus().failed()) return false;
+    }
+
+    if (!temporary.overwriteTargetFileWithTemporary()) return false;
+
+    dirty = false;
+    return true;
+}
+
+juce::ThreadPool& MidiAnalysisCache::getPool() {
+    if (pool == nullptr) {
+        const int numThreads = juce::jlimit(1, INIConfig::MIDI::ANALYSIS_MAX_THREADS, juce::SystemStats::getNumCpus());
+        pool = std::make_unique<juce::ThreadPool>(juce::ThreadPoolOptions{}
+                                                      .withThreadName("OTTO Groove Analysis")
+                                                      .withNumberOfThreads(numThreads));
+    }
+    return *pool;
+}
+
+MidiGrooveAnalysis MidiAnalysisCache::analyzeFile(const juce::File& file) {
+    MidiGrooveAnalysis analysis;
+
+    if (!file.existsAsFile()) {
+        return analysis;
+    }
+
+    juce::FileInputStream fileStream(file);
+    if (!fileStream.openedOk()) {
+        return analysis;
+    }
+
+    juce::MidiFile midiFileData;
+    if (!midiFileData.readFrom(fileStream)) {
+        return analysis;
+    }
+
+    juce::MidiMessageSequence allEvents;
+    for (int track = 0; track < midiFileData.getNumTracks(); ++track) {
+        const juce::MidiMessageSequence* sequence = midiFileData.getTrack(track);
+        if (sequence) {
+            for (int i = 0; i < sequence->getNumEvents(); ++i) {
+                allEvents.addEvent(sequence->getEventPointer(i)->message);
+            }
+        }
+    }
+
+    allEvents.sort();
+
+    analysis.tempo = estimateTempo(allEvents);
+
+    detectTimeSignature(allEvents, analysis.timeSignatureNumerator, analysis.timeSignatureDenominator);
+
+    analysis.averageSwing = calculateSwing(allEvents);
+
+    analysis.grooveTightness = calculateGrooveTightness(allEvents);
+
+    float totalVelocity = 0.0f;
+    float minVelocity = 127.0f;
+    float maxVelocity = 0.0f;
+    int noteCount = 0;
+    juce::Array<float> velocities;
+
+    for (int i = 0; i < allEvents.getNumEvents(); ++i) {
+        const auto* event = allEvents.getEventPointer(i);
+        if (event && event->message.isNoteOn()) {
+            float velocity = static_cast<float>(event->message.getVelocity());
+            totalVelocity += velocity;
+            minVelocity = juce::jmin(minVelocity, velocity);
+            maxVelocity = juce::jmax(maxVelocity, velocity);
+            velocities.add(velocity);
+            noteCount++;
+        }
+    }
+
+    if (noteCount > 0) {
+        analysis.averageVelocity = totalVelocity / noteCount;
+        analysis.velocityRange = maxVelocity - minVelocity;
+
+        float variance = 0.0f;
+        for (float v : velocities) {
+            variance += (v - analysis.averageVelocity) * (v - analysis.averageVelocity);
+        }
+        analysis.velocityVariation = std::sqrt(variance / noteCount);
+
+        double sequenceDuration = allEvents.getEndTime() - allEvents.getStartTime();
+        if (sequenceDuration > 0) {
+            double beatsInSequence = sequenceDuration * (analysis.tempo / 60.0);
+            analysis.noteDensity = noteCount / beatsInSequence;
+            analysis.numberOfBars = static_cast<int>(beatsInSequence / analysis.timeSignatureNumerator);
+        }
+    }
+
+    std::map<int, int> noteDistribution;
+    for (int i = 0; i < allEvents.getNumEvents(); ++i) {
+        const auto* event = allEvents.getEventPointer(i);
+        if (event && event->message.isNoteOn()) {
+            int note = event->message.getNoteNumber();
+            noteDistribution[note]++;
+        }
+    }
+
+    for (const auto& pair : noteDistribution) {
+        analysis.noteDistribution.add(pair.second);
+    }
+
+    return analysis;
+}
+
+float MidiAnalysisCache::calculateSwing(const juce::MidiMessageSequence& sequence) {
+    juce::Array<double> eighthNoteTimes;
+
+    for (int i = 0; i < sequence.getNumEvents(); ++i) {
+        const auto* event = sequence.getEventPointer(i);
+        if (event && event->message.isNoteOn()) {
+            double time = event->message.getTimeStamp();
+            double beatPosition = std::fmod(time * 2.0, 1.0);
+
+            if (beatPosition > INIConfig::LayoutConstants::midiFileManagerEighthNoteMin &&
+                beatPosition < INIConfig::LayoutConstants::midiFileManagerEighthNoteMax) {
+                eighthNoteTimes.add(beatPosition);
+            }
+        }
+    }
+
+    if (eighthNoteTimes.isEmpty()) {
+        return INIConfig::LayoutConstants::midiFileManagerSwingBase;
+    }
+
+    double averagePosition = 0.0;
+    for (double pos : eighthNoteTimes) {
+        averagePosition += pos;
+    }
+    averagePosition /= eighthNoteTimes.size();
+
+    float swing = INIConfig::LayoutConstants::midiFileManagerSwingBase +
+                  (averagePosition - INIConfig::LayoutConstants::midiFileManagerSwingOffset) *
+                  INIConfig::LayoutConstants::midiFileManagerSwingScale;
+    return juce::jlimit(INIConfig::LayoutConstants::midiFileManagerSwingMin,
+                       INIConfig::LayoutConstants::midiFileManagerSwingMax, swing);
+}
+
+float MidiAnalysisCache::calculateGrooveTightness(const juce::MidiMessageSequence& sequence) {
+    juce::Array<double> timingDeviations;
+    double gridResolution = INIConfig::LayoutConstants::midiFileManagerGridResolution;
+
+    for (int i = 0; i < sequence.getNumEvents(); ++i) {
+        const auto* event = sequence.getEventPointer(i);
+        if (event && event->message.isNoteOn()) {
+            double time = event->message.getTimeStamp();
+            double quantizedTime = std::round(time / gridResolution) * gridResolution;
+            double deviation = std::abs(time - quantizedTime);
+            timingDeviations.add(deviation);
+        }
+    }
+
+    if (timingDeviations.isEmpty()) {
+        return 1.0f;
+    }
+
+    double totalDeviation = 0.0;
+    for (double dev : timingDeviations) {
+        totalDeviation += dev;
+    }
+    double averageDeviation = totalDeviation / timingDeviations.size();
+
+    float tightness = 1.0f - juce::jlimit(0.0f, 1.0f,
+        static_cast<float>(averageDeviation * INIConfig::LayoutConstants::midiFileManagerTightnessScale));
+    return tightness;
+}
+
+void MidiAnalysisCache::detectTimeSignature(const juce::MidiMessageSequence& sequence,
+                                            int& numerator, int& denominator) {
+
+    juce::Array<double> kickTimes;
+    for (int i = 0; i < sequence.getNumEvents(); ++i) {
+        const auto* event = sequence.getEventPointer(i);
+        if (event && event->message.isNoteOn()) {
+            int note = event->message.getNoteNumber();
+            if (note == 36 || note == 35) {
+                kickTimes.add(event->message.getTimeStamp());
+            }
+        }
+    }
+
+    if (kickTimes.size() >= 2) {
+        double avgInterval = 0.0;
+        for (int i = 1; i < kickTimes.size(); ++i) {
+            avgInterval += kickTimes[i] - kickTimes[i-1];
+        }
+        avgInterval /= (kickTimes.size() - 1);
+
+        if (avgInterval > 0.9 && avgInterval < 1.1) {
+            numerator = 4;
+            denominator = 4;
+        } else if (avgInterval > 0.65 && avgInterval < 0.85) {
+            numerator = 3;
+            denominator = 4;
+        } else if (avgInterval > 1.4 && avgInterval < 1.6) {
+            numerator = 6;
+            denominator = 8;
+        } else {
+            numerator = 4;
+            denominator = 4;
+        }
+    } else {
+        numerator = 4;
+        denominator = 4;
+    }
+}
+
+float MidiAnalysisCache::estimateTempo(const juce::MidiMessageSequence& sequence) {
+    juce::Array<double> noteTimes;
+
+    for (int i = 0; i < sequence.getNumEvents(); ++i) {
+        const auto* event = sequence.getEventPointer(i);
+        if (event && event->message.isNoteOn()) {
+            noteTimes.add(event->message.getTimeStamp());
+        }
+    }
+
+    if (noteTimes.size() < 2) {
+        return INIConfig::Defaults::DEFAULT_TEMPO;
+    }
+
+    juce::Array<double> intervals;
+    for (int i = 1; i < noteTimes.size(); ++i) {
+        double interval = noteTimes[i] - noteTimes[i-1];
+        if (interval > 0.1 && interval < 2.0) {
+            intervals.add(interval);
+        }
+    }
+
+    if (intervals.isEmpty()) {
+        return INIConfig::Defaults::DEFAULT_TEMPO;
+    }
+
+    intervals.sort();
+    double modeInterval = intervals[intervals.size() / 2];
+
+    float tempo = 60.0f / static_cast<float>(modeInterval);
+
+    tempo = std::round(tempo / INIConfig::LayoutConstants::midiFileManagerTempoRoundTo) *
+            INIConfig::LayoutConstants::midiFileManagerTempoRoundTo;
+
+    return juce::jlimit(INIConfig::LayoutConstants::midiFileManagerTempoEstimateMin,
+                       INIConfig::LayoutConstants::midiFileManagerTempoEstimateMax, tempo);
+}
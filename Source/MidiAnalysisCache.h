@@ -0,0 +1,77 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include "INIConfig.h"
+#include "MidiAnalysisTypes.h"
+#include "MidiLibraryCatalog.h"
+
+// Groove analysis for the MIDI library, kept in a binary cache file keyed by path, size
+// and modification time that is read the first time anything asks for it. A file whose
+// time moved but whose contents hash the same is still current, so a cache survives an
+// installer or copy that does not keep modification times. analyze()
+// hands whatever is missing or out of date to a bounded pool of worker threads and
+// reports progress from the calling thread, so after the first run only new and changed
+// files are parsed again. Paths inside the library root are stored relative to it, so a
+// cache built offline by the batch analyzer can ship with the library and is read until
+// there is one of our own. Everything but the workers runs on the calling thread.
+class MidiAnalysisCache {
+public:
+    // Files done so far out of the total asked for; returning false cancels
+    using ProgressCallback = std::function<bool(int done, int total)>;
+
+    explicit MidiAnalysisCache(const juce::File& cacheFile,
+                               const juce::File& libraryRoot = {},
+                               const juce::File& prebuiltFile = {});
+    ~MidiAnalysisCache();
+
+    // False if cancelled; whatever finished by then is kept
+    bool analyze(const juce::Array<MidiLibraryCatalog::Entry>& entries, const ProgressCallback& progress = nullptr);
+    // Parses the file on the calling thread if it is not cached yet
+    MidiGrooveAnalysis getAnalysis(const MidiLibraryCatalog::Entry& entry);
+    // nullptr if the file was never analyzed or has changed since; valid until the next analysis.
+    // Reads the file to compare contents if only its modification time differs.
+    const MidiGrooveAnalysis* find(const MidiLibraryCatalog::Entry& entry);
+    int getNumAnalyses();
+    // Keeps an analysis made elsewhere, such as by another cache on a background thread
+    void store(const MidiLibraryCatalog::Entry& entry, const MidiGrooveAnalysis& analysis);
+
+    // Writes the cache file if anything changed since it was read, dropping files that are gone
+    bool save();
+
+    static MidiGrooveAnalysis analyzeFile(const juce::File& file);
+
+private:
+    struct Record {
+        juce::int64 size = 0;
+        juce::int64 modified = 0;
+        // Of the contents, or 0 where the analysis was made without reading them here
+        juce::uint64 hash = 0;
+        MidiGrooveAnalysis analysis;
+    };
+
+    struct Batch;
+    class AnalysisJob;
+
+    void load();
+    bool readRecords(juce::InputStream& stream);
+    juce::ThreadPool& getPool();
+
+    static float calculateSwing(const juce::MidiMessageSequence& sequence);
+    static float calculateGrooveTightness(const juce::MidiMessageSequence& sequence);
+    static void detectTimeSignature(const juce::MidiMessageSequence& sequence, int& numerator, int& denominator);
+    static float estimateTempo(const juce::MidiMessageSequence& sequence);
+
+    juce::File cacheFile;
+    juce::File libraryRoot;
+    juce::File prebuiltFile;
+    std::unordered_map<juce::String, Record> records;
+    bool loaded = false;
+    bool dirty = false;
+    std::unique_ptr<juce::ThreadPool> pool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiAnalysisCache)
+};
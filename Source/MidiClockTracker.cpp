@@ -0,0 +1,87 @@
+#include "MidiClockTracker.h"
+#include <cmath>
+
+namespace {
+    double tickPeriodForTempo(double bpm) {
+        return INIConfig::Defaults::SECONDS_PER_MINUTE / (juce::jmax(1.0, bpm) * INIConfig::MIDI::CLOCK_PPQN);
+    }
+}
+
+void MidiClockTracker::reset(double nominalBpm) noexcept {
+    nominalPeriod = tickPeriodForTempo(nominalBpm);
+    period = nominalPeriod;
+    tickCount = 0;
+    phase = LoopPhase::Acquiring;
+    ticksSinceRestart = 0;
+    awaitingFirstTick = true;
+}
+
+void MidiClockTracker::setBandwidth(double bandwidthHz) noexcept {
+    // Critically damped second-order loop
+    const double omega = juce::MathConstants<double>::twoPi * bandwidthHz * period;
+    loopGain = std::sqrt(2.0) * omega;
+    periodGain = omega * omega;
+}
+
+void MidiClockTracker::restartLoop(double timeSeconds) noexcept {
+    setBandwidth(INIConfig::MIDI::CLOCK_ACQUIRE_BANDWIDTH_HZ);
+    phase = LoopPhase::Acquiring;
+    ticksSinceRestart = 0;
+
+    tickTime = timeSeconds;
+    nextTickTime = timeSeconds + period;
+}
+
+void MidiClockTracker::processTick(double timeSeconds) noexcept {
+    if (tickCount == 0) {
+        if (nominalPeriod <= 0.0) {
+            nominalPeriod = tickPeriodForTempo(INIConfig::Defaults::DEFAULT_TEMPO);
+            period = nominalPeriod;
+        }
+        restartLoop(timeSeconds);
+    } else if (tickCount == 1 || timeSeconds - lastRawTickTime > INIConfig::MIDI::CLOCK_TIMEOUT_TICKS * period) {
+        // Seed the period from the first interval, or start over after a dropout
+        if (tickCount == 1) {
+            period = juce::jmax(timeSeconds - lastRawTickTime, nominalPeriod * 0.25);
+        }
+        restartLoop(timeSeconds);
+    } else {
+        const double error = timeSeconds - nextTickTime;
+        tickTime = nextTickTime + loopGain * error;
+        nextTickTime = tickTime + period;
+        period += periodGain * error;
+    }
+
+    // Counting the tick that restarted the loop
+    if (phase == LoopPhase::Acquiring && ++ticksSinceRestart >= INIConfig::MIDI::CLOCK_LOCK_TICKS) {
+        setBandwidth(INIConfig::MIDI::CLOCK_TRACK_BANDWIDTH_HZ);
+        phase = LoopPhase::Tracking;
+    }
+
+    lastRawTickTime = timeSeconds;
+    awaitingFirstTick = false;
+    ++tickCount;
+}
+
+bool MidiClockTracker::isFollowing(double timeSeconds) const noexcept {
+    if (awaitingFirstTick) return true;
+
+    return tickCount > 0 && timeSeconds - lastRawTickTime <= INIConfig::MIDI::CLOCK_TIMEOUT_TICKS * period;
+}
+
+double MidiClockTracker::getTempo() const noexcept {
+    if (period <= 0.0) return INIConfig::Defaults::DEFAULT_TEMPO;
+
+    return INIConfig::Defaults::SECONDS_PER_MINUTE / (period * INIConfig::MIDI::CLOCK_PPQN);
+}
+
+double MidiClockTracker::getBeatAt(double timeSeconds) const noexcept {
+    if (tickCount == 0) return 0.0;
+
+    // Measured from the filtered time of the last tick: a tick that arrived early is
+    // still ahead of the clock, and a late one is extrapolated from the period
+    const double span = nextTickTime - tickTime;
+    const double fraction = span > 0.0 ? juce::jmax(-1.0, (timeSeconds - tickTime) / span) : 0.0;
+
+    return (static_cast<double>(tickCount - 1) + fraction) / INIConfig::MIDI::CLOCK_PPQN;
+}
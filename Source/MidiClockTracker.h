@@ -0,0 +1,46 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "INIConfig.h"
+
+// Follows an incoming 24 ppqn MIDI clock with a second-order delay-locked loop.
+// Tick timestamps carry driver and host jitter; the loop filters them into a steady
+// tick period (tempo) and phase, so the transport can be slaved to external hardware
+// without stepping on every tick. The loop starts wide to pull in quickly and narrows
+// once locked, and again after every restart. Audio thread only.
+class MidiClockTracker {
+public:
+    MidiClockTracker() = default;
+
+    // Called on MIDI Start: the next tick is beat 0
+    void reset(double nominalBpm) noexcept;
+    void processTick(double timeSeconds) noexcept;
+
+    // True while waiting for the first tick after Start or while ticks keep arriving
+    bool isFollowing(double timeSeconds) const noexcept;
+    bool isAwaitingFirstTick() const noexcept { return awaitingFirstTick; }
+    // True once the loop has narrowed since Start or the last dropout
+    bool isLocked() const noexcept { return phase == LoopPhase::Tracking; }
+
+    double getTempo() const noexcept;
+    double getBeatAt(double timeSeconds) const noexcept;
+    juce::int64 getTickCount() const noexcept { return tickCount; }
+
+private:
+    enum class LoopPhase { Acquiring, Tracking };
+
+    void restartLoop(double timeSeconds) noexcept;
+    void setBandwidth(double bandwidthHz) noexcept;
+
+    double nominalPeriod = 0.0;
+    double period = 0.0;
+    double tickTime = 0.0;
+    double nextTickTime = 0.0;
+    double lastRawTickTime = 0.0;
+    double loopGain = 0.0;
+    double periodGain = 0.0;
+    juce::int64 tickCount = 0;
+    LoopPhase phase = LoopPhase::Acquiring;
+    int ticksSinceRestart = 0;
+    bool awaitingFirstTick = false;
+};
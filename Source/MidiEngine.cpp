@@ -2,20 +2,38 @@
 #include "INIConfig.h"
 #include "ErrorHandling.h"
 #include "MidiFileManager.h"
+#include "Mixer.h"
+#include <algorithm>
+#include <cstring>
 
-MidiEngine::MidiEngine() : currentPlayerIndex(0), isPlaying(false), tempo(120.0f), hostTempo(0.0) {
+MidiEngine::MidiEngine()
+    : currentPlayerIndex(0), isPlaying(false), tempo(120.0f), hostTempo(0.0),
+      patternPreloader([this](const SongArranger::Section* pattern) { return isGroupPatternInUse(pattern); }) {
     for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
         players[i].playerIndex = i;
         players[i].swing = INIConfig::Defaults::SWING;
         players[i].energy = INIConfig::Defaults::ENERGY;
         players[i].outputChannel = i + 1;
+        controls[i].outputChannel = i + 1;
     }
 
+    seedHumanization();
     initializeScenes();
+    startTimerHz(INIConfig::LayoutConstants::midiEngineEventTimerHz);
 }
 
 MidiEngine::~MidiEngine() {
+    stopTimer();
     stopPlayback();
+
+    for (auto& published : publishedPatterns) {
+        delete published.exchange(nullptr);
+    }
+
+    juce::MidiMessageSequence* retired = nullptr;
+    while (retiredPatterns.pop(retired)) {
+        delete retired;
+    }
 }
 
 void MidiEngine::initializeScenes() {
@@ -25,7 +43,9 @@ void MidiEngine::initializeScenes() {
         scene.name = "";
         scene.tempo = tempo;
         scenes.add(scene);
+        compileScene(i);
     }
+    publishScenes();
 }
 
 void MidiEngine::prepare(double sampleRate) {
@@ -39,12 +59,9 @@ void MidiEngine::prepare(double sampleRate) {
 }
 
 void MidiEngine::process(juce::MidiBuffer& midiMessages) {
-    try {
-        if (!isPlaying) {
-            midiMessages.clear();
-            return;
-        }
+    int numSamples = 0;
 
+    if (isPlaying) {
         #if JUCE_MAC || JUCE_IOS
             const double currentTime = juce::Time::getHighResolutionTicks() / juce::Time::getHighResolutionTicksPerSecond() * 1000.0;
         #elif JUCE_WINDOWS
@@ -52,35 +69,47 @@ void MidiEngine::process(juce::MidiBuffer& midiMessages) {
         #else
             const double currentTime = juce::Time::getMillisecondCounterHiRes();
         #endif
-        
+
         const double deltaTime = currentTime - lastProcessTime;
         lastProcessTime = currentTime;
 
-        static thread_local juce::MidiBuffer tempBuffer;
-        tempBuffer.clear();
+        // Carry the fractional sample over so short calls still add up
+        const double elapsedSamples = deltaTime * sampleRate / INIConfig::Defaults::MS_PER_SECOND + wallClockSampleRemainder;
+        numSamples = static_cast<int>(std::floor(elapsedSamples));
+        wallClockSampleRemainder = elapsedSamples - numSamples;
+    }
 
-        processMidiInput(midiMessages);
+    process(midiMessages, numSamples);
+}
+
+void MidiEngine::process(juce::MidiBuffer& midiMessages, int numSamples) {
+    try {
+        drainCommands();
 
-        if (liveRecording) {
-            processLiveRecording(midiMessages);
+        if (inputTapEnabled.load(std::memory_order_relaxed)) {
+            tapMidiInput(midiMessages);
         }
 
-        if (loopRecordingMode) {
-            processLoopRecording();
+        followingExternalClock = false;
+        if (receiveMidiClock) {
+            processClockInput(midiMessages, numSamples);
         }
+        processedSamples += juce::jmax(0, numSamples);
 
-        midiMessages.clear();
+        if (!isPlaying) {
+            midiMessages.clear();
+            return;
+        }
 
-        processQueuedChanges();
+        processMidiInput(midiMessages);
+        processLiveRecording(midiMessages);
 
-        for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
-            if (players[i].enabled) {
-                processPlayer(i, midiMessages, deltaTime);
-            }
-        }
+        midiMessages.clear();
 
-        if (sendMidiClock) {
-            generateMidiClock(midiMessages);
+        renderScheduledBlock(midiMessages, juce::jmax(0, numSamples));
+
+        if (audioTakeId != INIConfig::Defaults::ZERO_VALUE) {
+            advanceRecordingLoops(transportBeat - takeStartBeat);
         }
     } catch (const std::exception& e) {
         ErrorHandler::getInstance().reportError(ErrorHandler::ErrorLevel::Error,
@@ -90,100 +119,643 @@ void MidiEngine::process(juce::MidiBuffer& midiMessages) {
 }
 
 void MidiEngine::processLiveRecording(const juce::MidiBuffer& midiMessages) {
-    if (!liveRecording) return;
+    if (audioTakeId == INIConfig::Defaults::ZERO_VALUE) return;
+
+    // A take armed while stopped starts with the transport
+    if (takeStartPending) {
+        takeStartBeat = transportBeat;
+        nextLoopEndBeat = audioLoopBeats;
+        takeStartPending = false;
+    }
 
+    // Stamped from the event's sample offset, so callback jitter does not move notes
     for (const auto metadata : midiMessages) {
         const auto message = metadata.getMessage();
 
         if (message.isNoteOnOrOff()) {
-            double timestamp = juce::Time::getMillisecondCounterHiRes() - recordStartTime;
+            recordMidiMessage(message, getBeatAfterSamples(metadata.samplePosition) - takeStartBeat);
+        }
+    }
+}
+
+void MidiEngine::advanceRecordingLoops(double takeBeat) {
+    if (audioLoopBeats <= 0.0) return;
+
+    while (takeBeat >= nextLoopEndBeat) {
+        RecordedEvent marker;
+        marker.type = RecordedEvent::Type::LoopEnd;
+        marker.takeId = audioTakeId;
+        marker.beat = nextLoopEndBeat;
 
-            if (overdubMode && currentPlayerIndex >= 0 && currentPlayerIndex < INIConfig::Defaults::MAX_PLAYERS) {
-                players[currentPlayerIndex].recordedPattern.addEvent(message, timestamp);
-            } else {
-                recordBuffer.addEvent(message, timestamp);
+        // Retried on the next call once the message thread has caught up
+        if (!recordedEvents.push(marker)) return;
+
+        nextLoopEndBeat += audioLoopBeats;
+    }
+}
+
+void MidiEngine::adoptPublishedPatterns() {
+    for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
+        // Leave it published until there is room to hand the old pattern back
+        if (retiredPatterns.isFull()) return;
+
+        if (auto* published = publishedPatterns[i].exchange(nullptr, std::memory_order_acquire)) {
+            players[i].currentPattern.swapWith(*published);
+            retiredPatterns.push(published);
+
+            // A recorded take plays instead of the button's pattern
+            if (players[i].groupPattern != nullptr) {
+                players[i].groupPattern = nullptr;
+                playingGroupPatterns[i].store(nullptr);
+                players[i].releaseHeldNotes = true;
             }
         }
     }
 }
 
-void MidiEngine::processLoopRecording() {
-    if (!loopRecordingMode || !liveRecording) return;
+void MidiEngine::renderScheduledBlock(juce::MidiBuffer& midiMessages, int numSamples) {
+    auto fire = [this](const LaunchScheduler::Launch& launch) { fireLaunch(launch); };
+
+    auto samplesUntil = [this](double beat) { return getSamplesUntilBeat(beat); };
+
+    queueSongSections();
+    launchScheduler.resolve(transportBeat, tempoMaps.read());
+    launchScheduler.popDue(transportBeat, fire);
+    queueSongSections();
+
+    // Split the block at each launch so the change lands on its grid sample
+    int position = 0;
+    while (position < numSamples) {
+        const int nextLaunch = launchScheduler.getNextLaunchOffset(transportBeat, numSamples - position, samplesUntil);
+        const int segmentLength = nextLaunch > 0 ? nextLaunch : numSamples - position;
 
-    double currentTime = juce::Time::getMillisecondCounterHiRes();
-    double elapsedTime = currentTime - loopRecordingStartTime;
-    double loopLengthMs = (loopRecordingBars * INIConfig::Defaults::BEATS_PER_BAR * INIConfig::Defaults::MS_PER_MINUTE) / tempo;
+        renderSegment(midiMessages, position, segmentLength);
+        position += segmentLength;
 
-    if (elapsedTime >= loopLengthMs) {
-        if (currentPlayerIndex >= 0 && currentPlayerIndex < INIConfig::Defaults::MAX_PLAYERS) {
-            players[currentPlayerIndex].currentPattern = recordBuffer;
-            players[currentPlayerIndex].recordedPattern.clear();
+        // Launches due exactly at the end of the block go out at the start of the next one
+        if (nextLaunch > 0) {
+            launchScheduler.popDue(transportBeat, fire);
+            queueSongSections();
         }
+    }
+}
+
+void MidiEngine::renderSegment(juce::MidiBuffer& midiMessages, int startSample, int numSamples) {
+    const double endBeat = getBeatAfterSamples(numSamples);
+    const double beats = endBeat - transportBeat;
+
+    if (sendMidiClock) {
+        generateMidiClock(midiMessages, startSample, numSamples);
+    }
 
-        loopRecordingStartTime = currentTime;
-        recordBuffer.clear();
+    if (metronomeEnabled) {
+        generateMetronome(midiMessages, startSample, numSamples);
+    }
+
+    for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
+        if (players[i].section != nullptr || players[i].scenePattern != nullptr || players[i].groupPattern != nullptr
+            || players[i].releaseHeldNotes) {
+            playSection(i, midiMessages, startSample, numSamples);
+        } else if (players[i].enabled) {
+            processPlayer(i, midiMessages, startSample, beats);
+        }
+    }
+
+    transportBeat = endBeat;
+    transportSample += numSamples;
+
+    if (usesTempoMap()) {
+        tempo = static_cast<float>(tempoMaps.read().getTempoAt(transportBeat));
     }
 }
 
-void MidiEngine::processQueuedChanges() {
-    double currentBeat = getCurrentBeat();
-    int currentBar = getCurrentBar();
+void MidiEngine::fireLaunch(const LaunchScheduler::Launch& launch) {
+    switch (launch.kind) {
+        case LaunchScheduler::Kind::Scene:
+            launchScene(launch.targetIndex);
+            break;
+
+        case LaunchScheduler::Kind::Clip:
+        case LaunchScheduler::Kind::Pattern:
+            startPattern(launch.playerIndex, launch.targetIndex);
+            break;
+
+        case LaunchScheduler::Kind::Section:
+            adoptSection(launch.playerIndex);
+            break;
+    }
+}
+
+void MidiEngine::queueSongSections() {
+    const auto& map = tempoMaps.read();
+    songArranger.setPlayheadBar(map.getBarPosition(transportBeat).bar);
+
+    // Offline there is no deadline to protect, and a section must never depend on
+    // whether the arranger thread happened to keep up
+    if (offlineRender.load(std::memory_order_relaxed)) {
+        songArranger.prepareSections();
+    }
+
+    for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
+        auto& player = players[i];
+
+        if (!songArranger.isActive(i)) {
+            if (player.section == nullptr && player.nextSection == nullptr) continue;
+
+            // Song mode was switched off; the player goes back to its own pattern
+            launchScheduler.cancel(LaunchScheduler::Kind::Section, i);
+            songArranger.retireSection(i, player.nextSection);
+            songArranger.retireSection(i, player.section);
+            player.nextSection = nullptr;
+            player.section = nullptr;
+            player.releaseHeldNotes = true;
+            continue;
+        }
 
-    for (int i = queuedChanges.size() - 1; i >= 0; --i) {
-        const auto& change = queuedChanges[i];
+        // A replaced or rewound chain: the current section keeps playing until the new one starts
+        if (player.nextSection != nullptr && !songArranger.isCurrent(i, *player.nextSection)) {
+            launchScheduler.cancel(LaunchScheduler::Kind::Section, i);
+            songArranger.retireSection(i, player.nextSection);
+            player.nextSection = nullptr;
+        }
+
+        while (player.nextSection == nullptr) {
+            auto* section = songArranger.popSection(i);
+            if (section == nullptr) break;
 
-        bool shouldTrigger = false;
+            // A section that arrives late still starts in phase; one that has already ended is skipped
+            const double startBeat = map.getBarStartBeat(section->startBar);
+            const bool missed = section->bars > 0 && map.getBarStartBeat(section->startBar + section->bars) <= transportBeat;
 
-        if (change.quantizationBars == 0) {
-            shouldTrigger = true;
-        } else {
-            if (currentBar % change.quantizationBars == 0 &&
-                std::fmod(currentBeat, INIConfig::Defaults::BEATS_PER_BAR) < INIConfig::Defaults::BEAT_THRESHOLD) {
-                shouldTrigger = true;
+            if (!songArranger.isCurrent(i, *section) || missed ||
+                !launchScheduler.scheduleAt(LaunchScheduler::Kind::Section, i, section->patternIndex, startBeat)) {
+                songArranger.retireSection(i, section);
+                continue;
             }
+
+            player.nextSection = section;
         }
+    }
+}
+
+void MidiEngine::adoptSection(int playerIndex) {
+    auto& player = players[playerIndex];
+    if (player.nextSection == nullptr) return;
+
+    songArranger.retireSection(playerIndex, player.section);
+    player.section = player.nextSection;
+    player.nextSection = nullptr;
+    player.scenePattern = nullptr;
+    player.sectionStartBeat = tempoMaps.read().getBarStartBeat(player.section->startBar);
+    player.fillActive = player.section->isFill;
+    player.releaseHeldNotes = true;
+    playingScenePatterns[playerIndex].store(nullptr);
+
+    // On time this is the first event; a section that arrived late joins in phase,
+    // skipping only events that belonged on a sample already rendered
+    player.sectionPass = 0;
+    player.sectionEvent = 0;
+
+    const auto* section = player.section;
+    if (section->loopBeats > 0.0 && getSamplesUntilBeat(player.sectionStartBeat) <= -1.0) {
+        player.sectionPass = static_cast<juce::int64>(std::floor((transportBeat - player.sectionStartBeat) / section->loopBeats));
+
+        const double passStart = player.sectionStartBeat + static_cast<double>(player.sectionPass) * section->loopBeats;
+        const auto* first = section->events.data();
+        const auto* next = std::partition_point(first, first + section->numEvents, [this, passStart](const SongArranger::Event& event) {
+            return getSamplesUntilBeat(passStart + event.beat) <= -1.0;
+        });
+        player.sectionEvent = static_cast<int>(next - first);
+    }
+
+    if (player.section->patternIndex != INIConfig::MIDI::INACTIVE_PATTERN) {
+        player.selectedPattern = player.section->patternIndex;
+        postEvent({ EngineEvent::Type::PatternStarted, playerIndex, player.section->patternIndex });
+    }
+}
+
+void MidiEngine::playSection(int playerIndex, juce::MidiBuffer& midiMessages, int startSample, int numSamples) {
+    auto& player = players[playerIndex];
+    const auto channelBits = static_cast<juce::uint8>((player.outputChannel - INIConfig::Validation::MIN_MIDI_CHANNEL) & 0x0F);
 
-        if (shouldTrigger) {
-            switch (change.type) {
-                case QueuedChange::Scene:
-                    loadScene(change.targetIndex);
-                    break;
-
-                case QueuedChange::Clip:
-                    if (change.playerIndex >= 0 && change.playerIndex < INIConfig::Defaults::MAX_PLAYERS) {
-                        selectPattern(change.playerIndex, change.targetIndex);
-                    }
-                    break;
-
-                case QueuedChange::Pattern:
-                    selectPattern(change.playerIndex, change.targetIndex);
-                    break;
+    // Whatever the previous section left sounding stops where the new one starts
+    if (player.releaseHeldNotes) {
+        for (int note = 0; note < INIConfig::MIDI::NUM_NOTE_NUMBERS; ++note) {
+            if (player.heldNotes[static_cast<size_t>(note)]) {
+                midiMessages.addEvent(juce::MidiMessage::noteOff(player.outputChannel, note), startSample);
             }
+        }
+        player.heldNotes.reset();
+        player.releaseHeldNotes = false;
+    }
+
+    const auto* section = player.section != nullptr ? player.section
+                        : player.scenePattern != nullptr ? player.scenePattern
+                        : player.groupPattern;
+    if (section == nullptr || section->numEvents == 0 || section->loopBeats <= 0.0) return;
+
+    // Placed like clock pulses: each event lands on the sample the tempo map puts it on,
+    // and one that rounds into the next segment waits for it
+    for (;;) {
+        if (player.sectionEvent >= section->numEvents) {
+            ++player.sectionPass;
+            player.sectionEvent = 0;
+        }
 
-            queuedChanges.remove(i);
+        const auto& event = section->events[static_cast<size_t>(player.sectionEvent)];
+        const double beat = player.sectionStartBeat + static_cast<double>(player.sectionPass) * section->loopBeats + event.beat;
+
+        const double samplesAhead = getSamplesUntilBeat(beat);
+        if (samplesAhead >= numSamples) break;
+
+        const int offset = samplesAhead <= 0.0 ? 0 : static_cast<int>(std::ceil(samplesAhead - 1.0e-6));
+        if (offset >= numSamples) break;
+
+        ++player.sectionEvent;
+
+        // A disabled player keeps its place in the song but stays silent
+        if (!player.enabled) continue;
+
+        juce::uint8 data[3] = {};
+        std::memcpy(data, event.data, event.size);
+        data[0] = static_cast<juce::uint8>((data[0] & 0xF0) | channelBits);
+
+        const int status = data[0] & 0xF0;
+        if (status == 0x90 && data[2] > 0) {
+            data[2] = static_cast<juce::uint8>(humanizeVelocity(player, data[2]));
+            player.heldNotes.set(data[1]);
+        } else if (status == 0x80 || status == 0x90) {
+            player.heldNotes.reset(data[1]);
         }
+
+        midiMessages.addEvent(data, event.size, startSample + offset);
     }
 }
 
-void MidiEngine::startLiveRecording(bool overdub) {
-    liveRecording = true;
-    overdubMode = overdub;
-    recordStartTime = juce::Time::getMillisecondCounterHiRes();
+double MidiEngine::getBeatsPerSample() const {
+    if (followingExternalClock) return clockFollowBeatsPerSample;
+    if (sampleRate <= 0.0) return 0.0;
+
+    return tempo / INIConfig::Defaults::SECONDS_PER_MINUTE / sampleRate;
+}
+
+bool MidiEngine::usesTempoMap() const {
+    // An external clock sets its own pace; a map without changes leaves tempo to setTempo()
+    return !followingExternalClock && sampleRate > 0.0 && tempoMaps.read().hasTempoChanges();
+}
+
+double MidiEngine::getBeatAfterSamples(double numSamples) const {
+    if (usesTempoMap()) {
+        const auto& map = tempoMaps.read();
+        return map.secondsToBeat(map.beatToSeconds(transportBeat) + numSamples / sampleRate);
+    }
+
+    return transportBeat + numSamples * getBeatsPerSample();
+}
+
+double MidiEngine::getSamplesUntilBeat(double beat) const {
+    if (usesTempoMap()) {
+        const auto& map = tempoMaps.read();
+        return (map.beatToSeconds(beat) - map.beatToSeconds(transportBeat)) * sampleRate;
+    }
+
+    const double beatsPerSample = getBeatsPerSample();
+    if (beatsPerSample <= 0.0) return std::numeric_limits<double>::max();
+
+    return (beat - transportBeat) / beatsPerSample;
+}
+
+void MidiEngine::pushCommand(const EngineCommand& command) {
+    // Message thread only; automation on the audio thread goes through automateSwing()/automateEnergy()
+    if (!engineCommands.push(command)) {
+        DBG("MidiEngine: Command queue full, dropping command");
+    }
+}
+
+void MidiEngine::drainCommands() {
+    sceneTable.update();
+    tempoMaps.update();
+
+    EngineCommand command;
+    while (engineCommands.pop(command)) {
+        applyCommand(command);
+    }
+
+    adoptPublishedPatterns();
+}
+
+void MidiEngine::applyCommand(const EngineCommand& command) {
+    auto isPlayerCommand = [&command] {
+        return INIConfig::isValidPlayerIndex(command.playerIndex);
+    };
+
+    switch (command.type) {
+        case EngineCommand::Type::SelectPattern:
+            startPattern(command.playerIndex, command.index);
+            break;
+
+        case EngineCommand::Type::SchedulePatternChange:
+            launchScheduler.scheduleAt(LaunchScheduler::Kind::Pattern, command.playerIndex, command.index,
+                                       tempoMaps.read().getBarStartBeat(command.bar));
+            break;
+
+        case EngineCommand::Type::ClearPendingPatternChanges:
+            launchScheduler.cancel(LaunchScheduler::Kind::Pattern, command.playerIndex);
+            break;
+
+        case EngineCommand::Type::QueueSceneChange:
+            launchScheduler.schedule(LaunchScheduler::Kind::Scene, INIConfig::MIDI::ALL_PLAYERS, command.index, command.bar);
+            break;
+
+        case EngineCommand::Type::QueueClipChange:
+            launchScheduler.schedule(LaunchScheduler::Kind::Clip, command.playerIndex, command.index, command.bar);
+            break;
+
+        case EngineCommand::Type::LaunchScene:
+            launchScene(command.index);
+            break;
+
+        case EngineCommand::Type::SetSwing:
+            if (isPlayerCommand()) players[command.playerIndex].swing = command.value;
+            break;
+
+        case EngineCommand::Type::SetEnergy:
+            if (isPlayerCommand()) players[command.playerIndex].energy = command.value;
+            break;
+
+        case EngineCommand::Type::SetPlayerEnabled:
+            if (isPlayerCommand()) players[command.playerIndex].enabled = command.index != 0;
+            break;
+
+        case EngineCommand::Type::SetOutputChannel:
+            if (isPlayerCommand()) players[command.playerIndex].outputChannel = command.index;
+            break;
+
+        case EngineCommand::Type::SetHumanization:
+            if (isPlayerCommand()) players[command.playerIndex].humanizationAmount = command.value;
+            break;
+
+        case EngineCommand::Type::SetVelocityCurve:
+            if (isPlayerCommand()) players[command.playerIndex].velocityCurve = static_cast<VelocityCurve>(command.index);
+            break;
+
+        case EngineCommand::Type::TriggerFill:
+            if (isPlayerCommand()) players[command.playerIndex].fillActive = true;
+            break;
+
+        case EngineCommand::Type::StartRecording:
+            audioTakeId = command.index;
+            audioLoopBeats = command.value;
+            takeStartPending = true;
+            break;
+
+        case EngineCommand::Type::StopRecording:
+            if (audioTakeId == command.index) audioTakeId = INIConfig::Defaults::ZERO_VALUE;
+            break;
+
+        case EngineCommand::Type::StartTransport:
+            startTransport(command.index);
+            break;
+
+        case EngineCommand::Type::StopTransport:
+            stopTransport();
+            break;
+    }
+}
+
+void MidiEngine::startPattern(int playerIndex, int patternIndex) {
+    if (!INIConfig::isValidPlayerIndex(playerIndex) ||
+        !INIConfig::isValidButtonIndex(patternIndex)) {
+        return;
+    }
+
+    auto& player = players[playerIndex];
+    player.selectedPattern = patternIndex;
+
+    // Counted around the read, so the preloader cannot reuse the pattern before it is
+    // recorded as playing
+    groupPatternReads.fetch_add(1);
+    const auto* pattern = groupPatterns[playerIndex][patternIndex].load();
+    playingGroupPatterns[playerIndex].store(pattern);
+    groupPatternReads.fetch_add(1);
+
+    // The scene's pattern was for the pattern it replaces
+    const bool wasLooping = player.scenePattern != nullptr || player.groupPattern != nullptr;
+    player.scenePattern = nullptr;
+    playingScenePatterns[playerIndex].store(nullptr);
+    player.groupPattern = pattern;
+
+    // Song mode keeps its own place; otherwise the new pattern starts here
+    if (player.section == nullptr && (wasLooping || pattern != nullptr)) {
+        player.sectionStartBeat = transportBeat;
+        player.sectionPass = 0;
+        player.sectionEvent = 0;
+        player.releaseHeldNotes = true;
+    }
+
+    postEvent({ EngineEvent::Type::PatternStarted, playerIndex, patternIndex });
+}
+
+void MidiEngine::launchScene(int sceneIndex) {
+    if (!juce::isPositiveAndBelow(sceneIndex, INIConfig::Defaults::MAX_SCENES)) return;
+
+    const auto& scene = sceneTable.read()[static_cast<size_t>(sceneIndex)];
+
+    if (scene.tempo > 0) {
+        setTempo(scene.tempo);
+    }
+
+    // Counted around the reads, as in startPattern(), so a replaced pattern is not freed
+    // before it is recorded as playing
+    scenePatternReads.fetch_add(1);
+
+    for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
+        const auto& clip = scene.clips[static_cast<size_t>(i)];
+        auto& player = players[i];
+
+        player.enabled = clip.active;
+        if (clip.active) {
+            player.selectedPattern = clip.patternIndex;
+            player.energy = clip.energy;
+        }
+
+        // Song mode keeps playing its own sections
+        if (player.section == nullptr && (clip.pattern != nullptr || player.scenePattern != nullptr)) {
+            player.scenePattern = clip.active ? clip.pattern : nullptr;
+            playingScenePatterns[i].store(player.scenePattern);
+            player.sectionStartBeat = transportBeat;
+            player.sectionPass = 0;
+            player.sectionEvent = 0;
+            player.releaseHeldNotes = true;
+        }
+
+        // The mixer runs after the engine, so the levels take effect in this same block
+        if (scene.hasMixerLevels && mixer != nullptr) {
+            mixer->setChannelVolume(i, clip.mixerVolume);
+            mixer->setChannelMute(i, clip.muted);
+        }
+    }
+
+    scenePatternReads.fetch_add(1);
+
+    postEvent({ EngineEvent::Type::SceneLaunched, INIConfig::MIDI::ALL_PLAYERS, sceneIndex });
+}
 
-    if (!overdub) {
-        recordBuffer.clear();
+void MidiEngine::postEvent(const EngineEvent& event) {
+    auto stamped = event;
+    stamped.samplePosition = transportSample;
+    stamped.beat = transportBeat;
+
+    if (!engineEvents.push(stamped)) {
+        DBG("MidiEngine: Event queue full, dropping event");
+    }
+}
+
+void MidiEngine::dispatchEngineEvents() {
+    EngineEvent event;
+    while (engineEvents.pop(event)) {
+        switch (event.type) {
+            case EngineEvent::Type::PatternStarted:
+                controls[event.playerIndex].selectedPattern = event.index;
+                queuedChanges.removeIf([&event](const QueuedChange& c) {
+                    return c.type != QueuedChange::Scene && c.playerIndex == event.playerIndex && c.targetIndex == event.index;
+                });
+                break;
+
+            case EngineEvent::Type::SceneLaunched:
+                activeSceneIndex = event.index;
+                applySceneToControls(event.index);
+                queuedChanges.removeIf([&event](const QueuedChange& c) {
+                    return c.type == QueuedChange::Scene && c.targetIndex == event.index;
+                });
+                break;
+
+            case EngineEvent::Type::MidiLearned:
+                completeMidiLearn(event.playerIndex, event.index);
+                break;
+
+            case EngineEvent::Type::SwingAutomated:
+                controls[event.playerIndex].swing = event.value;
+                break;
+
+            case EngineEvent::Type::EnergyAutomated:
+                controls[event.playerIndex].energy = event.value;
+                break;
+
+            case EngineEvent::Type::TransportStopped:
+                if (liveRecording) {
+                    stopLiveRecording();
+                }
+                break;
+        }
+
+        if (onEngineEvent) {
+            onEngineEvent(event);
+        }
+    }
+}
+
+void MidiEngine::timerCallback() {
+    collectRecordedEvents();
+    dispatchEngineEvents();
+    reclaimScenePatterns();
+}
+
+void MidiEngine::beginRecordingTake() {
+    recordBuffer.clear();
+    std::fill(std::begin(noteOnShift), std::end(noteOnShift), 0.0);
+
+    activeTakeId = ++lastTakeId;
+    recordPlayerIndex = juce::jlimit(0, INIConfig::Defaults::MAX_PLAYERS - 1, currentPlayerIndex);
+    takeLoopBeats = loopRecordingMode ? loopRecordingBars * INIConfig::Defaults::BEATS_PER_BAR : 0.0;
+    completedLoops = INIConfig::Defaults::ZERO_VALUE;
+
+    pushCommand({ EngineCommand::Type::StartRecording, recordPlayerIndex, activeTakeId, 0, static_cast<float>(takeLoopBeats) });
+}
+
+void MidiEngine::endRecordingTake() {
+    if (activeTakeId == INIConfig::Defaults::ZERO_VALUE) return;
+
+    collectRecordedEvents();
+    pushCommand({ EngineCommand::Type::StopRecording, recordPlayerIndex, activeTakeId });
+
+    // Notes still in flight from the audio thread belong to the closed take and are dropped
+    activeTakeId = INIConfig::Defaults::ZERO_VALUE;
+}
+
+void MidiEngine::collectRecordedEvents() {
+    RecordedEvent event;
+    while (recordedEvents.pop(event)) {
+        if (event.takeId != activeTakeId) continue;
+
+        if (event.type == RecordedEvent::Type::LoopEnd) {
+            if (loopRecordingMode && takeLoopBeats > 0.0) {
+                commitRecordedTake();
+                recordBuffer.clear();
+                ++completedLoops;
+            }
+            continue;
+        }
+
+        const juce::MidiMessage message(event.data, event.size);
+        const double passBeat = event.beat - completedLoops * takeLoopBeats;
+        recordBuffer.addEvent(message, quantizeRecordedEvent(message, passBeat));
     }
 
-    if (loopRecordingMode) {
-        loopRecordingStartTime = recordStartTime;
+    juce::MidiMessageSequence* retired = nullptr;
+    while (retiredPatterns.pop(retired)) {
+        delete retired;
     }
 }
 
+double MidiEngine::quantizeRecordedEvent(const juce::MidiMessage& message, double beat) {
+    const int note = message.getNoteNumber();
+
+    if (message.isNoteOn()) {
+        const double gridBeats = quantizeRecording ? LaunchScheduler::quantizationToGridBeats(quantization) : 0.0;
+        noteOnShift[note] = gridBeats > 0.0 ? std::round(beat / gridBeats) * gridBeats - beat : 0.0;
+    }
+
+    // Note-offs move with their note-on so the length is kept
+    return juce::jmax(0.0, beat + noteOnShift[note]);
+}
+
+void MidiEngine::commitRecordedTake() {
+    if (!INIConfig::isValidPlayerIndex(recordPlayerIndex)) return;
+
+    auto& pattern = controls[recordPlayerIndex].pattern;
+
+    if (overdubMode) {
+        pattern.addSequence(recordBuffer, 0.0);
+    } else {
+        pattern = recordBuffer;
+    }
+
+    pattern.updateMatchedPairs();
+    publishPattern(recordPlayerIndex);
+}
+
+void MidiEngine::publishPattern(int playerIndex) {
+    auto* sequence = new juce::MidiMessageSequence(controls[playerIndex].pattern);
+
+    // A pattern the audio thread never picked up can be freed here
+    if (auto* superseded = publishedPatterns[playerIndex].exchange(sequence, std::memory_order_acq_rel)) {
+        delete superseded;
+    }
+}
+
+void MidiEngine::startLiveRecording(bool overdub) {
+    liveRecording = true;
+    overdubMode = overdub;
+    beginRecordingTake();
+}
+
 void MidiEngine::stopLiveRecording() {
     liveRecording = false;
+    endRecordingTake();
 
-    if (recordBuffer.getNumEvents() > 0 && currentPlayerIndex >= 0 && currentPlayerIndex < INIConfig::Defaults::MAX_PLAYERS) {
-        players[currentPlayerIndex].currentPattern = recordBuffer;
+    if (recordBuffer.getNumEvents() > 0) {
+        commitRecordedTake();
     }
 }
 
@@ -191,7 +763,8 @@ void MidiEngine::setLoopRecordingMode(bool enabled) {
     loopRecordingMode = enabled;
 
     if (enabled && liveRecording) {
-        loopRecordingStartTime = juce::Time::getMillisecondCounterHiRes();
+        collectRecordedEvents();
+        beginRecordingTake();
     }
 }
 
@@ -265,7 +838,7 @@ void MidiEngine::queueSceneChange(int sceneIndex, int quantization) {
     change.type = QueuedChange::Scene;
     change.targetIndex = sceneIndex;
     change.playerIndex = -1;
-    change.quantizationBars = quantization;
+    change.quantization = quantization;
     change.triggerTime = juce::Time::getMillisecondCounterHiRes();
 
     queuedChanges.removeIf([](const QueuedChange& c) {
@@ -273,6 +846,7 @@ void MidiEngine::queueSceneChange(int sceneIndex, int quantization) {
     });
 
     queuedChanges.add(change);
+    pushCommand({ EngineCommand::Type::QueueSceneChange, change.playerIndex, sceneIndex, quantization });
 }
 
 void MidiEngine::queueClipChange(int playerIndex, int patternIndex, int quantization) {
@@ -282,7 +856,7 @@ void MidiEngine::queueClipChange(int playerIndex, int patternIndex, int quantiza
     change.type = QueuedChange::Clip;
     change.targetIndex = patternIndex;
     change.playerIndex = playerIndex;
-    change.quantizationBars = quantization;
+    change.quantization = quantization;
     change.triggerTime = juce::Time::getMillisecondCounterHiRes();
 
     queuedChanges.removeIf([playerIndex](const QueuedChange& c) {
@@ -290,22 +864,41 @@ void MidiEngine::queueClipChange(int playerIndex, int patternIndex, int quantiza
     });
 
     queuedChanges.add(change);
+    preparePattern(playerIndex, patternIndex);
+    pushCommand({ EngineCommand::Type::QueueClipChange, playerIndex, patternIndex, quantization });
 }
 
 void MidiEngine::saveScene(int sceneIndex, const juce::String& name) {
     if (sceneIndex < 0 || sceneIndex >= scenes.size()) return;
 
-    auto& scene = scenes.getReference(sceneIndex);
+    Scene scene;
     scene.name = name.isEmpty() ? ("Scene " + juce::String(sceneIndex + 1)) : name;
     scene.tempo = tempo;
+    scene.hasMixerLevels = mixer != nullptr;
 
     for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
-        scene.clips[i].active = players[i].enabled;
-        scene.clips[i].patternIndex = players[i].selectedPattern;
-        scene.clips[i].midiFileName = players[i].selectedMidiGroup;
-        scene.clips[i].volume = players[i].energy / INIConfig::Defaults::MAX_ENERGY;
-        scene.clips[i].muted = false;
+        auto& clip = scene.clips[i];
+        clip.active = controls[i].enabled;
+        clip.patternIndex = controls[i].selectedPattern;
+        clip.midiFileName = controls[i].selectedMidiGroup;
+        clip.midiFile = resolvePatternFile(clip.patternIndex, clip.midiFileName);
+        clip.volume = controls[i].energy / INIConfig::Defaults::MAX_ENERGY;
+
+        if (mixer != nullptr) {
+            clip.mixerVolume = mixer->getChannelVolume(i);
+            clip.muted = mixer->isChannelMuted(i);
+        }
     }
+
+    setScene(sceneIndex, scene);
+}
+
+void MidiEngine::setScene(int sceneIndex, const Scene& scene) {
+    if (sceneIndex < 0 || sceneIndex >= scenes.size()) return;
+
+    scenes.getReference(sceneIndex) = scene;
+    compileScene(sceneIndex);
+    publishScenes();
 }
 
 MidiEngine::Scene MidiEngine::getScene(int sceneIndex) const {
@@ -318,57 +911,140 @@ MidiEngine::Scene MidiEngine::getScene(int sceneIndex) const {
 void MidiEngine::loadScene(int sceneIndex) {
     if (sceneIndex < 0 || sceneIndex >= scenes.size()) return;
 
-    const auto& scene = scenes[sceneIndex];
     activeSceneIndex = sceneIndex;
+    applySceneToControls(sceneIndex);
+    pushCommand({ EngineCommand::Type::LaunchScene, INIConfig::MIDI::ALL_PLAYERS, sceneIndex });
+}
 
-    if (scene.tempo > 0) {
-        setTempo(scene.tempo);
-    }
+void MidiEngine::applySceneToControls(int sceneIndex) {
+    if (sceneIndex < 0 || sceneIndex >= scenes.size()) return;
+
+    const auto& scene = scenes.getReference(sceneIndex);
 
     for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
         const auto& clip = scene.clips[i];
+        auto& control = controls[i];
 
+        control.enabled = clip.active;
         if (clip.active) {
-            players[i].enabled = true;
-            players[i].selectedPattern = clip.patternIndex;
-            players[i].selectedMidiGroup = clip.midiFileName;
-            players[i].energy = clip.volume * INIConfig::Defaults::MAX_ENERGY;
+            control.selectedPattern = clip.patternIndex;
+            control.energy = clip.volume * INIConfig::Defaults::MAX_ENERGY;
 
-            if (!clip.midiFileName.isEmpty() && midiFileManager) {
-                playMidiFile(i, clip.midiFileName);
+            if (!clip.midiFileName.isEmpty()) {
+                control.selectedMidiGroup = clip.midiFileName;
             }
-        } else {
-            players[i].enabled = false;
         }
     }
+
+    // The scene may have moved players to other groups
+    preloadPatterns();
+}
+
+void MidiEngine::compileScene(int sceneIndex) {
+    if (!juce::isPositiveAndBelow(sceneIndex, juce::jmin(scenes.size(), INIConfig::Defaults::MAX_SCENES))) return;
+
+    const auto& scene = scenes.getReference(sceneIndex);
+    auto& playback = compiledScenes[static_cast<size_t>(sceneIndex)];
+
+    playback.tempo = scene.tempo;
+    playback.hasMixerLevels = scene.hasMixerLevels;
+    for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
+        const auto& source = scene.clips[i];
+        auto& clip = playback.clips[static_cast<size_t>(i)];
+        clip.active = source.active;
+        clip.patternIndex = source.patternIndex;
+        clip.energy = source.volume * INIConfig::Defaults::MAX_ENERGY;
+        clip.pattern = source.active ? compileScenePattern(source) : nullptr;
+        clip.mixerVolume = source.mixerVolume;
+        clip.muted = source.muted;
+    }
+}
+
+const SongArranger::Section* MidiEngine::compileScenePattern(const Scene::ClipState& clip) {
+    const auto file = clip.midiFile.getFullPathName().isNotEmpty()
+        ? clip.midiFile
+        : resolvePatternFile(clip.patternIndex, clip.midiFileName);
+    if (!file.existsAsFile()) return nullptr;
+
+    const auto modified = file.getLastModificationTime();
+    const double barBeats = tempoMapControl.getBeatsPerBarAt(INIConfig::MIDI::DEFAULT_POSITION);
+
+    auto& cached = scenePatterns[file.getFullPathName()];
+    if (cached.section != nullptr && cached.modified == modified && cached.barBeats == barBeats) {
+        return cached.section.get();
+    }
+
+    if (cached.section != nullptr) {
+        replacedScenePatterns.push_back(std::move(cached.section));
+    }
+
+    const auto bank = midiFileManager != nullptr ? midiFileManager->getPatternBank() : nullptr;
+    cached.section = std::make_unique<SongArranger::Section>();
+    SongArranger::compilePattern(*cached.section, file, barBeats, bank.get());
+    cached.modified = modified;
+    cached.barBeats = barBeats;
+    return cached.section.get();
+}
+
+void MidiEngine::publishScenes() {
+    sceneTable.write(compiledScenes);
+}
+
+bool MidiEngine::isScenePatternInUse(const SongArranger::Section* pattern) const {
+    const auto reads = scenePatternReads.load();
+    if ((reads & 1) != 0) return true;
+
+    // Until the audio thread picks up the newest table it may still launch from an older one
+    if (!sceneTable.isPublishedValueRead()) return true;
+
+    // Other scenes compiled from the same file keep the old pattern until they are compiled again
+    for (const auto& scene : compiledScenes) {
+        for (const auto& clip : scene.clips) {
+            if (clip.pattern == pattern) return true;
+        }
+    }
+
+    for (const auto& playing : playingScenePatterns) {
+        if (playing.load() == pattern) return true;
+    }
+
+    return scenePatternReads.load() != reads;
+}
+
+void MidiEngine::reclaimScenePatterns() {
+    replacedScenePatterns.erase(std::remove_if(replacedScenePatterns.begin(), replacedScenePatterns.end(),
+                                               [this](const std::unique_ptr<SongArranger::Section>& section) {
+                                                   return !isScenePatternInUse(section.get());
+                                               }),
+                                replacedScenePatterns.end());
 }
 
 void MidiEngine::clearScene(int sceneIndex) {
     if (sceneIndex >= 0 && sceneIndex < scenes.size()) {
         scenes.getReference(sceneIndex) = Scene();
         scenes.getReference(sceneIndex).name = "";
+        compileScene(sceneIndex);
+        publishScenes();
     }
 }
 
-void MidiEngine::processPlayer(int playerIndex, juce::MidiBuffer& midiMessages, double deltaTime) {
+void MidiEngine::processPlayer(int playerIndex, juce::MidiBuffer& midiMessages, int startSample, double beats) {
     if (playerIndex < 0 || playerIndex >= INIConfig::Defaults::MAX_PLAYERS) return;
 
     auto& player = players[playerIndex];
-    if (!player.enabled || (player.currentPattern.getNumEvents() == 0 && player.recordedPattern.getNumEvents() == 0)) return;
+    if (!player.enabled || player.currentPattern.getNumEvents() == 0) return;
 
-    const double beatsPerMs = (tempo / INIConfig::Defaults::SECONDS_PER_MINUTE) / INIConfig::Defaults::MS_PER_SECOND;
-    const double beats = deltaTime * beatsPerMs;
     player.playbackPosition += beats;
 
-    const double patternLength = INIConfig::Defaults::BEATS_PER_BAR;
+    const double patternLength = tempoMaps.read().getBeatsPerBarAt(transportBeat);
     if (player.playbackPosition >= patternLength) {
         player.playbackPosition = std::fmod(player.playbackPosition, patternLength);
     }
 
-    generatePatternNotes(playerIndex, midiMessages);
+    generatePatternNotes(playerIndex, midiMessages, startSample);
 }
 
-void MidiEngine::generatePatternNotes(int playerIndex, juce::MidiBuffer& midiMessages) {
+void MidiEngine::generatePatternNotes(int playerIndex, juce::MidiBuffer& midiMessages, int startSample) {
     auto& player = players[playerIndex];
 
     float velocityScale = player.energy / INIConfig::Defaults::MAX_ENERGY;
@@ -377,48 +1053,159 @@ void MidiEngine::generatePatternNotes(int playerIndex, juce::MidiBuffer& midiMes
     if (beatPosition < INIConfig::Defaults::BEAT_THRESHOLD) {
         int velocity = static_cast<int>(INIConfig::LayoutConstants::midiEngineMaxMidiVelocity * velocityScale);
         velocity = juce::jlimit(1, INIConfig::LayoutConstants::midiEngineMaxMidiVelocity, velocity);
+        velocity = humanizeVelocity(player, velocity);
 
         auto noteOn = juce::MidiMessage::noteOn(player.outputChannel, INIConfig::LayoutConstants::midiEngineDefaultDrumNote, (juce::uint8)velocity);
-        midiMessages.addEvent(noteOn, 0);
+        midiMessages.addEvent(noteOn, startSample);
 
         auto noteOff = juce::MidiMessage::noteOff(player.outputChannel, INIConfig::LayoutConstants::midiEngineDefaultDrumNote);
-        midiMessages.addEvent(noteOff, INIConfig::LayoutConstants::midiEngineNoteOffDelay);
+        midiMessages.addEvent(noteOff, startSample + INIConfig::LayoutConstants::midiEngineNoteOffDelay);
     }
 }
 
-void MidiEngine::generateMidiClock(juce::MidiBuffer& midiMessages) {
+void MidiEngine::generateMidiClock(juce::MidiBuffer& midiMessages, int startSample, int numSamples) {
     const double pulsesPerBeat = INIConfig::LayoutConstants::midiEngineMidiClockPulsesPerBeat;
-    const double msPerPulse = (INIConfig::Defaults::MS_PER_MINUTE / tempo) / pulsesPerBeat;
+    const double transportPulse = transportBeat * pulsesPerBeat;
 
-    if (juce::Time::getMillisecondCounterHiRes() - lastClockTime >= msPerPulse) {
-        auto clockMessage = juce::MidiMessage::midiClock();
-        midiMessages.addEvent(clockMessage, 0);
-        lastClockTime = juce::Time::getMillisecondCounterHiRes();
+    // After a locate, pick up from the next pulse instead of bursting or skipping
+    if (std::abs(static_cast<double>(nextClockPulse) - transportPulse) > 1.0) {
+        nextClockPulse = static_cast<juce::int64>(std::ceil(transportPulse - 1.0e-9));
+    }
+
+    // Each pulse is placed through the tempo map, so pulses follow a ramp sample by sample
+    for (;;) {
+        const double samplesAhead = getSamplesUntilBeat(static_cast<double>(nextClockPulse) / pulsesPerBeat);
+        if (samplesAhead >= numSamples) break;
+
+        const int offset = samplesAhead <= 0.0 ? 0 : static_cast<int>(std::ceil(samplesAhead - 1.0e-6));
+        if (offset >= numSamples) break;
+
+        midiMessages.addEvent(juce::MidiMessage::midiClock(), startSample + offset);
+        ++nextClockPulse;
+    }
+}
+
+void MidiEngine::processClockInput(const juce::MidiBuffer& midiMessages, int numSamples) {
+    if (sampleRate <= 0.0) return;
+
+    const double blockStartTime = static_cast<double>(processedSamples) / sampleRate;
+
+    for (const auto metadata : midiMessages) {
+        const auto message = metadata.getMessage();
+        if (message.isMidiClock() || message.isMidiStart() || message.isMidiStop() || message.isMidiContinue()) {
+            handleClockMessage(message, blockStartTime + metadata.samplePosition / sampleRate);
+        }
+    }
+
+    // Steer the transport to where the loop puts the clock at the end of this block
+    const double blockEndTime = static_cast<double>(processedSamples + juce::jmax(0, numSamples)) / sampleRate;
+    followingExternalClock = clockTracker.isFollowing(blockEndTime);
+
+    if (followingExternalClock && numSamples > 0) {
+        const double targetBeat = clockBeatOffset + clockTracker.getBeatAt(blockEndTime);
+        clockFollowBeatsPerSample = juce::jmax(0.0, targetBeat - transportBeat) / numSamples;
+
+        if (clockTracker.getTickCount() > 1) {
+            tempo = INIConfig::clampTempo(static_cast<float>(clockTracker.getTempo()));
+        }
+    }
+}
+
+void MidiEngine::handleClockMessage(const juce::MidiMessage& message, double timeSeconds) {
+    if (message.isMidiClock()) {
+        // Clock without a Start: lock on from wherever the transport is
+        if (clockTracker.getTickCount() == 0 && !clockTracker.isAwaitingFirstTick()) {
+            clockBeatOffset = transportBeat;
+        }
+        clockTracker.processTick(timeSeconds);
+    } else if (message.isMidiStart()) {
+        startTransport(INIConfig::Defaults::ZERO_VALUE);
+        clockTracker.reset(tempo);
+        clockBeatOffset = INIConfig::MIDI::DEFAULT_POSITION;
+    } else if (message.isMidiStop()) {
+        // Nothing more goes into the take; the message thread commits it when the event arrives
+        isPlaying = false;
+        audioTakeId = INIConfig::Defaults::ZERO_VALUE;
+        postEvent({ EngineEvent::Type::TransportStopped });
+    } else if (message.isMidiContinue()) {
+        isPlaying = true;
     }
 }
 
 void MidiEngine::startPlayback() {
+    pushCommand({ EngineCommand::Type::StartTransport });
+}
+
+void MidiEngine::stopPlayback() {
+    pushCommand({ EngineCommand::Type::StopTransport });
+
+    if (liveRecording) {
+        stopLiveRecording();
+    }
+}
+
+void MidiEngine::startTransport(int countInBarsToPlay) {
+    countingIn = countInBarsToPlay > 0;
+    countInPosition = 0;
+
     isPlaying = true;
+    songArranger.rewind(INIConfig::Defaults::ZERO_VALUE);
     lastProcessTime = juce::Time::getMillisecondCounterHiRes();
-    lastClockTime = lastProcessTime;
+
+    if (offlineRender.load(std::memory_order_relaxed)) {
+        seedHumanization();
+    }
+
+    nextClockPulse = 0;
+    nextMetronomeBeat = INIConfig::MIDI::DEFAULT_POSITION;
+    transportBeat = INIConfig::MIDI::DEFAULT_POSITION;
+    transportSample = 0;
+    wallClockSampleRemainder = 0.0;
 
     for (auto& player : players) {
         player.playbackPosition = 0.0;
+
+        // A launched scene's or button's pattern starts over with the transport
+        if (player.scenePattern != nullptr || player.groupPattern != nullptr) {
+            player.sectionStartBeat = INIConfig::MIDI::DEFAULT_POSITION;
+            player.sectionPass = 0;
+            player.sectionEvent = 0;
+        }
     }
 }
 
-void MidiEngine::stopPlayback() {
+void MidiEngine::stopTransport() {
     isPlaying = false;
+    countingIn = false;
 
-    if (liveRecording) {
-        stopLiveRecording();
-    }
+    // Cue every chain from the top again so the next start is ready on its first sample
+    songArranger.rewind(INIConfig::Defaults::ZERO_VALUE);
 }
 
 void MidiEngine::setTempo(float newTempo) {
     tempo = INIConfig::clampTempo(newTempo);
 }
 
+void MidiEngine::setTempoMap(const TempoMap& map) {
+    const double barBeats = tempoMapControl.getBeatsPerBarAt(INIConfig::MIDI::DEFAULT_POSITION);
+
+    tempoMapControl = map;
+    tempoMaps.write(tempoMapControl);
+    songArranger.setTempoMap(tempoMapControl);
+
+    // Preloaded patterns loop on whole bars
+    if (tempoMapControl.getBeatsPerBarAt(INIConfig::MIDI::DEFAULT_POSITION) != barBeats) {
+        preloadPatterns();
+    }
+}
+
+void MidiEngine::setTimeSignature(int numerator, int denominator) {
+    auto map = tempoMapControl;
+    if (map.addMeterChange(INIConfig::Defaults::ZERO_VALUE, numerator, denominator)) {
+        setTempoMap(map);
+    }
+}
+
 void MidiEngine::setCurrentPlayer(int index) {
     currentPlayerIndex = INIConfig::clampPlayerIndex(index);
 }
@@ -429,46 +1216,214 @@ void MidiEngine::selectPattern(int playerIndex, int patternIndex) {
         return;
     }
 
-    players[playerIndex].selectedPattern = patternIndex;
+    controls[playerIndex].selectedPattern = patternIndex;
+    preparePattern(playerIndex, patternIndex);
+    pushCommand({ EngineCommand::Type::SelectPattern, playerIndex, patternIndex });
+}
+
+void MidiEngine::setMidiFileManager(MidiFileManager* manager) {
+    midiFileManager = manager;
+    preloadPatterns();
+}
+
+void MidiEngine::preloadPatterns() {
+    if (midiFileManager == nullptr) return;
+
+    patternPreloader.setPatternBank(midiFileManager->getPatternBank());
+    patternPreloader.setBarBeats(tempoMapControl.getBeatsPerBarAt(INIConfig::MIDI::DEFAULT_POSITION));
+
+    // The players' own groups first, then the groups either side of them in the list
+    juce::StringArray groups;
+    for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
+        groups.addIfNotAlreadyThere(getPlayerGroupName(i));
+    }
+
+    const auto groupNames = midiFileManager->getGroupNames();
+    const int numPlayerGroups = groups.size();
+    for (int distance = 1; distance <= INIConfig::MIDI::PATTERN_PRELOAD_NEIGHBOUR_GROUPS; ++distance) {
+        for (int i = 0; i < numPlayerGroups; ++i) {
+            const int index = groupNames.indexOf(groups[i]);
+            if (index < 0) continue;
+
+            for (const int neighbour : { index - distance, index + distance }) {
+                if (juce::isPositiveAndBelow(neighbour, groupNames.size())) {
+                    groups.addIfNotAlreadyThere(groupNames[neighbour]);
+                }
+            }
+        }
+    }
+
+    juce::Array<juce::File> files;
+    for (const auto& group : groups) {
+        files.addArray(midiFileManager->getGroupMidiFiles(group));
+    }
+    patternPreloader.prefetch(files);
+}
+
+bool MidiEngine::preparePattern(int playerIndex, int patternIndex) {
+    if (!INIConfig::isValidPlayerIndex(playerIndex) ||
+        !INIConfig::isValidButtonIndex(patternIndex)) {
+        return false;
+    }
+
+    // Resolved every time, since the group or the file may have changed since
+    const auto file = resolvePatternFile(patternIndex, controls[playerIndex].selectedMidiGroup);
+    const auto* pattern = file.existsAsFile() ? patternPreloader.getPattern(file) : nullptr;
+
+    groupPatterns[playerIndex][patternIndex].store(pattern);
+    return pattern != nullptr;
+}
+
+bool MidiEngine::isGroupPatternInUse(const SongArranger::Section* pattern) const {
+    const auto reads = groupPatternReads.load();
+    if ((reads & 1) != 0) return true;
+
+    for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
+        if (playingGroupPatterns[i].load() == pattern) return true;
+
+        for (const auto& slot : groupPatterns[i]) {
+            if (slot.load() == pattern) return true;
+        }
+    }
+
+    // The audio thread may have picked it up while the tables were being looked through
+    return groupPatternReads.load() != reads;
+}
+
+void MidiEngine::setPatternChain(int playerIndex, const SongArranger::Chain& chain) {
+    if (!INIConfig::isValidPlayerIndex(playerIndex)) return;
+
+    // Resolved here because the file manager belongs to the message thread
+    auto resolved = chain;
+    for (auto& step : resolved.steps) {
+        if (step.midiFile.getFullPathName().isEmpty()) {
+            step.midiFile = resolvePatternFile(step.patternIndex);
+        }
+        if (step.fillMidiFile.getFullPathName().isEmpty() && step.fillPatternIndex != INIConfig::MIDI::INACTIVE_PATTERN) {
+            step.fillMidiFile = resolvePatternFile(step.fillPatternIndex);
+        }
+    }
+
+    if (midiFileManager != nullptr) {
+        songArranger.setPatternBank(midiFileManager->getPatternBank());
+    }
+
+    const int startBar = isPlaying ? getCurrentBar() + INIConfig::Defaults::ONE_VALUE : INIConfig::Defaults::ZERO_VALUE;
+    songArranger.setChain(playerIndex, resolved, startBar);
+}
+
+void MidiEngine::clearPatternChain(int playerIndex) {
+    songArranger.clearChain(playerIndex);
+}
+
+juce::File MidiEngine::resolvePatternFile(int patternIndex, const juce::String& groupName) const {
+    if (midiFileManager == nullptr) return {};
+
+    const auto files = groupName.isNotEmpty() && midiFileManager->isBeatsButtonGroup(groupName)
+        ? midiFileManager->getBeatsButtonGroupFiles(groupName)
+        : midiFileManager->getCurrentGroupFiles();
+    if (!juce::isPositiveAndBelow(patternIndex, files.size())) return {};
+
+    return midiFileManager->getMidiFile(files[patternIndex]);
+}
+
+juce::String MidiEngine::getPlayerGroupName(int playerIndex) const {
+    // As resolvePatternFile() has it: a player without a beats-button group uses the current group
+    const auto& groupName = controls[playerIndex].selectedMidiGroup;
+    return groupName.isNotEmpty() && midiFileManager->isBeatsButtonGroup(groupName)
+        ? groupName
+        : midiFileManager->getCurrentGroupName();
 }
 
 void MidiEngine::playMidiFile(int playerIndex, const juce::String& filename) {
     if (!INIConfig::isValidPlayerIndex(playerIndex)) return;
 
-    players[playerIndex].selectedMidiGroup = filename;
+    controls[playerIndex].selectedMidiGroup = filename;
+    preloadPatterns();
 }
 
 void MidiEngine::setSwing(int playerIndex, float swing) {
     if (!INIConfig::isValidPlayerIndex(playerIndex)) return;
 
-    players[playerIndex].swing = INIConfig::clampSwing(swing);
+    controls[playerIndex].swing = INIConfig::clampSwing(swing);
+    pushCommand({ EngineCommand::Type::SetSwing, playerIndex, 0, 0, controls[playerIndex].swing });
 }
 
 void MidiEngine::setEnergy(int playerIndex, float energy) {
     if (!INIConfig::isValidPlayerIndex(playerIndex)) return;
 
-    players[playerIndex].energy = INIConfig::clampEnergy(energy);
+    controls[playerIndex].energy = INIConfig::clampEnergy(energy);
+    pushCommand({ EngineCommand::Type::SetEnergy, playerIndex, 0, 0, controls[playerIndex].energy });
+}
+
+void MidiEngine::automateSwing(int playerIndex, float swing) {
+    if (!INIConfig::isValidPlayerIndex(playerIndex)) return;
+
+    EngineEvent event;
+    event.type = EngineEvent::Type::SwingAutomated;
+    event.playerIndex = playerIndex;
+    event.value = INIConfig::clampSwing(swing);
+
+    players[playerIndex].swing = event.value;
+    postEvent(event);
+}
+
+void MidiEngine::automateEnergy(int playerIndex, float energy) {
+    if (!INIConfig::isValidPlayerIndex(playerIndex)) return;
+
+    EngineEvent event;
+    event.type = EngineEvent::Type::EnergyAutomated;
+    event.playerIndex = playerIndex;
+    event.value = INIConfig::clampEnergy(energy);
+
+    players[playerIndex].energy = event.value;
+    postEvent(event);
 }
 
 float MidiEngine::getSwing(int playerIndex) const {
     if (!INIConfig::isValidPlayerIndex(playerIndex)) return INIConfig::Defaults::SWING;
 
-    return players[playerIndex].swing;
+    return controls[playerIndex].swing;
 }
 
 float MidiEngine::getEnergy(int playerIndex) const {
     if (!INIConfig::isValidPlayerIndex(playerIndex)) return INIConfig::Defaults::ENERGY;
 
-    return players[playerIndex].energy;
+    return controls[playerIndex].energy;
 }
 
 void MidiEngine::triggerFill(int playerIndex) {
     if (!INIConfig::isValidPlayerIndex(playerIndex)) return;
 
-    players[playerIndex].fillActive = true;
+    pushCommand({ EngineCommand::Type::TriggerFill, playerIndex });
+}
+
+void MidiEngine::setInputTapEnabled(bool enabled) {
+    InputNote stale;
+    while (inputTap.pop(stale)) {
+    }
+    inputTapEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void MidiEngine::tapMidiInput(const juce::MidiBuffer& midiMessages) {
+    if (sampleRate <= 0.0) return;
+
+    for (const auto metadata : midiMessages) {
+        if (metadata.numBytes != 3 || (metadata.data[0] & 0xF0) != 0x90 || metadata.data[2] == 0) continue;
+
+        InputNote note;
+        note.time = static_cast<double>(processedSamples + metadata.samplePosition) / sampleRate;
+        note.channel = static_cast<juce::uint8>((metadata.data[0] & 0x0F) + 1);
+        note.note = metadata.data[1];
+        note.velocity = metadata.data[2];
+
+        if (!inputTap.push(note)) return;
+    }
 }
 
 void MidiEngine::processMidiInput(const juce::MidiBuffer& midiMessages) {
+    ccDispatchTable.update();
+
     try {
         // Null-pointer safety: Validate MIDI buffer
         if (midiMessages.getNumEvents() == 0) {
@@ -525,72 +1480,33 @@ void MidiEngine::handleMidiCC(int channel, int ccNumber, int value) {
             return;
         }
 
-        // Handle MIDI learn mode with null-pointer safety
-        if (midiLearnActive && currentLearnParameter.isNotEmpty()) {
-            MidiMapping newMapping;
-            newMapping.ccNumber = ccNumber;
-            newMapping.channel = channel;
-            newMapping.parameterID = currentLearnParameter;
-            newMapping.minValue = 0.0f;
-            newMapping.maxValue = 1.0f;
-            newMapping.enabled = true;
-
-            ErrorHandler::safeExecute([&]() {
-                addMidiMapping(newMapping);
-            }, "MidiEngine add mapping");
-            
-            midiLearnActive = false;
-            currentLearnParameter.clear();
-
-            // Null-pointer safety: Check callback before calling
-            if (onMidiLearnComplete) {
-                try {
-                    onMidiLearnComplete(newMapping);
-                } catch (const std::exception& e) {
-                    DBG("MidiEngine: Exception in MIDI learn callback - " + juce::String(e.what()));
-                }
+        // MIDI learn takes the first CC; the mapping itself is made on the message thread
+        if (midiLearnActive.load(std::memory_order_acquire)) {
+            bool expected = true;
+            if (midiLearnActive.compare_exchange_strong(expected, false, std::memory_order_acq_rel)) {
+                postEvent({ EngineEvent::Type::MidiLearned, channel, ccNumber });
             }
             return;
         }
 
-        // Process existing MIDI mappings with null-pointer safety
-        if (midiMappings.isEmpty()) {
+        const auto& table = ccDispatchTable.read();
+        const auto& slot = table.slots[static_cast<size_t>(CCDispatchTable::slotIndex(channel, ccNumber))];
+        if (slot.count == 0) {
             return;
         }
 
-        for (const auto& mapping : midiMappings) {
-            // Null-pointer safety: Validate mapping data
-            if (!mapping.enabled ||
-                mapping.ccNumber != ccNumber ||
-                (mapping.channel != 0 && mapping.channel != channel) ||
-                mapping.parameterID.isEmpty()) {
-                continue;
-            }
-
-            // Null-pointer safety: Safe value conversion with bounds checking
-            float maxVelocity = static_cast<float>(INIConfig::LayoutConstants::midiEngineMaxMidiVelocity);
-            if (maxVelocity <= 0.0f) {
-                DBG("MidiEngine: Invalid max MIDI velocity configuration");
-                continue;
-            }
-
-            float normalizedValue = juce::jlimit(0.0f, 1.0f, value / maxVelocity);
-            float valueRange = mapping.maxValue - mapping.minValue;
-            
-            // Validate mapping range
-            if (!std::isfinite(mapping.minValue) || !std::isfinite(mapping.maxValue) ||
-                !std::isfinite(valueRange)) {
-                DBG("MidiEngine: Invalid mapping range for parameter: " + mapping.parameterID);
-                continue;
-            }
+        const float normalizedValue = static_cast<float>(value) / INIConfig::MIDI::VELOCITY_DIVISOR;
 
-            float mappedValue = mapping.minValue + (normalizedValue * valueRange);
-            mappedValue = juce::jlimit(mapping.minValue, mapping.maxValue, mappedValue);
+        for (int i = slot.first; i < slot.first + slot.count; ++i) {
+            const auto& binding = table.bindings[static_cast<size_t>(i)];
+            const float mappedValue = juce::jlimit(binding.minValue, binding.maxValue,
+                                                   binding.minValue + normalizedValue * (binding.maxValue - binding.minValue));
 
-            // Null-pointer safety: Check callback before calling
-            if (onMidiParameterChanged) {
+            if (binding.parameter != nullptr) {
+                binding.parameter->setValueNotifyingHost(binding.parameter->convertTo0to1(mappedValue));
+            } else if (onMidiParameterChanged) {
                 try {
-                    onMidiParameterChanged(mapping.parameterID, mappedValue);
+                    onMidiParameterChanged(table.unresolvedParameterIDs[binding.unresolvedIndex], mappedValue);
                 } catch (const std::exception& e) {
                     DBG("MidiEngine: Exception in parameter change callback - " + juce::String(e.what()));
                 }
@@ -602,16 +1518,49 @@ void MidiEngine::handleMidiCC(int channel, int ccNumber, int value) {
 }
 
 void MidiEngine::startMidiLearn(const juce::String& parameterID) {
-    midiLearnActive = true;
     currentLearnParameter = parameterID;
+    midiLearnActive.store(true, std::memory_order_release);
 }
 
 void MidiEngine::cancelMidiLearn() {
-    midiLearnActive = false;
+    midiLearnActive.store(false, std::memory_order_release);
     currentLearnParameter.clear();
 }
 
+void MidiEngine::completeMidiLearn(int channel, int ccNumber) {
+    // Learning was cancelled or started over since the CC arrived
+    if (currentLearnParameter.isEmpty() || midiLearnActive.load(std::memory_order_acquire)) return;
+
+    MidiMapping newMapping;
+    newMapping.ccNumber = ccNumber;
+    newMapping.channel = channel;
+    newMapping.parameterID = currentLearnParameter;
+    newMapping.minValue = 0.0f;
+    newMapping.maxValue = 1.0f;
+    newMapping.enabled = true;
+
+    ErrorHandler::safeExecute([&]() {
+        addMidiMapping(newMapping);
+    }, "MidiEngine add mapping");
+
+    currentLearnParameter.clear();
+
+    // Null-pointer safety: Check callback before calling
+    if (onMidiLearnComplete) {
+        try {
+            onMidiLearnComplete(newMapping);
+        } catch (const std::exception& e) {
+            DBG("MidiEngine: Exception in MIDI learn callback - " + juce::String(e.what()));
+        }
+    }
+}
+
 void MidiEngine::addMidiMapping(const MidiMapping& mapping) {
+    insertMidiMapping(mapping);
+    rebuildCCDispatchTable();
+}
+
+void MidiEngine::insertMidiMapping(const MidiMapping& mapping) {
     midiMappings.removeIf([&mapping](const MidiMapping& m) {
         return m.parameterID == mapping.parameterID;
     });
@@ -623,10 +1572,91 @@ void MidiEngine::removeMidiMapping(const juce::String& parameterID) {
     midiMappings.removeIf([&parameterID](const MidiMapping& m) {
         return m.parameterID == parameterID;
     });
+    rebuildCCDispatchTable();
 }
 
 void MidiEngine::clearAllMidiMappings() {
     midiMappings.clear();
+    rebuildCCDispatchTable();
+}
+
+void MidiEngine::setParameterResolver(std::function<juce::RangedAudioParameter*(const juce::String&)> resolver) {
+    parameterResolver = std::move(resolver);
+    rebuildCCDispatchTable();
+}
+
+void MidiEngine::rebuildCCDispatchTable() {
+    const juce::SpinLock::ScopedLockType lock(ccDispatchWriteLock);
+
+    auto& table = ccDispatchTable.getWriteBuffer();
+    table.slots.fill({});
+    table.unresolvedParameterIDs.clearQuick();
+
+    auto isDispatchable = [](const MidiMapping& mapping) {
+        return mapping.enabled && mapping.parameterID.isNotEmpty()
+            && juce::isPositiveAndBelow(mapping.ccNumber, INIConfig::MIDI::NUM_CC_NUMBERS)
+            && (mapping.channel == INIConfig::MIDI::OMNI_CHANNEL
+                || (mapping.channel >= INIConfig::Validation::MIN_MIDI_CHANNEL && mapping.channel <= INIConfig::Validation::MAX_MIDI_CHANNEL))
+            && std::isfinite(mapping.minValue) && std::isfinite(mapping.maxValue);
+    };
+
+    // Omni mappings occupy a slot on every channel
+    auto forEachSlot = [](const MidiMapping& mapping, auto&& callback) {
+        const bool omni = mapping.channel == INIConfig::MIDI::OMNI_CHANNEL;
+        const int firstChannel = omni ? INIConfig::Validation::MIN_MIDI_CHANNEL : mapping.channel;
+        const int lastChannel = omni ? INIConfig::Validation::MAX_MIDI_CHANNEL : mapping.channel;
+
+        for (int channel = firstChannel; channel <= lastChannel; ++channel)
+            callback(static_cast<size_t>(CCDispatchTable::slotIndex(channel, mapping.ccNumber)));
+    };
+
+    // Count bindings per slot first so each slot's bindings can be laid out contiguously
+    int numBindings = 0;
+    for (const auto& mapping : midiMappings) {
+        if (!isDispatchable(mapping))
+            continue;
+
+        forEachSlot(mapping, [&](size_t slot) {
+            if (numBindings < INIConfig::MIDI::MAX_CC_BINDINGS) {
+                ++table.slots[slot].count;
+                ++numBindings;
+            }
+        });
+    }
+
+    if (numBindings >= INIConfig::MIDI::MAX_CC_BINDINGS)
+        DBG("MidiEngine: CC dispatch table full, some mappings will be ignored");
+
+    juce::uint16 nextBinding = 0;
+    for (auto& slot : table.slots) {
+        slot.first = nextBinding;
+        nextBinding = static_cast<juce::uint16>(nextBinding + slot.count);
+    }
+
+    std::array<juce::uint16, std::tuple_size<decltype(table.slots)>::value> filled{};
+    for (const auto& mapping : midiMappings) {
+        if (!isDispatchable(mapping))
+            continue;
+
+        CCBinding binding;
+        binding.parameter = parameterResolver ? parameterResolver(mapping.parameterID) : nullptr;
+        binding.minValue = mapping.minValue;
+        binding.maxValue = mapping.maxValue;
+
+        if (binding.parameter == nullptr) {
+            binding.unresolvedIndex = table.unresolvedParameterIDs.size();
+            table.unresolvedParameterIDs.add(mapping.parameterID);
+        }
+
+        forEachSlot(mapping, [&](size_t slot) {
+            if (filled[slot] < table.slots[slot].count) {
+                table.bindings[static_cast<size_t>(table.slots[slot].first + filled[slot])] = binding;
+                ++filled[slot];
+            }
+        });
+    }
+
+    ccDispatchTable.publish();
 }
 
 MidiEngine::MidiMapping MidiEngine::getMidiMapping(const juce::String& parameterID) const {
@@ -665,7 +1695,7 @@ void MidiEngine::saveStates(ComponentState& state) {
     state.toggleStates[112] = loopRecordingMode;
 
     for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
-        const auto& player = players[i];
+        const auto& player = controls[i];
         const juce::String playerPrefix = "player_" + juce::String(i) + "_";
 
         state.toggleStates[200 + i] = player.enabled;
@@ -714,27 +1744,46 @@ void MidiEngine::loadStates(const ComponentState& state) {
     currentPlayerIndex = INIConfig::clampPlayerIndex(state.currentPlayer);
 
     for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
-        auto& player = players[i];
         const juce::String playerPrefix = "player_" + juce::String(i) + "_";
 
         if (state.toggleStates.count(200 + i)) {
-            player.enabled = state.toggleStates.at(200 + i);
+            setPlayerEnabled(i, state.toggleStates.at(200 + i));
         }
 
         if (state.sliderValues.count(playerPrefix + "swing")) {
-            player.swing = INIConfig::clampSwing(state.sliderValues.at(playerPrefix + "swing"));
+            setSwing(i, state.sliderValues.at(playerPrefix + "swing"));
         }
 
         if (state.sliderValues.count(playerPrefix + "energy")) {
-            player.energy = INIConfig::clampEnergy(state.sliderValues.at(playerPrefix + "energy"));
+            setEnergy(i, state.sliderValues.at(playerPrefix + "energy"));
         }
 
         if (state.dropdownSelections.count(playerPrefix + "pattern")) {
-            player.selectedPattern = state.dropdownSelections.at(playerPrefix + "pattern");
+            selectPattern(i, state.dropdownSelections.at(playerPrefix + "pattern"));
         }
 
         if (state.dropdownSelections.count(playerPrefix + "output_channel")) {
-            player.outputChannel = state.dropdownSelections.at(playerPrefix + "output_channel");
+            setPlayerOutputChannel(i, state.dropdownSelections.at(playerPrefix + "output_channel"));
+        }
+
+        const auto& settings = state.playerSettings[i];
+        if (settings.patternChainEnabled && !settings.patternChainIndices.isEmpty()) {
+            SongArranger::Chain chain;
+            chain.loop = settings.patternChainLoop;
+
+            for (const auto patternIndex : settings.patternChainIndices) {
+                SongArranger::Step step;
+                step.patternIndex = patternIndex;
+                if (midiFileManager != nullptr && INIConfig::isValidButtonIndex(patternIndex) &&
+                    settings.assignedMidiFiles[patternIndex].isNotEmpty()) {
+                    step.midiFile = midiFileManager->getMidiFile(settings.assignedMidiFiles[patternIndex]);
+                }
+                chain.steps.add(step);
+            }
+
+            setPatternChain(i, chain);
+        } else if (hasPatternChain(i)) {
+            clearPatternChain(i);
         }
     }
 
@@ -747,8 +1796,9 @@ void MidiEngine::loadStates(const ComponentState& state) {
         mapping.minValue = mappingState.minValue;
         mapping.maxValue = mappingState.maxValue;
         mapping.enabled = mappingState.enabled;
-        addMidiMapping(mapping);
+        insertMidiMapping(mapping);
     }
+    rebuildCCDispatchTable();
 }
 
 void MidiEngine::loadFromXml(const juce::XmlElement* xml) {
@@ -772,12 +1822,11 @@ void MidiEngine::loadFromXml(const juce::XmlElement* xml) {
 
     for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
         if (auto* playerXml = xml->getChildByName("Player" + juce::String(i))) {
-            auto& player = players[i];
-            player.enabled = playerXml->getBoolAttribute("enabled", true);
-            player.swing = INIConfig::clampSwing(static_cast<float>(playerXml->getDoubleAttribute("swing", INIConfig::Defaults::SWING)));
-            player.energy = INIConfig::clampEnergy(static_cast<float>(playerXml->getDoubleAttribute("energy", INIConfig::Defaults::ENERGY)));
-            player.selectedPattern = playerXml->getIntAttribute("selectedPattern", 0);
-            player.outputChannel = playerXml->getIntAttribute("outputChannel", i + 1);
+            setPlayerEnabled(i, playerXml->getBoolAttribute("enabled", true));
+            setSwing(i, static_cast<float>(playerXml->getDoubleAttribute("swing", INIConfig::Defaults::SWING)));
+            setEnergy(i, static_cast<float>(playerXml->getDoubleAttribute("energy", INIConfig::Defaults::ENERGY)));
+            selectPattern(i, playerXml->getIntAttribute("selectedPattern", 0));
+            setPlayerOutputChannel(i, playerXml->getIntAttribute("outputChannel", i + 1));
         }
     }
 
@@ -796,10 +1845,11 @@ void MidiEngine::loadFromXml(const juce::XmlElement* xml) {
                 mapping.sendFeedback = mappingXml->getBoolAttribute("feedback", false);
 
                 if (mapping.ccNumber >= 0 && mapping.parameterID.isNotEmpty()) {
-                    addMidiMapping(mapping);
+                    insertMidiMapping(mapping);
                 }
             }
         }
+        rebuildCCDispatchTable();
     }
 }
 
@@ -807,12 +1857,12 @@ std::unique_ptr<juce::XmlElement> MidiEngine::saveToXml() const {
     auto xml = std::make_unique<juce::XmlElement>("MidiEngine");
 
     xml->setAttribute("tempo", tempo);
-    xml->setAttribute("playing", isPlaying);
+    xml->setAttribute("playing", isPlaying.load());
     xml->setAttribute("sendMidiClock", sendMidiClock);
     xml->setAttribute("currentPlayer", currentPlayerIndex);
 
     for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
-        const auto& player = players[i];
+        const auto& player = controls[i];
         auto playerXml = xml->createNewChildElement("Player" + juce::String(i));
         playerXml->setAttribute("enabled", player.enabled);
         playerXml->setAttribute("swing", player.swing);
@@ -840,8 +1890,9 @@ void MidiEngine::loadControllerPreset(const MidiControllerPreset& preset) {
     clearAllMidiMappings();
 
     for (const auto& mapping : preset.mappings) {
-        addMidiMapping(mapping);
+        insertMidiMapping(mapping);
     }
+    rebuildCCDispatchTable();
 
     currentControllerPreset = preset.name;
 }
@@ -875,11 +1926,11 @@ void MidiEngine::enableMidiLearnMode(bool enable) {
     if (!enable) {
         cancelMidiLearn();
     }
-    midiLearnActive = enable;
+    midiLearnActive.store(enable, std::memory_order_release);
 }
 
 bool MidiEngine::isMidiLearnActive() const {
-    return midiLearnActive;
+    return midiLearnActive.load(std::memory_order_acquire);
 }
 
 juce::String MidiEngine::getCurrentLearnParameter() const {
@@ -897,6 +1948,7 @@ void MidiEngine::setMidiMappingEnabled(const juce::String& parameterID, bool ena
             break;
         }
     }
+    rebuildCCDispatchTable();
 }
 
 bool MidiEngine::isMidiMappingEnabled(const juce::String& parameterID) const {
@@ -911,26 +1963,28 @@ bool MidiEngine::isMidiMappingEnabled(const juce::String& parameterID) const {
 void MidiEngine::setPlayerEnabled(int playerIndex, bool enabled) {
     if (!INIConfig::isValidPlayerIndex(playerIndex)) return;
 
-    players[playerIndex].enabled = enabled;
+    controls[playerIndex].enabled = enabled;
+    pushCommand({ EngineCommand::Type::SetPlayerEnabled, playerIndex, enabled ? 1 : 0 });
 }
 
 bool MidiEngine::isPlayerEnabled(int playerIndex) const {
     if (!INIConfig::isValidPlayerIndex(playerIndex)) return false;
 
-    return players[playerIndex].enabled;
+    return controls[playerIndex].enabled;
 }
 
 void MidiEngine::setPlayerOutputChannel(int playerIndex, int channel) {
     if (!INIConfig::isValidPlayerIndex(playerIndex)) return;
     if (!INIConfig::isValidMidiChannel(channel)) return;
 
-    players[playerIndex].outputChannel = channel;
+    controls[playerIndex].outputChannel = channel;
+    pushCommand({ EngineCommand::Type::SetOutputChannel, playerIndex, channel });
 }
 
 int MidiEngine::getPlayerOutputChannel(int playerIndex) const {
     if (!INIConfig::isValidPlayerIndex(playerIndex)) return 1;
 
-    return players[playerIndex].outputChannel;
+    return controls[playerIndex].outputChannel;
 }
 
 void MidiEngine::syncToHost(double hostBpm, double hostPosition) {
@@ -942,8 +1996,11 @@ void MidiEngine::syncToHost(double hostBpm, double hostPosition) {
     }
 
     if (syncToHostPosition && hostPosition >= 0) {
+        transportBeat = hostPosition;
+
+        const double barStart = tempoMapControl.getBarPosition(hostPosition).barStartBeat;
         for (auto& player : players) {
-            player.playbackPosition = std::fmod(hostPosition, INIConfig::Defaults::BEATS_PER_BAR);
+            player.playbackPosition = hostPosition - barStart;
         }
     }
 }
@@ -1002,20 +2059,37 @@ float MidiEngine::getMetronomeVolume() const {
     return metronomeVolume;
 }
 
-void MidiEngine::generateMetronome(juce::MidiBuffer& midiMessages) {
-    if (!metronomeEnabled || !isPlaying) return;
+void MidiEngine::generateMetronome(juce::MidiBuffer& midiMessages, int startSample, int numSamples) {
+    const int velocity = static_cast<int>(INIConfig::LayoutConstants::midiEngineMaxMidiVelocity * metronomeVolume);
+    if (velocity <= 0) return;
 
-    const double beatPosition = std::fmod(players[0].playbackPosition, 1.0);
+    const auto& map = tempoMaps.read();
 
-    if (beatPosition < INIConfig::Defaults::BEAT_THRESHOLD) {
-        int note = (std::fmod(players[0].playbackPosition, INIConfig::Defaults::BEATS_PER_BAR) < INIConfig::Defaults::BEAT_THRESHOLD) ? INIConfig::LayoutConstants::midiEngineMetronomeHighNote : INIConfig::LayoutConstants::midiEngineMetronomeLowNote;
-        int velocity = static_cast<int>(INIConfig::LayoutConstants::midiEngineMaxMidiVelocity * metronomeVolume);
+    // After a locate, pick up from the next click instead of bursting or skipping
+    if (nextMetronomeBeat < transportBeat - INIConfig::Defaults::BEAT_THRESHOLD ||
+        nextMetronomeBeat > transportBeat + map.getBeatsPerBarAt(transportBeat)) {
+        nextMetronomeBeat = map.getNextGridBoundary(transportBeat, map.getBarPosition(transportBeat).denominator);
+    }
+
+    // One click per beat of the meter (quarters in 4/4, eighths in 6/8), accented on the bar line
+    for (;;) {
+        const double samplesAhead = getSamplesUntilBeat(nextMetronomeBeat);
+        if (samplesAhead >= numSamples) break;
+
+        const int offset = samplesAhead <= 0.0 ? 0 : static_cast<int>(std::ceil(samplesAhead - 1.0e-6));
+        if (offset >= numSamples) break;
+
+        const auto position = map.getBarPosition(nextMetronomeBeat);
+        const bool downbeat = nextMetronomeBeat - position.barStartBeat < INIConfig::Defaults::BEAT_THRESHOLD;
+        const int note = downbeat ? INIConfig::LayoutConstants::midiEngineMetronomeHighNote : INIConfig::LayoutConstants::midiEngineMetronomeLowNote;
 
         auto noteOn = juce::MidiMessage::noteOn(INIConfig::LayoutConstants::midiEngineMetronomeChannel, note, (juce::uint8)velocity);
-        midiMessages.addEvent(noteOn, 0);
+        midiMessages.addEvent(noteOn, startSample + offset);
 
         auto noteOff = juce::MidiMessage::noteOff(INIConfig::LayoutConstants::midiEngineMetronomeChannel, note);
-        midiMessages.addEvent(noteOff, INIConfig::LayoutConstants::midiEngineMetronomeNoteOffDelay);
+        midiMessages.addEvent(noteOff, startSample + offset + INIConfig::LayoutConstants::midiEngineMetronomeNoteOffDelay);
+
+        nextMetronomeBeat = map.getNextGridBoundary(nextMetronomeBeat + INIConfig::Defaults::BEAT_THRESHOLD, position.denominator);
     }
 }
 
@@ -1023,8 +2097,9 @@ void MidiEngine::setRecording(bool shouldRecord) {
     isRecording = shouldRecord;
 
     if (shouldRecord) {
-        recordBuffer.clear();
-        recordStartTime = juce::Time::getMillisecondCounterHiRes();
+        beginRecordingTake();
+    } else {
+        endRecordingTake();
     }
 }
 
@@ -1036,15 +2111,24 @@ void MidiEngine::clearRecordBuffer() {
     recordBuffer.clear();
 }
 
-const juce::MidiMessageSequence& MidiEngine::getRecordedSequence() const {
+const juce::MidiMessageSequence& MidiEngine::getRecordedSequence() {
+    collectRecordedEvents();
     return recordBuffer;
 }
 
-void MidiEngine::recordMidiMessage(const juce::MidiMessage& message) {
-    if (!isRecording) return;
+void MidiEngine::recordMidiMessage(const juce::MidiMessage& message, double takeBeat) {
+    // Close any loop pass this note falls after, so the marker stays in stream order
+    advanceRecordingLoops(takeBeat);
+
+    RecordedEvent event;
+    event.takeId = audioTakeId;
+    event.beat = takeBeat;
+    event.size = static_cast<juce::uint8>(juce::jmin(message.getRawDataSize(), static_cast<int>(sizeof(event.data))));
+    std::memcpy(event.data, message.getRawData(), event.size);
 
-    double timestamp = juce::Time::getMillisecondCounterHiRes() - recordStartTime;
-    recordBuffer.addEvent(message, timestamp);
+    if (!recordedEvents.push(event)) {
+        DBG("MidiEngine: Record queue full, dropping note");
+    }
 }
 
 void MidiEngine::exportRecording(const juce::File& file) {
@@ -1065,32 +2149,36 @@ void MidiEngine::exportRecording(const juce::File& file) {
 void MidiEngine::applyHumanization(int playerIndex, float amount) {
     if (!INIConfig::isValidPlayerIndex(playerIndex)) return;
 
-    players[playerIndex].humanizationAmount = juce::jlimit(0.0f, 1.0f, amount);
+    controls[playerIndex].humanizationAmount = juce::jlimit(0.0f, 1.0f, amount);
+    pushCommand({ EngineCommand::Type::SetHumanization, playerIndex, 0, 0, controls[playerIndex].humanizationAmount });
 }
 
 float MidiEngine::getHumanization(int playerIndex) const {
     if (!INIConfig::isValidPlayerIndex(playerIndex)) return 0.0f;
 
-    return players[playerIndex].humanizationAmount;
+    return controls[playerIndex].humanizationAmount;
 }
 
-juce::MidiMessage MidiEngine::humanizeMessage(const juce::MidiMessage& message, float amount) {
-    if (amount <= 0.0f) return message;
+int MidiEngine::humanizeVelocity(PlayerState& player, int velocity) {
+    const int variation = static_cast<int>(INIConfig::Defaults::HUMANIZE_VELOCITY_RANGE * player.humanizationAmount);
+    if (variation <= 0) return velocity;
 
-    juce::Random random;
+    // xorshift32: a few instructions, no shared state between players, and the same
+    // sequence from the same seed
+    auto& state = player.randomState;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
 
-    if (message.isNoteOn()) {
-        int velocity = message.getVelocity();
-        int variation = static_cast<int>(INIConfig::Defaults::HUMANIZE_VELOCITY_RANGE * amount);
-        velocity += random.nextInt(variation * 2 + 1) - variation;
-        velocity = juce::jlimit(1, INIConfig::LayoutConstants::midiEngineMaxMidiVelocity, velocity);
+    velocity += static_cast<int>(state % static_cast<juce::uint32>(variation * 2 + 1)) - variation;
+    return juce::jlimit(1, INIConfig::LayoutConstants::midiEngineMaxMidiVelocity, velocity);
+}
 
-        return juce::MidiMessage::noteOn(message.getChannel(),
-                                        message.getNoteNumber(),
-                                        (juce::uint8)velocity);
+void MidiEngine::seedHumanization() {
+    for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
+        // Distinct per player, and never zero, which xorshift cannot leave
+        players[i].randomState = (INIConfig::MIDI::HUMANIZE_SEED + static_cast<juce::uint32>(i) * 0x9E3779B9u) | 1u;
     }
-
-    return message;
 }
 
 void MidiEngine::setLoopEnabled(bool enabled) {
@@ -1146,22 +2234,9 @@ bool MidiEngine::isReceivingMidiClock() const {
 }
 
 void MidiEngine::handleMidiClock(const juce::MidiMessage& message) {
-    if (!receiveMidiClock) return;
-
-    if (message.isMidiClock()) {
-        const double ticksPerBeat = INIConfig::LayoutConstants::midiEngineMidiClockPulsesPerBeat;
-        const double beatsPerTick = 1.0 / ticksPerBeat;
+    if (!receiveMidiClock || sampleRate <= 0.0) return;
 
-        for (auto& player : players) {
-            player.playbackPosition += beatsPerTick;
-        }
-    } else if (message.isMidiStart()) {
-        startPlayback();
-    } else if (message.isMidiStop()) {
-        stopPlayback();
-    } else if (message.isMidiContinue()) {
-        isPlaying = true;
-    }
+    handleClockMessage(message, static_cast<double>(processedSamples) / sampleRate);
 }
 
 float MidiEngine::getCurrentBeat() const {
@@ -1173,7 +2248,7 @@ float MidiEngine::getCurrentBeat() const {
 int MidiEngine::getCurrentBar() const {
     if (!isPlaying) return 0;
 
-    return static_cast<int>(players[currentPlayerIndex].playbackPosition / INIConfig::Defaults::BEATS_PER_BAR);
+    return tempoMapControl.getBarPosition(transportBeat).bar;
 }
 
 void MidiEngine::schedulePatternChange(int playerIndex, int patternIndex, int barNumber) {
@@ -1182,35 +2257,12 @@ void MidiEngine::schedulePatternChange(int playerIndex, int patternIndex, int ba
         return;
     }
 
-    PatternChange change;
-    change.playerIndex = playerIndex;
-    change.patternIndex = patternIndex;
-    change.triggerBar = barNumber;
-
-    pendingPatternChanges.add(change);
-}
-
-void MidiEngine::processPendingPatternChanges() {
-    const int currentBar = getCurrentBar();
-
-    for (int i = pendingPatternChanges.size() - 1; i >= 0; --i) {
-        const auto& change = pendingPatternChanges[i];
-
-        if (currentBar >= change.triggerBar) {
-            selectPattern(change.playerIndex, change.patternIndex);
-            pendingPatternChanges.remove(i);
-        }
-    }
+    preparePattern(playerIndex, patternIndex);
+    pushCommand({ EngineCommand::Type::SchedulePatternChange, playerIndex, patternIndex, barNumber });
 }
 
 void MidiEngine::clearPendingPatternChanges(int playerIndex) {
-    if (playerIndex < 0) {
-        pendingPatternChanges.clear();
-    } else {
-        pendingPatternChanges.removeIf([playerIndex](const PatternChange& change) {
-            return change.playerIndex == playerIndex;
-        });
-    }
+    pushCommand({ EngineCommand::Type::ClearPendingPatternChanges, playerIndex });
 }
 
 void MidiEngine::setCountIn(int bars) {
@@ -1222,13 +2274,8 @@ int MidiEngine::getCountIn() const {
 }
 
 void MidiEngine::startWithCountIn() {
-    if (countInBars > 0) {
-        countingIn = true;
-        countInPosition = 0;
-        startPlayback();
-    } else {
-        startPlayback();
-    }
+    pushCommand({ EngineCommand::Type::StartTransport, INIConfig::MIDI::ALL_PLAYERS,
+                  juce::jmax(INIConfig::Defaults::ZERO_VALUE, countInBars) });
 }
 
 void MidiEngine::processCountIn(juce::MidiBuffer& midiMessages) {
@@ -1245,7 +2292,8 @@ void MidiEngine::processCountIn(juce::MidiBuffer& midiMessages) {
             player.playbackPosition = 0.0;
         }
     } else {
-        generateMetronome(midiMessages);
+        // Clicks come from the metronome in the render loop
+        juce::ignoreUnused(midiMessages);
         countInPosition += (tempo / INIConfig::Defaults::SECONDS_PER_MINUTE) / INIConfig::Defaults::MS_PER_SECOND;
     }
 }
@@ -1264,13 +2312,14 @@ float MidiEngine::getCountInProgress() const {
 void MidiEngine::setVelocityCurve(int playerIndex, VelocityCurve curve) {
     if (!INIConfig::isValidPlayerIndex(playerIndex)) return;
 
-    players[playerIndex].velocityCurve = curve;
+    controls[playerIndex].velocityCurve = curve;
+    pushCommand({ EngineCommand::Type::SetVelocityCurve, playerIndex, static_cast<int>(curve) });
 }
 
 MidiEngine::VelocityCurve MidiEngine::getVelocityCurve(int playerIndex) const {
     if (!INIConfig::isValidPlayerIndex(playerIndex)) return VelocityCurve::Linear;
 
-    return players[playerIndex].velocityCurve;
+    return controls[playerIndex].velocityCurve;
 }
 
 int MidiEngine::applyVelocityCurve(int velocity, VelocityCurve curve) {
@@ -1323,7 +2372,7 @@ juce::String MidiEngine::getEngineStatus() const {
 
     int activeCount = 0;
     for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
-        if (players[i].enabled) {
+        if (controls[i].enabled) {
             if (activeCount > 0) status << ", ";
             status << (i + 1);
             activeCount++;
@@ -1333,7 +2382,7 @@ juce::String MidiEngine::getEngineStatus() const {
     if (activeCount == 0) status << "None";
 
     status << "\n";
-    status << "MIDI Learn: " << (midiLearnActive ? "Active" : "Inactive") << "\n";
+    status << "MIDI Learn: " << (isMidiLearnActive() ? "Active" : "Inactive") << "\n";
     status << "MIDI Mappings: " << midiMappings.size() << "\n";
     status << "Sync to Host: " << (syncToHostTempo ? "Yes" : "No") << "\n";
     status << "Live Recording: " << (liveRecording ? "Active" : "Inactive") << "\n";
@@ -1346,19 +2395,19 @@ MidiEngine::EngineState MidiEngine::getCurrentEngineState() const {
     EngineState state;
     state.tempo = tempo;
     state.isPlaying = isPlaying;
-    state.swingValue = players[currentPlayerIndex].swing;
-    state.energyValue = players[currentPlayerIndex].energy;
+    state.swingValue = controls[currentPlayerIndex].swing;
+    state.energyValue = controls[currentPlayerIndex].energy;
     state.currentPosition = players[currentPlayerIndex].playbackPosition;
     state.isFillActive = players[currentPlayerIndex].fillActive;
 
     for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
-        if (players[i].enabled) {
-            if (players[i].currentPattern.getNumEvents() > 0) {
+        if (controls[i].enabled) {
+            if (controls[i].pattern.getNumEvents() > 0) {
                 EngineState::PatternInfo pattern;
                 pattern.group = i;
-                pattern.index = players[i].selectedPattern;
-                pattern.name = "Pattern " + juce::String(players[i].selectedPattern + 1);
-                pattern.midiFileName = players[i].selectedMidiGroup;
+                pattern.index = controls[i].selectedPattern;
+                pattern.name = "Pattern " + juce::String(controls[i].selectedPattern + 1);
+                pattern.midiFileName = controls[i].selectedMidiGroup;
                 state.patterns.add(pattern);
             }
         }
@@ -1372,16 +2421,20 @@ void MidiEngine::applyEngineState(const EngineState& state) {
     isPlaying = state.isPlaying;
 
     if (currentPlayerIndex >= 0 && currentPlayerIndex < INIConfig::Defaults::MAX_PLAYERS) {
-        players[currentPlayerIndex].swing = INIConfig::clampSwing(state.swingValue);
-        players[currentPlayerIndex].energy = INIConfig::clampEnergy(state.energyValue);
+        setSwing(currentPlayerIndex, state.swingValue);
+        setEnergy(currentPlayerIndex, state.energyValue);
         players[currentPlayerIndex].playbackPosition = state.currentPosition;
-        players[currentPlayerIndex].fillActive = state.isFillActive;
+        if (state.isFillActive) {
+            triggerFill(currentPlayerIndex);
+        }
     }
 
     for (const auto& pattern : state.patterns) {
         if (pattern.group >= 0 && pattern.group < INIConfig::Defaults::MAX_PLAYERS) {
-            players[pattern.group].selectedPattern = pattern.index;
-            players[pattern.group].selectedMidiGroup = pattern.midiFileName;
+            controls[pattern.group].selectedMidiGroup = pattern.midiFileName;
+            selectPattern(pattern.group, pattern.index);
         }
     }
+
+    preloadPatterns();
 }
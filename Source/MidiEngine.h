@@ -1,12 +1,28 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <array>
+#include <bitset>
+#include <map>
+#include <memory>
+#include <vector>
 #include "ComponentState.h"
 #include "INIConfig.h"
+#include "LockFreeStructures.h"
+#include "LaunchScheduler.h"
+#include "MidiClockTracker.h"
+#include "PatternPreloader.h"
+#include "SongArranger.h"
+#include "TempoMap.h"
 
 class MidiFileManager;
+class Mixer;
 
-class MidiEngine {
+// Message-thread calls that change playback state are posted to the audio thread as
+// plain commands and applied at the start of the next block; getters read the
+// message-thread copy. Changes the audio thread makes on its own (quantised launches)
+// come back as EngineEvents.
+class MidiEngine : private juce::Timer {
 public:
     enum class VelocityCurve {
         Linear = INIConfig::Defaults::ZERO_VALUE,
@@ -60,24 +76,41 @@ public:
             bool active = false;
             int patternIndex = INIConfig::MIDI::INACTIVE_PATTERN;
             juce::String midiFileName;
+            // Resolved when the scene is saved; empty falls back to the pattern group
+            juce::File midiFile;
             float volume = INIConfig::Defaults::VOLUME;
+            // The mixer channel of the same player
+            float mixerVolume = INIConfig::Defaults::VOLUME;
             bool muted = false;
         };
         ClipState clips[INIConfig::Defaults::MAX_PLAYERS];
         float tempo = INIConfig::Defaults::DEFAULT_TEMPO;
+        bool hasMixerLevels = false;
     };
 
     MidiEngine();
     ~MidiEngine();
 
     void prepare(double sampleRate);
+    // Advances the transport by numSamples; queued launches land on their exact sample
+    void process(juce::MidiBuffer& midiMessages, int numSamples);
+    // Same, advancing by the wall-clock time since the previous call
     void process(juce::MidiBuffer& midiMessages);
+    // Message thread; the transport moves when the audio thread drains the command
     void startPlayback();
     void stopPlayback();
-    bool isPlaybackActive() const { return isPlaying; }
+    bool isPlaybackActive() const { return isPlaying.load(std::memory_order_relaxed); }
+    // Offline bounces: song sections are prepared in line rather than on the arranger thread
+    // and humanization restarts from a fixed seed on every start, so a bounce is repeatable
+    void setOfflineRender(bool offline) { offlineRender.store(offline, std::memory_order_relaxed); }
+    bool isOfflineRender() const { return offlineRender.load(std::memory_order_relaxed); }
 
     void setTempo(float newTempo);
     float getTempo() const { return tempo; }
+    // Meter always comes from the map; its tempo takes over from setTempo() once it has changes
+    void setTempoMap(const TempoMap& map);
+    const TempoMap& getTempoMap() const { return tempoMapControl; }
+    void setTimeSignature(int numerator, int denominator);
     void syncToHost(double hostBpm, double hostPosition);
     void setSyncToHost(bool syncTempo, bool syncPosition);
     bool isSyncedToHostTempo() const;
@@ -96,8 +129,26 @@ public:
     void schedulePatternChange(int playerIndex, int patternIndex, int barNumber);
     void clearPendingPatternChanges(int playerIndex = INIConfig::MIDI::ALL_PLAYERS);
 
+    // Beats-button patterns are flattened ahead of time: every pattern of each player's
+    // group and the groups beside it loads in the background, and a selected button plays
+    // from memory. preparePattern() makes sure one is ready; false if it has no file.
+    void preloadPatterns();
+    bool preparePattern(int playerIndex, int patternIndex);
+
+    // Song mode: the player follows chain from the next bar (bar 0 while stopped). Steps
+    // without a MIDI file are looked up in the current pattern group.
+    void setPatternChain(int playerIndex, const SongArranger::Chain& chain);
+    void clearPatternChain(int playerIndex);
+    bool hasPatternChain(int playerIndex) const { return songArranger.isActive(playerIndex); }
+    // Prefetches the upcoming sections now instead of on the arranger thread, e.g. before starting playback
+    void prepareSongSections() { songArranger.prepareSections(); }
+
     void setSwing(int playerIndex, float swing);
     void setEnergy(int playerIndex, float energy);
+    // Audio thread, before process(): parameter automation that arrived off the message
+    // thread. Takes effect at once; getSwing()/getEnergy() follow once the event is dispatched.
+    void automateSwing(int playerIndex, float swing);
+    void automateEnergy(int playerIndex, float energy);
     float getSwing(int playerIndex) const;
     float getEnergy(int playerIndex) const;
     void setQuantize(int quantizeValue);
@@ -109,6 +160,7 @@ public:
 
     void triggerScene(int sceneIndex);
     void triggerClip(int sceneIndex, int playerIndex);
+    // quantization is the launch grid as a note division (1 = bar, 4 = beat, 16 = sixteenth); 0 = next block
     void queueSceneChange(int sceneIndex, int quantization = INIConfig::Defaults::ZERO_VALUE);
     void queueClipChange(int playerIndex, int patternIndex, int quantization = INIConfig::Defaults::ZERO_VALUE);
     void startLiveRecording(bool overdub = false);
@@ -118,11 +170,16 @@ public:
     bool isOverdubMode() const { return overdubMode; }
     void setLoopRecordingMode(bool enabled);
     bool isLoopRecordingMode() const { return loopRecordingMode; }
+    // Snap recorded note-ons to the setQuantize() grid as they are merged
+    void setQuantizeRecording(bool enabled) { quantizeRecording = enabled; }
+    bool isQuantizingRecording() const { return quantizeRecording; }
     void tapTempo();
     void resetTapTempo();
     float getTapTempoAveraging() const;
 
     void saveScene(int sceneIndex, const juce::String& name = "");
+    // Compiles the scene's patterns now so that launching it later reads no files
+    void setScene(int sceneIndex, const Scene& scene);
     Scene getScene(int sceneIndex) const;
     void loadScene(int sceneIndex);
     void clearScene(int sceneIndex);
@@ -133,12 +190,43 @@ public:
         Type type;
         int targetIndex;
         int playerIndex;
-        int quantizationBars;
+        int quantization;
         double triggerTime;
     };
 
     const juce::Array<QueuedChange>& getQueuedChanges() const { return queuedChanges; }
 
+    struct EngineEvent {
+        enum class Type : juce::uint8 { PatternStarted, SceneLaunched, MidiLearned, SwingAutomated, EnergyAutomated, TransportStopped };
+        Type type = Type::PatternStarted;
+        // For MidiLearned, playerIndex holds the MIDI channel and index the CC number that was moved
+        int playerIndex = INIConfig::MIDI::ALL_PLAYERS;
+        int index = INIConfig::Defaults::ZERO_VALUE;
+        // Transport position the change took effect at
+        juce::int64 samplePosition = 0;
+        double beat = 0.0;
+        // For SwingAutomated and EnergyAutomated, the player's new value
+        float value = 0.0f;
+    };
+
+    // Message thread; also runs from an internal timer
+    void dispatchEngineEvents();
+
+    // Note-ons from the MIDI input as they arrive, for one reader off the audio thread,
+    // stamped in seconds of processed audio. Notes are dropped, not waited for, when the
+    // reader falls behind; nothing is queued while the tap is off.
+    struct InputNote {
+        double time = 0.0;
+        juce::uint8 channel = 0;
+        juce::uint8 note = 0;
+        juce::uint8 velocity = 0;
+    };
+
+    // Reader thread. Enabling discards whatever was left from before.
+    void setInputTapEnabled(bool enabled);
+    bool isInputTapEnabled() const { return inputTapEnabled.load(std::memory_order_relaxed); }
+    bool popInputNote(InputNote& note) { return inputTap.pop(note); }
+
     void startMidiLearn(const juce::String& parameterID);
     void cancelMidiLearn();
     void enableMidiLearnMode(bool enable);
@@ -153,6 +241,10 @@ public:
     void setMidiMappingEnabled(const juce::String& parameterID, bool enabled);
     bool isMidiMappingEnabled(const juce::String& parameterID) const;
 
+    // Mappings are resolved through this once, when the CC dispatch table is rebuilt.
+    // IDs it cannot resolve are reported through onMidiParameterChanged instead.
+    void setParameterResolver(std::function<juce::RangedAudioParameter*(const juce::String&)> resolver);
+
     void loadControllerPreset(const MidiControllerPreset& preset);
     void saveControllerPreset(const juce::String& name);
     juce::StringArray getAvailableControllerPresets() const;
@@ -185,11 +277,13 @@ public:
     void setRecording(bool shouldRecord);
     bool isCurrentlyRecording() const;
     void clearRecordBuffer();
-    const juce::MidiMessageSequence& getRecordedSequence() const;
+    // Merges anything still in the record ring first; times are in beats from the start of the take
+    const juce::MidiMessageSequence& getRecordedSequence();
     void exportRecording(const juce::File& file);
 
     float getCurrentBeat() const;
     int getCurrentBar() const;
+    double getTransportBeat() const { return transportBeat; }
     void panic();
     void freezePlayback();
     void unfreezePlayback();
@@ -208,13 +302,15 @@ public:
     std::function<void(const MidiMapping&)> onMidiLearnComplete;
     std::function<void(int channel, int cc, int value)> onMidiFeedbackRequired;
     std::function<void(const juce::MidiMessage&)> onPanicRequired;
+    std::function<void(const EngineEvent&)> onEngineEvent;
 
-    void setMidiFileManager(MidiFileManager* manager) { midiFileManager = manager; }
+    void setMidiFileManager(MidiFileManager* manager);
+    // Scenes save and recall the mixer's channel volumes and mutes
+    void setMixer(Mixer* sceneMixer) { mixer = sceneMixer; }
 
 private:
     struct PlayerState {
         juce::MidiMessageSequence currentPattern;
-        juce::MidiMessageSequence recordedPattern;
         juce::String selectedMidiGroup;
         float swingValue = INIConfig::Defaults::SWING;
         float energyValue = INIConfig::Defaults::ENERGY;
@@ -229,23 +325,113 @@ private:
         float energy = INIConfig::Defaults::ENERGY;
         VelocityCurve velocityCurve = VelocityCurve::Linear;
         float humanizationAmount = INIConfig::Validation::MIN_VOLUME;
+        juce::uint32 randomState = INIConfig::MIDI::HUMANIZE_SEED;
         bool hasQueuedChange = false;
         int queuedPattern = INIConfig::MIDI::INACTIVE_PATTERN;
+
+        // Song mode; both belong to the arranger's pool and go back to it when replaced
+        SongArranger::Section* section = nullptr;
+        SongArranger::Section* nextSection = nullptr;
+        // A launched scene's pattern, owned by the scene pattern cache; played like a section
+        const SongArranger::Section* scenePattern = nullptr;
+        // The selected beats-button pattern, owned by the preloader; played like a section
+        const SongArranger::Section* groupPattern = nullptr;
+        double sectionStartBeat = INIConfig::MIDI::DEFAULT_POSITION;
+        // Next event to play: which pass through the loop, and which event in it
+        juce::int64 sectionPass = 0;
+        int sectionEvent = INIConfig::Defaults::ZERO_VALUE;
+        std::bitset<INIConfig::MIDI::NUM_NOTE_NUMBERS> heldNotes;
+        bool releaseHeldNotes = false;
     };
 
-    struct PatternChange {
-        int playerIndex;
-        int patternIndex;
-        int triggerBar;
+    struct PlayerControls {
+        juce::String selectedMidiGroup;
+        float swing = INIConfig::Defaults::SWING;
+        float energy = INIConfig::Defaults::ENERGY;
+        bool enabled = INIConfig::Defaults::DEFAULT_PLAYER_ENABLED;
+        int selectedPattern = INIConfig::Defaults::ZERO_VALUE;
+        int outputChannel = INIConfig::Validation::MIN_MIDI_CHANNEL;
+        VelocityCurve velocityCurve = VelocityCurve::Linear;
+        float humanizationAmount = INIConfig::Validation::MIN_VOLUME;
+        juce::MidiMessageSequence pattern;
+    };
+
+    struct EngineCommand {
+        enum class Type : juce::uint8 {
+            SelectPattern,
+            SchedulePatternChange,
+            ClearPendingPatternChanges,
+            QueueSceneChange,
+            QueueClipChange,
+            LaunchScene,
+            SetSwing,
+            SetEnergy,
+            SetPlayerEnabled,
+            SetOutputChannel,
+            SetHumanization,
+            SetVelocityCurve,
+            TriggerFill,
+            StartRecording,
+            StopRecording,
+            StartTransport,
+            StopTransport
+        };
+
+        Type type = Type::SelectPattern;
+        int playerIndex = INIConfig::MIDI::ALL_PLAYERS;
+        int index = INIConfig::Defaults::ZERO_VALUE;
+        int bar = INIConfig::Defaults::ZERO_VALUE;
+        float value = 0.0f;
     };
 
+    // Audio thread -> message thread. Notes are stamped in beats from the start of the
+    // take; a LoopEnd marker closes each pass of a loop recording in stream order.
+    struct RecordedEvent {
+        enum class Type : juce::uint8 {
+            Note,
+            LoopEnd
+        };
+
+        Type type = Type::Note;
+        int takeId = INIConfig::Defaults::ZERO_VALUE;
+        double beat = INIConfig::MIDI::DEFAULT_POSITION;
+        juce::uint8 data[3] = {};
+        juce::uint8 size = 0;
+    };
+
+    // What the audio thread needs to launch a scene; names and file names stay on the message thread
+    struct ScenePlayback {
+        struct Clip {
+            bool active = false;
+            int patternIndex = INIConfig::MIDI::INACTIVE_PATTERN;
+            float energy = INIConfig::Defaults::ENERGY;
+            // Already flattened; nullptr leaves the player on its own pattern
+            const SongArranger::Section* pattern = nullptr;
+            float mixerVolume = INIConfig::Defaults::VOLUME;
+            bool muted = false;
+        };
+
+        std::array<Clip, INIConfig::Defaults::MAX_PLAYERS> clips{};
+        float tempo = INIConfig::Defaults::DEFAULT_TEMPO;
+        bool hasMixerLevels = false;
+    };
+
+    // One flattened pattern per file, shared by every scene that uses it
+    struct ScenePattern {
+        juce::Time modified;
+        double barBeats = 0.0;
+        std::unique_ptr<SongArranger::Section> section;
+    };
+
+    using SceneTable = std::array<ScenePlayback, INIConfig::Defaults::MAX_SCENES>;
+
+    // Audio thread
     PlayerState players[INIConfig::Defaults::MAX_PLAYERS];
     int currentPlayerIndex = INIConfig::Defaults::DEFAULT_CURRENT_PLAYER;
-    bool isPlaying = INIConfig::Defaults::DEFAULT_PLAY_STATE;
+    std::atomic<bool> isPlaying{INIConfig::Defaults::DEFAULT_PLAY_STATE};
     float tempo = INIConfig::Defaults::DEFAULT_TEMPO;
     double sampleRate = static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE);
     double lastProcessTime = INIConfig::MIDI::DEFAULT_LAST_TIME;
-    double lastClockTime = INIConfig::MIDI::DEFAULT_LAST_TIME;
     bool playbackFrozen = false;
 
     bool syncToHostTempo = false;
@@ -253,6 +439,7 @@ private:
     double hostTempo = INIConfig::MIDI::DEFAULT_POSITION;
     bool sendMidiClock = INIConfig::Defaults::DEFAULT_MIDI_CLOCK_OUT;
     bool receiveMidiClock = INIConfig::Defaults::DEFAULT_MIDI_CLOCK_IN;
+    std::atomic<bool> offlineRender{false};
 
     bool loopEnabled = false;
     int loopStartBar = INIConfig::Defaults::ZERO_VALUE;
@@ -262,22 +449,87 @@ private:
 
     int countInBars = INIConfig::Defaults::DEFAULT_COUNT_IN_BARS;
     double countInPosition = INIConfig::MIDI::DEFAULT_POSITION;
-    bool countingIn = false;
+    std::atomic<bool> countingIn{false};
 
     bool metronomeEnabled = INIConfig::Defaults::DEFAULT_METRONOME_ENABLED;
     float metronomeVolume = INIConfig::Defaults::DEFAULT_METRONOME_VOLUME;
 
     bool isRecording = false;
     juce::MidiMessageSequence recordBuffer;
-    double recordStartTime = INIConfig::MIDI::DEFAULT_LAST_TIME;
 
     bool liveRecording = false;
     bool overdubMode = false;
     bool loopRecordingMode = false;
+    bool quantizeRecording = false;
     int loopRecordingBars = static_cast<int>(INIConfig::Defaults::BEATS_PER_BAR);
-    double loopRecordingStartTime = INIConfig::MIDI::DEFAULT_LAST_TIME;
 
+    // Message thread side of the take; events from an older take are dropped
+    int activeTakeId = INIConfig::Defaults::ZERO_VALUE;
+    int lastTakeId = INIConfig::Defaults::ZERO_VALUE;
+    int recordPlayerIndex = INIConfig::Defaults::ZERO_VALUE;
+    double takeLoopBeats = INIConfig::MIDI::DEFAULT_POSITION;
+    int completedLoops = INIConfig::Defaults::ZERO_VALUE;
+    double noteOnShift[INIConfig::MIDI::NUM_NOTE_NUMBERS] = {};
+
+    // Audio thread side of the take
+    int audioTakeId = INIConfig::Defaults::ZERO_VALUE;
+    bool takeStartPending = false;
+    double takeStartBeat = INIConfig::MIDI::DEFAULT_POSITION;
+    double audioLoopBeats = INIConfig::MIDI::DEFAULT_POSITION;
+    double nextLoopEndBeat = INIConfig::MIDI::DEFAULT_POSITION;
+
+    // Sample-counted position since playback started; bars do not wrap
+    double transportBeat = INIConfig::MIDI::DEFAULT_POSITION;
+    juce::int64 transportSample = 0;
+    double wallClockSampleRemainder = 0.0;
+    LaunchScheduler launchScheduler;
+
+    // Shared: chains are set from the message thread, Sections are consumed here
+    SongArranger songArranger;
+
+    juce::int64 nextClockPulse = 0;
+    double nextMetronomeBeat = INIConfig::MIDI::DEFAULT_POSITION;
+    juce::int64 processedSamples = 0;
+    MidiClockTracker clockTracker;
+    double clockBeatOffset = INIConfig::MIDI::DEFAULT_POSITION;
+    double clockFollowBeatsPerSample = 0.0;
+    bool followingExternalClock = false;
+
+    SpscFifo<EngineCommand, INIConfig::MIDI::COMMAND_QUEUE_SIZE> engineCommands;
+    SpscFifo<EngineEvent, INIConfig::MIDI::EVENT_QUEUE_SIZE> engineEvents;
+    TripleBuffer<SceneTable> sceneTable;
+    TripleBuffer<TempoMap> tempoMaps;
+    SpscFifo<RecordedEvent, INIConfig::MIDI::RECORD_QUEUE_SIZE> recordedEvents;
+    std::atomic<bool> inputTapEnabled{false};
+    SpscFifo<InputNote, INIConfig::MIDI::INPUT_TAP_QUEUE_SIZE> inputTap;
+
+    // Finished patterns are built on the message thread and swapped in by the audio thread,
+    // which hands the replaced sequence back to be freed
+    std::atomic<juce::MidiMessageSequence*> publishedPatterns[INIConfig::Defaults::MAX_PLAYERS] = {};
+    SpscFifo<juce::MidiMessageSequence*, INIConfig::MIDI::RETIRED_PATTERN_QUEUE_SIZE> retiredPatterns;
+
+    // Each player's beats-button patterns, set on the message thread and picked up by the
+    // audio thread when a button starts. The preloader reuses a Section only once it is
+    // in neither table; the count is odd while the audio thread is between reading one
+    // and recording it as playing, and moves on each time, so a check that overlapped
+    // a read can tell.
+    std::atomic<const SongArranger::Section*> groupPatterns[INIConfig::Defaults::MAX_PLAYERS][INIConfig::Validation::MAX_BUTTON_INDEX + 1] = {};
+    std::atomic<const SongArranger::Section*> playingGroupPatterns[INIConfig::Defaults::MAX_PLAYERS] = {};
+    std::atomic<juce::uint32> groupPatternReads{0};
+    // Scene patterns the audio thread launched, guarded by a count that works the same way
+    std::atomic<const SongArranger::Section*> playingScenePatterns[INIConfig::Defaults::MAX_PLAYERS] = {};
+    std::atomic<juce::uint32> scenePatternReads{0};
+    PatternPreloader patternPreloader;
+
+    // Message thread
+    PlayerControls controls[INIConfig::Defaults::MAX_PLAYERS];
+    TempoMap tempoMapControl;
     juce::Array<Scene> scenes;
+    SceneTable compiledScenes{};
+    std::map<juce::String, ScenePattern> scenePatterns;
+    // Replaced patterns may still be playing or sit in a published table; they are freed
+    // from the timer once neither holds them
+    std::vector<std::unique_ptr<SongArranger::Section>> replacedScenePatterns;
     int activeSceneIndex = INIConfig::MIDI::INACTIVE_SCENE;
     juce::Array<QueuedChange> queuedChanges;
 
@@ -285,32 +537,100 @@ private:
     double lastTapTime = INIConfig::MIDI::DEFAULT_LAST_TIME;
     int tapTempoAverageCount = INIConfig::Defaults::TAP_TEMPO_AVERAGE_COUNT;
 
-    juce::Array<PatternChange> pendingPatternChanges;
-
-    bool midiLearnActive = false;
+    // Set on the message thread; the audio thread clears it when a CC arrives and leaves
+    // the mapping to be made by dispatchEngineEvents()
+    std::atomic<bool> midiLearnActive{false};
     juce::String currentLearnParameter;
     juce::Array<MidiMapping> midiMappings;
     juce::Array<MidiControllerPreset> controllerPresets;
     juce::String currentControllerPreset;
 
-    MidiFileManager* midiFileManager = nullptr;
+    struct CCBinding {
+        juce::RangedAudioParameter* parameter = nullptr;
+        int unresolvedIndex = INIConfig::Defaults::ZERO_VALUE;
+        float minValue = INIConfig::Validation::MIN_VOLUME;
+        float maxValue = INIConfig::Validation::MAX_VOLUME;
+    };
+
+    // [channel][cc] -> contiguous run of bindings, so an incoming CC is one lookup
+    struct CCDispatchTable {
+        struct Slot {
+            juce::uint16 first = 0;
+            juce::uint16 count = 0;
+        };
+
+        static int slotIndex(int channel, int ccNumber) {
+            return (channel - INIConfig::Validation::MIN_MIDI_CHANNEL) * INIConfig::MIDI::NUM_CC_NUMBERS + ccNumber;
+        }
+
+        std::array<Slot, INIConfig::Validation::MAX_MIDI_CHANNEL * INIConfig::MIDI::NUM_CC_NUMBERS> slots{};
+        std::array<CCBinding, INIConfig::MIDI::MAX_CC_BINDINGS> bindings{};
+        juce::StringArray unresolvedParameterIDs;
+    };
+
+    std::function<juce::RangedAudioParameter*(const juce::String&)> parameterResolver;
+    TripleBuffer<CCDispatchTable> ccDispatchTable;
+    juce::SpinLock ccDispatchWriteLock;
 
-    void processPlayer(int playerIndex, juce::MidiBuffer& midiMessages, double deltaTime);
-    void generatePatternNotes(int playerIndex, juce::MidiBuffer& midiMessages);
-    void generateMidiClock(juce::MidiBuffer& midiMessages);
-    void generateMetronome(juce::MidiBuffer& midiMessages);
+    MidiFileManager* midiFileManager = nullptr;
+    Mixer* mixer = nullptr;
+
+    void processPlayer(int playerIndex, juce::MidiBuffer& midiMessages, int startSample, double beats);
+    void generatePatternNotes(int playerIndex, juce::MidiBuffer& midiMessages, int startSample);
+    void generateMidiClock(juce::MidiBuffer& midiMessages, int startSample, int numSamples);
+    void processClockInput(const juce::MidiBuffer& midiMessages, int numSamples);
+    void handleClockMessage(const juce::MidiMessage& message, double timeSeconds);
+    void generateMetronome(juce::MidiBuffer& midiMessages, int startSample, int numSamples);
     void processMidiInput(const juce::MidiBuffer& midiMessages);
     void handleMidiCC(int channel, int ccNumber, int value);
-    void processPendingPatternChanges();
+    void completeMidiLearn(int channel, int ccNumber);
+    void insertMidiMapping(const MidiMapping& mapping);
+    void rebuildCCDispatchTable();
     void processCountIn(juce::MidiBuffer& midiMessages);
     void handleLoop();
-    void recordMidiMessage(const juce::MidiMessage& message);
-    juce::MidiMessage humanizeMessage(const juce::MidiMessage& message, float amount);
+    void recordMidiMessage(const juce::MidiMessage& message, double takeBeat);
+    int humanizeVelocity(PlayerState& player, int velocity);
+    void seedHumanization();
+    void startTransport(int countInBarsToPlay);
+    void stopTransport();
     int applyVelocityCurve(int velocity, VelocityCurve curve);
 
-    void processQueuedChanges();
+    void renderScheduledBlock(juce::MidiBuffer& midiMessages, int numSamples);
+    void renderSegment(juce::MidiBuffer& midiMessages, int startSample, int numSamples);
+    void fireLaunch(const LaunchScheduler::Launch& launch);
+    void queueSongSections();
+    void adoptSection(int playerIndex);
+    void playSection(int playerIndex, juce::MidiBuffer& midiMessages, int startSample, int numSamples);
+    juce::File resolvePatternFile(int patternIndex, const juce::String& groupName = {}) const;
+    juce::String getPlayerGroupName(int playerIndex) const;
+    bool isGroupPatternInUse(const SongArranger::Section* pattern) const;
+    bool isScenePatternInUse(const SongArranger::Section* pattern) const;
+    void reclaimScenePatterns();
+    double getBeatsPerSample() const;
+    bool usesTempoMap() const;
+    double getBeatAfterSamples(double numSamples) const;
+    double getSamplesUntilBeat(double beat) const;
+    void pushCommand(const EngineCommand& command);
+    void drainCommands();
+    void applyCommand(const EngineCommand& command);
+    void startPattern(int playerIndex, int patternIndex);
+    void launchScene(int sceneIndex);
+    void postEvent(const EngineEvent& event);
+    void applySceneToControls(int sceneIndex);
+    void compileScene(int sceneIndex);
+    const SongArranger::Section* compileScenePattern(const Scene::ClipState& clip);
+    void publishScenes();
+    void timerCallback() override;
     void processLiveRecording(const juce::MidiBuffer& midiMessages);
-    void processLoopRecording();
+    void advanceRecordingLoops(double takeBeat);
+    void adoptPublishedPatterns();
+    void beginRecordingTake();
+    void endRecordingTake();
+    void collectRecordedEvents();
+    void tapMidiInput(const juce::MidiBuffer& midiMessages);
+    void commitRecordedTake();
+    void publishPattern(int playerIndex);
+    double quantizeRecordedEvent(const juce::MidiMessage& message, double beat);
     void initializeScenes();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiEngine)
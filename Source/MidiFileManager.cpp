@@ -3,10 +3,21 @@
 #include <algorithm>
 #include <cmath>
 
-MidiFileManager::MidiFileManager() {
+MidiFileManager::MidiFileManager()
+    : libraryRoot(getAssetsChild(INIConfig::MIDI_LIBRARY_FOLDER)),
+      analysisCacheFile(INIConfig::getOTTODataDirectory().getChildFile(INIConfig::CACHE_FOLDER)
+                            .getChildFile(INIConfig::MIDI_ANALYSIS_BINARY_CACHE_FILE)),
+      prebuiltAnalysisCacheFile(getAssetsChild(INIConfig::PREBUILT_CACHE_FOLDER + "/" + INIConfig::MIDI_ANALYSIS_BINARY_CACHE_FILE)),
+      analysisCache(analysisCacheFile, libraryRoot, prebuiltAnalysisCacheFile),
+      patternBankFile(INIConfig::getOTTODataDirectory().getChildFile(INIConfig::CACHE_FOLDER)
+                          .getChildFile(INIConfig::PATTERN_BANK_FILE)),
+      prebuiltPatternBankFile(getAssetsChild(INIConfig::PREBUILT_CACHE_FOLDER + "/" + INIConfig::PATTERN_BANK_FILE)) {
+    // Whatever was compiled last time; patterns changed since are read from their files
+    openPatternBank();
+
     juce::File assetsPath = getAssetsPath();
     if (assetsPath.exists()) {
-        midiFilesFolder = assetsPath.getChildFile("MidiFiles/Grooves");
+        midiFilesFolder = assetsPath.getChildFile(INIConfig::MIDI_LIBRARY_FOLDER);
         grooveTemplatesFolder = INIConfig::getOTTODataDirectory().getChildFile("GrooveTemplates");
 
         if (!grooveTemplatesFolder.exists()) {
@@ -21,6 +32,10 @@ MidiFileManager::MidiFileManager() {
     }
 }
 
+MidiFileManager::~MidiFileManager() {
+    cancelLibraryAnalysis();
+}
+
 juce::File MidiFileManager::getAssetsPath() {
     juce::File exePath = juce::File::getSpecialLocation(juce::File::currentExecutableFile);
     juce::File bundleContents = exePath.getParentDirectory().getParentDirectory();
@@ -45,242 +60,181 @@ juce::File MidiFileManager::getAssetsPath() {
     return juce::File();
 }
 
-MidiGrooveAnalysis MidiFileManager::analyzeMidiFile(const juce::String& fileName) {
-    if (analysisCache.count(fileName) > 0) {
-        return analysisCache[fileName];
-    }
-
-    MidiGrooveAnalysis analysis;
-    juce::File midiFile = getMidiFile(fileName);
-
-    if (!midiFile.existsAsFile()) {
-        return analysis;
-    }
-
-    juce::FileInputStream fileStream(midiFile);
-    if (!fileStream.openedOk()) {
-        return analysis;
-    }
-
-    juce::MidiFile midiFileData;
-    if (!midiFileData.readFrom(fileStream)) {
-        return analysis;
-    }
-
-    juce::MidiMessageSequence allEvents;
-    for (int track = 0; track < midiFileData.getNumTracks(); ++track) {
-        const juce::MidiMessageSequence* sequence = midiFileData.getTrack(track);
-        if (sequence) {
-            for (int i = 0; i < sequence->getNumEvents(); ++i) {
-                allEvents.addEvent(sequence->getEventPointer(i)->message);
-            }
-        }
-    }
-
-    allEvents.sort();
-
-    analysis.tempo = estimateTempo(allEvents);
-
-    detectTimeSignature(allEvents, analysis.timeSignatureNumerator, analysis.timeSignatureDenominator);
-
-    analysis.averageSwing = calculateSwing(allEvents);
-
-    analysis.grooveTightness = calculateGrooveTightness(allEvents);
-
-    float totalVelocity = 0.0f;
-    float minVelocity = 127.0f;
-    float maxVelocity = 0.0f;
-    int noteCount = 0;
-    juce::Array<float> velocities;
-
-    for (int i = 0; i < allEvents.getNumEvents(); ++i) {
-        const auto* event = allEvents.getEventPointer(i);
-        if (event && event->message.isNoteOn()) {
-            float velocity = static_cast<float>(event->message.getVelocity());
-            totalVelocity += velocity;
-            minVelocity = juce::jmin(minVelocity, velocity);
-            maxVelocity = juce::jmax(maxVelocity, velocity);
-            velocities.add(velocity);
-            noteCount++;
-        }
-    }
-
-    if (noteCount > 0) {
-        analysis.averageVelocity = totalVelocity / noteCount;
-        analysis.velocityRange = maxVelocity - minVelocity;
-
-        float variance = 0.0f;
-        for (float v : velocities) {
-            variance += (v - analysis.averageVelocity) * (v - analysis.averageVelocity);
-        }
-        analysis.velocityVariation = std::sqrt(variance / noteCount);
+juce::File MidiFileManager::getAssetsChild(const juce::String& path) {
+    const auto assetsPath = getAssetsPath();
+    return assetsPath.exists() ? assetsPath.getChildFile(path) : juce::File();
+}
 
-        double sequenceDuration = allEvents.getEndTime() - allEvents.getStartTime();
-        if (sequenceDuration > 0) {
-            double beatsInSequence = sequenceDuration * (analysis.tempo / 60.0);
-            analysis.noteDensity = noteCount / beatsInSequence;
-            analysis.numberOfBars = static_cast<int>(beatsInSequence / analysis.timeSignatureNumerator);
-        }
-    }
+MidiGrooveAnalysis MidiFileManager::analyzeMidiFile(const juce::String& fileName) {
+    const juce::File midiFile = getMidiFile(fileName);
 
-    std::map<int, int> noteDistribution;
-    for (int i = 0; i < allEvents.getNumEvents(); ++i) {
-        const auto* event = allEvents.getEventPointer(i);
-        if (event && event->message.isNoteOn()) {
-            int note = event->message.getNoteNumber();
-            noteDistribution[note]++;
-        }
+    // Library files come with their size and time from the catalog
+    if (const auto* entry = libraryCatalog.find(midiFile.getParentDirectory(), fileName)) {
+        return analysisCache.getAnalysis(*entry);
     }
 
-    for (const auto& pair : noteDistribution) {
-        analysis.noteDistribution.add(pair.second);
+    if (!midiFile.existsAsFile()) {
+        return MidiGrooveAnalysis();
     }
 
-    analysisCache[fileName] = analysis;
-
-    return analysis;
+    return analysisCache.getAnalysis({ midiFile, midiFile.getSize(), midiFile.getLastModificationTime() });
 }
 
-float MidiFileManager::calculateSwing(const juce::MidiMessageSequence& sequence) {
-    juce::Array<double> eighthNoteTimes;
-
-    for (int i = 0; i < sequence.getNumEvents(); ++i) {
-        const auto* event = sequence.getEventPointer(i);
-        if (event && event->message.isNoteOn()) {
-            double time = event->message.getTimeStamp();
-            double beatPosition = std::fmod(time * 2.0, 1.0);
+bool MidiFileManager::analyzeLibrary(const MidiAnalysisCache::ProgressCallback& progress) {
+    libraryCatalog.applyWatchedChanges();
+    return analysisCache.analyze(libraryCatalog.getEntries(), progress);
+}
 
-            if (beatPosition > INIConfig::LayoutConstants::midiFileManagerEighthNoteMin &&
-                beatPosition < INIConfig::LayoutConstants::midiFileManagerEighthNoteMax) {
-                eighthNoteTimes.add(beatPosition);
+// One analyzeLibraryAsync() call. The thread fills in everything after entries, and the
+// message thread only swaps it in.
+struct MidiFileManager::LibraryAnalysis {
+    Organization organization = Organization::None;
+    int generation = -1;
+    juce::Array<MidiLibraryCatalog::Entry> entries;
+    juce::Array<MidiGrooveAnalysis> analyses;
+    std::unique_ptr<GrooveSimilarityIndex> index;
+    juce::StringArray names;
+    // Its current patterns are copied into the bank compiled from this analysis
+    std::shared_ptr<const PatternBank> previousBank;
+    bool bankCompiled = false;
+};
+
+// Runs one analyzeLibraryAsync() call with a cache of its own, so the message thread's
+// cache is never used off it
+class MidiFileManager::AnalysisThread : public juce::Thread {
+public:
+    AnalysisThread(MidiFileManager& manager, std::shared_ptr<LibraryAnalysis> analysisToRun)
+        : juce::Thread("OTTO Library Analysis"), owner(&manager), number(manager.analysisNumber),
+          cache(manager.analysisCacheFile, manager.libraryRoot, manager.prebuiltAnalysisCacheFile),
+          bankFile(manager.patternBankFile), libraryRoot(manager.libraryRoot), analysis(std::move(analysisToRun)) {
+    }
+
+    ~AnalysisThread() override {
+        // The workers finish the file each is on, which never takes long, so this waits
+        // for them rather than leaving them with a cache that is gone
+        stopThread(-1);
+    }
+
+    void run() override {
+        double lastReportMs = 0.0;
+        const bool finished = cache.analyze(analysis->entries, [this, &lastReportMs](int done, int total) {
+            const double nowMs = juce::Time::getMillisecondCounterHiRes();
+            if (done == total || nowMs - lastReportMs >= INIConfig::MIDI::ANALYSIS_PROGRESS_INTERVAL_MS) {
+                lastReportMs = nowMs;
+                juce::MessageManager::callAsync([manager = owner, number = number, done, total]() {
+                    if (auto* strongManager = manager.get()) strongManager->handleAnalysisProgress(number, done, total);
+                });
             }
-        }
-    }
-
-    if (eighthNoteTimes.isEmpty()) {
-        return INIConfig::LayoutConstants::midiFileManagerSwingBase;
-    }
-
-    double averagePosition = 0.0;
-    for (double pos : eighthNoteTimes) {
-        averagePosition += pos;
-    }
-    averagePosition /= eighthNoteTimes.size();
-
-    float swing = INIConfig::LayoutConstants::midiFileManagerSwingBase +
-                  (averagePosition - INIConfig::LayoutConstants::midiFileManagerSwingOffset) *
-                  INIConfig::LayoutConstants::midiFileManagerSwingScale;
-    return juce::jlimit(INIConfig::LayoutConstants::midiFileManagerSwingMin,
-                       INIConfig::LayoutConstants::midiFileManagerSwingMax, swing);
+            return !threadShouldExit();
+        });
+        if (!finished || threadShouldExit()) return;
+
+        // Every entry is cached by now, so this reads rather than parses
+        auto index = std::make_unique<GrooveSimilarityIndex>();
+        index->reserve(analysis->entries.size());
+        analysis->analyses.ensureStorageAllocated(analysis->entries.size());
+        analysis->names.ensureStorageAllocated(analysis->entries.size());
+
+        for (const auto& entry : analysis->entries) {
+            const auto groove = cache.getAnalysis(entry);
+            index->add(groove);
+            analysis->analyses.add(groove);
+            analysis->names.add(entry.file.getFileNameWithoutExtension());
+        }
+
+        index->build();
+        analysis->index = std::move(index);
+        if (threadShouldExit()) return;
+
+        // From the same cache, so nothing is analyzed twice; a bank still mapped keeps its old contents
+        analysis->bankCompiled = PatternBank::compile(bankFile, analysis->entries, cache, analysis->previousBank.get(),
+                                                      libraryRoot, [this](int, int) { return !threadShouldExit(); });
+        if (threadShouldExit()) return;
+        if (!analysis->bankCompiled) {
+            DBG("MidiFileManager: Could not compile " + bankFile.getFullPathName());
+        }
+
+        juce::MessageManager::callAsync([manager = owner, number = number, result = analysis]() {
+            if (auto* strongManager = manager.get()) strongManager->handleAnalysisFinished(number, *result);
+        });
+    }
+
+private:
+    juce::WeakReference<MidiFileManager> owner;
+    const int number;
+    MidiAnalysisCache cache;
+    const juce::File bankFile;
+    const juce::File libraryRoot;
+    std::shared_ptr<LibraryAnalysis> analysis;
+};
+
+void MidiFileManager::analyzeLibraryAsync(Organization organization, AnalysisProgressCallback onProgress,
+                                          AnalysisFinishedCallback onFinished) {
+    cancelLibraryAnalysis();
+
+    libraryCatalog.applyWatchedChanges();
+    auto analysis = std::make_shared<LibraryAnalysis>();
+    analysis->organization = organization;
+    analysis->generation = libraryCatalog.getGeneration();
+    analysis->entries = libraryCatalog.getEntries();
+    analysis->previousBank = patternBank;
+
+    onAnalysisProgress = std::move(onProgress);
+    onAnalysisFinished = std::move(onFinished);
+    analysisThread = std::make_unique<AnalysisThread>(*this, std::move(analysis));
+    analysisThread->startThread();
 }
 
-float MidiFileManager::calculateGrooveTightness(const juce::MidiMessageSequence& sequence) {
-    juce::Array<double> timingDeviations;
-    double gridResolution = INIConfig::LayoutConstants::midiFileManagerGridResolution;
-
-    for (int i = 0; i < sequence.getNumEvents(); ++i) {
-        const auto* event = sequence.getEventPointer(i);
-        if (event && event->message.isNoteOn()) {
-            double time = event->message.getTimeStamp();
-            double quantizedTime = std::round(time / gridResolution) * gridResolution;
-            double deviation = std::abs(time - quantizedTime);
-            timingDeviations.add(deviation);
-        }
-    }
-
-    if (timingDeviations.isEmpty()) {
-        return 1.0f;
-    }
-
-    double totalDeviation = 0.0;
-    for (double dev : timingDeviations) {
-        totalDeviation += dev;
-    }
-    double averageDeviation = totalDeviation / timingDeviations.size();
-
-    float tightness = 1.0f - juce::jlimit(0.0f, 1.0f,
-        static_cast<float>(averageDeviation * INIConfig::LayoutConstants::midiFileManagerTightnessScale));
-    return tightness;
+void MidiFileManager::cancelLibraryAnalysis() {
+    analysisThread.reset();
+    ++analysisNumber;
+    onAnalysisProgress = nullptr;
+    onAnalysisFinished = nullptr;
 }
 
+void MidiFileManager::handleAnalysisProgress(int number, int done, int total) {
+    if (number != analysisNumber || onAnalysisProgress == nullptr) return;
 
-
-void MidiFileManager::detectTimeSignature(const juce::MidiMessageSequence& sequence,
-                                         int& numerator, int& denominator) {
-
-    juce::Array<double> kickTimes;
-    for (int i = 0; i < sequence.getNumEvents(); ++i) {
-        const auto* event = sequence.getEventPointer(i);
-        if (event && event->message.isNoteOn()) {
-            int note = event->message.getNoteNumber();
-            if (note == 36 || note == 35) {
-                kickTimes.add(event->message.getTimeStamp());
-            }
-        }
-    }
-
-    if (kickTimes.size() >= 2) {
-        double avgInterval = 0.0;
-        for (int i = 1; i < kickTimes.size(); ++i) {
-            avgInterval += kickTimes[i] - kickTimes[i-1];
-        }
-        avgInterval /= (kickTimes.size() - 1);
-
-        if (avgInterval > 0.9 && avgInterval < 1.1) {
-            numerator = 4;
-            denominator = 4;
-        } else if (avgInterval > 0.65 && avgInterval < 0.85) {
-            numerator = 3;
-            denominator = 4;
-        } else if (avgInterval > 1.4 && avgInterval < 1.6) {
-            numerator = 6;
-            denominator = 8;
-        } else {
-            numerator = 4;
-            denominator = 4;
-        }
-    } else {
-        numerator = 4;
-        denominator = 4;
+    if (!onAnalysisProgress(done, total)) {
+        cancelLibraryAnalysis();
     }
 }
 
-float MidiFileManager::estimateTempo(const juce::MidiMessageSequence& sequence) {
-    juce::Array<double> noteTimes;
+void MidiFileManager::handleAnalysisFinished(int number, LibraryAnalysis& analysis) {
+    if (number != analysisNumber) return;
 
-    for (int i = 0; i < sequence.getNumEvents(); ++i) {
-        const auto* event = sequence.getEventPointer(i);
-        if (event && event->message.isNoteOn()) {
-            noteTimes.add(event->message.getTimeStamp());
-        }
-    }
+    analysisThread.reset();
+    ++analysisNumber;
+    onAnalysisProgress = nullptr;
+    const auto onFinished = std::move(onAnalysisFinished);
+    onAnalysisFinished = nullptr;
 
-    if (noteTimes.size() < 2) {
-        return INIConfig::Defaults::DEFAULT_TEMPO;
+    // The thread's cache has written them to the cache file; this keeps lookups from parsing again
+    for (int i = 0; i < analysis.entries.size(); ++i) {
+        analysisCache.store(analysis.entries.getReference(i), analysis.analyses.getReference(i));
     }
 
-    juce::Array<double> intervals;
-    for (int i = 1; i < noteTimes.size(); ++i) {
-        double interval = noteTimes[i] - noteTimes[i-1];
-        if (interval > 0.1 && interval < 2.0) {
-            intervals.add(interval);
-        }
-    }
+    grooveIndex = std::move(analysis.index);
+    grooveIndexNames = std::move(analysis.names);
+    grooveIndexGeneration = analysis.generation;
 
-    if (intervals.isEmpty()) {
-        return INIConfig::Defaults::DEFAULT_TEMPO;
+    // Players pick up the new bank the next time they load patterns
+    if (analysis.bankCompiled) {
+        openPatternBank();
     }
 
-    intervals.sort();
-    double modeInterval = intervals[intervals.size() / 2];
-
-    float tempo = 60.0f / static_cast<float>(modeInterval);
+    applyOrganization(analysis.organization);
 
-    tempo = std::round(tempo / INIConfig::LayoutConstants::midiFileManagerTempoRoundTo) *
-            INIConfig::LayoutConstants::midiFileManagerTempoRoundTo;
+    if (onFinished) {
+        onFinished();
+    }
+}
 
-    return juce::jlimit(INIConfig::LayoutConstants::midiFileManagerTempoEstimateMin,
-                       INIConfig::LayoutConstants::midiFileManagerTempoEstimateMax, tempo);
+void MidiFileManager::openPatternBank() {
+    // The bank already handed out stays mapped for as long as anyone holds it
+    auto bank = std::make_shared<PatternBank>();
+    const bool opened = bank->open(patternBankFile, libraryRoot) || bank->open(prebuiltPatternBankFile, libraryRoot);
+    patternBank = opened ? std::move(bank) : nullptr;
 }
 
 void MidiFileManager::autoMapMidiFileToKit(const juce::String& fileName, int playerIndex) {
@@ -290,35 +244,28 @@ void MidiFileManager::autoMapMidiFileToKit(const juce::String& fileName, int pla
 
 juce::StringArray MidiFileManager::suggestSimilarGrooves(const juce::String& fileName, int maxSuggestions) {
     juce::StringArray suggestions;
-    MidiGrooveAnalysis targetAnalysis = analyzeMidiFile(fileName);
-
-    juce::Array<std::pair<float, juce::String>> scores;
-
-    for (const auto& group : availableGroups) {
-        for (const auto& file : group.midiFiles) {
-            if (file == fileName) continue;
-
-            MidiGrooveAnalysis analysis = analyzeMidiFile(file);
-
-            float tempoScore = 1.0f - std::abs(analysis.tempo - targetAnalysis.tempo) / 100.0f;
-            float swingScore = 1.0f - std::abs(analysis.averageSwing - targetAnalysis.averageSwing) / 100.0f;
-            float tightnessScore = 1.0f - std::abs(analysis.grooveTightness - targetAnalysis.grooveTightness);
-            float velocityScore = 1.0f - std::abs(analysis.averageVelocity - targetAnalysis.averageVelocity) / 127.0f;
+    updateGrooveIndex();
+    if (grooveIndex == nullptr) return suggestions;
 
-            float totalScore = (tempoScore + swingScore + tightnessScore + velocityScore) / 4.0f;
+    // One extra for the file itself; a name in several folders can still crowd out a suggestion
+    const auto matches = grooveIndex->findNearest(analyzeMidiFile(fileName), maxSuggestions + 1);
 
-            scores.add({totalScore, file});
+    for (const auto& match : matches) {
+        const auto& name = grooveIndexNames[match.index];
+        if (name != fileName && suggestions.size() < maxSuggestions) {
+            suggestions.addIfNotAlreadyThere(name);
         }
     }
 
-    std::sort(scores.begin(), scores.end(),
-              [](const auto& a, const auto& b) { return a.first > b.first; });
+    return suggestions;
+}
 
-    for (int i = 0; i < juce::jmin(maxSuggestions, scores.size()); ++i) {
-        suggestions.add(scores[i].second);
-    }
+void MidiFileManager::updateGrooveIndex() {
+    libraryCatalog.applyWatchedChanges();
+    if (grooveIndexGeneration == libraryCatalog.getGeneration() || isAnalyzingLibrary()) return;
 
-    return suggestions;
+    // Suggestions keep coming from the old index until the new one is swapped in
+    analyzeLibraryAsync(Organization::None, nullptr, nullptr);
 }
 
 juce::MidiMessageSequence MidiFileManager::extractGrooveFromMidiFile(const juce::String& fileName) {
@@ -660,7 +607,38 @@ void MidiFileManager::applySwing(juce::MidiMessageSequence& sequence, float swin
     sequence.sort();
 }
 
-void MidiFileManager::organizeFilesByTempo() {
+void MidiFileManager::organizeFilesByTempo(AnalysisProgressCallback onProgress, AnalysisFinishedCallback onFinished) {
+    analyzeLibraryAsync(Organization::ByTempo, std::move(onProgress), std::move(onFinished));
+}
+
+void MidiFileManager::organizeFilesByGroove(AnalysisProgressCallback onProgress, AnalysisFinishedCallback onFinished) {
+    analyzeLibraryAsync(Organization::ByGroove, std::move(onProgress), std::move(onFinished));
+}
+
+void MidiFileManager::createSmartGroups(AnalysisProgressCallback onProgress, AnalysisFinishedCallback onFinished) {
+    analyzeLibraryAsync(Organization::Smart, std::move(onProgress), std::move(onFinished));
+}
+
+void MidiFileManager::applyOrganization(Organization organization) {
+    switch (organization) {
+        case Organization::ByTempo:
+            groupFilesByTempo();
+            break;
+
+        case Organization::ByGroove:
+            groupFilesByGroove();
+            break;
+
+        case Organization::Smart:
+            groupFilesSmartly();
+            break;
+
+        case Organization::None:
+            break;
+    }
+}
+
+void MidiFileManager::groupFilesByTempo() {
     for (int i = availableGroups.size() - 1; i >= 0; --i) {
         if (!availableGroups[i].isCustomGroup) {
             availableGroups.remove(i);
@@ -690,7 +668,7 @@ void MidiFileManager::organizeFilesByTempo() {
     }
 }
 
-void MidiFileManager::organizeFilesByGroove() {
+void MidiFileManager::groupFilesByGroove() {
     for (int i = availableGroups.size() - 1; i >= 0; --i) {
         if (!availableGroups[i].isCustomGroup) {
             availableGroups.remove(i);
@@ -741,7 +719,7 @@ void MidiFileManager::organizeFilesByGroove() {
     }
 }
 
-void MidiFileManager::createSmartGroups() {
+void MidiFileManager::groupFilesSmartly() {
     struct SmartGroupCriteria {
         juce::String name;
         float minTempo, maxTempo;
@@ -802,22 +780,17 @@ void MidiFileManager::scanMidiFiles() {
         return;
     }
 
-    juce::Array<juce::File> subFolders;
-    midiFilesFolder.findChildFiles(subFolders, juce::File::findDirectories, false);
+    // The first scan indexes the whole library; later ones reread only directories that changed
+    if (libraryCatalog.getRoot() != midiFilesFolder) {
+        libraryCatalog.setRoot(midiFilesFolder);
+    } else {
+        libraryCatalog.refresh();
+    }
 
-    for (const auto& subFolder : subFolders) {
+    for (const auto& subFolder : libraryCatalog.getSubdirectories(midiFilesFolder)) {
         MidiFileGroup group(subFolder.getFileName(), subFolder.getFullPathName(), false);
-        juce::Array<juce::File> midiFiles;
-        subFolder.findChildFiles(midiFiles, juce::File::findFiles, false, "*.mid;*.MID;*.midi;*.MIDI");
-
-        juce::StringArray fileNames;
-        for (const auto& midiFile : midiFiles) {
-            fileNames.add(midiFile.getFileNameWithoutExtension());
-        }
 
-        fileNames.sort(true);
-
-        for (const auto& fileName : fileNames) {
+        for (const auto& fileName : libraryCatalog.getFileNames(subFolder)) {
             group.midiFiles.add(fileName);
             group.displayNames.add(truncateTextForButton(fileName));
         }
@@ -827,18 +800,7 @@ void MidiFileManager::scanMidiFiles() {
         }
     }
 
-    juce::Array<juce::File> rootMidiFiles;
-    midiFilesFolder.findChildFiles(rootMidiFiles, juce::File::findFiles, false, "*.mid;*.MID;*.midi;*.MIDI");
-
-    if (!rootMidiFiles.isEmpty()) {
-        juce::StringArray rootFileNames;
-        for (const auto& midiFile : rootMidiFiles) {
-            rootFileNames.add(midiFile.getFileNameWithoutExtension());
-        }
-
-        rootFileNames.sort(true);
-        rootMidiFileNames = rootFileNames;
-    }
+    rootMidiFileNames = libraryCatalog.getFileNames(midiFilesFolder);
 }
 
 juce::Array<juce::String> MidiFileManager::getAllMidiFilesAlphabetically() const {
@@ -1110,29 +1072,54 @@ bool MidiFileManager::selectGroup(const juce::String& groupName) {
 }
 
 juce::File MidiFileManager::getMidiFile(const juce::String& fileName) const {
+    libraryCatalog.applyWatchedChanges();
+
     for (const auto& group : availableGroups) {
         if (group.groupName == currentGroupName) {
-            if (group.isCustomGroup) {
-                juce::Array<juce::File> allMidiFiles;
-                midiFilesFolder.findChildFiles(allMidiFiles, juce::File::findFilesAndDirectories, true, "*.mid;*.MID;*.midi;*.MIDI");
+            return findGroupMidiFile(group, fileName);
+        }
+    }
+    return juce::File();
+}
 
-                for (const auto& file : allMidiFiles) {
-                    if (file.getFileNameWithoutExtension() == fileName) {
-                        return file;
-                    }
-                }
-            } else {
-                juce::File groupFolder(group.folderPath);
-                juce::String extensions[] = {".mid", ".MID", ".midi", ".MIDI"};
-
-                for (const auto& ext : extensions) {
-                    juce::File midiFile = groupFolder.getChildFile(fileName + ext);
-                    if (midiFile.existsAsFile()) {
-                        return midiFile;
-                    }
-                }
+juce::Array<juce::File> MidiFileManager::getGroupMidiFiles(const juce::String& groupName) const {
+    libraryCatalog.applyWatchedChanges();
+
+    juce::Array<juce::File> files;
+    for (const auto& group : availableGroups) {
+        if (group.groupName != groupName) continue;
+
+        for (const auto& fileName : group.midiFiles) {
+            const auto file = findGroupMidiFile(group, fileName);
+            if (file.existsAsFile()) {
+                files.add(file);
             }
         }
+        break;
+    }
+    return files;
+}
+
+juce::File MidiFileManager::findGroupMidiFile(const MidiFileGroup& group, const juce::String& fileName) const {
+    if (group.isCustomGroup) {
+        const auto* entry = libraryCatalog.find(fileName);
+        return entry != nullptr ? entry->file : juce::File();
+    }
+
+    juce::File groupFolder(group.folderPath);
+    if (libraryCatalog.containsDirectory(groupFolder)) {
+        const auto* entry = libraryCatalog.find(groupFolder, fileName);
+        return entry != nullptr ? entry->file : juce::File();
+    }
+
+    // A folder from outside the library is probed directly
+    juce::String extensions[] = {".mid", ".MID", ".midi", ".MIDI"};
+
+    for (const auto& ext : extensions) {
+        juce::File midiFile = groupFolder.getChildFile(fileName + ext);
+        if (midiFile.existsAsFile()) {
+            return midiFile;
+        }
     }
     return juce::File();
 }
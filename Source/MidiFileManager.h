@@ -1,8 +1,14 @@
 #pragma once
 #include <JuceHeader.h>
+#include <functional>
+#include <memory>
 #include "ComponentState.h"
 #include "MidiAnalysisTypes.h"
 #include "INIConfig.h"
+#include "MidiLibraryCatalog.h"
+#include "MidiAnalysisCache.h"
+#include "GrooveSimilarityIndex.h"
+#include "PatternBank.h"
 
 struct MidiFileGroup {
     juce::String groupName;
@@ -20,8 +26,20 @@ struct MidiFileGroup {
 
 class MidiFileManager {
 public:
+    enum class Organization {
+        None,
+        ByTempo,
+        ByGroove,
+        Smart
+    };
+
+    // Files analyzed so far out of the library's total; returning false cancels
+    using AnalysisProgressCallback = MidiAnalysisCache::ProgressCallback;
+    // Called once the results are in; never for an analysis that was cancelled
+    using AnalysisFinishedCallback = std::function<void()>;
+
     MidiFileManager();
-    ~MidiFileManager() = default;
+    ~MidiFileManager();
 
     void setMidiFilesFolder(const juce::File& folder);
     void scanMidiFiles();
@@ -34,6 +52,8 @@ public:
     juce::Array<juce::String> getCurrentGroupDisplayNames() const;
     bool selectGroup(const juce::String& groupName);
     juce::File getMidiFile(const juce::String& fileName) const;
+    // The files behind a group's buttons, in button order, skipping any that are missing
+    juce::Array<juce::File> getGroupMidiFiles(const juce::String& groupName) const;
 
     void addBeatsButtonGroup(const juce::String& groupName, const juce::Array<juce::String>& fileNames, bool isFavorite = false, int selectedButton = INIConfig::Defaults::DEFAULT_SELECTED_BUTTON);
     void removeBeatsButtonGroup(const juce::String& groupName);
@@ -58,7 +78,22 @@ public:
     void createGroupsFromSortedMidiFiles(const juce::Array<juce::String>& sortedFiles);
 
     MidiGrooveAnalysis analyzeMidiFile(const juce::String& fileName);
+    // Analyzes every library file not already cached, on worker threads; false if cancelled
+    bool analyzeLibrary(const MidiAnalysisCache::ProgressCallback& progress = nullptr);
+    // Message thread only. Analyzes the library, builds its groove index and compiles the
+    // pattern bank on a background thread, reporting progress on the message thread. The
+    // results are swapped in there, the library is regrouped by organization, and then
+    // onFinished is called. Starting another analysis cancels this one.
+    void analyzeLibraryAsync(Organization organization, AnalysisProgressCallback onProgress,
+                             AnalysisFinishedCallback onFinished);
+    // Nothing more is reported for the analysis once this returns
+    void cancelLibraryAnalysis();
+    bool isAnalyzingLibrary() const { return analysisThread != nullptr; }
+    // The bank the last library analysis compiled, in this session or an earlier one, else
+    // the prebuilt one, else nullptr; shared with whoever plays from it
+    std::shared_ptr<const PatternBank> getPatternBank() const { return patternBank; }
     void autoMapMidiFileToKit(const juce::String& fileName, int playerIndex);
+    // From the groove index as of the last library analysis; a stale index starts a new one
     juce::StringArray suggestSimilarGrooves(const juce::String& fileName, int maxSuggestions = INIConfig::UI::MAX_TOGGLE_STATES);
 
     juce::MidiMessageSequence extractGrooveFromMidiFile(const juce::String& fileName);
@@ -80,9 +115,10 @@ public:
     juce::MidiMessageSequence createVariation(const juce::MidiMessageSequence& pattern,
                                              float variationAmount);
 
-    void organizeFilesByTempo();
-    void organizeFilesByGroove();
-    void createSmartGroups();
+    // Regroup the library once a background analysis finishes; see analyzeLibraryAsync()
+    void organizeFilesByTempo(AnalysisProgressCallback onProgress = nullptr, AnalysisFinishedCallback onFinished = nullptr);
+    void organizeFilesByGroove(AnalysisProgressCallback onProgress = nullptr, AnalysisFinishedCallback onFinished = nullptr);
+    void createSmartGroups(AnalysisProgressCallback onProgress = nullptr, AnalysisFinishedCallback onFinished = nullptr);
 
     void saveStates(ComponentState& state);
     void loadStates(const ComponentState& state);
@@ -92,20 +128,48 @@ private:
     juce::Array<MidiFileGroup> availableGroups;
     juce::String currentGroupName;
     juce::StringArray rootMidiFileNames;
-
-    std::map<juce::String, MidiGrooveAnalysis> analysisCache;
+    // Brought up to date from lookups, which are otherwise read-only
+    mutable MidiLibraryCatalog libraryCatalog;
+
+    // The library shipped with the assets; cached paths inside it are kept relative to it
+    juce::File libraryRoot;
+    juce::File analysisCacheFile;
+    juce::File prebuiltAnalysisCacheFile;
+    MidiAnalysisCache analysisCache;
+    // Every library file by name, rebuilt in the background when the catalog moves on
+    std::unique_ptr<GrooveSimilarityIndex> grooveIndex;
+    juce::StringArray grooveIndexNames;
+    int grooveIndexGeneration = -1;
+
+    struct LibraryAnalysis;
+    class AnalysisThread;
+    std::unique_ptr<AnalysisThread> analysisThread;
+    AnalysisProgressCallback onAnalysisProgress;
+    AnalysisFinishedCallback onAnalysisFinished;
+    // Reports from an analysis that was cancelled arrive late and are told apart by this
+    int analysisNumber = 0;
+
+    juce::File patternBankFile;
+    // Compiled offline along with the assets, and used until one is compiled here
+    juce::File prebuiltPatternBankFile;
+    std::shared_ptr<const PatternBank> patternBank;
 
     juce::File grooveTemplatesFolder;
     juce::Array<MidiGrooveAnalysis> grooveTemplates;
 
-    juce::File getAssetsPath();
+    static juce::File getAssetsPath();
+    static juce::File getAssetsChild(const juce::String& path);
     void scanFolderRecursively(const juce::File& folder, const juce::String& relativePath = "");
     void createInitialBeatsButtonGroups();
-
-    float calculateSwing(const juce::MidiMessageSequence& sequence);
-    float calculateGrooveTightness(const juce::MidiMessageSequence& sequence);
-    void detectTimeSignature(const juce::MidiMessageSequence& sequence, int& numerator, int& denominator);
-    float estimateTempo(const juce::MidiMessageSequence& sequence);
+    void updateGrooveIndex();
+    void handleAnalysisProgress(int number, int done, int total);
+    void handleAnalysisFinished(int number, LibraryAnalysis& analysis);
+    void applyOrganization(Organization organization);
+    void groupFilesByTempo();
+    void groupFilesByGroove();
+    void groupFilesSmartly();
+    void openPatternBank();
+    juce::File findGroupMidiFile(const MidiFileGroup& group, const juce::String& fileName) const;
 
     void quantizeToGrid(juce::MidiMessageSequence& sequence, int gridSubdivision);
     void humanizePattern(juce::MidiMessageSequence& sequence, float amount);
@@ -120,5 +184,6 @@ private:
 
     juce::Array<REXSlice> parseREXFile(const juce::File& rexFile);
 
+    JUCE_DECLARE_WEAK_REFERENCEABLE(MidiFileManager)
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiFileManager)
 };
@@ -0,0 +1,361 @@
+#include "MidiLibraryCatalog.h"
+#include <iterator>
+#include <utility>
+
+#if JUCE_LINUX
+    #include <poll.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+    // Preference when one name exists with several extensions, as the old per-extension probe had it
+    int getExtensionRank(const juce::String& extension) {
+        const char* const extensions[] = { ".mid", ".MID", ".midi", ".MIDI" };
+
+        for (int i = 0; i < static_cast<int>(std::size(extensions)); ++i) {
+            if (extension == extensions[i]) return i;
+        }
+        return -1;
+    }
+}
+
+MidiLibraryCatalog::MidiLibraryCatalog() : juce::Thread("OTTO MIDI Library") {
+}
+
+MidiLibraryCatalog::~MidiLibraryCatalog() {
+    stopWatching();
+}
+
+bool MidiLibraryCatalog::isMidiFile(const juce::File& file) {
+    return getExtensionRank(file.getFileExtension()) >= 0;
+}
+
+juce::String MidiLibraryCatalog::getPortablePath(const juce::File& file, const juce::File& root) {
+    if (root == juce::File() || !file.isAChildOf(root)) return file.getFullPathName();
+
+    return file.getRelativePathFrom(root).replaceCharacter('\\', '/');
+}
+
+juce::File MidiLibraryCatalog::resolvePortablePath(const juce::String& path, const juce::File& root) {
+    if (juce::File::isAbsolutePath(path)) return juce::File(path);
+
+    return root != juce::File() ? root.getChildFile(path) : juce::File();
+}
+
+juce::uint64 MidiLibraryCatalog::getContentHash(const juce::File& file) {
+    juce::MemoryBlock data;
+    if (!file.loadFileAsData(data)) return 0;
+
+    return getContentHash(data.getData(), data.getSize());
+}
+
+juce::uint64 MidiLibraryCatalog::getContentHash(const void* data, size_t size) {
+    // 64-bit FNV-1a
+    juce::uint64 hash = 0xcbf29ce484222325ull;
+    const auto* bytes = static_cast<const juce::uint8*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+void MidiLibraryCatalog::setRoot(const juce::File& newRoot) {
+    stopWatching();
+    directories.clear();
+    nameIndex.clear();
+    numFiles = 0;
+    ++generation;
+
+    root = newRoot;
+    if (!root.isDirectory()) return;
+
+    startWatching();
+    scanDirectory(root);
+}
+
+bool MidiLibraryCatalog::applyWatchedChanges() {
+    if (!changesPending.exchange(false)) return false;
+
+    juce::StringArray changed;
+    bool everything = false;
+    {
+        const juce::ScopedLock lock(watchLock);
+        for (const auto& path : changedPaths) {
+            changed.add(path);
+        }
+        changedPaths.clear();
+        everything = std::exchange(rescanEverything, false);
+    }
+
+    // The watcher lost events; nothing short of a full scan can be trusted
+    if (everything) {
+        setRoot(root);
+        return true;
+    }
+
+    rescan(changed);
+    return !changed.isEmpty();
+}
+
+bool MidiLibraryCatalog::refresh() {
+    bool changed = applyWatchedChanges();
+
+    juce::StringArray moved;
+    for (const auto& [path, directory] : directories) {
+        if (juce::File(path).getLastModificationTime() != directory.modified) {
+            moved.add(path);
+        }
+    }
+
+    rescan(moved);
+    return changed || !moved.isEmpty();
+}
+
+void MidiLibraryCatalog::rescan(const juce::StringArray& paths) {
+    for (const auto& path : paths) {
+        // Already gone with a parent that was rescanned first
+        if (directories.count(path) == 0) continue;
+
+        const juce::File directory(path);
+        if (directory.isDirectory())
+            scanDirectory(directory);
+        else
+            removeDirectory(path);
+    }
+}
+
+const MidiLibraryCatalog::Entry* MidiLibraryCatalog::find(const juce::String& name) const {
+    const auto indexed = nameIndex.find(name);
+    if (indexed == nameIndex.end() || indexed->second.empty()) return nullptr;
+
+    return find(juce::File(*indexed->second.begin()), name);
+}
+
+const MidiLibraryCatalog::Entry* MidiLibraryCatalog::find(const juce::File& directory, const juce::String& name) const {
+    const auto found = directories.find(directory.getFullPathName());
+    if (found == directories.end()) return nullptr;
+
+    const auto& files = found->second.files;
+    const auto entry = files.find(name);
+    return entry != files.end() ? &entry->second : nullptr;
+}
+
+bool MidiLibraryCatalog::containsDirectory(const juce::File& directory) const {
+    return directories.count(directory.getFullPathName()) > 0;
+}
+
+juce::StringArray MidiLibraryCatalog::getFileNames(const juce::File& directory) const {
+    const auto found = directories.find(directory.getFullPathName());
+    return found != directories.end() ? found->second.fileNames : juce::StringArray();
+}
+
+juce::Array<juce::File> MidiLibraryCatalog::getSubdirectories(const juce::File& directory) const {
+    juce::Array<juce::File> subdirectories;
+
+    const auto found = directories.find(directory.getFullPathName());
+    if (found != directories.end()) {
+        for (const auto& path : found->second.subdirectories) {
+            subdirectories.add(juce::File(path));
+        }
+    }
+    return subdirectories;
+}
+
+juce::Array<MidiLibraryCatalog::Entry> MidiLibraryCatalog::getEntries() const {
+    juce::Array<Entry> entries;
+    entries.ensureStorageAllocated(numFiles);
+
+    for (const auto& [path, directory] : directories) {
+        for (const auto& [name, entry] : directory.files) {
+            entries.add(entry);
+        }
+    }
+    return entries;
+}
+
+void MidiLibraryCatalog::scanDirectory(const juce::File& directoryFile) {
+    const auto path = directoryFile.getFullPathName();
+    auto& directory = directories[path];
+    ++generation;
+
+    // Watched and timed before listing, so a change made while listing is seen again
+    watchDirectory(path, directory);
+    directory.modified = directoryFile.getLastModificationTime();
+
+    unindexFiles(path, directory);
+    directory.files.clear();
+    directory.fileNames.clear();
+
+    juce::StringArray subdirectories;
+    for (const auto& child : juce::RangedDirectoryIterator(directoryFile, false, "*", juce::File::findFilesAndDirectories)) {
+        const auto& file = child.getFile();
+
+        if (child.isDirectory()) {
+            subdirectories.add(file.getFullPathName());
+            continue;
+        }
+
+        const int rank = getExtensionRank(file.getFileExtension());
+        if (rank < 0) continue;
+
+        const auto name = file.getFileNameWithoutExtension();
+        const auto existing = directory.files.find(name);
+        if (existing != directory.files.end() && getExtensionRank(existing->second.file.getFileExtension()) < rank) continue;
+
+        directory.files[name] = { file, child.getFileSize(), child.getModificationTime() };
+    }
+
+    for (const auto& [name, entry] : directory.files) {
+        directory.fileNames.add(name);
+        nameIndex[name].insert(path);
+    }
+    directory.fileNames.sort(true);
+    numFiles += static_cast<int>(directory.files.size());
+
+    // Directories that went away take their files with them; new ones are read now.
+    // References into the map survive the inserts and erases below.
+    subdirectories.sort(true);
+    const auto previous = std::exchange(directory.subdirectories, subdirectories);
+
+    for (const auto& subdirectory : previous) {
+        if (!subdirectories.contains(subdirectory)) {
+            removeDirectory(subdirectory);
+        }
+    }
+
+    for (const auto& subdirectory : subdirectories) {
+        if (directories.count(subdirectory) == 0) {
+            scanDirectory(juce::File(subdirectory));
+        }
+    }
+}
+
+void MidiLibraryCatalog::removeDirectory(const juce::String& path) {
+    const auto found = directories.find(path);
+    if (found == directories.end()) return;
+
+    const auto subdirectories = found->second.subdirectories;
+    ++generation;
+    unindexFiles(path, found->second);
+    unwatchDirectory(found->second);
+    directories.erase(found);
+
+    for (const auto& subdirectory : subdirectories) {
+        removeDirectory(subdirectory);
+    }
+}
+
+void MidiLibraryCatalog::unindexFiles(const juce::String& path, const Directory& directory) {
+    for (const auto& [name, entry] : directory.files) {
+        const auto indexed = nameIndex.find(name);
+        if (indexed == nameIndex.end()) continue;
+
+        indexed->second.erase(path);
+        if (indexed->second.empty()) {
+            nameIndex.erase(indexed);
+        }
+    }
+    numFiles -= static_cast<int>(directory.files.size());
+}
+
+void MidiLibraryCatalog::startWatching() {
+    #if JUCE_LINUX
+        inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd < 0) {
+            DBG("MidiLibraryCatalog: inotify unavailable, changes are picked up by refresh()");
+            return;
+        }
+
+        startThread();
+    #endif
+}
+
+void MidiLibraryCatalog::stopWatching() {
+    #if JUCE_LINUX
+        if (inotifyFd < 0) return;
+
+        stopThread(INIConfig::LayoutConstants::midiLibraryThreadStopTimeoutMs);
+        close(inotifyFd);
+        inotifyFd = -1;
+
+        for (auto& [path, directory] : directories) {
+            directory.watch = -1;
+        }
+
+        const juce::ScopedLock lock(watchLock);
+        watchedPaths.clear();
+        changedPaths.clear();
+        rescanEverything = false;
+        changesPending.store(false);
+    #endif
+}
+
+void MidiLibraryCatalog::watchDirectory(const juce::String& path, Directory& directory) {
+    #if JUCE_LINUX
+        if (inotifyFd < 0 || directory.watch >= 0) return;
+
+        const auto events = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE
+                          | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+        const int watch = inotify_add_watch(inotifyFd, path.toRawUTF8(), events);
+        if (watch < 0) {
+            DBG("MidiLibraryCatalog: Could not watch " + path);
+            return;
+        }
+
+        directory.watch = watch;
+
+        const juce::ScopedLock lock(watchLock);
+        watchedPaths[watch] = path;
+    #else
+        juce::ignoreUnused(path, directory);
+    #endif
+}
+
+void MidiLibraryCatalog::unwatchDirectory(Directory& directory) {
+    #if JUCE_LINUX
+        if (inotifyFd < 0 || directory.watch < 0) return;
+
+        inotify_rm_watch(inotifyFd, directory.watch);
+
+        const juce::ScopedLock lock(watchLock);
+        watchedPaths.erase(directory.watch);
+        directory.watch = -1;
+    #else
+        juce::ignoreUnused(directory);
+    #endif
+}
+
+void MidiLibraryCatalog::run() {
+    #if JUCE_LINUX
+        alignas(inotify_event) char buffer[INIConfig::MIDI::LIBRARY_WATCH_BUFFER_SIZE];
+
+        while (!threadShouldExit()) {
+            pollfd descriptor { inotifyFd, POLLIN, 0 };
+            if (poll(&descriptor, 1, INIConfig::MIDI::LIBRARY_WATCH_POLL_MS) <= 0) continue;
+
+            const auto length = read(inotifyFd, buffer, sizeof(buffer));
+            if (length <= 0) continue;
+
+            const juce::ScopedLock lock(watchLock);
+
+            for (ssize_t offset = 0; offset < length;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+                if ((event->mask & IN_Q_OVERFLOW) != 0) {
+                    rescanEverything = true;
+                    continue;
+                }
+
+                // Whatever happened inside a directory, reading it again brings the index up to date
+                const auto watched = watchedPaths.find(event->wd);
+                if (watched != watchedPaths.end()) {
+                    changedPaths.insert(watched->second);
+                }
+            }
+
+            changesPending.store(true);
+        }
+    #endif
+}
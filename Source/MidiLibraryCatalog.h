@@ -0,0 +1,100 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <set>
+#include <unordered_map>
+#include "INIConfig.h"
+
+// Index of the MIDI library by file name, built by one recursive scan so that resolving
+// a pattern is a hash lookup rather than a directory walk. Each directory keeps its own
+// listing and modification time, and only directories that changed are read again. On
+// Linux an inotify watcher thread notes which directories changed as it happens, so
+// applyWatchedChanges() costs nothing while the library sits still; elsewhere refresh()
+// compares directory times. Everything but the watcher runs on the message thread.
+class MidiLibraryCatalog : private juce::Thread {
+public:
+    struct Entry {
+        juce::File file;
+        juce::int64 size = 0;
+        juce::Time modified;
+    };
+
+    MidiLibraryCatalog();
+    ~MidiLibraryCatalog() override;
+
+    // Indexes everything under root from scratch
+    void setRoot(const juce::File& newRoot);
+    const juce::File& getRoot() const { return root; }
+
+    // Rescans the directories the watcher saw change; true if there were any
+    bool applyWatchedChanges();
+    // Also rescans every directory whose modification time moved, for when nothing is watching.
+    // A file rewritten in place does not touch its directory, so its size and time can lag until then.
+    bool refresh();
+    bool isWatching() const { return inotifyFd >= 0; }
+
+    // Name without extension anywhere in the library; the first directory in path order wins
+    const Entry* find(const juce::String& name) const;
+    // Name without extension directly inside directory
+    const Entry* find(const juce::File& directory, const juce::String& name) const;
+    bool containsDirectory(const juce::File& directory) const;
+
+    // Direct children of an indexed directory, sorted
+    juce::StringArray getFileNames(const juce::File& directory) const;
+    juce::Array<juce::File> getSubdirectories(const juce::File& directory) const;
+    int getNumFiles() const { return numFiles; }
+    // Moves whenever a directory is read again or dropped
+    int getGeneration() const { return generation; }
+    // Every indexed file, in no particular order
+    juce::Array<Entry> getEntries() const;
+
+    static bool isMidiFile(const juce::File& file);
+
+    // Inside root, the path from it with forward slashes, so that a cache made on one
+    // machine still matches on another; anything else keeps its full path
+    static juce::String getPortablePath(const juce::File& file, const juce::File& root);
+    static juce::File resolvePortablePath(const juce::String& path, const juce::File& root);
+
+    // Of the contents, for recognizing a file whose modification time was not kept, as by
+    // an installer; 0 if the file cannot be read
+    static juce::uint64 getContentHash(const juce::File& file);
+    static juce::uint64 getContentHash(const void* data, size_t size);
+
+private:
+    struct Directory {
+        juce::Time modified;
+        // By name without extension; .mid beats .MID beats .midi beats .MIDI
+        std::unordered_map<juce::String, Entry> files;
+        juce::StringArray fileNames;
+        juce::StringArray subdirectories;
+        int watch = -1;
+    };
+
+    void run() override;
+    void scanDirectory(const juce::File& directoryFile);
+    void removeDirectory(const juce::String& path);
+    void unindexFiles(const juce::String& path, const Directory& directory);
+    void rescan(const juce::StringArray& paths);
+    void startWatching();
+    void stopWatching();
+    void watchDirectory(const juce::String& path, Directory& directory);
+    void unwatchDirectory(Directory& directory);
+
+    juce::File root;
+    std::unordered_map<juce::String, Directory> directories;
+    // Every directory holding each name, in path order
+    std::unordered_map<juce::String, std::set<juce::String>> nameIndex;
+    int numFiles = 0;
+    int generation = 0;
+
+    // Shared with the watcher thread
+    juce::CriticalSection watchLock;
+    std::unordered_map<int, juce::String> watchedPaths;
+    std::set<juce::String> changedPaths;
+    bool rescanEverything = false;
+    std::atomic<bool> changesPending{false};
+    int inotifyFd = -1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiLibraryCatalog)
+};
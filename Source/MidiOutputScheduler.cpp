@@ -0,0 +1,161 @@
+#include "MidiOutputScheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+MidiOutputScheduler::MidiOutputScheduler() : juce::Thread("OTTO MIDI Out") {
+}
+
+MidiOutputScheduler::~MidiOutputScheduler() {
+    setOutput(nullptr);
+}
+
+void MidiOutputScheduler::setOutput(std::unique_ptr<juce::MidiOutput> newOutput) {
+    active.store(false);
+    stopThread(INIConfig::LayoutConstants::midiOutputThreadStopTimeoutMs);
+
+    output = std::move(newOutput);
+    numPending = 0;
+    clockValid = false;
+
+    if (output != nullptr) {
+        // Anything the audio thread queued for the previous device is stale
+        OutputEvent stale;
+        while (events.pop(stale)) {}
+
+        active.store(true);
+        startThread(juce::Thread::Priority::highest);
+    }
+}
+
+void MidiOutputScheduler::prepare(double sampleRate, int deviceLatency) {
+    if (sampleRate > 0.0) {
+        currentSampleRate.store(sampleRate);
+    }
+    deviceLatencySamples.store(juce::jmax(0, deviceLatency));
+}
+
+void MidiOutputScheduler::setProcessingLatency(int latencySamples) {
+    processingLatencySamples.store(juce::jmax(0, latencySamples));
+}
+
+double MidiOutputScheduler::getOutputDelayMs(juce::int64 samplePosition) const {
+    const juce::int64 latency = deviceLatencySamples.load() + processingLatencySamples.load();
+    return (samplePosition + latency) * INIConfig::Defaults::MS_PER_SECOND / currentSampleRate.load();
+}
+
+void MidiOutputScheduler::pushBlock(const juce::MidiBuffer& midiMessages, int numSamples) noexcept {
+    const juce::int64 blockStart = blockStartSample;
+    blockStartSample += juce::jmax(0, numSamples);
+
+    if (!active.load(std::memory_order_relaxed)) return;
+
+    OutputEvent block;
+    block.type = OutputEvent::Type::BlockStart;
+    block.samplePosition = blockStart;
+    block.callbackTimeMs = juce::Time::getMillisecondCounterHiRes();
+    if (!events.push(block)) return;
+
+    for (const auto metadata : midiMessages) {
+        // SysEx does not fit the fixed event and is not part of what the engine sends
+        if (metadata.numBytes > static_cast<int>(sizeof(OutputEvent::data))) continue;
+
+        OutputEvent event;
+        event.samplePosition = blockStart + metadata.samplePosition;
+        event.size = static_cast<juce::uint8>(metadata.numBytes);
+        std::memcpy(event.data, metadata.data, event.size);
+
+        if (!events.push(event)) {
+            DBG("MidiOutputScheduler: Output queue full, dropping message");
+            return;
+        }
+    }
+}
+
+void MidiOutputScheduler::run() {
+    while (!threadShouldExit()) {
+        OutputEvent event;
+        while (events.pop(event)) {
+            if (event.type == OutputEvent::Type::BlockStart) {
+                updateSampleClock(event.samplePosition, event.callbackTimeMs);
+            } else {
+                addPending(event);
+            }
+        }
+
+        const double nowMs = juce::Time::getMillisecondCounterHiRes();
+        sendDueMessages(nowMs);
+
+        // Sleep until the next message is due, but keep draining the queue meanwhile
+        int waitMs = INIConfig::MIDI::MIDI_OUT_POLL_MS;
+        if (numPending > 0) {
+            waitMs = juce::jlimit(0, waitMs, static_cast<int>(pending[0].dueTimeMs - nowMs));
+        }
+
+        if (waitMs > 0) {
+            wait(waitMs);
+        } else if (numPending > 0) {
+            juce::Thread::yield();
+        }
+    }
+}
+
+void MidiOutputScheduler::updateSampleClock(juce::int64 samplePosition, double callbackTimeMs) {
+    if (!clockValid) {
+        anchorSample = samplePosition;
+        anchorTimeMs = callbackTimeMs;
+        clockValid = true;
+        return;
+    }
+
+    const double predictedMs = anchorTimeMs + (samplePosition - anchorSample) * INIConfig::Defaults::MS_PER_SECOND / currentSampleRate.load();
+    const double errorMs = callbackTimeMs - predictedMs;
+
+    anchorSample = samplePosition;
+
+    // A stall or sample-rate change starts over; otherwise callback jitter is averaged out
+    if (std::abs(errorMs) > INIConfig::MIDI::MIDI_OUT_RESYNC_MS) {
+        anchorTimeMs = callbackTimeMs;
+    } else {
+        anchorTimeMs = predictedMs + errorMs * INIConfig::MIDI::MIDI_OUT_CLOCK_SMOOTHING;
+    }
+}
+
+double MidiOutputScheduler::sampleToDeviceTimeMs(juce::int64 samplePosition) const {
+    return anchorTimeMs + getOutputDelayMs(samplePosition - anchorSample);
+}
+
+void MidiOutputScheduler::addPending(const OutputEvent& event) {
+    if (!clockValid || numPending >= static_cast<int>(pending.size())) {
+        DBG("MidiOutputScheduler: Dropping message");
+        return;
+    }
+
+    PendingMessage message;
+    message.dueTimeMs = sampleToDeviceTimeMs(event.samplePosition);
+    message.size = event.size;
+    std::memcpy(message.data, event.data, event.size);
+
+    // Messages arrive in sample order, so this rarely moves anything
+    int position = numPending;
+    while (position > 0 && pending[static_cast<size_t>(position - 1)].dueTimeMs > message.dueTimeMs) {
+        pending[static_cast<size_t>(position)] = pending[static_cast<size_t>(position - 1)];
+        --position;
+    }
+    pending[static_cast<size_t>(position)] = message;
+    ++numPending;
+}
+
+void MidiOutputScheduler::sendDueMessages(double nowMs) {
+    int sent = 0;
+    while (sent < numPending && pending[static_cast<size_t>(sent)].dueTimeMs <= nowMs) {
+        const auto& message = pending[static_cast<size_t>(sent)];
+        output->sendMessageNow(juce::MidiMessage(message.data, message.size));
+        ++sent;
+    }
+
+    if (sent > 0) {
+        std::move(pending.begin() + sent, pending.begin() + numPending, pending.begin());
+        numPending -= sent;
+    }
+}
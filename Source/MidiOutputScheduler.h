@@ -0,0 +1,77 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include "INIConfig.h"
+#include "LockFreeStructures.h"
+
+// Sends OTTO's MIDI output to a hardware port from its own thread. The audio thread
+// only stamps each event with its sample position and pushes it to a lock-free queue.
+// The output thread maps sample positions onto the millisecond counter, smoothing out
+// callback jitter, adds the audio device's output latency and sends each event when
+// it is due, so external gear plays in time with what comes out of the speakers.
+class MidiOutputScheduler : private juce::Thread {
+public:
+    MidiOutputScheduler();
+    ~MidiOutputScheduler() override;
+
+    // Message thread; takes ownership of the opened device, nullptr closes it
+    void setOutput(std::unique_ptr<juce::MidiOutput> newOutput);
+    bool hasOutput() const { return output != nullptr; }
+
+    // deviceLatency is from the end of processBlock to the sound leaving the device, in samples
+    void prepare(double sampleRate, int deviceLatency);
+    // Any thread; the plug-in's own latency, which changes with the mixer's lookahead
+    void setProcessingLatency(int latencySamples);
+    // How long after its block started an event at samplePosition is sent
+    double getOutputDelayMs(juce::int64 samplePosition) const;
+
+    // Audio thread
+    void pushBlock(const juce::MidiBuffer& midiMessages, int numSamples) noexcept;
+
+private:
+    struct OutputEvent {
+        enum class Type : juce::uint8 {
+            BlockStart,
+            Message
+        };
+
+        Type type = Type::Message;
+        juce::int64 samplePosition = 0;
+        double callbackTimeMs = 0.0;
+        juce::uint8 data[3] = {};
+        juce::uint8 size = 0;
+    };
+
+    struct PendingMessage {
+        double dueTimeMs = 0.0;
+        juce::uint8 data[3] = {};
+        juce::uint8 size = 0;
+    };
+
+    void run() override;
+    void updateSampleClock(juce::int64 samplePosition, double callbackTimeMs);
+    double sampleToDeviceTimeMs(juce::int64 samplePosition) const;
+    void addPending(const OutputEvent& event);
+    void sendDueMessages(double nowMs);
+
+    std::unique_ptr<juce::MidiOutput> output;
+    std::atomic<bool> active{false};
+    std::atomic<double> currentSampleRate{static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE)};
+    std::atomic<int> deviceLatencySamples{0};
+    std::atomic<int> processingLatencySamples{0};
+
+    // Audio thread
+    SpscFifo<OutputEvent, INIConfig::MIDI::MIDI_OUT_QUEUE_SIZE> events;
+    juce::int64 blockStartSample = 0;
+
+    // Output thread
+    std::array<PendingMessage, static_cast<size_t>(INIConfig::MIDI::MIDI_OUT_QUEUE_SIZE)> pending{};
+    int numPending = 0;
+    bool clockValid = false;
+    juce::int64 anchorSample = 0;
+    double anchorTimeMs = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiOutputScheduler)
+};
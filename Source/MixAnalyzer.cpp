@@ -0,0 +1,260 @@
+#include "MixAnalyzer.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace {
+    // Octaves from the kick's fundamental up to the cymbals
+    constexpr float bandEdges[] = { 30.0f, 60.0f, 120.0f, 250.0f, 500.0f, 1000.0f, 2000.0f, 4000.0f, 8000.0f };
+    static_assert(std::size(bandEdges) == MixAnalyzer::NUM_BANDS + 1, "One edge more than there are bands");
+
+    constexpr int decimation = INIConfig::Audio::MIX_ANALYSIS_DECIMATION;
+}
+
+float MixAnalyzer::ChannelSpectrum::getTotalEnergy() const {
+    float total = 0.0f;
+    for (const float energy : bandEnergy) {
+        total += energy;
+    }
+    return total;
+}
+
+float MixAnalyzer::ChannelSpectrum::getBandShare(int band) const {
+    const float total = getTotalEnergy();
+    return total > 0.0f ? bandEnergy[static_cast<size_t>(band)] / total : 0.0f;
+}
+
+MixAnalyzer::MixAnalyzer() : juce::Thread("OTTO Mix Analyzer") {
+}
+
+MixAnalyzer::~MixAnalyzer() {
+    stopThread(INIConfig::LayoutConstants::mixAnalyzerThreadStopTimeoutMs);
+}
+
+float MixAnalyzer::getBandEdge(int band) {
+    return bandEdges[juce::jlimit(0, NUM_BANDS, band)];
+}
+
+void MixAnalyzer::prepare(double sampleRate) {
+    const juce::ScopedLock scoped(analysisLock);
+
+    analysisRate = sampleRate / decimation;
+    fftSize = 1 << INIConfig::Audio::MIX_ANALYSIS_FFT_ORDER;
+    fft = std::make_unique<juce::dsp::FFT>(INIConfig::Audio::MIX_ANALYSIS_FFT_ORDER);
+    window = std::make_unique<juce::dsp::WindowingFunction<float>>(static_cast<size_t>(fftSize),
+                                                                    juce::dsp::WindowingFunction<float>::hann, false);
+    fftData.assign(static_cast<size_t>(fftSize * 2), 0.0f);
+
+    // Enough for the analysis thread to miss a few passes without the audio thread dropping anything
+    const int ringSize = juce::jmax(fftSize, static_cast<int>(std::ceil(analysisRate * INIConfig::Audio::MIX_ANALYSIS_RING_SECONDS)));
+
+    for (auto& tap : taps) {
+        tap.fifo.setTotalSize(ringSize + 1);
+        tap.left.assign(static_cast<size_t>(ringSize + 1), 0.0f);
+        tap.right.assign(static_cast<size_t>(ringSize + 1), 0.0f);
+        tap.sumLeft = 0.0f;
+        tap.sumRight = 0.0f;
+        tap.phase = 0;
+    }
+
+    for (auto& history : histories) {
+        history.left.assign(static_cast<size_t>(fftSize), 0.0f);
+        history.right.assign(static_cast<size_t>(fftSize), 0.0f);
+    }
+
+    const auto frameIndex = current.frameIndex;
+    current = Snapshot();
+    current.frameIndex = frameIndex;
+}
+
+void MixAnalyzer::setActive(bool shouldBeActive) {
+    active.store(shouldBeActive, std::memory_order_relaxed);
+
+    if (shouldBeActive) {
+        if (!isThreadRunning()) startThread();
+    } else {
+        stopThread(INIConfig::LayoutConstants::mixAnalyzerThreadStopTimeoutMs);
+    }
+}
+
+void MixAnalyzer::pushChannel(int channel, const juce::AudioBuffer<float>& buffer) noexcept {
+    if (!juce::isPositiveAndBelow(channel, NUM_CHANNELS)) return;
+
+    push(taps[static_cast<size_t>(channel)], buffer);
+}
+
+void MixAnalyzer::pushMaster(const juce::AudioBuffer<float>& buffer) noexcept {
+    push(taps[MASTER], buffer);
+}
+
+void MixAnalyzer::push(Tap& tap, const juce::AudioBuffer<float>& buffer) noexcept {
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = buffer.getNumChannels();
+    if (numSamples <= 0 || numChannels <= 0 || tap.left.empty()) return;
+
+    const float* left = buffer.getReadPointer(0);
+    const float* right = buffer.getReadPointer(juce::jmin(1, numChannels - 1));
+    constexpr float scale = 1.0f / decimation;
+
+    // Averaging is all the filtering the estimates need; frames that do not fit are
+    // dropped, as the analysis thread has fallen behind
+    const auto scope = tap.fifo.write((tap.phase + numSamples) / decimation);
+    const int writable = scope.blockSize1 + scope.blockSize2;
+    int frame = 0;
+
+    for (int i = 0; i < numSamples; ++i) {
+        tap.sumLeft += left[i];
+        tap.sumRight += right[i];
+        if (++tap.phase < decimation) continue;
+
+        if (frame < writable) {
+            const int index = frame < scope.blockSize1 ? scope.startIndex1 + frame
+                                                       : scope.startIndex2 + frame - scope.blockSize1;
+            tap.left[static_cast<size_t>(index)] = tap.sumLeft * scale;
+            tap.right[static_cast<size_t>(index)] = tap.sumRight * scale;
+        }
+
+        ++frame;
+        tap.sumLeft = 0.0f;
+        tap.sumRight = 0.0f;
+        tap.phase = 0;
+    }
+}
+
+void MixAnalyzer::run() {
+    while (!threadShouldExit()) {
+        analyze();
+        wait(INIConfig::Audio::MIX_ANALYSIS_INTERVAL_MS);
+    }
+}
+
+bool MixAnalyzer::analyze() {
+    const juce::ScopedLock scoped(analysisLock);
+    if (fft == nullptr) return false;
+
+    // The master is pushed last in each block, so every channel has at least as much;
+    // a channel that was skipped (muted, or not soloed) reads as silence
+    const int numFrames = taps[MASTER].fifo.getNumReady();
+    if (numFrames == 0) return false;
+
+    for (int tap = 0; tap < NUM_TAPS; ++tap) {
+        readInto(taps[static_cast<size_t>(tap)], histories[static_cast<size_t>(tap)], numFrames);
+    }
+
+    for (int channel = 0; channel < NUM_CHANNELS; ++channel) {
+        measure(histories[static_cast<size_t>(channel)], current.channels[static_cast<size_t>(channel)]);
+    }
+    measure(histories[MASTER], current.master);
+
+    for (int a = 0; a < NUM_CHANNELS; ++a) {
+        const auto& first = current.channels[static_cast<size_t>(a)];
+
+        for (int b = a; b < NUM_CHANNELS; ++b) {
+            const auto& second = current.channels[static_cast<size_t>(b)];
+
+            float overlap = 0.0f;
+            if (first.active && second.active) {
+                for (int band = 0; band < NUM_BANDS; ++band) {
+                    overlap += juce::jmin(first.getBandShare(band), second.getBandShare(band));
+                }
+            }
+            current.masking[static_cast<size_t>(a)][static_cast<size_t>(b)] = overlap;
+            current.masking[static_cast<size_t>(b)][static_cast<size_t>(a)] = overlap;
+        }
+    }
+
+    ++current.frameIndex;
+    snapshots.write(current);
+    return true;
+}
+
+int MixAnalyzer::readInto(Tap& tap, History& history, int numFrames) {
+    const int available = juce::jmin(numFrames, tap.fifo.getNumReady());
+    const int kept = juce::jmin(available, fftSize);
+
+    // Older than the window; skipped without being copied
+    tap.fifo.finishedRead(available - kept);
+
+    // Everything moves along by the master's frames, the missing ones as silence
+    const int shift = juce::jmin(numFrames, fftSize);
+    for (auto* side : { &history.left, &history.right }) {
+        std::move(side->begin() + shift, side->end(), side->begin());
+        std::fill(side->end() - shift, side->end(), 0.0f);
+    }
+
+    const auto scope = tap.fifo.read(kept);
+    const int destination = fftSize - kept;
+    std::copy_n(tap.left.data() + scope.startIndex1, scope.blockSize1, history.left.data() + destination);
+    std::copy_n(tap.right.data() + scope.startIndex1, scope.blockSize1, history.right.data() + destination);
+    std::copy_n(tap.left.data() + scope.startIndex2, scope.blockSize2, history.left.data() + destination + scope.blockSize1);
+    std::copy_n(tap.right.data() + scope.startIndex2, scope.blockSize2, history.right.data() + destination + scope.blockSize1);
+    return kept;
+}
+
+void MixAnalyzer::measure(const History& history, ChannelSpectrum& spectrum) {
+    const float* left = history.left.data();
+    const float* right = history.right.data();
+
+    double leftPower = 0.0;
+    double rightPower = 0.0;
+    double crossPower = 0.0;
+    double sidePower = 0.0;
+    for (int i = 0; i < fftSize; ++i) {
+        leftPower += left[i] * left[i];
+        rightPower += right[i] * right[i];
+        crossPower += left[i] * right[i];
+        const float side = left[i] - right[i];
+        sidePower += side * side;
+    }
+    const double midPower = leftPower + rightPower + 2.0 * crossPower;
+
+    const auto leftRange = juce::FloatVectorOperations::findMinAndMax(left, fftSize);
+    const auto rightRange = juce::FloatVectorOperations::findMinAndMax(right, fftSize);
+    spectrum.peak = juce::jmax(-leftRange.getStart(), leftRange.getEnd(), -rightRange.getStart(), rightRange.getEnd());
+    spectrum.rms = static_cast<float>(std::sqrt((leftPower + rightPower) / (2.0 * fftSize)));
+    spectrum.active = spectrum.rms > INIConfig::Audio::MIX_ANALYSIS_SILENCE_RMS;
+
+    if (!spectrum.active) {
+        spectrum.crestFactor = 0.0f;
+        spectrum.correlation = 1.0f;
+        spectrum.stereoWidth = 0.0f;
+    } else {
+        spectrum.crestFactor = juce::Decibels::gainToDecibels(spectrum.peak / spectrum.rms);
+        const double bothSides = std::sqrt(leftPower * rightPower);
+        spectrum.correlation = bothSides > 0.0 ? static_cast<float>(crossPower / bothSides) : 0.0f;
+        spectrum.stereoWidth = midPower > 0.0 ? juce::jmin(1.0f, static_cast<float>(std::sqrt(sidePower / midPower))) : 1.0f;
+    }
+
+    // Spectrum of the mid signal, scaled so that a full-scale sine reads about 1
+    float* data = fftData.data();
+    juce::FloatVectorOperations::add(data, left, right, fftSize);
+    juce::FloatVectorOperations::multiply(data, 0.5f, fftSize);
+    juce::FloatVectorOperations::clear(data + fftSize, fftSize);
+    window->multiplyWithWindowingTable(data, static_cast<size_t>(fftSize));
+    fft->performFrequencyOnlyForwardTransform(data, true);
+
+    const int numBins = fftSize / 2;
+    const float binWidth = static_cast<float>(analysisRate) / static_cast<float>(fftSize);
+    juce::FloatVectorOperations::multiply(data, 4.0f / static_cast<float>(fftSize), numBins + 1);
+    juce::FloatVectorOperations::multiply(data, data, numBins + 1);
+
+    const float smoothing = INIConfig::Audio::MIX_ANALYSIS_SMOOTHING;
+    for (int band = 0; band < NUM_BANDS; ++band) {
+        const int first = juce::jlimit(1, numBins + 1, static_cast<int>(std::ceil(bandEdges[band] / binWidth)));
+        const int last = juce::jlimit(first, numBins + 1, static_cast<int>(std::ceil(bandEdges[band + 1] / binWidth)));
+
+        float energy = 0.0f;
+        for (int bin = first; bin < last; ++bin) {
+            energy += data[bin];
+        }
+
+        auto& smoothed = spectrum.bandEnergy[static_cast<size_t>(band)];
+        smoothed += smoothing * (energy - smoothed);
+    }
+}
+
+const MixAnalyzer::Snapshot& MixAnalyzer::getLatestSnapshot() const {
+    if (snapshots.update())
+        latestSnapshot = snapshots.read();
+    return latestSnapshot;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "INIConfig.h"
+#include "LockFreeStructures.h"
+
+// Measures what the mix actually sounds like for the auto-mix assistant. The audio
+// thread only decimates each channel's stem and the master into lock-free rings; a
+// background thread takes the latest window from them, works out band energies,
+// crest factor, stereo correlation and how much each pair of channels masks the other,
+// and publishes the result as a snapshot. Nothing is measured while it is inactive.
+class MixAnalyzer : private juce::Thread {
+public:
+    static constexpr int NUM_CHANNELS = INIConfig::Defaults::MAX_PLAYERS;
+    static constexpr int NUM_BANDS = INIConfig::Audio::MIX_ANALYSIS_NUM_BANDS;
+
+    struct ChannelSpectrum {
+        // Power per band, smoothed over successive windows
+        std::array<float, NUM_BANDS> bandEnergy{};
+        float rms = 0.0f;
+        float peak = 0.0f;
+        // Peak over RMS in dB; 3 for a sine, higher the more transient the signal
+        float crestFactor = 0.0f;
+        // 1 when both sides carry the same signal, 0 when unrelated, -1 when opposed
+        float correlation = 1.0f;
+        // Side level over mid level, 0 for mono and 1 once the sides are as loud as the middle
+        float stereoWidth = 0.0f;
+        bool active = false;
+
+        float getTotalEnergy() const;
+        float getBandShare(int band) const;
+    };
+
+    struct Snapshot {
+        std::array<ChannelSpectrum, NUM_CHANNELS> channels{};
+        ChannelSpectrum master;
+        // Spectral overlap of two active channels, from 0 (no band in common) to 1 (the same spectrum)
+        std::array<std::array<float, NUM_CHANNELS>, NUM_CHANNELS> masking{};
+        juce::uint32 frameIndex = 0;
+
+        bool isValid() const { return frameIndex > 0; }
+    };
+
+    MixAnalyzer();
+    ~MixAnalyzer() override;
+
+    // Audio stopped; sizes the rings and FFT for the sample rate
+    void prepare(double sampleRate);
+
+    // Message thread. The background thread runs only while active.
+    void setActive(bool shouldBeActive);
+    bool isActive() const { return active.load(std::memory_order_relaxed); }
+
+    // Audio thread: each channel's stem as it is mixed, then the master once per block
+    void pushChannel(int channel, const juce::AudioBuffer<float>& buffer) noexcept;
+    void pushMaster(const juce::AudioBuffer<float>& buffer) noexcept;
+
+    // One pass over whatever has arrived; the background thread calls this on its own.
+    // False if there was nothing new.
+    bool analyze();
+
+    // Message thread
+    const Snapshot& getLatestSnapshot() const;
+
+    // Lower edge of a band in Hz; band NUM_BANDS is the top edge of the last one
+    static float getBandEdge(int band);
+
+private:
+    static constexpr int MASTER = NUM_CHANNELS;
+    static constexpr int NUM_TAPS = NUM_CHANNELS + 1;
+
+    // Written by the audio thread, read by the analysis thread
+    struct Tap {
+        juce::AbstractFifo fifo { 1 };
+        std::vector<float> left;
+        std::vector<float> right;
+        // Decimation carries over between blocks
+        float sumLeft = 0.0f;
+        float sumRight = 0.0f;
+        int phase = 0;
+    };
+
+    // Analysis thread only
+    struct History {
+        std::vector<float> left;
+        std::vector<float> right;
+    };
+
+    void run() override;
+    void push(Tap& tap, const juce::AudioBuffer<float>& buffer) noexcept;
+    int readInto(Tap& tap, History& history, int numFrames);
+    void measure(const History& history, ChannelSpectrum& spectrum);
+
+    std::atomic<bool> active { false };
+    std::array<Tap, NUM_TAPS> taps;
+
+    // Held by prepare() and analyze(), never by the audio thread
+    juce::CriticalSection analysisLock;
+    double analysisRate = 0.0;
+    int fftSize = 0;
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+    std::array<History, NUM_TAPS> histories;
+    std::vector<float> fftData;
+    Snapshot current;
+
+    mutable TripleBuffer<Snapshot> snapshots;
+    mutable Snapshot latestSnapshot;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MixAnalyzer)
+};
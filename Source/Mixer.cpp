@@ -3,6 +3,97 @@
 #include "INIConfig.h"
 #include "ErrorHandling.h"
 
+namespace {
+    float lerp(float from, float to, float position) {
+        return from + (to - from) * position;
+    }
+
+    // Cutoffs move geometrically so a sweep sounds even across the range
+    float lerpFrequency(float from, float to, float position) {
+        return from * std::pow(to / from, position);
+    }
+}
+
+Mixer::Snapshot Mixer::Snapshot::interpolate(const Snapshot& from, const Snapshot& to, float position) {
+    if (position >= 1.0f)
+        return to;
+
+    // Discrete settings switch half way; continuous ones are interpolated below
+    Snapshot result = position < 0.5f ? from : to;
+
+    for (size_t i = 0; i < result.channels.size(); ++i) {
+        const auto& a = from.channels[i];
+        const auto& b = to.channels[i];
+        auto& c = result.channels[i];
+
+        c.volume = lerp(a.volume, b.volume, position);
+        c.pan = lerp(a.pan, b.pan, position);
+        for (size_t band = 0; band < c.eqGains.size(); ++band)
+            c.eqGains[band] = lerp(a.eqGains[band], b.eqGains[band], position);
+        for (size_t send = 0; send < c.sends.size(); ++send)
+            c.sends[send] = lerp(a.sends[send], b.sends[send], position);
+    }
+
+    result.master.volume = lerp(from.master.volume, to.master.volume, position);
+    result.master.limiterThreshold = lerp(from.master.limiterThreshold, to.master.limiterThreshold, position);
+    result.master.limiterRelease = lerp(from.master.limiterRelease, to.master.limiterRelease, position);
+
+    // Effects that are switched on at either end stay running for the whole morph;
+    // the reverb and delay returns are faded by the mixer, the inline effects are
+    // interpolated from a transparent setting
+    auto& reverb = result.reverb;
+    reverb.enabled = from.reverb.enabled || to.reverb.enabled;
+    reverb.mix = lerp(from.reverb.mix, to.reverb.mix, position);
+    reverb.roomSize = lerp(from.reverb.roomSize, to.reverb.roomSize, position);
+    reverb.damping = lerp(from.reverb.damping, to.reverb.damping, position);
+    reverb.predelay = lerp(from.reverb.predelay, to.reverb.predelay, position);
+    reverb.width = lerp(from.reverb.width, to.reverb.width, position);
+    reverb.highCut = lerpFrequency(from.reverb.highCut, to.reverb.highCut, position);
+    reverb.lowCut = lerpFrequency(from.reverb.lowCut, to.reverb.lowCut, position);
+
+    auto& delay = result.delay;
+    delay.enabled = from.delay.enabled || to.delay.enabled;
+    delay.delayTime = lerp(from.delay.delayTime, to.delay.delayTime, position);
+    delay.feedback = lerp(from.delay.feedback, to.delay.feedback, position);
+    delay.mix = lerp(from.delay.mix, to.delay.mix, position);
+    delay.highCut = lerpFrequency(from.delay.highCut, to.delay.highCut, position);
+    delay.lowCut = lerpFrequency(from.delay.lowCut, to.delay.lowCut, position);
+    delay.spread = lerp(from.delay.spread, to.delay.spread, position);
+
+    auto compressorEnd = [](const CompressorSettings& end, const CompressorSettings& other) {
+        if (end.enabled)
+            return end;
+        auto transparent = other;
+        transparent.ratio = 1.0f;
+        transparent.makeupGain = 0.0f;
+        return transparent;
+    };
+
+    const auto compFrom = compressorEnd(from.compressor, to.compressor);
+    const auto compTo = compressorEnd(to.compressor, from.compressor);
+    auto& compressor = result.compressor;
+    compressor.enabled = from.compressor.enabled || to.compressor.enabled;
+    compressor.threshold = lerp(compFrom.threshold, compTo.threshold, position);
+    compressor.ratio = lerp(compFrom.ratio, compTo.ratio, position);
+    compressor.attack = lerp(compFrom.attack, compTo.attack, position);
+    compressor.release = lerp(compFrom.release, compTo.release, position);
+    compressor.makeupGain = lerp(compFrom.makeupGain, compTo.makeupGain, position);
+    compressor.knee = lerp(compFrom.knee, compTo.knee, position);
+
+    const auto& distFrom = from.distortion.enabled ? from.distortion : to.distortion;
+    const auto& distTo = to.distortion.enabled ? to.distortion : from.distortion;
+    auto& distortion = result.distortion;
+    distortion.enabled = from.distortion.enabled || to.distortion.enabled;
+    distortion.mix = lerp(from.distortion.enabled ? from.distortion.mix : 0.0f,
+                          to.distortion.enabled ? to.distortion.mix : 0.0f, position);
+    distortion.drive = lerp(distFrom.drive, distTo.drive, position);
+    distortion.preGain = lerp(distFrom.preGain, distTo.preGain, position);
+    distortion.postGain = lerp(distFrom.postGain, distTo.postGain, position);
+    distortion.sampleRateReduction = lerp(distFrom.sampleRateReduction, distTo.sampleRateReduction, position);
+
+    return result;
+}
+
 Mixer::Mixer() {
     loadDefaultPresets();
 }
@@ -10,6 +101,15 @@ Mixer::Mixer() {
 void Mixer::prepare(double newSampleRate, int samplesPerBlock) {
     sampleRate = newSampleRate;
     blockSize = samplesPerBlock;
+    mixAnalyzer.prepare(sampleRate);
+
+    active = captureSnapshot();
+    morphActive.store(false, std::memory_order_relaxed);
+
+    const float reverbLevel = active.reverb.enabled ? 1.0f : 0.0f;
+    const float delayLevel = active.delay.enabled ? 1.0f : 0.0f;
+    reverbReturn = {reverbLevel, reverbLevel, reverbLevel};
+    delayReturn = {delayLevel, delayLevel, delayLevel};
 
     for (int i = 0; i < NUM_CHANNELS; ++i) {
         auto& proc = channelProcessors[i];
@@ -17,10 +117,23 @@ void Mixer::prepare(double newSampleRate, int samplesPerBlock) {
         proc.volumeSmoothed.reset(sampleRate, 0.01);
         proc.volumeSmoothed.setCurrentAndTargetValue(channelStates[i].volume.load());
 
+        const float pan = channelStates[i].pan.load();
+        proc.panLeftSmoothed.reset(sampleRate, INIConfig::Audio::PARAMETER_SMOOTHING_SECONDS);
+        proc.panRightSmoothed.reset(sampleRate, INIConfig::Audio::PARAMETER_SMOOTHING_SECONDS);
+        proc.panLeftSmoothed.setCurrentAndTargetValue(std::cos((pan + 1.0f) * juce::MathConstants<float>::pi * 0.25f));
+        proc.panRightSmoothed.setCurrentAndTargetValue(std::sin((pan + 1.0f) * juce::MathConstants<float>::pi * 0.25f));
+
+        for (int band = 0; band < NUM_EQ_FILTERS; ++band) {
+            proc.eqGainSmoothed[band].reset(sampleRate, INIConfig::Audio::PARAMETER_SMOOTHING_SECONDS);
+            proc.eqGainSmoothed[band].setCurrentAndTargetValue(channelStates[i].eqGains[band].load());
+        }
+
         proc.levelFollowerLeft.reset(sampleRate, 0.1);
         proc.levelFollowerRight.reset(sampleRate, 0.1);
 
         updateEQCoefficients(i);
+        proc.inserts.prepare(sampleRate);
+        proc.appliedGeneration = GENERATION_NOT_APPLIED;
     }
 
     juce::dsp::Reverb::Parameters reverbParams;
@@ -46,6 +159,17 @@ void Mixer::prepare(double newSampleRate, int samplesPerBlock) {
     delayHighCut.setType(juce::dsp::StateVariableTPTFilterType::lowpass);
     delayLowCut.setType(juce::dsp::StateVariableTPTFilterType::highpass);
 
+    auto prepareCutoff = [this](SmoothedFrequency& smoothed, juce::dsp::StateVariableTPTFilter<float>& filter, float frequency) {
+        smoothed.reset(sampleRate, INIConfig::Audio::PARAMETER_SMOOTHING_SECONDS);
+        smoothed.setCurrentAndTargetValue(frequency);
+        filter.setCutoffFrequency(frequency);
+    };
+
+    prepareCutoff(reverbHighCutSmoothed, reverbHighCut, reverbState.highCut.load());
+    prepareCutoff(reverbLowCutSmoothed, reverbLowCut, reverbState.lowCut.load());
+    prepareCutoff(delayHighCutSmoothed, delayHighCut, delayState.highCut.load());
+    prepareCutoff(delayLowCutSmoothed, delayLowCut, delayState.lowCut.load());
+
     delayLineLeft.prepare(spec);
     delayLineRight.prepare(spec);
     delayLineLeft.setMaximumDelayInSamples(INIConfig::Defaults::MAX_DELAY_SAMPLES);
@@ -57,9 +181,25 @@ void Mixer::prepare(double newSampleRate, int samplesPerBlock) {
     compressor.setAttack(compressorState.attack.load());
     compressor.setRelease(compressorState.release.load());
 
+    compressorThresholdSmoothed.reset(sampleRate, INIConfig::Audio::PARAMETER_SMOOTHING_SECONDS);
+    compressorThresholdSmoothed.setCurrentAndTargetValue(compressorState.threshold.load());
+    compressorMakeupSmoothed.reset(sampleRate, INIConfig::Audio::PARAMETER_SMOOTHING_SECONDS);
+    compressorMakeupSmoothed.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(compressorState.makeupGain.load()));
+
+    limiter.setLookahead(masterState.limiterLookahead.load());
     limiter.prepare(spec);
     limiter.setThreshold(masterState.limiterThreshold.load());
     limiter.setRelease(masterState.limiterRelease.load());
+    limiter.setBypassed(!masterState.limiterEnabled.load());
+
+    masterVolumeSmoothed.reset(sampleRate, INIConfig::Audio::PARAMETER_SMOOTHING_SECONDS);
+    masterVolumeSmoothed.setCurrentAndTargetValue(masterState.volume.load());
+
+    appliedMasterGeneration = GENERATION_NOT_APPLIED;
+    appliedReverbGeneration = GENERATION_NOT_APPLIED;
+    appliedDelayGeneration = GENERATION_NOT_APPLIED;
+    appliedCompressorGeneration = GENERATION_NOT_APPLIED;
+    appliedDistortionGeneration = GENERATION_NOT_APPLIED;
 
     sendBuffer.setSize(2, blockSize);
     reverbBuffer.setSize(2, blockSize);
@@ -75,6 +215,7 @@ void Mixer::reset() {
         proc.midPeak.reset();
         proc.highShelf.reset();
         proc.panner.reset();
+        proc.inserts.reset();
     }
 
     reverb.reset();
@@ -88,6 +229,8 @@ void Mixer::reset() {
     delayHighCut.reset();
     delayLowCut.reset();
 
+    meteringService.reset();
+
     sendBuffer.clear();
     reverbBuffer.clear();
     delayBuffer.clear();
@@ -120,6 +263,13 @@ void Mixer::processBlock(juce::AudioBuffer<float>& buffer) {
             delayBuffer.clear();
         }, "Mixer buffer clearing");
 
+        const bool metering = meteringEnabled.load(std::memory_order_relaxed);
+        if (metering) {
+            meteringService.beginFrame();
+        }
+        const bool analysing = metering && mixAnalyzer.isActive();
+        syncSnapshot(numSamples);
+
         bool hasSolo = anySolo();
 
         // Null-pointer safety: Validate channel count
@@ -132,8 +282,9 @@ void Mixer::processBlock(juce::AudioBuffer<float>& buffer) {
                 break;
             }
 
-            if (channelStates[ch].mute.load()) continue;
-            if (hasSolo && !channelStates[ch].solo.load()) continue;
+            const auto& channelSettings = active.channels[static_cast<size_t>(ch)];
+            if (channelSettings.mute) continue;
+            if (hasSolo && !channelSettings.solo) continue;
 
             // Null-pointer safety: Create channel buffer with validation
             try {
@@ -159,11 +310,11 @@ void Mixer::processBlock(juce::AudioBuffer<float>& buffer) {
 
                 // Null-pointer safety: Validate send array bounds
                 if (static_cast<size_t>(ch) < channelStates.size() &&
-                    static_cast<int>(SendType::Reverb) < static_cast<int>(channelStates[ch].sends.size()) &&
-                    static_cast<int>(SendType::Delay) < static_cast<int>(channelStates[ch].sends.size())) {
+                    static_cast<int>(SendType::Reverb) < static_cast<int>(channelSettings.sends.size()) &&
+                    static_cast<int>(SendType::Delay) < static_cast<int>(channelSettings.sends.size())) {
                     
-                    float reverbSend = channelStates[ch].sends[static_cast<int>(SendType::Reverb)].load();
-                    float delaySend = channelStates[ch].sends[static_cast<int>(SendType::Delay)].load();
+                    float reverbSend = channelSettings.sends[static_cast<int>(SendType::Reverb)];
+                    float delaySend = channelSettings.sends[static_cast<int>(SendType::Delay)];
                     
                     // Validate send values
                     if (std::isfinite(reverbSend) && std::isfinite(delaySend)) {
@@ -187,7 +338,12 @@ void Mixer::processBlock(juce::AudioBuffer<float>& buffer) {
                             buffer.addFrom(1, 0, channelBuffer, 1, 0, numSamples);
                         }
 
-                        updateMetering(ch, channelBuffer);
+                        if (metering) {
+                            updateMetering(ch, channelBuffer);
+                        }
+                        if (analysing) {
+                            mixAnalyzer.pushChannel(ch, channelBuffer);
+                        }
                     } else {
                         DBG("Mixer: Invalid send values for channel " + juce::String(ch));
                     }
@@ -200,40 +356,60 @@ void Mixer::processBlock(juce::AudioBuffer<float>& buffer) {
         }
 
         // Process global effects
-        if (reverbState.enabled.load()) {
+        if (reverbReturn.start > 0.0f || reverbReturn.end > 0.0f) {
             processReverb(reverbBuffer);
-            buffer.addFrom(0, 0, reverbBuffer, 0, 0, numSamples);
-            buffer.addFrom(1, 0, reverbBuffer, 1, 0, numSamples);
+            buffer.addFromWithRamp(0, 0, reverbBuffer.getReadPointer(0), numSamples, reverbReturn.start, reverbReturn.end);
+            buffer.addFromWithRamp(1, 0, reverbBuffer.getReadPointer(1), numSamples, reverbReturn.start, reverbReturn.end);
         }
 
-        if (delayState.enabled.load()) {
+        if (delayReturn.start > 0.0f || delayReturn.end > 0.0f) {
             processDelay(delayBuffer);
-            buffer.addFrom(0, 0, delayBuffer, 0, 0, numSamples);
-            buffer.addFrom(1, 0, delayBuffer, 1, 0, numSamples);
+            buffer.addFromWithRamp(0, 0, delayBuffer.getReadPointer(0), numSamples, delayReturn.start, delayReturn.end);
+            buffer.addFromWithRamp(1, 0, delayBuffer.getReadPointer(1), numSamples, delayReturn.start, delayReturn.end);
         }
 
-        if (compressorState.enabled.load()) {
+        if (active.compressor.enabled) {
             processCompressor(buffer);
         }
 
-        if (distortionState.enabled.load()) {
+        if (active.distortion.enabled) {
             processDistortion(buffer);
         }
 
+        if (dirtySections & MasterSection) {
+            float masterVol = active.master.volume;
+            if (std::isfinite(masterVol) && masterVol >= 0.0f) {
+                masterVolumeSmoothed.setTargetValue(masterVol);
+            } else {
+                DBG("Mixer: Invalid master volume, applying safety gain");
+                masterVolumeSmoothed.setTargetValue(0.5f);
+            }
+
+            limiter.setThreshold(active.master.limiterThreshold);
+            limiter.setRelease(active.master.limiterRelease);
+            limiter.setLookahead(active.master.limiterLookahead);
+            limiter.setBypassed(!active.master.limiterEnabled);
+            dirtySections &= ~MasterSection;
+        }
+
         // Apply master volume
-        float masterVol = masterState.volume.load();
-        if (std::isfinite(masterVol) && masterVol >= 0.0f) {
-            buffer.applyGain(masterVol);
+        if (masterVolumeSmoothed.isSmoothing()) {
+            const float startGain = masterVolumeSmoothed.getCurrentValue();
+            masterVolumeSmoothed.skip(numSamples);
+            buffer.applyGainRamp(0, numSamples, startGain, masterVolumeSmoothed.getCurrentValue());
         } else {
-            DBG("Mixer: Invalid master volume, applying safety gain");
-            buffer.applyGain(0.5f);
+            buffer.applyGain(masterVolumeSmoothed.getTargetValue());
         }
 
-        if (masterState.limiterEnabled.load()) {
-            processLimiter(buffer);
-        }
+        // Always runs so the reported latency holds while the limiter is bypassed
+        processLimiter(buffer);
 
-        updateMasterMetering(buffer);
+        if (metering) {
+            updateMasterMetering(buffer);
+        }
+        if (analysing) {
+            mixAnalyzer.pushMaster(buffer);
+        }
         
     } catch (const std::exception& e) {
         DBG("Mixer: Critical exception in processBlock - " + juce::String(e.what()));
@@ -244,76 +420,147 @@ void Mixer::processBlock(juce::AudioBuffer<float>& buffer) {
 
 void Mixer::processChannel(int channel, juce::AudioBuffer<float>& buffer) {
     auto& proc = channelProcessors[channel];
-    auto& state = channelStates[channel];
+    const auto& settings = active.channels[static_cast<size_t>(channel)];
 
     const int numSamples = buffer.getNumSamples();
 
+    // Only pick up new targets when the snapshot for this channel has changed
+    if (dirtySections & (1u << channel)) {
+        for (int band = 0; band < NUM_EQ_FILTERS; ++band) {
+            proc.eqGainSmoothed[band].setTargetValue(settings.eqGains[band]);
+        }
+
+        float pan = settings.pan;
+        proc.panLeftSmoothed.setTargetValue(std::cos((pan + 1.0f) * juce::MathConstants<float>::pi * 0.25f));
+        proc.panRightSmoothed.setTargetValue(std::sin((pan + 1.0f) * juce::MathConstants<float>::pi * 0.25f));
+        proc.volumeSmoothed.setTargetValue(settings.volume);
+        dirtySections &= ~(1u << channel);
+    }
+
     juce::dsp::AudioBlock<float> block(buffer);
-    juce::dsp::ProcessContextReplacing<float> context(block);
+    processChannelEQ(channel, block);
+
+    proc.inserts.process(buffer.getWritePointer(0), buffer.getWritePointer(1), numSamples);
+
+    const float volumeStart = proc.volumeSmoothed.getCurrentValue();
+    const float leftStart = proc.panLeftSmoothed.getCurrentValue();
+    const float rightStart = proc.panRightSmoothed.getCurrentValue();
+    proc.volumeSmoothed.skip(numSamples);
+    proc.panLeftSmoothed.skip(numSamples);
+    proc.panRightSmoothed.skip(numSamples);
+    const float volumeEnd = proc.volumeSmoothed.getCurrentValue();
+
+    buffer.applyGainRamp(0, 0, numSamples, volumeStart * leftStart, volumeEnd * proc.panLeftSmoothed.getCurrentValue());
+    buffer.applyGainRamp(1, 0, numSamples, volumeStart * rightStart, volumeEnd * proc.panRightSmoothed.getCurrentValue());
+}
 
-    proc.lowShelf.process(context);
-    proc.midPeak.process(context);
-    proc.highShelf.process(context);
+void Mixer::processChannelEQ(int channel, juce::dsp::AudioBlock<float>& block) {
+    auto& proc = channelProcessors[channel];
 
-    proc.volumeSmoothed.setTargetValue(state.volume.load());
-    buffer.applyGainRamp(0, numSamples, proc.volumeSmoothed.getCurrentValue(), proc.volumeSmoothed.getNextValue());
+    bool smoothing = false;
+    for (const auto& gain : proc.eqGainSmoothed) {
+        smoothing = smoothing || gain.isSmoothing();
+    }
 
-    float pan = state.pan.load();
-    float leftGain = std::cos((pan + 1.0f) * juce::MathConstants<float>::pi * 0.25f);
-    float rightGain = std::sin((pan + 1.0f) * juce::MathConstants<float>::pi * 0.25f);
+    const int numSamples = static_cast<int>(block.getNumSamples());
+    const int subBlockSize = smoothing ? INIConfig::Audio::PARAMETER_SMOOTHING_SUBBLOCK : numSamples;
 
-    buffer.applyGain(0, 0, numSamples, leftGain);
-    buffer.applyGain(1, 0, numSamples, rightGain);
+    // While a gain is moving, coefficients are recomputed every sub-block to avoid zipper noise
+    for (int start = 0; start < numSamples; start += subBlockSize) {
+        const int length = juce::jmin(subBlockSize, numSamples - start);
+
+        if (smoothing) {
+            for (auto& gain : proc.eqGainSmoothed) {
+                gain.skip(length);
+            }
+            updateEQCoefficients(channel);
+        }
+
+        auto subBlock = block.getSubBlock(static_cast<size_t>(start), static_cast<size_t>(length));
+        juce::dsp::ProcessContextReplacing<float> context(subBlock);
+
+        proc.lowShelf.process(context);
+        proc.midPeak.process(context);
+        proc.highShelf.process(context);
+    }
 }
 
-void Mixer::processReverb(juce::AudioBuffer<float>& buffer) {
-    juce::dsp::Reverb::Parameters params;
-    params.roomSize = reverbState.roomSize.load();
-    params.damping = reverbState.damping.load();
-    params.wetLevel = reverbState.mix.load();
-    params.dryLevel = 0.0f;
-    params.width = reverbState.width.load();
-    reverb.setParameters(params);
+void Mixer::processCutFilters(juce::dsp::AudioBlock<float>& block,
+                              juce::dsp::StateVariableTPTFilter<float>& lowCut,
+                              juce::dsp::StateVariableTPTFilter<float>& highCut,
+                              SmoothedFrequency& lowCutFrequency,
+                              SmoothedFrequency& highCutFrequency) {
+    const bool smoothing = lowCutFrequency.isSmoothing() || highCutFrequency.isSmoothing();
+    const int numSamples = static_cast<int>(block.getNumSamples());
+    const int subBlockSize = smoothing ? INIConfig::Audio::PARAMETER_SMOOTHING_SUBBLOCK : numSamples;
 
-    juce::dsp::AudioBlock<float> block(buffer);
-    juce::dsp::ProcessContextReplacing<float> context(block);
+    for (int start = 0; start < numSamples; start += subBlockSize) {
+        const int length = juce::jmin(subBlockSize, numSamples - start);
 
-    reverbLowCut.setCutoffFrequency(reverbState.lowCut.load());
-    reverbHighCut.setCutoffFrequency(reverbState.highCut.load());
+        if (smoothing) {
+            lowCut.setCutoffFrequency(lowCutFrequency.skip(length));
+            highCut.setCutoffFrequency(highCutFrequency.skip(length));
+        }
 
-    reverbLowCut.process(context);
-    reverbHighCut.process(context);
+        auto subBlock = block.getSubBlock(static_cast<size_t>(start), static_cast<size_t>(length));
+        juce::dsp::ProcessContextReplacing<float> context(subBlock);
 
+        lowCut.process(context);
+        highCut.process(context);
+    }
+}
+
+void Mixer::processReverb(juce::AudioBuffer<float>& buffer) {
+    if (dirtySections & ReverbSection) {
+        juce::dsp::Reverb::Parameters params;
+        params.roomSize = active.reverb.roomSize;
+        params.damping = active.reverb.damping;
+        params.wetLevel = active.reverb.mix;
+        params.dryLevel = 0.0f;
+        params.width = active.reverb.width;
+        reverb.setParameters(params);
+
+        reverbLowCutSmoothed.setTargetValue(active.reverb.lowCut);
+        reverbHighCutSmoothed.setTargetValue(active.reverb.highCut);
+        dirtySections &= ~ReverbSection;
+    }
+
+    juce::dsp::AudioBlock<float> block(buffer);
+    processCutFilters(block, reverbLowCut, reverbHighCut, reverbLowCutSmoothed, reverbHighCutSmoothed);
+
+    juce::dsp::ProcessContextReplacing<float> context(block);
     reverb.process(context);
 }
 
 void Mixer::processDelay(juce::AudioBuffer<float>& buffer) {
     const int numSamples = buffer.getNumSamples();
 
-    float delayMs = delayState.delayTime.load();
-    if (delayState.syncToHost.load() && hostTempo > 0) {
+    const auto& settings = active.delay;
+
+    float delayMs = settings.delayTime;
+    if (settings.syncToHost && hostTempo > 0) {
         float beatLength = static_cast<float>(INIConfig::Defaults::MS_PER_MINUTE) / static_cast<float>(hostTempo);
-        float division = static_cast<float>(delayState.syncDivision.load());
+        float division = static_cast<float>(settings.syncDivision);
         delayMs = beatLength * (static_cast<float>(INIConfig::Defaults::BEATS_PER_BAR) / division);
     }
 
     int delaySamples = static_cast<int>(delayMs * sampleRate / static_cast<float>(INIConfig::Defaults::MS_PER_SECOND));
     delaySamples = juce::jlimit(1, INIConfig::Defaults::MAX_DELAY_SAMPLES, delaySamples);
 
-    juce::dsp::AudioBlock<float> block(buffer);
-    juce::dsp::ProcessContextReplacing<float> context(block);
-
-    delayLowCut.setCutoffFrequency(delayState.lowCut.load());
-    delayHighCut.setCutoffFrequency(delayState.highCut.load());
+    if (dirtySections & DelaySection) {
+        delayLowCutSmoothed.setTargetValue(settings.lowCut);
+        delayHighCutSmoothed.setTargetValue(settings.highCut);
+        dirtySections &= ~DelaySection;
+    }
 
     auto* leftIn = buffer.getReadPointer(0);
     auto* rightIn = buffer.getReadPointer(1);
     auto* leftOut = buffer.getWritePointer(0);
     auto* rightOut = buffer.getWritePointer(1);
 
-    float feedback = delayState.feedback.load();
-    float mix = delayState.mix.load();
-    bool pingPong = delayState.pingPong.load();
+    float feedback = settings.feedback;
+    float mix = settings.mix;
+    bool pingPong = settings.pingPong;
 
     for (int i = 0; i < numSamples; ++i) {
         float delayedLeft = delayLineLeft.popSample(0, delaySamples);
@@ -334,47 +581,65 @@ void Mixer::processDelay(juce::AudioBuffer<float>& buffer) {
         rightOut[i] = rightIn[i] * (1.0f - mix) + delayedRight * mix;
     }
 
-    delayLowCut.process(context);
-    delayHighCut.process(context);
+    juce::dsp::AudioBlock<float> block(buffer);
+    processCutFilters(block, delayLowCut, delayHighCut, delayLowCutSmoothed, delayHighCutSmoothed);
 }
 
 void Mixer::processCompressor(juce::AudioBuffer<float>& buffer) {
-    compressor.setThreshold(compressorState.threshold.load());
-    compressor.setRatio(compressorState.ratio.load());
-    compressor.setAttack(compressorState.attack.load());
-    compressor.setRelease(compressorState.release.load());
+    const int numSamples = buffer.getNumSamples();
+
+    if (dirtySections & CompressorSection) {
+        compressor.setRatio(active.compressor.ratio);
+        compressor.setAttack(active.compressor.attack);
+        compressor.setRelease(active.compressor.release);
+        compressorThresholdSmoothed.setTargetValue(active.compressor.threshold);
+        compressorMakeupSmoothed.setTargetValue(juce::Decibels::decibelsToGain(active.compressor.makeupGain));
+        dirtySections &= ~CompressorSection;
+    }
 
     juce::dsp::AudioBlock<float> block(buffer);
-    juce::dsp::ProcessContextReplacing<float> context(block);
 
-    if (compressorState.sidechainEnabled.load()) {
+    if (active.compressor.sidechainEnabled) {
     }
 
-    compressor.process(context);
+    const bool smoothing = compressorThresholdSmoothed.isSmoothing();
+    const int subBlockSize = smoothing ? INIConfig::Audio::PARAMETER_SMOOTHING_SUBBLOCK : numSamples;
+
+    for (int start = 0; start < numSamples; start += subBlockSize) {
+        const int length = juce::jmin(subBlockSize, numSamples - start);
+        compressor.setThreshold(smoothing ? compressorThresholdSmoothed.skip(length)
+                                          : compressorThresholdSmoothed.getTargetValue());
 
-    float makeupGain = juce::Decibels::decibelsToGain(compressorState.makeupGain.load());
-    buffer.applyGain(makeupGain);
+        auto subBlock = block.getSubBlock(static_cast<size_t>(start), static_cast<size_t>(length));
+        juce::dsp::ProcessContextReplacing<float> context(subBlock);
+        compressor.process(context);
+    }
+
+    const float makeupStart = compressorMakeupSmoothed.getCurrentValue();
+    compressorMakeupSmoothed.skip(numSamples);
+    buffer.applyGainRamp(0, numSamples, makeupStart, compressorMakeupSmoothed.getCurrentValue());
 }
 
 void Mixer::processDistortion(juce::AudioBuffer<float>& buffer) {
     const int numSamples = buffer.getNumSamples();
-    float drive = distortionState.drive.load();
-    float mix = distortionState.mix.load();
-    float preGain = juce::Decibels::decibelsToGain(distortionState.preGain.load());
-    float postGain = juce::Decibels::decibelsToGain(distortionState.postGain.load());
+    const auto& settings = active.distortion;
+    float drive = settings.drive;
+    float mix = settings.mix;
+    float preGain = juce::Decibels::decibelsToGain(settings.preGain);
+    float postGain = juce::Decibels::decibelsToGain(settings.postGain);
 
     for (int ch = 0; ch < buffer.getNumChannels(); ++ch) {
         auto* data = buffer.getWritePointer(ch);
 
         for (int i = 0; i < numSamples; ++i) {
             float input = data[i] * preGain;
-            float distorted = applyDistortion(input, distortionState.mode, drive);
+            float distorted = applyDistortion(input, settings.mode, drive, settings.bitDepth);
             data[i] = (data[i] * (1.0f - mix)) + (distorted * postGain * mix);
         }
     }
 }
 
-float Mixer::applyDistortion(float input, DistortionState::Mode mode, float drive) {
+float Mixer::applyDistortion(float input, DistortionState::Mode mode, float drive, int bitDepth) {
     switch (mode) {
         case DistortionState::Mode::Soft:
             return std::tanh(input * drive * INIConfig::Defaults::SCURVE_FACTOR) / std::tanh(drive * INIConfig::Defaults::SCURVE_FACTOR);
@@ -383,8 +648,7 @@ float Mixer::applyDistortion(float input, DistortionState::Mode mode, float driv
             return juce::jlimit(-1.0f, 1.0f, input * drive * 5.0f);
 
         case DistortionState::Mode::Bit: {
-            int bits = distortionState.bitDepth.load();
-            float levels = std::pow(2.0f, bits);
+            float levels = std::pow(2.0f, static_cast<float>(bitDepth));
             return std::round(input * levels) / levels;
         }
 
@@ -401,282 +665,384 @@ float Mixer::applyDistortion(float input, DistortionState::Mode mode, float driv
 }
 
 void Mixer::processLimiter(juce::AudioBuffer<float>& buffer) {
-    limiter.setThreshold(masterState.limiterThreshold.load());
-    limiter.setRelease(masterState.limiterRelease.load());
-
-    juce::dsp::AudioBlock<float> block(buffer);
-    juce::dsp::ProcessContextReplacing<float> context(block);
-    limiter.process(context);
+    limiter.process(buffer);
 }
 
 void Mixer::updateMetering(int channel, const juce::AudioBuffer<float>& buffer) {
     if (channel < 0 || channel >= NUM_CHANNELS) return;
 
-    auto& state = channelStates[channel];
-    const int numSamples = buffer.getNumSamples();
-
-    float maxLeft = 0.0f;
-    float maxRight = 0.0f;
-
-    for (int i = 0; i < numSamples; ++i) {
-        maxLeft = juce::jmax(maxLeft, std::abs(buffer.getSample(0, i)));
-        maxRight = juce::jmax(maxRight, std::abs(buffer.getSample(1, i)));
-    }
-
-    state.currentLevelLeft.store(maxLeft);
-    state.currentLevelRight.store(maxRight);
-
-    if (maxLeft > state.peakLevelLeft.load()) {
-        state.peakLevelLeft.store(maxLeft);
-    }
-    if (maxRight > state.peakLevelRight.load()) {
-        state.peakLevelRight.store(maxRight);
-    }
+    meteringService.measureChannel(channel, buffer);
 }
 
 void Mixer::updateMasterMetering(const juce::AudioBuffer<float>& buffer) {
-    const int numSamples = buffer.getNumSamples();
-
-    float maxLeft = 0.0f;
-    float maxRight = 0.0f;
-
-    for (int i = 0; i < numSamples; ++i) {
-        maxLeft = juce::jmax(maxLeft, std::abs(buffer.getSample(0, i)));
-        maxRight = juce::jmax(maxRight, std::abs(buffer.getSample(1, i)));
-    }
-
-    masterState.currentLevelLeft.store(maxLeft);
-    masterState.currentLevelRight.store(maxRight);
-
-    if (maxLeft > masterState.peakLevelLeft.load()) {
-        masterState.peakLevelLeft.store(maxLeft);
-    }
-    if (maxRight > masterState.peakLevelRight.load()) {
-        masterState.peakLevelRight.store(maxRight);
-    }
+    meteringService.measureMaster(buffer);
+    meteringService.publishFrame();
 }
 
 void Mixer::updateEQCoefficients(int channel) {
     if (channel < 0 || channel >= NUM_CHANNELS) return;
 
     auto& proc = channelProcessors[channel];
-    auto& state = channelStates[channel];
 
-    float lowGain = state.eqGains[static_cast<int>(EQBand::Low)].load();
-    *proc.lowShelf.coefficients = *juce::dsp::IIR::Coefficients<float>::makeLowShelf(
+    // ArrayCoefficients write into the existing coefficient storage, so this is safe on the audio thread
+    float lowGain = proc.eqGainSmoothed[static_cast<int>(EQBand::Low)].getCurrentValue();
+    *proc.lowShelf.coefficients = juce::dsp::IIR::ArrayCoefficients<float>::makeLowShelf(
         sampleRate, 80.0f, 0.7f, juce::Decibels::decibelsToGain(lowGain));
 
-    float midGain = state.eqGains[static_cast<int>(EQBand::Mid)].load();
-    *proc.midPeak.coefficients = *juce::dsp::IIR::Coefficients<float>::makePeakFilter(
+    float midGain = proc.eqGainSmoothed[static_cast<int>(EQBand::Mid)].getCurrentValue();
+    *proc.midPeak.coefficients = juce::dsp::IIR::ArrayCoefficients<float>::makePeakFilter(
         sampleRate, 1000.0f, 0.7f, juce::Decibels::decibelsToGain(midGain));
 
-    float highGain = state.eqGains[static_cast<int>(EQBand::High)].load();
-    *proc.highShelf.coefficients = *juce::dsp::IIR::Coefficients<float>::makeHighShelf(
+    float highGain = proc.eqGainSmoothed[static_cast<int>(EQBand::High)].getCurrentValue();
+    *proc.highShelf.coefficients = juce::dsp::IIR::ArrayCoefficients<float>::makeHighShelf(
         sampleRate, 8000.0f, 0.7f, juce::Decibels::decibelsToGain(highGain));
 }
 
 bool Mixer::anySolo() const {
-    for (const auto& state : channelStates) {
-        if (state.solo.load()) return true;
+    for (const auto& settings : active.channels) {
+        if (settings.solo) return true;
     }
     return false;
 }
 
+void Mixer::syncSnapshot(int numSamples) {
+    // Bits stay set until the section is next processed, so a muted channel or a
+    // bypassed effect still picks up what changed while it was idle
+    if (snapshotUpdates.update()) {
+        const auto& update = snapshotUpdates.read();
+
+        if (update.morphSamples > 0) {
+            // Start from wherever we are now, which may be part way through another morph
+            morphSource = active;
+            morphTarget = update.snapshot;
+            morphLength = update.morphSamples;
+            morphPosition = 0;
+            reverbReturn.from = reverbReturn.end;
+            delayReturn.from = delayReturn.end;
+            morphActive.store(true, std::memory_order_relaxed);
+        } else {
+            active = update.snapshot;
+            morphActive.store(false, std::memory_order_relaxed);
+        }
+
+        dirtySections |= AllSections;
+    }
+
+    const bool morphing = morphActive.load(std::memory_order_relaxed);
+    auto& target = morphing ? morphTarget : active;
+
+    // Individual setters still arrive through the generation counters, a section at a time
+    auto refresh = [this](const auto& state, auto& settings, juce::uint32& applied, juce::uint32 bit) {
+        const auto generation = state.generation.load(std::memory_order_acquire);
+        if (generation != applied) {
+            settings = state.load();
+            applied = generation;
+            dirtySections |= bit;
+        }
+    };
+
+    for (int ch = 0; ch < NUM_CHANNELS; ++ch)
+        refresh(channelStates[ch], target.channels[static_cast<size_t>(ch)], channelProcessors[ch].appliedGeneration, 1u << ch);
+    refresh(masterState, target.master, appliedMasterGeneration, MasterSection);
+    refresh(reverbState, target.reverb, appliedReverbGeneration, ReverbSection);
+    refresh(delayState, target.delay, appliedDelayGeneration, DelaySection);
+    refresh(compressorState, target.compressor, appliedCompressorGeneration, CompressorSection);
+    refresh(distortionState, target.distortion, appliedDistortionGeneration, 0);  // read every block, nothing to re-target
+
+    if (morphing) {
+        morphPosition = juce::jmin(morphLength, morphPosition + numSamples);
+        const float position = static_cast<float>(morphPosition) / static_cast<float>(morphLength);
+
+        active = Snapshot::interpolate(morphSource, morphTarget, position);
+        updateReturnLevel(reverbReturn, morphTarget.reverb.enabled, position);
+        updateReturnLevel(delayReturn, morphTarget.delay.enabled, position);
+        dirtySections |= AllSections;
+
+        if (morphPosition >= morphLength)
+            morphActive.store(false, std::memory_order_relaxed);
+    } else {
+        const float reverbLevel = active.reverb.enabled ? 1.0f : 0.0f;
+        const float delayLevel = active.delay.enabled ? 1.0f : 0.0f;
+        reverbReturn = {reverbLevel, reverbLevel, reverbLevel};
+        delayReturn = {delayLevel, delayLevel, delayLevel};
+    }
+}
+
+void Mixer::updateReturnLevel(ReturnLevel& level, bool enabled, float position) {
+    level.start = level.end;
+    level.end = lerp(level.from, enabled ? 1.0f : 0.0f, position);
+}
+
 void Mixer::setChannelVolume(int channel, float volume) {
     if (channel >= 0 && channel < NUM_CHANNELS) {
         channelStates[channel].volume.store(juce::jlimit(0.0f, 1.0f, volume));
+        markChanged(channelStates[channel]);
     }
 }
 
 void Mixer::setChannelPan(int channel, float pan) {
     if (channel >= 0 && channel < NUM_CHANNELS) {
         channelStates[channel].pan.store(juce::jlimit(-1.0f, 1.0f, pan));
+        markChanged(channelStates[channel]);
     }
 }
 
 void Mixer::setChannelMute(int channel, bool mute) {
     if (channel >= 0 && channel < NUM_CHANNELS) {
         channelStates[channel].mute.store(mute);
+        markChanged(channelStates[channel]);
     }
 }
 
 void Mixer::setChannelSolo(int channel, bool solo) {
     if (channel >= 0 && channel < NUM_CHANNELS) {
         channelStates[channel].solo.store(solo);
+        markChanged(channelStates[channel]);
     }
 }
 
 void Mixer::setChannelEQ(int channel, EQBand band, float gain) {
     if (channel >= 0 && channel < NUM_CHANNELS) {
         channelStates[channel].eqGains[static_cast<int>(band)].store(juce::jlimit(-12.0f, 12.0f, gain));
-        updateEQCoefficients(channel);
+        markChanged(channelStates[channel]);
     }
 }
 
 void Mixer::setChannelSend(int channel, SendType send, float amount) {
     if (channel >= 0 && channel < NUM_CHANNELS) {
         channelStates[channel].sends[static_cast<int>(send)].store(juce::jlimit(0.0f, 1.0f, amount));
+        markChanged(channelStates[channel]);
+    }
+}
+
+void Mixer::setChannelInsertChain(int channel, const InsertEffects::ChainSettings& settings) {
+    if (channel >= 0 && channel < NUM_CHANNELS) {
+        channelProcessors[channel].inserts.setSettings(settings);
+    }
+}
+
+void Mixer::setChannelInsertEnabled(int channel, InsertEffects::Type type, bool enabled) {
+    if (channel >= 0 && channel < NUM_CHANNELS) {
+        auto settings = channelProcessors[channel].inserts.getSettings();
+        settings.setEnabled(type, enabled);
+        channelProcessors[channel].inserts.setSettings(settings);
     }
 }
 
 void Mixer::setMasterVolume(float volume) {
     masterState.volume.store(juce::jlimit(0.0f, 1.2f, volume));
+    markChanged(masterState);
 }
 
 void Mixer::setLimiterEnabled(bool enabled) {
     masterState.limiterEnabled.store(enabled);
+    markChanged(masterState);
 }
 
 void Mixer::setLimiterThreshold(float threshold) {
     masterState.limiterThreshold.store(juce::jlimit(-24.0f, 0.0f, threshold));
+    markChanged(masterState);
 }
 
 void Mixer::setLimiterRelease(float release) {
     masterState.limiterRelease.store(juce::jlimit(1.0f, 1000.0f, release));
+    markChanged(masterState);
+}
+
+void Mixer::setLimiterLookahead(float lookaheadMs) {
+    const int previousLatency = getLatencySamples();
+
+    masterState.limiterLookahead.store(juce::jlimit(INIConfig::Audio::MIN_LIMITER_LOOKAHEAD_MS,
+                                                    INIConfig::Audio::MAX_LIMITER_LOOKAHEAD_MS, lookaheadMs));
+    markChanged(masterState);
+
+    const int latency = getLatencySamples();
+    if (latency != previousLatency && onLatencyChanged)
+        onLatencyChanged(latency);
+}
+
+int Mixer::getLatencySamples() const {
+    return TruePeakLimiter::calculateLatencySamples(masterState.limiterLookahead.load(), sampleRate);
 }
 
 void Mixer::setReverbEnabled(bool enabled) {
     reverbState.enabled.store(enabled);
+    markChanged(reverbState);
 }
 
 void Mixer::setReverbAlgorithm(ReverbAlgorithm algorithm) {
     reverbState.algorithm.store(algorithm);
+    markChanged(reverbState);
 }
 
 void Mixer::setReverbMix(float mix) {
     reverbState.mix.store(juce::jlimit(0.0f, 1.0f, mix));
+    markChanged(reverbState);
 }
 
 void Mixer::setReverbRoomSize(float size) {
     reverbState.roomSize.store(juce::jlimit(0.0f, 1.0f, size));
+    markChanged(reverbState);
 }
 
 void Mixer::setReverbDamping(float damping) {
     reverbState.damping.store(juce::jlimit(0.0f, 1.0f, damping));
+    markChanged(reverbState);
 }
 
 void Mixer::setReverbPredelay(float predelay) {
     reverbState.predelay.store(juce::jlimit(0.0f, 100.0f, predelay));
+    markChanged(reverbState);
 }
 
 void Mixer::setReverbWidth(float width) {
     reverbState.width.store(juce::jlimit(0.0f, 1.0f, width));
+    markChanged(reverbState);
 }
 
 void Mixer::setReverbHighCut(float freq) {
     reverbState.highCut.store(juce::jlimit(1000.0f, 20000.0f, freq));
+    markChanged(reverbState);
 }
 
 void Mixer::setReverbLowCut(float freq) {
     reverbState.lowCut.store(juce::jlimit(20.0f, 1000.0f, freq));
+    markChanged(reverbState);
 }
 
 void Mixer::setDelayEnabled(bool enabled) {
     delayState.enabled.store(enabled);
+    markChanged(delayState);
 }
 
 void Mixer::setDelaySyncToHost(bool sync) {
     delayState.syncToHost.store(sync);
+    markChanged(delayState);
 }
 
 void Mixer::setDelayTime(float timeMs) {
     delayState.delayTime.store(juce::jlimit(0.1f, 4000.0f, timeMs));
+    markChanged(delayState);
 }
 
 void Mixer::setDelaySyncDivision(int division) {
     delayState.syncDivision.store(juce::jlimit(1, 32, division));
+    markChanged(delayState);
 }
 
 void Mixer::setDelayFeedback(float feedback) {
     delayState.feedback.store(juce::jlimit(0.0f, 0.99f, feedback));
+    markChanged(delayState);
 }
 
 void Mixer::setDelayMix(float mix) {
     delayState.mix.store(juce::jlimit(0.0f, 1.0f, mix));
+    markChanged(delayState);
 }
 
 void Mixer::setDelayHighCut(float freq) {
     delayState.highCut.store(juce::jlimit(1000.0f, 20000.0f, freq));
+    markChanged(delayState);
 }
 
 void Mixer::setDelayLowCut(float freq) {
     delayState.lowCut.store(juce::jlimit(20.0f, 1000.0f, freq));
+    markChanged(delayState);
 }
 
 void Mixer::setDelayPingPong(bool enabled) {
     delayState.pingPong.store(enabled);
+    markChanged(delayState);
 }
 
 void Mixer::setDelaySpread(float spread) {
     delayState.spread.store(juce::jlimit(0.0f, 1.0f, spread));
+    markChanged(delayState);
 }
 
 void Mixer::setCompressorEnabled(bool enabled) {
     compressorState.enabled.store(enabled);
+    markChanged(compressorState);
 }
 
 void Mixer::setCompressorThreshold(float threshold) {
     compressorState.threshold.store(juce::jlimit(-60.0f, 0.0f, threshold));
+    markChanged(compressorState);
 }
 
 void Mixer::setCompressorRatio(float ratio) {
     compressorState.ratio.store(juce::jlimit(1.0f, 20.0f, ratio));
+    markChanged(compressorState);
 }
 
 void Mixer::setCompressorAttack(float attack) {
     compressorState.attack.store(juce::jlimit(0.1f, 100.0f, attack));
+    markChanged(compressorState);
 }
 
 void Mixer::setCompressorRelease(float release) {
     compressorState.release.store(juce::jlimit(1.0f, 5000.0f, release));
+    markChanged(compressorState);
 }
 
 void Mixer::setCompressorMakeupGain(float gain) {
     compressorState.makeupGain.store(juce::jlimit(-12.0f, 24.0f, gain));
+    markChanged(compressorState);
 }
 
 void Mixer::setCompressorKnee(float knee) {
     compressorState.knee.store(juce::jlimit(0.0f, 10.0f, knee));
+    markChanged(compressorState);
 }
 
 void Mixer::setSidechainEnabled(bool enabled) {
     compressorState.sidechainEnabled.store(enabled);
+    markChanged(compressorState);
 }
 
 void Mixer::setSidechainSource(int channel) {
     compressorState.sidechainSource.store(juce::jlimit(0, NUM_CHANNELS - 1, channel));
+    markChanged(compressorState);
 }
 
 void Mixer::setDistortionEnabled(bool enabled) {
     distortionState.enabled.store(enabled);
+    markChanged(distortionState);
 }
 
 void Mixer::setDistortionDrive(float drive) {
     distortionState.drive.store(juce::jlimit(0.0f, 1.0f, drive));
+    markChanged(distortionState);
 }
 
 void Mixer::setDistortionMix(float mix) {
     distortionState.mix.store(juce::jlimit(0.0f, 1.0f, mix));
+    markChanged(distortionState);
 }
 
 void Mixer::setBitDepth(int bits) {
     distortionState.bitDepth.store(juce::jlimit(1, 24, bits));
+    markChanged(distortionState);
 }
 
 void Mixer::setSampleRateReduction(float factor) {
     distortionState.sampleRateReduction.store(juce::jlimit(1.0f, 100.0f, factor));
+    markChanged(distortionState);
 }
 
 void Mixer::setDistortionPreGain(float gain) {
     distortionState.preGain.store(juce::jlimit(-24.0f, 24.0f, gain));
+    markChanged(distortionState);
 }
 
 void Mixer::setDistortionPostGain(float gain) {
     distortionState.postGain.store(juce::jlimit(-24.0f, 24.0f, gain));
+    markChanged(distortionState);
 }
 
 void Mixer::setDistortionMode(DistortionState::Mode mode) {
     distortionState.mode = mode;
+    markChanged(distortionState);
 }
 
 float Mixer::getChannelVolume(int channel) const {
@@ -721,45 +1087,95 @@ float Mixer::getChannelSend(int channel, SendType send) const {
     return 0.0f;
 }
 
+InsertEffects::ChainSettings Mixer::getChannelInsertChain(int channel) const {
+    if (channel >= 0 && channel < NUM_CHANNELS) {
+        return channelProcessors[channel].inserts.getSettings();
+    }
+    return {};
+}
+
+bool Mixer::isChannelInsertEnabled(int channel, InsertEffects::Type type) const {
+    if (channel >= 0 && channel < NUM_CHANNELS) {
+        return channelProcessors[channel].inserts.getSettings().isEnabled(type);
+    }
+    return false;
+}
+
 Mixer::LevelInfo Mixer::getChannelLevels(int channel) const {
     LevelInfo info{0.0f, 0.0f};
     if (channel >= 0 && channel < NUM_CHANNELS) {
-        info.left = channelStates[channel].currentLevelLeft.load();
-        info.right = channelStates[channel].currentLevelRight.load();
+        const auto& reading = meteringService.getLatestFrame().get(channel);
+        info.left = reading.peakLeft;
+        info.right = reading.peakRight;
     }
     return info;
 }
 
 Mixer::LevelInfo Mixer::getMasterLevels() const {
-    return {masterState.currentLevelLeft.load(), masterState.currentLevelRight.load()};
-}
-
-void Mixer::resetPeakLevels() {
-    for (auto& state : channelStates) {
-        state.peakLevelLeft.store(0.0f);
-        state.peakLevelRight.store(0.0f);
+    const auto& reading = meteringService.getLatestFrame().master;
+    return {reading.peakLeft, reading.peakRight};
+}
+
+Mixer::Snapshot Mixer::captureSnapshot() const {
+    Snapshot snapshot;
+    for (int ch = 0; ch < NUM_CHANNELS; ++ch)
+        snapshot.channels[static_cast<size_t>(ch)] = channelStates[ch].load();
+    snapshot.master = masterState.load();
+    snapshot.reverb = reverbState.load();
+    snapshot.delay = delayState.load();
+    snapshot.compressor = compressorState.load();
+    snapshot.distortion = distortionState.load();
+    return snapshot;
+}
+
+void Mixer::storeSnapshot(const Snapshot& snapshot) {
+    // Generations are deliberately left alone: the audio thread takes this snapshot whole
+    for (int ch = 0; ch < NUM_CHANNELS; ++ch)
+        channelStates[ch].store(snapshot.channels[static_cast<size_t>(ch)]);
+    masterState.store(snapshot.master);
+    reverbState.store(snapshot.reverb);
+    delayState.store(snapshot.delay);
+    compressorState.store(snapshot.compressor);
+    distortionState.store(snapshot.distortion);
+}
+
+void Mixer::applySnapshot(const Snapshot& snapshot, float morphTimeMs) {
+    const int previousLatency = getLatencySamples();
+
+    storeSnapshot(snapshot);
+
+    {
+        const juce::SpinLock::ScopedLockType lock(snapshotWriteLock);
+        auto& update = snapshotUpdates.getWriteBuffer();
+        update.snapshot = snapshot;
+        update.morphSamples = juce::roundToInt(juce::jmax(0.0f, morphTimeMs) * 0.001 * sampleRate);
+        snapshotUpdates.publish();
     }
-    masterState.peakLevelLeft.store(0.0f);
-    masterState.peakLevelRight.store(0.0f);
+
+    const int latency = getLatencySamples();
+    if (latency != previousLatency && onLatencyChanged)
+        onLatencyChanged(latency);
 }
 
 void Mixer::savePreset(const juce::String& name) {
     EffectPreset preset;
     preset.name = name;
-    preset.reverb.copyFrom(reverbState);
-    preset.delay.copyFrom(delayState);
-    preset.compressor.copyFrom(compressorState);
-    preset.distortion.copyFrom(distortionState);
+    preset.reverb = reverbState.load();
+    preset.delay = delayState.load();
+    preset.compressor = compressorState.load();
+    preset.distortion = distortionState.load();
     effectPresets.add(preset);
 }
 
-void Mixer::loadPreset(int index) {
+void Mixer::loadPreset(int index, float morphTimeMs) {
     if (index >= 0 && index < effectPresets.size()) {
-        const auto& preset = effectPresets[index];
-        reverbState.copyFrom(preset.reverb);
-        delayState.copyFrom(preset.delay);
-        compressorState.copyFrom(preset.compressor);
-        distortionState.copyFrom(preset.distortion);
+        const auto& preset = effectPresets.getReference(index);
+        auto snapshot = captureSnapshot();
+        snapshot.reverb = preset.reverb;
+        snapshot.delay = preset.delay;
+        snapshot.compressor = preset.compressor;
+        snapshot.distortion = preset.distortion;
+        applySnapshot(snapshot, morphTimeMs);
     }
 }
 
@@ -839,12 +1255,22 @@ void Mixer::saveState(ComponentState& state) const {
 
         state.sliderValues[prefix + "send_reverb"] = ch.sends[0].load();
         state.sliderValues[prefix + "send_delay"] = ch.sends[1].load();
+
+        const auto inserts = channelProcessors[i].inserts.getSettings();
+        for (int slot = 0; slot < InsertEffects::NUM_SLOTS; ++slot) {
+            state.toggleStates[1002 + i * 10 + slot] = inserts.enabled[slot];
+            state.dropdownSelections[prefix + "insert_order_" + juce::String(slot)] = static_cast<int>(inserts.order[slot]);
+        }
+        for (const auto& param : InsertEffects::getParameterTable()) {
+            state.sliderValues[prefix + "insert_" + param.key] = inserts.*(param.member);
+        }
     }
 
     state.sliderValues["mixer_master_volume"] = masterState.volume.load();
     state.toggleStates[2000] = masterState.limiterEnabled.load();
     state.sliderValues["mixer_limiter_threshold"] = masterState.limiterThreshold.load();
     state.sliderValues["mixer_limiter_release"] = masterState.limiterRelease.load();
+    state.sliderValues["mixer_limiter_lookahead"] = masterState.limiterLookahead.load();
 
     state.toggleStates[2100] = reverbState.enabled.load();
     state.dropdownSelections["reverb_algorithm"] = static_cast<int>(reverbState.algorithm.load());
@@ -884,7 +1310,7 @@ void Mixer::saveState(ComponentState& state) const {
     state.sliderValues["dist_sr_reduction"] = distortionState.sampleRateReduction.load();
     state.sliderValues["dist_pre_gain"] = distortionState.preGain.load();
     state.sliderValues["dist_post_gain"] = distortionState.postGain.load();
-    state.dropdownSelections["dist_mode"] = static_cast<int>(distortionState.mode);
+    state.dropdownSelections["dist_mode"] = static_cast<int>(distortionState.mode.load());
 }
 
 void Mixer::loadState(const ComponentState& state) {
@@ -911,6 +1337,21 @@ void Mixer::loadState(const ComponentState& state) {
             setChannelSend(i, SendType::Reverb, state.sliderValues.at(prefix + "send_reverb"));
         if (state.sliderValues.count(prefix + "send_delay"))
             setChannelSend(i, SendType::Delay, state.sliderValues.at(prefix + "send_delay"));
+
+        auto inserts = channelProcessors[i].inserts.getSettings();
+        for (int slot = 0; slot < InsertEffects::NUM_SLOTS; ++slot) {
+            if (state.toggleStates.count(1002 + i * 10 + slot))
+                inserts.enabled[slot] = state.toggleStates.at(1002 + i * 10 + slot);
+            juce::String orderKey = prefix + "insert_order_" + juce::String(slot);
+            if (state.dropdownSelections.count(orderKey))
+                inserts.order[slot] = static_cast<InsertEffects::Type>(state.dropdownSelections.at(orderKey));
+        }
+        for (const auto& param : InsertEffects::getParameterTable()) {
+            juce::String key = prefix + "insert_" + param.key;
+            if (state.sliderValues.count(key))
+                inserts.*(param.member) = state.sliderValues.at(key);
+        }
+        setChannelInsertChain(i, inserts);
     }
 
     if (state.sliderValues.count("mixer_master_volume"))
@@ -921,6 +1362,8 @@ void Mixer::loadState(const ComponentState& state) {
         setLimiterThreshold(state.sliderValues.at("mixer_limiter_threshold"));
     if (state.sliderValues.count("mixer_limiter_release"))
         setLimiterRelease(state.sliderValues.at("mixer_limiter_release"));
+    if (state.sliderValues.count("mixer_limiter_lookahead"))
+        setLimiterLookahead(state.sliderValues.at("mixer_limiter_lookahead"));
 
     if (state.toggleStates.count(2100))
         setReverbEnabled(state.toggleStates.at(2100));
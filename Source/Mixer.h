@@ -3,8 +3,14 @@
 #include <JuceHeader.h>
 #include <array>
 #include <atomic>
+#include <functional>
 #include "ComponentState.h"
 #include "INIConfig.h"
+#include "InsertEffectChain.h"
+#include "LockFreeStructures.h"
+#include "MeteringService.h"
+#include "MixAnalyzer.h"
+#include "TruePeakLimiter.h"
 
 class Mixer {
 public:
@@ -27,6 +33,75 @@ public:
         Shimmer = INIConfig::Defaults::ONE_VALUE + INIConfig::Defaults::ONE_VALUE + INIConfig::Defaults::ONE_VALUE + INIConfig::Defaults::ONE_VALUE
     };
 
+    // Plain-value copies of each section. These are what snapshots and presets are made of;
+    // the atomic states below remain the message-thread view used by setters and getters.
+    struct ChannelSettings {
+        float volume = INIConfig::Defaults::DEFAULT_KICK_VOLUME;
+        float pan = INIConfig::Audio::DEFAULT_PAN;
+        bool mute = INIConfig::Audio::DEFAULT_MUTE;
+        bool solo = INIConfig::Audio::DEFAULT_SOLO;
+        std::array<float, INIConfig::Audio::NUM_EQ_BANDS> eqGains{};
+        std::array<float, INIConfig::Audio::NUM_SEND_TYPES> sends{};
+    };
+
+    struct MasterSettings {
+        float volume = INIConfig::Defaults::DEFAULT_MASTER_VOLUME;
+        bool limiterEnabled = true;
+        float limiterThreshold = INIConfig::Defaults::DEFAULT_LIMITER_THRESHOLD;
+        float limiterRelease = INIConfig::Defaults::DEFAULT_LIMITER_RELEASE;
+        float limiterLookahead = static_cast<float>(INIConfig::Defaults::DEFAULT_LIMITER_LOOKAHEAD);
+    };
+
+    struct ReverbSettings {
+        bool enabled = true;
+        ReverbAlgorithm algorithm = ReverbAlgorithm::Hall;
+        float mix = INIConfig::Defaults::DEFAULT_REVERB_MIX;
+        float roomSize = INIConfig::Defaults::DEFAULT_ROOM_SIZE;
+        float damping = INIConfig::Defaults::DEFAULT_DAMPING;
+        float predelay = INIConfig::Defaults::DEFAULT_PREDELAY;
+        float width = INIConfig::Defaults::DEFAULT_WIDTH;
+        float highCut = INIConfig::Defaults::DEFAULT_REVERB_HIGH_CUT;
+        float lowCut = INIConfig::Defaults::DEFAULT_REVERB_LOW_CUT;
+    };
+
+    struct DelaySettings {
+        bool enabled = true;
+        bool syncToHost = true;
+        float delayTime = INIConfig::Defaults::DEFAULT_DELAY_TIME;
+        int syncDivision = INIConfig::Audio::DEFAULT_SYNC_DIVISION;
+        float feedback = INIConfig::Defaults::DEFAULT_FEEDBACK;
+        float mix = INIConfig::Defaults::DEFAULT_DELAY_MIX;
+        float highCut = INIConfig::Defaults::DEFAULT_DELAY_HIGH_CUT;
+        float lowCut = INIConfig::Defaults::DEFAULT_DELAY_LOW_CUT;
+        bool pingPong = INIConfig::Defaults::DEFAULT_PINGPONG;
+        float spread = INIConfig::Defaults::DEFAULT_SPREAD;
+    };
+
+    struct CompressorSettings {
+        bool enabled = false;
+        float threshold = INIConfig::Defaults::DEFAULT_COMPRESSOR_THRESHOLD;
+        float ratio = INIConfig::Defaults::DEFAULT_COMPRESSOR_RATIO;
+        float attack = INIConfig::Defaults::DEFAULT_COMPRESSOR_ATTACK;
+        float release = INIConfig::Defaults::DEFAULT_COMPRESSOR_RELEASE;
+        float makeupGain = INIConfig::Defaults::DEFAULT_MAKEUPGAIN;
+        float knee = INIConfig::Defaults::DEFAULT_COMPRESSOR_KNEE;
+        bool sidechainEnabled = INIConfig::Defaults::DEFAULT_SIDECHAIN_ENABLED;
+        int sidechainSource = INIConfig::Audio::DEFAULT_SIDECHAIN_SOURCE;
+    };
+
+    struct DistortionSettings {
+        enum class Mode { Soft, Hard, Bit, Fold };
+
+        bool enabled = false;
+        float drive = INIConfig::Defaults::DEFAULT_DRIVE;
+        float mix = INIConfig::Defaults::DEFAULT_MIX;
+        int bitDepth = INIConfig::Audio::BIT_DEPTH_16;
+        float sampleRateReduction = INIConfig::Audio::DEFAULT_SAMPLERATE_REDUCTION;
+        float preGain = INIConfig::Audio::DEFAULT_PRE_GAIN;
+        float postGain = INIConfig::Audio::DEFAULT_POST_GAIN;
+        Mode mode = Mode::Soft;
+    };
+
     struct ChannelState {
         std::atomic<float> volume{INIConfig::Defaults::DEFAULT_KICK_VOLUME};
         std::atomic<float> pan{INIConfig::Audio::DEFAULT_PAN};
@@ -35,10 +110,27 @@ public:
         std::array<std::atomic<float>, INIConfig::Audio::NUM_EQ_BANDS> eqGains{{INIConfig::Audio::EQ_ATOMIC_INIT, INIConfig::Audio::EQ_ATOMIC_INIT, INIConfig::Audio::EQ_ATOMIC_INIT}};
         std::array<std::atomic<float>, INIConfig::Audio::NUM_SEND_TYPES> sends{{INIConfig::Audio::SEND_ATOMIC_INIT, INIConfig::Audio::SEND_ATOMIC_INIT}};
 
-        std::atomic<float> currentLevelLeft{INIConfig::Defaults::DEFAULT_LEVELLEFT};
-        std::atomic<float> currentLevelRight{INIConfig::Defaults::DEFAULT_LEVELRIGHT};
-        std::atomic<float> peakLevelLeft{INIConfig::Defaults::DEFAULT_PEAKLEFT};
-        std::atomic<float> peakLevelRight{INIConfig::Defaults::DEFAULT_PEAKRIGHT};
+        std::atomic<juce::uint32> generation{0};
+
+        ChannelSettings load() const {
+            ChannelSettings s;
+            s.volume = volume.load();
+            s.pan = pan.load();
+            s.mute = mute.load();
+            s.solo = solo.load();
+            for (size_t i = 0; i < eqGains.size(); ++i) s.eqGains[i] = eqGains[i].load();
+            for (size_t i = 0; i < sends.size(); ++i) s.sends[i] = sends[i].load();
+            return s;
+        }
+
+        void store(const ChannelSettings& s) {
+            volume.store(s.volume);
+            pan.store(s.pan);
+            mute.store(s.mute);
+            solo.store(s.solo);
+            for (size_t i = 0; i < eqGains.size(); ++i) eqGains[i].store(s.eqGains[i]);
+            for (size_t i = 0; i < sends.size(); ++i) sends[i].store(s.sends[i]);
+        }
     };
 
     struct MasterState {
@@ -46,11 +138,21 @@ public:
         std::atomic<bool> limiterEnabled{true};
         std::atomic<float> limiterThreshold{INIConfig::Defaults::DEFAULT_LIMITER_THRESHOLD};
         std::atomic<float> limiterRelease{INIConfig::Defaults::DEFAULT_LIMITER_RELEASE};
+        std::atomic<float> limiterLookahead{static_cast<float>(INIConfig::Defaults::DEFAULT_LIMITER_LOOKAHEAD)};
+
+        std::atomic<juce::uint32> generation{0};
+
+        MasterSettings load() const {
+            return { volume.load(), limiterEnabled.load(), limiterThreshold.load(), limiterRelease.load(), limiterLookahead.load() };
+        }
 
-        std::atomic<float> currentLevelLeft{INIConfig::Defaults::DEFAULT_LEVELLEFT};
-        std::atomic<float> currentLevelRight{INIConfig::Defaults::DEFAULT_LEVELRIGHT};
-        std::atomic<float> peakLevelLeft{INIConfig::Defaults::DEFAULT_PEAKLEFT};
-        std::atomic<float> peakLevelRight{INIConfig::Defaults::DEFAULT_PEAKRIGHT};
+        void store(const MasterSettings& s) {
+            volume.store(s.volume);
+            limiterEnabled.store(s.limiterEnabled);
+            limiterThreshold.store(s.limiterThreshold);
+            limiterRelease.store(s.limiterRelease);
+            limiterLookahead.store(s.limiterLookahead);
+        }
     };
 
     struct ReverbState {
@@ -63,17 +165,23 @@ public:
         std::atomic<float> width{INIConfig::Defaults::DEFAULT_WIDTH};
         std::atomic<float> highCut{INIConfig::Defaults::DEFAULT_REVERB_HIGH_CUT};
         std::atomic<float> lowCut{INIConfig::Defaults::DEFAULT_REVERB_LOW_CUT};
+        std::atomic<juce::uint32> generation{0};
+
+        ReverbSettings load() const {
+            return { enabled.load(), algorithm.load(), mix.load(), roomSize.load(), damping.load(),
+                     predelay.load(), width.load(), highCut.load(), lowCut.load() };
+        }
 
-        void copyFrom(const ReverbState& other) {
-            enabled.store(other.enabled.load());
-            algorithm.store(other.algorithm.load());
-            mix.store(other.mix.load());
-            roomSize.store(other.roomSize.load());
-            damping.store(other.damping.load());
-            predelay.store(other.predelay.load());
-            width.store(other.width.load());
-            highCut.store(other.highCut.load());
-            lowCut.store(other.lowCut.load());
+        void store(const ReverbSettings& s) {
+            enabled.store(s.enabled);
+            algorithm.store(s.algorithm);
+            mix.store(s.mix);
+            roomSize.store(s.roomSize);
+            damping.store(s.damping);
+            predelay.store(s.predelay);
+            width.store(s.width);
+            highCut.store(s.highCut);
+            lowCut.store(s.lowCut);
         }
     };
 
@@ -88,18 +196,24 @@ public:
         std::atomic<float> lowCut{INIConfig::Defaults::DEFAULT_DELAY_LOW_CUT};
         std::atomic<bool> pingPong{INIConfig::Defaults::DEFAULT_PINGPONG};
         std::atomic<float> spread{INIConfig::Defaults::DEFAULT_SPREAD};
+        std::atomic<juce::uint32> generation{0};
+
+        DelaySettings load() const {
+            return { enabled.load(), syncToHost.load(), delayTime.load(), syncDivision.load(), feedback.load(),
+                     mix.load(), highCut.load(), lowCut.load(), pingPong.load(), spread.load() };
+        }
 
-        void copyFrom(const DelayState& other) {
-            enabled.store(other.enabled.load());
-            syncToHost.store(other.syncToHost.load());
-            delayTime.store(other.delayTime.load());
-            syncDivision.store(other.syncDivision.load());
-            feedback.store(other.feedback.load());
-            mix.store(other.mix.load());
-            highCut.store(other.highCut.load());
-            lowCut.store(other.lowCut.load());
-            pingPong.store(other.pingPong.load());
-            spread.store(other.spread.load());
+        void store(const DelaySettings& s) {
+            enabled.store(s.enabled);
+            syncToHost.store(s.syncToHost);
+            delayTime.store(s.delayTime);
+            syncDivision.store(s.syncDivision);
+            feedback.store(s.feedback);
+            mix.store(s.mix);
+            highCut.store(s.highCut);
+            lowCut.store(s.lowCut);
+            pingPong.store(s.pingPong);
+            spread.store(s.spread);
         }
     };
 
@@ -113,21 +227,29 @@ public:
         std::atomic<float> knee{INIConfig::Defaults::DEFAULT_COMPRESSOR_KNEE};
         std::atomic<bool> sidechainEnabled{INIConfig::Defaults::DEFAULT_SIDECHAIN_ENABLED};
         std::atomic<int> sidechainSource{INIConfig::Audio::DEFAULT_SIDECHAIN_SOURCE};
+        std::atomic<juce::uint32> generation{0};
 
-        void copyFrom(const CompressorState& other) {
-            enabled.store(other.enabled.load());
-            threshold.store(other.threshold.load());
-            ratio.store(other.ratio.load());
-            attack.store(other.attack.load());
-            release.store(other.release.load());
-            makeupGain.store(other.makeupGain.load());
-            knee.store(other.knee.load());
-            sidechainEnabled.store(other.sidechainEnabled.load());
-            sidechainSource.store(other.sidechainSource.load());
+        CompressorSettings load() const {
+            return { enabled.load(), threshold.load(), ratio.load(), attack.load(), release.load(),
+                     makeupGain.load(), knee.load(), sidechainEnabled.load(), sidechainSource.load() };
+        }
+
+        void store(const CompressorSettings& s) {
+            enabled.store(s.enabled);
+            threshold.store(s.threshold);
+            ratio.store(s.ratio);
+            attack.store(s.attack);
+            release.store(s.release);
+            makeupGain.store(s.makeupGain);
+            knee.store(s.knee);
+            sidechainEnabled.store(s.sidechainEnabled);
+            sidechainSource.store(s.sidechainSource);
         }
     };
 
     struct DistortionState {
+        using Mode = DistortionSettings::Mode;
+
         std::atomic<bool> enabled{false};
         std::atomic<float> drive{INIConfig::Defaults::DEFAULT_DRIVE};
         std::atomic<float> mix{INIConfig::Defaults::DEFAULT_MIX};
@@ -135,47 +257,45 @@ public:
         std::atomic<float> sampleRateReduction{INIConfig::Audio::DEFAULT_SAMPLERATE_REDUCTION};
         std::atomic<float> preGain{INIConfig::Audio::DEFAULT_PRE_GAIN};
         std::atomic<float> postGain{INIConfig::Audio::DEFAULT_POST_GAIN};
-        enum class Mode { Soft, Hard, Bit, Fold } mode{Mode::Soft};
-
-        void copyFrom(const DistortionState& other) {
-            enabled.store(other.enabled.load());
-            drive.store(other.drive.load());
-            mix.store(other.mix.load());
-            bitDepth.store(other.bitDepth.load());
-            sampleRateReduction.store(other.sampleRateReduction.load());
-            preGain.store(other.preGain.load());
-            postGain.store(other.postGain.load());
-            mode = other.mode;
+        std::atomic<Mode> mode{Mode::Soft};
+        std::atomic<juce::uint32> generation{0};
+
+        DistortionSettings load() const {
+            return { enabled.load(), drive.load(), mix.load(), bitDepth.load(), sampleRateReduction.load(),
+                     preGain.load(), postGain.load(), mode.load() };
+        }
+
+        void store(const DistortionSettings& s) {
+            enabled.store(s.enabled);
+            drive.store(s.drive);
+            mix.store(s.mix);
+            bitDepth.store(s.bitDepth);
+            sampleRateReduction.store(s.sampleRateReduction);
+            preGain.store(s.preGain);
+            postGain.store(s.postGain);
+            mode.store(s.mode);
         }
     };
 
     struct EffectPreset {
         juce::String name;
-        ReverbState reverb;
-        DelayState delay;
-        CompressorState compressor;
-        DistortionState distortion;
-
-        EffectPreset() = default;
-
-        EffectPreset(const EffectPreset& other)
-            : name(other.name) {
-            reverb.copyFrom(other.reverb);
-            delay.copyFrom(other.delay);
-            compressor.copyFrom(other.compressor);
-            distortion.copyFrom(other.distortion);
-        }
+        ReverbSettings reverb;
+        DelaySettings delay;
+        CompressorSettings compressor;
+        DistortionSettings distortion;
+    };
 
-        EffectPreset& operator=(const EffectPreset& other) {
-            if (this != &other) {
-                name = other.name;
-                reverb.copyFrom(other.reverb);
-                delay.copyFrom(other.delay);
-                compressor.copyFrom(other.compressor);
-                distortion.copyFrom(other.distortion);
-            }
-            return *this;
-        }
+    // Complete, immutable picture of the mixer. The audio thread only ever processes from
+    // a snapshot; whole snapshots are swapped in (or morphed towards) at block boundaries.
+    struct Snapshot {
+        std::array<ChannelSettings, INIConfig::Defaults::MAX_PLAYERS> channels{};
+        MasterSettings master;
+        ReverbSettings reverb;
+        DelaySettings delay;
+        CompressorSettings compressor;
+        DistortionSettings distortion;
+
+        static Snapshot interpolate(const Snapshot& from, const Snapshot& to, float position);
     };
 
     Mixer();
@@ -192,10 +312,14 @@ public:
     void setChannelEQ(int channel, EQBand band, float gain);
     void setChannelSend(int channel, SendType send, float amount);
 
+    void setChannelInsertChain(int channel, const InsertEffects::ChainSettings& settings);
+    void setChannelInsertEnabled(int channel, InsertEffects::Type type, bool enabled);
+
     void setMasterVolume(float volume);
     void setLimiterEnabled(bool enabled);
     void setLimiterThreshold(float threshold);
     void setLimiterRelease(float release);
+    void setLimiterLookahead(float lookaheadMs);
 
     void setReverbEnabled(bool enabled);
     void setReverbAlgorithm(ReverbAlgorithm algorithm);
@@ -237,8 +361,14 @@ public:
     void setDistortionPostGain(float gain);
     void setDistortionMode(DistortionState::Mode mode);
 
+    // Message thread. The atomic states are updated for getters and UI, and the snapshot is
+    // handed to the audio thread in one piece; a positive morph time interpolates towards it.
+    Snapshot captureSnapshot() const;
+    void applySnapshot(const Snapshot& snapshot, float morphTimeMs = 0.0f);
+    bool isMorphing() const { return morphActive.load(std::memory_order_relaxed); }
+
     void savePreset(const juce::String& name);
-    void loadPreset(int index);
+    void loadPreset(int index, float morphTimeMs = 0.0f);
     void deletePreset(int index);
     juce::StringArray getPresetNames() const;
     int getNumPresets() const { return effectPresets.size(); }
@@ -250,7 +380,13 @@ public:
 
     LevelInfo getChannelLevels(int channel) const;
     LevelInfo getMasterLevels() const;
-    void resetPeakLevels();
+
+    MeteringService& getMeteringService() { return meteringService; }
+    // Off while bouncing offline: no one watches the meters and the render should not pay for them
+    void setMeteringEnabled(bool enabled) { meteringEnabled.store(enabled, std::memory_order_relaxed); }
+    bool isMeteringEnabled() const { return meteringEnabled.load(std::memory_order_relaxed); }
+    // Fed only while it is active and metering is on, so offline bounces skip it too
+    MixAnalyzer& getMixAnalyzer() { return mixAnalyzer; }
 
     void saveState(ComponentState& state) const;
     void loadState(const ComponentState& state);
@@ -261,10 +397,17 @@ public:
     bool isChannelSoloed(int channel) const;
     float getChannelEQ(int channel, EQBand band) const;
     float getChannelSend(int channel, SendType send) const;
+    InsertEffects::ChainSettings getChannelInsertChain(int channel) const;
+    bool isChannelInsertEnabled(int channel, InsertEffects::Type type) const;
 
     float getMasterVolume() const { return masterState.volume.load(); }
     bool isLimiterEnabled() const { return masterState.limiterEnabled.load(); }
     float getLimiterThreshold() const { return masterState.limiterThreshold.load(); }
+    float getLimiterLookahead() const { return masterState.limiterLookahead.load(); }
+
+    // Latency introduced by the master limiter's lookahead, for setLatencySamples()
+    int getLatencySamples() const;
+    std::function<void(int)> onLatencyChanged;
 
     const ReverbState& getReverbState() const { return reverbState; }
     const DelayState& getDelayState() const { return delayState; }
@@ -283,29 +426,91 @@ private:
     CompressorState compressorState;
     DistortionState distortionState;
 
+    static constexpr int NUM_EQ_FILTERS = 3;
+    static constexpr juce::uint32 GENERATION_NOT_APPLIED = ~juce::uint32(0);
+
+    struct SnapshotUpdate {
+        Snapshot snapshot;
+        int morphSamples = 0;
+    };
+
+    // Bits in dirtySections: one per channel, then the shared sections
+    enum SectionBit : juce::uint32 {
+        MasterSection = 1u << NUM_CHANNELS,
+        ReverbSection = MasterSection << 1,
+        DelaySection = MasterSection << 2,
+        CompressorSection = MasterSection << 3,
+        AllSections = (MasterSection << 4) - 1
+    };
+
+    using SmoothedFrequency = juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative>;
+
     struct ChannelProcessors {
         juce::dsp::IIR::Filter<float> lowShelf;
         juce::dsp::IIR::Filter<float> midPeak;
         juce::dsp::IIR::Filter<float> highShelf;
         juce::dsp::Panner<float> panner;
+        InsertEffects::InsertChain inserts;
         juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> volumeSmoothed;
+        juce::LinearSmoothedValue<float> panLeftSmoothed;
+        juce::LinearSmoothedValue<float> panRightSmoothed;
+        std::array<juce::LinearSmoothedValue<float>, NUM_EQ_FILTERS> eqGainSmoothed;
         juce::LinearSmoothedValue<float> levelFollowerLeft;
         juce::LinearSmoothedValue<float> levelFollowerRight;
+        juce::uint32 appliedGeneration = GENERATION_NOT_APPLIED;
+    };
+
+    // Audio thread view: what this block processes, and the morph in progress
+    TripleBuffer<SnapshotUpdate> snapshotUpdates;
+    juce::SpinLock snapshotWriteLock;
+    Snapshot active;
+    Snapshot morphSource;
+    Snapshot morphTarget;
+    int morphLength = 0;
+    int morphPosition = 0;
+    std::atomic<bool> morphActive{false};
+    juce::uint32 dirtySections = AllSections;
+
+    // Send returns fade in or out when a morph enables or disables the reverb or delay
+    struct ReturnLevel {
+        float from = 1.0f;
+        float start = 1.0f;
+        float end = 1.0f;
     };
+    ReturnLevel reverbReturn;
+    ReturnLevel delayReturn;
 
     std::array<ChannelProcessors, NUM_CHANNELS> channelProcessors;
+    MeteringService meteringService;
+    std::atomic<bool> meteringEnabled{true};
+    MixAnalyzer mixAnalyzer;
 
     juce::dsp::Reverb reverb;
     juce::dsp::DelayLine<float> delayLineLeft{INIConfig::Defaults::MAX_DELAY_SAMPLES};
     juce::dsp::DelayLine<float> delayLineRight{INIConfig::Defaults::MAX_DELAY_SAMPLES};
     juce::dsp::Compressor<float> compressor;
-    juce::dsp::Limiter<float> limiter;
+    TruePeakLimiter limiter;
 
     juce::dsp::StateVariableTPTFilter<float> reverbHighCut;
     juce::dsp::StateVariableTPTFilter<float> reverbLowCut;
     juce::dsp::StateVariableTPTFilter<float> delayHighCut;
     juce::dsp::StateVariableTPTFilter<float> delayLowCut;
 
+    SmoothedFrequency reverbHighCutSmoothed;
+    SmoothedFrequency reverbLowCutSmoothed;
+    SmoothedFrequency delayHighCutSmoothed;
+    SmoothedFrequency delayLowCutSmoothed;
+    juce::LinearSmoothedValue<float> compressorThresholdSmoothed;
+    juce::LinearSmoothedValue<float> compressorMakeupSmoothed;
+    juce::LinearSmoothedValue<float> masterVolumeSmoothed;
+
+    // Last state generation picked up by the audio thread
+    juce::uint32 appliedMasterGeneration = GENERATION_NOT_APPLIED;
+    juce::uint32 appliedReverbGeneration = GENERATION_NOT_APPLIED;
+    juce::uint32 appliedDelayGeneration = GENERATION_NOT_APPLIED;
+    juce::uint32 appliedCompressorGeneration = GENERATION_NOT_APPLIED;
+    juce::uint32 appliedDistortionGeneration = GENERATION_NOT_APPLIED;
+
     juce::AudioBuffer<float> sendBuffer;
     juce::AudioBuffer<float> reverbBuffer;
     juce::AudioBuffer<float> delayBuffer;
@@ -327,11 +532,25 @@ private:
     void updateMetering(int channel, const juce::AudioBuffer<float>& buffer);
     void updateMasterMetering(const juce::AudioBuffer<float>& buffer);
 
-    float applyDistortion(float input, DistortionState::Mode mode, float drive);
+    void syncSnapshot(int numSamples);
+    void updateReturnLevel(ReturnLevel& level, bool enabled, float position);
+    float applyDistortion(float input, DistortionState::Mode mode, float drive, int bitDepth);
     void updateEQCoefficients(int channel);
+    void processChannelEQ(int channel, juce::dsp::AudioBlock<float>& block);
+    void processCutFilters(juce::dsp::AudioBlock<float>& block,
+                           juce::dsp::StateVariableTPTFilter<float>& lowCut,
+                           juce::dsp::StateVariableTPTFilter<float>& highCut,
+                           SmoothedFrequency& lowCutFrequency,
+                           SmoothedFrequency& highCutFrequency);
     void updateDelayTime();
 
     bool anySolo() const;
+    void storeSnapshot(const Snapshot& snapshot);
+
+    template <typename State>
+    static void markChanged(State& state) {
+        state.generation.fetch_add(1, std::memory_order_release);
+    }
 
     void loadDefaultPresets();
 
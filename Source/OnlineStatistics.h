@@ -0,0 +1,155 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <cmath>
+
+// Estimators that take one value at a time in constant time and memory, so statistics
+// over a live performance can be kept up to date without holding on to its events.
+
+// Count, mean and variance by Welford's method, which stays accurate over long runs
+// where summing squares would not.
+class RunningStatistics {
+public:
+    void add(double value) noexcept {
+        ++count;
+        const double delta = value - mean;
+        mean += delta / static_cast<double>(count);
+        squaredDeviations += delta * (value - mean);
+        minimum = count == 1 ? value : juce::jmin(minimum, value);
+        maximum = count == 1 ? value : juce::jmax(maximum, value);
+    }
+
+    void reset() noexcept { *this = {}; }
+
+    juce::int64 getCount() const noexcept { return count; }
+    bool isEmpty() const noexcept { return count == 0; }
+    double getMean() const noexcept { return mean; }
+    // Of the values seen, not an estimate of a wider population
+    double getVariance() const noexcept { return count > 0 ? squaredDeviations / static_cast<double>(count) : 0.0; }
+    double getStandardDeviation() const noexcept { return std::sqrt(getVariance()); }
+    double getMinimum() const noexcept { return minimum; }
+    double getMaximum() const noexcept { return maximum; }
+
+private:
+    juce::int64 count = 0;
+    double mean = 0.0;
+    double squaredDeviations = 0.0;
+    double minimum = 0.0;
+    double maximum = 0.0;
+};
+
+// Exponentially weighted moving average; each value moves it by alpha of the way. The
+// first value is taken as it is, so it does not start out pulled towards zero.
+class ExponentialAverage {
+public:
+    explicit ExponentialAverage(double smoothing = 0.1) noexcept : alpha(juce::jlimit(0.0, 1.0, smoothing)) {}
+
+    void add(double value) noexcept {
+        average = hasValue ? average + alpha * (value - average) : value;
+        hasValue = true;
+    }
+
+    void reset() noexcept { average = 0.0; hasValue = false; }
+
+    bool isEmpty() const noexcept { return !hasValue; }
+    double getValue(double fallback = 0.0) const noexcept { return hasValue ? average : fallback; }
+
+private:
+    double alpha;
+    double average = 0.0;
+    bool hasValue = false;
+};
+
+// Counts over NumBins equal bins of [low, high); values outside land in the end bins.
+template <int NumBins>
+class FixedHistogram {
+public:
+    static_assert(NumBins > 0, "A histogram needs at least one bin");
+
+    FixedHistogram(double lowest = 0.0, double highest = static_cast<double>(NumBins)) noexcept
+        : low(lowest), binWidth((highest - lowest) / NumBins) {}
+
+    // The bin's count before this value was added
+    int add(double value) noexcept {
+        ++total;
+        return bins[static_cast<size_t>(getBin(value))]++;
+    }
+
+    void reset() noexcept {
+        bins.fill(0);
+        total = 0;
+    }
+
+    int getBin(double value) const noexcept {
+        return juce::jlimit(0, NumBins - 1, static_cast<int>(std::floor((value - low) / binWidth)));
+    }
+
+    static constexpr int getNumBins() noexcept { return NumBins; }
+    int getCount(int bin) const noexcept { return bins[static_cast<size_t>(bin)]; }
+    int getTotal() const noexcept { return total; }
+    float getFraction(int bin) const noexcept { return total > 0 ? static_cast<float>(getCount(bin)) / static_cast<float>(total) : 0.0f; }
+    double getBinCentre(int bin) const noexcept { return low + (bin + 0.5) * binWidth; }
+
+    // Centre of the bin below which half the values fall
+    double getMedian() const noexcept {
+        int seen = 0;
+        for (int bin = 0; bin < NumBins; ++bin) {
+            seen += getCount(bin);
+            if (seen * 2 >= total && total > 0) return getBinCentre(bin);
+        }
+        return getBinCentre(NumBins / 2);
+    }
+
+private:
+    std::array<int, static_cast<size_t>(NumBins)> bins{};
+    int total = 0;
+    double low;
+    double binWidth;
+};
+
+// A uniform sample of at most Capacity of everything added, by reservoir sampling, so
+// the first items seen are not favoured over the last however long it runs.
+template <typename T, int Capacity>
+class ReservoirSample {
+public:
+    static_assert(Capacity > 0, "A reservoir needs room for at least one item");
+
+    explicit ReservoirSample(juce::int64 seed = 0) : random(seed) {}
+
+    // True if the item was kept
+    bool add(const T& item) {
+        ++numSeen;
+        if (size < Capacity) {
+            items[static_cast<size_t>(size++)] = item;
+            return true;
+        }
+
+        const auto slot = static_cast<juce::int64>(random.nextDouble() * static_cast<double>(numSeen));
+        if (slot >= Capacity) return false;
+
+        items[static_cast<size_t>(slot)] = item;
+        return true;
+    }
+
+    void reset() {
+        items = {};
+        size = 0;
+        numSeen = 0;
+    }
+
+    static constexpr int getCapacity() noexcept { return Capacity; }
+    int getSize() const noexcept { return size; }
+    bool isEmpty() const noexcept { return size == 0; }
+    juce::int64 getNumSeen() const noexcept { return numSeen; }
+    const T& operator[](int index) const noexcept { return items[static_cast<size_t>(index)]; }
+
+    const T* begin() const noexcept { return items.data(); }
+    const T* end() const noexcept { return items.data() + size; }
+
+private:
+    std::array<T, static_cast<size_t>(Capacity)> items{};
+    int size = 0;
+    juce::int64 numSeen = 0;
+    juce::Random random;
+};
@@ -0,0 +1,339 @@
+#include "PatternBank.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Records are written and mapped as they are laid out in memory
+static_assert(std::is_trivially_copyable_v<PatternBank::Note> && sizeof(PatternBank::Note) == 8);
+static_assert(std::is_trivially_copyable_v<PatternBank::Header> && sizeof(PatternBank::Header) % alignof(PatternBank::Header) == 0);
+
+namespace {
+    constexpr int numChannels = 16;
+
+    bool isCurrent(const PatternBank::Header& header, const juce::File& file, juce::int64 size, juce::Time modified) {
+        if (header.size != size) return false;
+
+        return header.modified == modified.toMilliseconds()
+            || (header.hash != 0 && header.hash == MidiLibraryCatalog::getContentHash(file));
+    }
+
+    // Byte order of the UTF-8 paths, the order the bank is sorted in
+    int comparePaths(const char* a, size_t aLength, const char* b, size_t bLength) {
+        const int result = std::memcmp(a, b, juce::jmin(aLength, bLength));
+        if (result != 0) return result;
+        return aLength < bLength ? -1 : (aLength > bLength ? 1 : 0);
+    }
+
+    struct CompiledPattern {
+        std::string path;
+        PatternBank::Header header;
+        juce::Array<PatternBank::Note> ownNotes;
+        // ownNotes, or notes still mapped from the previous bank
+        const PatternBank::Note* notes = nullptr;
+    };
+}
+
+double PatternBank::Pattern::getLengthBeats() const {
+    return header != nullptr ? static_cast<double>(header->lengthTicks) / ticksPerBeat : 0.0;
+}
+
+bool PatternBank::open(const juce::File& bankFile, const juce::File& libraryRoot) {
+    close();
+
+    auto mapped = std::make_unique<juce::MemoryMappedFile>(bankFile, juce::MemoryMappedFile::readOnly);
+    const auto* data = static_cast<const char*>(mapped->getData());
+    const auto size = mapped->getSize();
+    if (data == nullptr || size < sizeof(FileHeader)) return false;
+
+    FileHeader fileHeader;
+    std::memcpy(&fileHeader, data, sizeof(fileHeader));
+
+    if (fileHeader.magic != INIConfig::MIDI::PATTERN_BANK_MAGIC
+        || fileHeader.version != INIConfig::MIDI::PATTERN_BANK_VERSION
+        || fileHeader.ticksPerBeat != static_cast<juce::uint32>(ticksPerBeat)) {
+        DBG("PatternBank: " + bankFile.getFullPathName() + " is not a current pattern bank");
+        return false;
+    }
+
+    // In 64 bits, so counts from a damaged file cannot wrap around to a plausible size
+    const auto headerBytes = static_cast<juce::uint64>(fileHeader.numPatterns) * sizeof(Header);
+    const auto noteBytes = static_cast<juce::uint64>(fileHeader.numNotes) * sizeof(Note);
+    if (sizeof(FileHeader) + headerBytes + noteBytes + fileHeader.pathBytes != size) {
+        DBG("PatternBank: " + bankFile.getFullPathName() + " is damaged");
+        return false;
+    }
+
+    const auto* bankHeaders = reinterpret_cast<const Header*>(data + sizeof(FileHeader));
+    const auto* bankPaths = data + sizeof(FileHeader) + headerBytes + noteBytes;
+
+    // Checked once here so views never have to
+    for (juce::uint32 i = 0; i < fileHeader.numPatterns; ++i) {
+        const auto& header = bankHeaders[i];
+        const bool notesInside = static_cast<juce::uint64>(header.firstNote) + header.numNotes <= fileHeader.numNotes;
+        const bool pathInside = static_cast<juce::uint64>(header.pathOffset) + header.pathLength < fileHeader.pathBytes;
+
+        if (!notesInside || !pathInside || bankPaths[header.pathOffset + header.pathLength] != '\0') {
+            DBG("PatternBank: " + bankFile.getFullPathName() + " is damaged");
+            return false;
+        }
+    }
+
+    mappedFile = std::move(mapped);
+    root = libraryRoot;
+    numPatterns = static_cast<int>(fileHeader.numPatterns);
+    headers = bankHeaders;
+    notes = reinterpret_cast<const Note*>(data + sizeof(FileHeader) + headerBytes);
+    paths = bankPaths;
+    return true;
+}
+
+void PatternBank::close() {
+    mappedFile.reset();
+    root = juce::File();
+    numPatterns = 0;
+    headers = nullptr;
+    notes = nullptr;
+    paths = nullptr;
+}
+
+PatternBank::Pattern PatternBank::getPattern(int index) const {
+    if (!juce::isPositiveAndBelow(index, numPatterns)) return {};
+
+    const auto* header = headers + index;
+    return { header, notes + header->firstNote };
+}
+
+juce::String PatternBank::getPath(int index) const {
+    if (!juce::isPositiveAndBelow(index, numPatterns)) return {};
+
+    const auto& header = headers[index];
+    const auto path = juce::String::fromUTF8(paths + header.pathOffset, static_cast<int>(header.pathLength));
+    return MidiLibraryCatalog::resolvePortablePath(path, root).getFullPathName();
+}
+
+int PatternBank::indexOf(const juce::File& file) const {
+    const auto path = MidiLibraryCatalog::getPortablePath(file, root);
+    const char* key = path.toRawUTF8();
+    const size_t keyLength = std::strlen(key);
+
+    const auto* end = headers + numPatterns;
+    const auto* found = std::lower_bound(headers, end, key, [this, keyLength](const Header& header, const char* target) {
+        return comparePaths(paths + header.pathOffset, header.pathLength, target, keyLength) < 0;
+    });
+
+    if (found == end || comparePaths(paths + found->pathOffset, found->pathLength, key, keyLength) != 0) return -1;
+    return static_cast<int>(found - headers);
+}
+
+PatternBank::Pattern PatternBank::find(const juce::File& file) const {
+    const auto pattern = getPattern(indexOf(file));
+    if (!pattern.isValid() || !isCurrent(*pattern.header, file, file.getSize(), file.getLastModificationTime())) return {};
+
+    return pattern;
+}
+
+bool PatternBank::compile(const juce::File& bankFile,
+                          const juce::Array<MidiLibraryCatalog::Entry>& entries,
+                          MidiAnalysisCache& analyses,
+                          const PatternBank* previous,
+                          const juce::File& libraryRoot,
+                          const MidiAnalysisCache::ProgressCallback& progress) {
+    std::vector<CompiledPattern> patterns;
+    patterns.reserve(static_cast<size_t>(entries.size()));
+
+    for (int i = 0; i < entries.size(); ++i) {
+        if (progress != nullptr && !progress(i, entries.size())) return false;
+
+        const auto& entry = entries.getReference(i);
+        CompiledPattern compiled;
+        compiled.path = MidiLibraryCatalog::getPortablePath(entry.file, libraryRoot).toStdString();
+
+        const auto kept = previous != nullptr ? previous->getPattern(previous->indexOf(entry.file)) : Pattern();
+        if (kept.isValid() && isCurrent(*kept.header, entry.file, entry.size, entry.modified)) {
+            // Under this copy's time, so it is matched without being read from now on
+            compiled.header = *kept.header;
+            compiled.header.modified = entry.modified.toMilliseconds();
+            compiled.notes = kept.notes;
+            patterns.push_back(std::move(compiled));
+            continue;
+        }
+
+        auto& header = compiled.header;
+        if (!readNotes(entry.file, compiled.ownNotes, header)) {
+            DBG("PatternBank: Could not read " + entry.file.getFullPathName());
+            continue;
+        }
+
+        const auto analysis = analyses.getAnalysis(entry);
+        header.size = entry.size;
+        header.modified = entry.modified.toMilliseconds();
+        header.numNotes = static_cast<juce::uint32>(compiled.ownNotes.size());
+        header.timeSignatureNumerator = static_cast<juce::uint8>(juce::jlimit(1, INIConfig::MIDI::MAX_METER_NUMERATOR, analysis.timeSignatureNumerator));
+        header.timeSignatureDenominator = static_cast<juce::uint8>(juce::jlimit(1, INIConfig::MIDI::MAX_METER_DENOMINATOR, analysis.timeSignatureDenominator));
+        header.tempo = analysis.tempo;
+        GrooveSimilarityIndex::getFeatures(analysis, header.features);
+
+        compiled.notes = compiled.ownNotes.getRawDataPointer();
+        patterns.push_back(std::move(compiled));
+    }
+
+    if (progress != nullptr && !progress(entries.size(), entries.size())) return false;
+
+    std::sort(patterns.begin(), patterns.end(), [](const CompiledPattern& a, const CompiledPattern& b) {
+        return comparePaths(a.path.data(), a.path.size(), b.path.data(), b.path.size()) < 0;
+    });
+
+    FileHeader fileHeader;
+    fileHeader.magic = INIConfig::MIDI::PATTERN_BANK_MAGIC;
+    fileHeader.version = INIConfig::MIDI::PATTERN_BANK_VERSION;
+    fileHeader.numPatterns = static_cast<juce::uint32>(patterns.size());
+    fileHeader.ticksPerBeat = static_cast<juce::uint32>(ticksPerBeat);
+
+    juce::uint64 numNotes = 0;
+    juce::uint64 pathBytes = 0;
+    for (auto& compiled : patterns) {
+        compiled.header.firstNote = static_cast<juce::uint32>(numNotes);
+        compiled.header.pathOffset = static_cast<juce::uint32>(pathBytes);
+        compiled.header.pathLength = static_cast<juce::uint32>(compiled.path.size());
+        numNotes += compiled.header.numNotes;
+        pathBytes += compiled.path.size() + 1;
+    }
+
+    if (numNotes > std::numeric_limits<juce::uint32>::max() || pathBytes > std::numeric_limits<juce::uint32>::max()) {
+        DBG("PatternBank: Library too large for one bank");
+        return false;
+    }
+    fileHeader.numNotes = static_cast<juce::uint32>(numNotes);
+    fileHeader.pathBytes = static_cast<juce::uint32>(pathBytes);
+
+    if (bankFile.getParentDirectory().createDirectory().failed()) {
+        DBG("PatternBank: Could not create " + bankFile.getParentDirectory().getFullPathName());
+        return false;
+    }
+
+    // Moved over the bank once complete, so a bank that is still mapped keeps its old
+    // contents; where a mapped file cannot be replaced, the old bank stays in use
+    juce::TemporaryFile temporary(bankFile);
+    {
+        juce::FileOutputStream stream(temporary.getFile());
+        if (!stream.openedOk()) return false;
+
+        stream.write(&fileHeader, sizeof(fileHeader));
+        for (const auto& compiled : patterns) {
+            stream.write(&compiled.header, sizeof(Header));
+        }
+        for (const auto& compiled : patterns) {
+            stream.write(compiled.notes, compiled.header.numNotes * sizeof(Note));
+        }
+        for (const auto& compiled : patterns) {
+            stream.write(compiled.path.c_str(), compiled.path.size() + 1);
+        }
+
+        stream.flush();
+        if (stream.getStatus().failed()) return false;
+    }
+
+    return temporary.overwriteTargetFileWithTemporary();
+}
+
+bool PatternBank::readNotes(const juce::File& file, juce::Array<Note>& notes, Header& header) {
+    notes.clearQuick();
+    header.lengthTicks = 0;
+    header.channel = 1;
+    header.complete = 1;
+
+    juce::MemoryBlock data;
+    if (!file.loadFileAsData(data)) return false;
+    header.hash = MidiLibraryCatalog::getContentHash(data.getData(), data.getSize());
+
+    juce::MemoryInputStream stream(data, false);
+    juce::MidiFile midiFile;
+    if (!midiFile.readFrom(stream)) return false;
+
+    // SMPTE-timed files have no beats to put notes on
+    const int fileTicksPerBeat = midiFile.getTimeFormat();
+    if (fileTicksPerBeat <= 0) return false;
+
+    const double scale = static_cast<double>(ticksPerBeat) / fileTicksPerBeat;
+    auto toTicks = [scale](double timeStamp) {
+        const double ticks = std::round(timeStamp * scale);
+        return static_cast<juce::uint32>(juce::jlimit(0.0, static_cast<double>(std::numeric_limits<juce::uint32>::max()), ticks));
+    };
+
+    const auto lengthTicks = toTicks(midiFile.getLastTimestamp());
+    header.lengthTicks = lengthTicks;
+    int channel = 0;
+
+    // Note-ons waiting for their note-off, oldest first for each channel and note, as a
+    // linked list through the notes themselves
+    std::array<int, numChannels * INIConfig::MIDI::NUM_NOTE_NUMBERS> firstOpen;
+    std::array<int, numChannels * INIConfig::MIDI::NUM_NOTE_NUMBERS> lastOpen;
+    std::vector<int> nextOpen;
+
+    auto setDuration = [&notes](int index, juce::uint32 endTick) {
+        auto& note = notes.getReference(index);
+        const auto duration = endTick > note.tick ? endTick - note.tick : 1u;
+        note.duration = static_cast<juce::uint16>(juce::jmin(duration, static_cast<juce::uint32>(std::numeric_limits<juce::uint16>::max())));
+    };
+
+    for (int t = 0; t < midiFile.getNumTracks(); ++t) {
+        firstOpen.fill(-1);
+        lastOpen.fill(-1);
+
+        for (const auto* holder : *midiFile.getTrack(t)) {
+            const auto& message = holder->message;
+            const auto* raw = message.getRawData();
+
+            // Meta events and SysEx carry nothing to play, as when played from the file
+            if (message.getRawDataSize() < 1 || raw[0] < 0x80 || raw[0] >= 0xF0) continue;
+
+            if (channel == 0) channel = message.getChannel();
+            if (message.getChannel() != channel) header.complete = 0;
+
+            const bool noteOn = message.isNoteOn();
+            if (!noteOn && !message.isNoteOff()) {
+                header.complete = 0;
+                continue;
+            }
+
+            const int key = (message.getChannel() - 1) * INIConfig::MIDI::NUM_NOTE_NUMBERS + message.getNoteNumber();
+            const auto tick = toTicks(message.getTimeStamp());
+
+            if (noteOn) {
+                const int index = notes.size();
+                notes.add({ tick, 0, static_cast<juce::uint8>(message.getNoteNumber()), message.getVelocity() });
+                nextOpen.push_back(-1);
+
+                if (lastOpen[key] >= 0)
+                    nextOpen[static_cast<size_t>(lastOpen[key])] = index;
+                else
+                    firstOpen[key] = index;
+                lastOpen[key] = index;
+            } else if (firstOpen[key] >= 0) {
+                const int index = firstOpen[key];
+                setDuration(index, tick);
+
+                firstOpen[key] = nextOpen[static_cast<size_t>(index)];
+                if (firstOpen[key] < 0) lastOpen[key] = -1;
+            }
+        }
+
+        // Never let go of: held to the end of the pattern
+        for (int key = 0; key < static_cast<int>(firstOpen.size()); ++key) {
+            for (int index = firstOpen[key]; index >= 0; index = nextOpen[static_cast<size_t>(index)]) {
+                setDuration(index, lengthTicks);
+            }
+        }
+    }
+
+    if (channel > 0) header.channel = static_cast<juce::uint8>(channel);
+
+    // Tracks were read one after another
+    std::stable_sort(notes.begin(), notes.end(), [](const Note& a, const Note& b) { return a.tick < b.tick; });
+    return true;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <memory>
+#include "INIConfig.h"
+#include "GrooveSimilarityIndex.h"
+#include "MidiAnalysisCache.h"
+#include "MidiLibraryCatalog.h"
+
+// The MIDI library compiled into one file of flat note records that is mapped into
+// memory rather than read. Each pattern is a header, with its length, meter and groove
+// features, and a run of notes whose note-ons and note-offs were paired when the bank
+// was compiled, all at one tick resolution. Patterns are sorted by path, so finding one
+// is a binary search over the mapped headers and getting at its notes is pointer
+// arithmetic; nothing is parsed or allocated. Only notes on one channel are kept, which
+// is all most grooves hold; a pattern with controllers, pitch bend or notes on several
+// channels is marked incomplete and played from its file. Release velocities are not
+// kept. Paths inside the library root are kept relative to it, so a bank
+// compiled offline by the batch analyzer can ship with the library. Read-only once
+// open, so one bank can be shared between threads.
+class PatternBank {
+public:
+    struct Note {
+        juce::uint32 tick = 0;
+        juce::uint16 duration = 0;
+        juce::uint8 note = 0;
+        juce::uint8 velocity = 0;
+    };
+
+    struct Header {
+        // The file as it was compiled; a file that differs now is not served. One whose
+        // modification time alone differs, as after an installer, is told by its contents.
+        juce::int64 size = 0;
+        juce::int64 modified = 0;
+        juce::uint64 hash = 0;
+        juce::uint32 pathOffset = 0;
+        juce::uint32 pathLength = 0;
+        juce::uint32 firstNote = 0;
+        juce::uint32 numNotes = 0;
+        juce::uint32 lengthTicks = 0;
+        juce::uint8 timeSignatureNumerator = 0;
+        juce::uint8 timeSignatureDenominator = 0;
+        // The channel the notes are on, from 1 to 16, if the pattern is complete
+        juce::uint8 channel = 0;
+        // 1 where the notes are everything the file plays
+        juce::uint8 complete = 0;
+        float tempo = 0.0f;
+        float features[GrooveSimilarityIndex::numFeatures] = {};
+    };
+
+    // A view into the mapped file, valid while the bank is open
+    struct Pattern {
+        const Header* header = nullptr;
+        const Note* notes = nullptr;
+
+        bool isValid() const { return header != nullptr; }
+        int getNumNotes() const { return header != nullptr ? static_cast<int>(header->numNotes) : 0; }
+        // False where the pattern has to be played from its file
+        bool isComplete() const { return header != nullptr && header->complete != 0; }
+        double getLengthBeats() const;
+    };
+
+    static constexpr int ticksPerBeat = INIConfig::MIDI::PATTERN_BANK_TICKS_PER_BEAT;
+
+    PatternBank() = default;
+
+    // libraryRoot must be the one the bank was compiled with
+    bool open(const juce::File& bankFile, const juce::File& libraryRoot = {});
+    void close();
+    bool isOpen() const { return mappedFile != nullptr; }
+
+    int getNumPatterns() const { return numPatterns; }
+    Pattern getPattern(int index) const;
+    juce::String getPath(int index) const;
+    // Invalid if the file is not in the bank or has changed since it was compiled
+    Pattern find(const juce::File& file) const;
+    int indexOf(const juce::File& file) const;
+
+    // Writes a bank of every entry, analyzing any the cache does not have yet. Patterns
+    // still current in previous are copied from it instead of being read again. Returning
+    // false from progress cancels, and nothing is written.
+    static bool compile(const juce::File& bankFile,
+                        const juce::Array<MidiLibraryCatalog::Entry>& entries,
+                        MidiAnalysisCache& analyses,
+                        const PatternBank* previous = nullptr,
+                        const juce::File& libraryRoot = {},
+                        const MidiAnalysisCache::ProgressCallback& progress = nullptr);
+
+    // Notes of a MIDI file at the bank's resolution, along with the header's length,
+    // channel, completeness and hash; false if it cannot be read
+    static bool readNotes(const juce::File& file, juce::Array<Note>& notes, Header& header);
+
+private:
+    struct FileHeader {
+        juce::uint32 magic = 0;
+        juce::uint32 version = 0;
+        juce::uint32 numPatterns = 0;
+        juce::uint32 numNotes = 0;
+        juce::uint32 pathBytes = 0;
+        juce::uint32 ticksPerBeat = 0;
+    };
+
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    juce::File root;
+    int numPatterns = 0;
+    const Header* headers = nullptr;
+    const Note* notes = nullptr;
+    const char* paths = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PatternBank)
+};
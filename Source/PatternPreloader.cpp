@@ -0,0 +1,224 @@
+#include "PatternPreloader.h"
+#include <utility>
+
+PatternPreloader::PatternPreloader(InUseCallback callback, int capacity)
+    : juce::Thread("OTTO Pattern Preloader"), isInUse(std::move(callback)) {
+    slots.resize(static_cast<size_t>(juce::jmax(1, capacity)));
+}
+
+PatternPreloader::~PatternPreloader() {
+    signalThreadShouldExit();
+    notify();
+    stopThread(INIConfig::LayoutConstants::patternPreloaderThreadStopTimeoutMs);
+}
+
+void PatternPreloader::setPatternBank(std::shared_ptr<const PatternBank> bank) {
+    const juce::ScopedLock scoped(lock);
+    patternBank = std::move(bank);
+}
+
+void PatternPreloader::setBarBeats(double barBeats) {
+    {
+        const juce::ScopedLock scoped(lock);
+        if (barBeats == currentBarBeats) return;
+
+        // Everything loaded so far loops on the old bar length and is loaded again
+        currentBarBeats = barBeats;
+        nextWanted = 0;
+    }
+    notify();
+}
+
+void PatternPreloader::prefetch(const juce::Array<juce::File>& files) {
+    {
+        const juce::ScopedLock scoped(lock);
+
+        wantedFiles.clearQuick();
+        for (const auto& file : files) {
+            if (file.existsAsFile()) wantedFiles.addIfNotAlreadyThere(file);
+        }
+        nextWanted = 0;
+
+        for (auto& slot : slots) {
+            slot.wanted = false;
+        }
+        for (const auto& file : wantedFiles) {
+            const auto indexed = slotIndex.find(file.getFullPathName());
+            if (indexed != slotIndex.end()) {
+                slots[static_cast<size_t>(indexed->second)].wanted = true;
+            }
+        }
+    }
+
+    if (!isThreadRunning()) {
+        startThread();
+    }
+    notify();
+}
+
+const SongArranger::Section* PatternPreloader::getPattern(const juce::File& file) {
+    const auto path = file.getFullPathName();
+    const auto modified = file.getLastModificationTime();
+
+    std::shared_ptr<const PatternBank> bank;
+    double barBeats = 0.0;
+    {
+        const juce::ScopedLock scoped(lock);
+
+        const int index = findLoaded(path);
+        if (index >= 0 && slots[static_cast<size_t>(index)].modified == modified) {
+            auto& slot = slots[static_cast<size_t>(index)];
+            slot.lastUsed = ++useCounter;
+            slot.wanted = true;
+            return slot.section.get();
+        }
+
+        bank = patternBank;
+        barBeats = currentBarBeats;
+    }
+
+    auto section = std::make_unique<SongArranger::Section>();
+    SongArranger::compilePattern(*section, file, barBeats, bank.get());
+
+    const juce::ScopedLock scoped(lock);
+    return store(file, modified, barBeats, section, true);
+}
+
+bool PatternPreloader::isLoaded(const juce::File& file) const {
+    const juce::ScopedLock scoped(lock);
+    return findLoaded(file.getFullPathName()) >= 0;
+}
+
+int PatternPreloader::getNumLoaded() const {
+    const juce::ScopedLock scoped(lock);
+
+    int numLoaded = 0;
+    for (const auto& [path, index] : slotIndex) {
+        if (findLoaded(path) >= 0) ++numLoaded;
+    }
+    return numLoaded;
+}
+
+void PatternPreloader::run() {
+    // Flattened into here and swapped into the pool, which hands back the Section it replaced
+    std::unique_ptr<SongArranger::Section> section;
+
+    while (!threadShouldExit()) {
+        juce::File file;
+        std::shared_ptr<const PatternBank> bank;
+        double barBeats = 0.0;
+        {
+            const juce::ScopedLock scoped(lock);
+            if (takeNextWanted(file)) {
+                bank = patternBank;
+                barBeats = currentBarBeats;
+            }
+        }
+
+        if (file.getFullPathName().isEmpty()) {
+            wait(-1);
+            continue;
+        }
+
+        const auto modified = file.getLastModificationTime();
+        if (section == nullptr) {
+            section = std::make_unique<SongArranger::Section>();
+        }
+        SongArranger::compilePattern(*section, file, barBeats, bank.get());
+
+        const juce::ScopedLock scoped(lock);
+
+        // Every Section is wanted more or still playing; the rest waits for the next prefetch
+        if (store(file, modified, barBeats, section, false) == nullptr) {
+            nextWanted = wantedFiles.size();
+        }
+    }
+}
+
+int PatternPreloader::findLoaded(const juce::String& path) const {
+    const auto indexed = slotIndex.find(path);
+    if (indexed == slotIndex.end()) return -1;
+
+    return slots[static_cast<size_t>(indexed->second)].barBeats == currentBarBeats ? indexed->second : -1;
+}
+
+bool PatternPreloader::takeNextWanted(juce::File& file) {
+    while (nextWanted < wantedFiles.size()) {
+        const auto& next = wantedFiles.getReference(nextWanted++);
+        if (findLoaded(next.getFullPathName()) < 0) {
+            file = next;
+            return true;
+        }
+    }
+    return false;
+}
+
+const SongArranger::Section* PatternPreloader::store(const juce::File& file, juce::Time modified, double barBeats,
+                                                     std::unique_ptr<SongArranger::Section>& section, bool mayReuseWanted) {
+    const auto path = file.getFullPathName();
+    const auto existing = slotIndex.find(path);
+    const int previous = existing != slotIndex.end() ? existing->second : -1;
+
+    // Loaded by getPattern() meanwhile, and perhaps already handed out
+    if (!mayReuseWanted && previous >= 0 && findLoaded(path) == previous) {
+        return slots[static_cast<size_t>(previous)].section.get();
+    }
+
+    // An older copy of the same file is replaced in place unless the engine still reads it
+    int target = previous;
+    if (target < 0 || isPatternInUse(slots[static_cast<size_t>(target)].section.get())) {
+        target = findSlotToReuse(mayReuseWanted);
+    }
+    if (target < 0) return nullptr;
+
+    auto& slot = slots[static_cast<size_t>(target)];
+
+    if (previous >= 0 && previous != target) {
+        // Left to finish playing, then reused before anything else
+        auto& orphan = slots[static_cast<size_t>(previous)];
+        orphan.path = {};
+        orphan.wanted = false;
+        orphan.lastUsed = 0;
+    }
+
+    if (slot.path.isNotEmpty() && slot.path != path) {
+        slotIndex.erase(slot.path);
+    }
+
+    std::swap(slot.section, section);
+    slot.path = path;
+    slot.modified = modified;
+    slot.barBeats = barBeats;
+    slot.lastUsed = ++useCounter;
+    // One handed out is left alone by the loading thread until the engine has taken it in
+    slot.wanted = mayReuseWanted || wantedFiles.contains(file);
+    slotIndex[path] = target;
+    return slot.section.get();
+}
+
+int PatternPreloader::findSlotToReuse(bool mayReuseWanted) const {
+    int best = -1;
+
+    for (int i = 0; i < static_cast<int>(slots.size()); ++i) {
+        const auto& slot = slots[static_cast<size_t>(i)];
+        if (slot.section == nullptr) return i;
+        if (slot.wanted && !mayReuseWanted) continue;
+        if (isPatternInUse(slot.section.get())) continue;
+
+        // Unwanted before wanted, then least recently used
+        if (best < 0) {
+            best = i;
+            continue;
+        }
+
+        const auto& current = slots[static_cast<size_t>(best)];
+        if (current.wanted != slot.wanted ? current.wanted : slot.lastUsed < current.lastUsed) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+bool PatternPreloader::isPatternInUse(const SongArranger::Section* section) const {
+    return isInUse != nullptr && isInUse(section);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "INIConfig.h"
+#include "PatternBank.h"
+#include "SongArranger.h"
+
+// Beats-button patterns flattened ahead of time. A background thread works through the
+// files asked for by prefetch(), most wanted first, and flattens each into a Section
+// like a launched scene's pattern, so that selecting a button finds it already in
+// memory. The pool holds a fixed number of Sections and reuses the least recently used
+// one that is neither wanted nor still in use by the engine, which bounds its memory.
+class PatternPreloader : private juce::Thread {
+public:
+    // Any thread; true while the engine may still read the Section. Only reads atomics.
+    using InUseCallback = std::function<bool(const SongArranger::Section*)>;
+
+    explicit PatternPreloader(InUseCallback isInUse, int capacity = INIConfig::MIDI::PATTERN_PRELOAD_CAPACITY);
+    ~PatternPreloader() override;
+
+    // Message thread. Patterns are looped on whole bars of barBeats.
+    void setPatternBank(std::shared_ptr<const PatternBank> bank);
+    void setBarBeats(double barBeats);
+    // Replaces the files to load in the background, most wanted first
+    void prefetch(const juce::Array<juce::File>& files);
+    // Flattens the file on the calling thread if the background thread has not got to
+    // it yet; nullptr only if every Section is wanted or in use
+    const SongArranger::Section* getPattern(const juce::File& file);
+
+    bool isLoaded(const juce::File& file) const;
+    int getNumLoaded() const;
+    int getCapacity() const { return static_cast<int>(slots.size()); }
+
+private:
+    struct Slot {
+        std::unique_ptr<SongArranger::Section> section;
+        juce::String path;
+        juce::Time modified;
+        double barBeats = 0.0;
+        juce::uint64 lastUsed = 0;
+        // Asked for by prefetch(), or handed out by getPattern() since the last one
+        bool wanted = false;
+    };
+
+    void run() override;
+    // Index of the slot holding the file at the current bar length, or -1
+    int findLoaded(const juce::String& path) const;
+    bool takeNextWanted(juce::File& file);
+    // Swaps the flattened Section into a free or reusable slot; nullptr if there is none
+    const SongArranger::Section* store(const juce::File& file, juce::Time modified, double barBeats,
+                                       std::unique_ptr<SongArranger::Section>& section, bool mayReuseWanted);
+    int findSlotToReuse(bool mayReuseWanted) const;
+    bool isPatternInUse(const SongArranger::Section* section) const;
+
+    InUseCallback isInUse;
+
+    // Slots, the index and the wish list are shared with the loading thread
+    juce::CriticalSection lock;
+    std::vector<Slot> slots;
+    std::unordered_map<juce::String, int> slotIndex;
+    juce::Array<juce::File> wantedFiles;
+    int nextWanted = 0;
+    juce::uint64 useCounter = 0;
+    std::shared_ptr<const PatternBank> patternBank;
+    double currentBarBeats = INIConfig::Defaults::BEATS_PER_BAR;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PatternPreloader)
+};
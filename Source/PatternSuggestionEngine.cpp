@@ -2,6 +2,10 @@
 #include "ErrorHandling.h"
 #include "INIConfig.h"
 #include "PerformanceOptimizations.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
 
 PatternSuggestionEngine::PatternSuggestionEngine() {
     try {
@@ -17,6 +21,11 @@ PatternSuggestionEngine::PatternSuggestionEngine() {
     }
 }
 
+PatternSuggestionEngine::~PatternSuggestionEngine() {
+    // Before the pool its workers run on goes
+    cancelBatch();
+}
+
 void PatternSuggestionEngine::initializeGenreProfiles() noexcept {
     GenreProfile rock;
     rock.genre = Genre::Rock;
@@ -226,6 +235,458 @@ PatternSuggestionEngine::generatePattern(const SuggestionParams& params) noexcep
     }
 }
 
+// One batch. Workers claim candidates through nextIndex, each writes only the slot it
+// claimed, and the indices of finished slots are handed to the thread running the batch
+// under the lock.
+struct PatternSuggestionEngine::Batch {
+    std::vector<Variation> variations;
+    juce::int64 seed = 0;
+    std::vector<Candidate> candidates;
+    std::atomic<int> nextIndex{0};
+    std::atomic<bool> cancelled{false};
+    juce::CriticalSection lock;
+    juce::Array<int> finished;
+    juce::WaitableEvent candidateDone;
+};
+
+class PatternSuggestionEngine::GenerationJob : public juce::ThreadPoolJob {
+public:
+    explicit GenerationJob(Batch& batchToRun) : juce::ThreadPoolJob("Pattern Generation"), batch(batchToRun) {}
+
+    JobStatus runJob() override {
+        const int numCandidates = static_cast<int>(batch.candidates.size());
+
+        while (!shouldExit() && !batch.cancelled.load()) {
+            const int index = batch.nextIndex.fetch_add(1);
+            if (index >= numCandidates) break;
+
+            // A candidate that fails is still reported, with no index, so the batch can finish
+            try {
+                const auto& variation = batch.variations[static_cast<size_t>(index) % batch.variations.size()];
+                batch.candidates[static_cast<size_t>(index)] = makeCandidate(variation, index, getCandidateSeed(batch.seed, index));
+            } catch (...) {
+            }
+
+            {
+                const juce::ScopedLock scoped(batch.lock);
+                batch.finished.add(index);
+            }
+            batch.candidateDone.signal();
+        }
+        return jobHasFinished;
+    }
+
+private:
+    Batch& batch;
+};
+
+std::unique_ptr<PatternSuggestionEngine::Batch> PatternSuggestionEngine::prepareBatch(const BatchRequest& request) const {
+    auto batch = std::make_unique<Batch>();
+    batch->seed = request.seed;
+    for (const auto& params : request.variations) {
+        batch->variations.push_back(prepareVariation(params));
+    }
+    if (batch->variations.empty()) {
+        batch->variations.push_back(prepareVariation(SuggestionParams()));
+    }
+    if (request.hasTarget) {
+        for (auto& variation : batch->variations) {
+            variation.target = request.target;
+        }
+    }
+    batch->candidates.resize(static_cast<size_t>(
+        juce::jlimit(0, INIConfig::MIDI::PATTERN_BATCH_MAX_CANDIDATES, request.numCandidates)));
+    return batch;
+}
+
+juce::Array<PatternSuggestionEngine::Candidate>
+PatternSuggestionEngine::runBatch(Batch& batch, juce::ThreadPool& workers, const CandidateCallback& onCandidate) {
+    juce::Array<Candidate> ranked;
+    const int numCandidates = static_cast<int>(batch.candidates.size());
+    if (numCandidates == 0) return ranked;
+
+    // The pool owns no jobs; every one is waited for before the batch goes out of scope
+    std::vector<std::unique_ptr<GenerationJob>> jobs;
+    for (int i = 0; i < juce::jmin(workers.getNumThreads(), numCandidates); ++i) {
+        jobs.push_back(std::make_unique<GenerationJob>(batch));
+        workers.addJob(jobs.back().get(), false);
+    }
+
+    // Streamed in the order they finish
+    juce::Array<int> finished;
+    int numFinished = 0;
+    while (numFinished < numCandidates && !batch.cancelled.load()) {
+        batch.candidateDone.wait(INIConfig::MIDI::PATTERN_BATCH_WAIT_MS);
+        {
+            const juce::ScopedLock scoped(batch.lock);
+            finished.swapWith(batch.finished);
+        }
+
+        for (const int index : finished) {
+            ++numFinished;
+
+            const auto& candidate = batch.candidates[static_cast<size_t>(index)];
+            if (candidate.index < 0 || onCandidate == nullptr || batch.cancelled.load()) continue;
+
+            if (!onCandidate(candidate)) {
+                batch.cancelled.store(true);
+            }
+        }
+        finished.clearQuick();
+    }
+
+    for (const auto& job : jobs) {
+        workers.waitForJobToFinish(job.get(), -1);
+    }
+
+    // Ties keep the order they were asked for in, so a batch always ranks the same way
+    for (auto& candidate : batch.candidates) {
+        if (candidate.index >= 0) {
+            ranked.add(std::move(candidate));
+        }
+    }
+    std::stable_sort(ranked.begin(), ranked.end(), [](const Candidate& a, const Candidate& b) {
+        return a.matchScore > b.matchScore;
+    });
+    return ranked;
+}
+
+juce::Array<PatternSuggestionEngine::Candidate>
+PatternSuggestionEngine::generateBatch(const BatchRequest& request, const CandidateCallback& onCandidate) noexcept {
+    clearError();
+
+    try {
+        auto batch = prepareBatch(request);
+        return runBatch(*batch, getPool(), onCandidate);
+
+    } catch (const std::exception& e) {
+        setError("Exception in generateBatch: " + juce::String(e.what()));
+        ErrorHandler::getInstance().reportError(ErrorHandler::ErrorLevel::Error,
+            "Batch pattern generation failed: " + juce::String(e.what()), "PatternSuggestionEngine");
+        return {};
+    } catch (...) {
+        setError("Unknown error in generateBatch");
+        ErrorHandler::getInstance().reportError(ErrorHandler::ErrorLevel::Error,
+            "Unknown error in batch pattern generation", "PatternSuggestionEngine");
+        return {};
+    }
+}
+
+// Runs one generateBatchAsync() call, so the message thread never waits on the workers
+class PatternSuggestionEngine::BatchThread : public juce::Thread {
+public:
+    BatchThread(PatternSuggestionEngine& engine, std::unique_ptr<Batch> batchToRun)
+        : juce::Thread("OTTO Pattern Batch"), owner(&engine), workers(engine.getPool()),
+          number(engine.batchNumber), batch(std::move(batchToRun)) {
+    }
+
+    ~BatchThread() override {
+        // The workers finish the candidate each is on, which never takes long, so this waits
+        // for them rather than leaving them with a batch that is gone
+        batch->cancelled.store(true);
+        stopThread(-1);
+    }
+
+    void run() override {
+        juce::Array<Candidate> ranked;
+        juce::String error;
+
+        try {
+            ranked = runBatch(*batch, workers, [this](const Candidate& candidate) {
+                juce::MessageManager::callAsync([engine = owner, number = number, candidate]() {
+                    if (auto* strongEngine = engine.get()) strongEngine->handleBatchCandidate(number, candidate);
+                });
+                return !threadShouldExit();
+            });
+        } catch (const std::exception& e) {
+            error = e.what();
+        } catch (...) {
+            error = "Unknown error";
+        }
+
+        if (threadShouldExit()) return;
+
+        juce::MessageManager::callAsync([engine = owner, number = number, ranked = std::move(ranked), error]() {
+            if (auto* strongEngine = engine.get()) strongEngine->handleBatchFinished(number, ranked, error);
+        });
+    }
+
+private:
+    juce::WeakReference<PatternSuggestionEngine> owner;
+    juce::ThreadPool& workers;
+    const int number;
+    std::unique_ptr<Batch> batch;
+};
+
+void PatternSuggestionEngine::generateBatchAsync(const BatchRequest& request, CandidateCallback onCandidate,
+                                                 BatchCallback onFinished) noexcept {
+    cancelBatch();
+    clearError();
+
+    try {
+        auto batch = prepareBatch(request);
+        onBatchCandidate = std::move(onCandidate);
+        onBatchFinished = std::move(onFinished);
+        batchThread = std::make_unique<BatchThread>(*this, std::move(batch));
+        batchThread->startThread();
+
+    } catch (const std::exception& e) {
+        cancelBatch();
+        setError("Exception in generateBatchAsync: " + juce::String(e.what()));
+        ErrorHandler::getInstance().reportError(ErrorHandler::ErrorLevel::Error,
+            "Batch pattern generation failed: " + juce::String(e.what()), "PatternSuggestionEngine");
+    } catch (...) {
+        cancelBatch();
+        setError("Unknown error in generateBatchAsync");
+        ErrorHandler::getInstance().reportError(ErrorHandler::ErrorLevel::Error,
+            "Unknown error in batch pattern generation", "PatternSuggestionEngine");
+    }
+}
+
+void PatternSuggestionEngine::cancelBatch() noexcept {
+    batchThread.reset();
+    ++batchNumber;
+    onBatchCandidate = nullptr;
+    onBatchFinished = nullptr;
+}
+
+void PatternSuggestionEngine::handleBatchCandidate(int number, const Candidate& candidate) {
+    if (number != batchNumber || onBatchCandidate == nullptr) return;
+
+    if (!onBatchCandidate(candidate)) {
+        cancelBatch();
+    }
+}
+
+void PatternSuggestionEngine::handleBatchFinished(int number, const juce::Array<Candidate>& ranked,
+                                                  const juce::String& error) {
+    if (number != batchNumber) return;
+
+    batchThread.reset();
+    ++batchNumber;
+    onBatchCandidate = nullptr;
+    const auto onFinished = std::move(onBatchFinished);
+    onBatchFinished = nullptr;
+
+    if (error.isNotEmpty()) {
+        setError("Exception in generateBatchAsync: " + error);
+        ErrorHandler::getInstance().reportError(ErrorHandler::ErrorLevel::Error,
+            "Batch pattern generation failed: " + error, "PatternSuggestionEngine");
+    }
+
+    if (onFinished) {
+        onFinished(ranked);
+    }
+}
+
+PatternSuggestionEngine::Candidate
+PatternSuggestionEngine::generateCandidate(const SuggestionParams& params, juce::int64 seed) const noexcept {
+    try {
+        return makeCandidate(prepareVariation(params), 0, seed);
+    } catch (...) {
+        setError("Unknown error in generateCandidate");
+        return {};
+    }
+}
+
+juce::int64 PatternSuggestionEngine::getCandidateSeed(juce::int64 batchSeed, int index) noexcept {
+    // SplitMix64, so that neighbouring candidates do not start from neighbouring seeds
+    auto z = static_cast<juce::uint64>(batchSeed) + 0x9E3779B97F4A7C15ull * static_cast<juce::uint64>(index + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return static_cast<juce::int64>(z ^ (z >> 31));
+}
+
+const PatternSuggestionEngine::GenreProfile& PatternSuggestionEngine::getProfile(Genre genre) const noexcept {
+    static const GenreProfile fallback{};
+
+    for (const auto& profile : genreProfiles) {
+        if (profile.genre == genre) return profile;
+    }
+    return genreProfiles.isEmpty() ? fallback : genreProfiles.getReference(0);
+}
+
+PatternSuggestionEngine::Variation PatternSuggestionEngine::prepareVariation(const SuggestionParams& params) const {
+    Variation variation;
+    variation.params = sanitizeParams(params);
+    variation.profile = getProfile(variation.params.genre);
+
+    const int stepsPerBar = variation.params.timeSignature * 4;
+    variation.kick = generateKickPattern(variation.params.genre, stepsPerBar);
+    variation.snare = generateSnarePattern(variation.params.genre, stepsPerBar);
+    variation.hiHat = generateHiHatPattern(variation.params.genre, stepsPerBar);
+
+    // The groove suggestPatterns() describes for these params
+    auto& target = variation.target;
+    target.averageSwing = variation.profile.avgSwing;
+    target.averageVelocity = variation.profile.avgVelocity;
+    target.grooveTightness = 1.0f - variation.params.humanization;
+    target.timingDeviation = (1.0f - target.grooveTightness) / 2.0f;
+    target.timeSignatureNumerator = variation.params.timeSignature;
+    target.timeSignatureDenominator = 4;
+    target.tempo = variation.params.tempo;
+    target.numberOfBars = variation.params.bars;
+    return variation;
+}
+
+PatternSuggestionEngine::Candidate PatternSuggestionEngine::makeCandidate(const Variation& variation, int index, juce::int64 seed) {
+    const auto& params = variation.params;
+    const auto& profile = variation.profile;
+    juce::Random random(seed);
+
+    Candidate candidate;
+    candidate.index = index;
+    candidate.seed = seed;
+    candidate.params = params;
+
+    const int ticksPerStep = PatternBank::ticksPerBeat / 4;
+    const int stepsPerBar = params.timeSignature * 4;
+    const float complexity = juce::jlimit(0.0f, 1.0f, params.complexity + random.nextFloat() * 0.4f - 0.2f);
+
+    // Straight at the swing base; above it the off-beat sixteenths come late, in steps
+    const float swingBase = INIConfig::LayoutConstants::midiFileManagerSwingBase;
+    const float swing = (profile.avgSwing - swingBase) / swingBase;
+
+    // Complexity adds ghost notes between the written hits and keeps off-beat hits from being dropped
+    struct Voice {
+        const juce::Array<float>& steps;
+        int note;
+        float level;
+        float ghostChance;
+        float ghostLevel;
+        int duration;
+    };
+    const Voice voices[] = {
+        { variation.kick, INIConfig::GMDrums::BASS_DRUM_1, 1.0f, 0.1f, 0.7f, ticksPerStep / 2 },
+        { variation.snare, INIConfig::GMDrums::ACOUSTIC_SNARE, 1.0f, 0.25f, 0.35f, ticksPerStep / 2 },
+        { variation.hiHat, INIConfig::GMDrums::CLOSED_HI_HAT, 0.8f, 0.3f, 0.5f, ticksPerStep / 4 },
+    };
+
+    auto& notes = candidate.notes;
+    notes.reserve(static_cast<size_t>(params.bars * stepsPerBar * 2));
+
+    for (int bar = 0; bar < params.bars; ++bar) {
+        for (int step = 0; step < stepsPerBar; ++step) {
+            for (const auto& voice : voices) {
+                float level = step < voice.steps.size() ? voice.steps[step] : 0.0f;
+
+                if (level <= 0.0f) {
+                    if (random.nextFloat() < complexity * voice.ghostChance) level = voice.ghostLevel;
+                } else if (step % 4 != 0 && random.nextFloat() < (1.0f - complexity) * 0.2f) {
+                    level = 0.0f;
+                }
+                if (level <= 0.0f) continue;
+
+                const float accent = 1.0f + 0.15f * params.humanization * (random.nextFloat() * 2.0f - 1.0f);
+                const int velocity = juce::jlimit(1, INIConfig::Validation::MAX_MIDI_VELOCITY,
+                                                  juce::roundToInt(level * voice.level * profile.avgVelocity * accent));
+
+                const float offset = (step % 2 == 1 ? swing : 0.0f)
+                                   + 0.25f * params.humanization * (random.nextFloat() * 2.0f - 1.0f);
+                const int tick = juce::jmax(0, (bar * stepsPerBar + step) * ticksPerStep + juce::roundToInt(offset * ticksPerStep));
+
+                notes.push_back({ static_cast<juce::uint32>(tick), static_cast<juce::uint16>(voice.duration),
+                                  static_cast<juce::uint8>(voice.note), static_cast<juce::uint8>(velocity) });
+            }
+        }
+    }
+
+    std::stable_sort(notes.begin(), notes.end(), [](const PatternBank::Note& a, const PatternBank::Note& b) {
+        return a.tick < b.tick;
+    });
+
+    // Analyzed straight from the notes, in the terms the similarity index compares
+    auto& analysis = candidate.analysis;
+    analysis = variation.target;
+    analysis.averageSwing = profile.avgSwing;
+    analysis.noteDensity = static_cast<float>(notes.size()) / static_cast<float>(params.bars * params.timeSignature);
+
+    std::array<int, INIConfig::MIDI::NUM_NOTE_NUMBERS> hitsPerNote{};
+    std::vector<float> stepOffsets(static_cast<size_t>(stepsPerBar), 0.0f);
+    std::vector<int> stepHits(static_cast<size_t>(stepsPerBar), 0);
+    float totalVelocity = 0.0f;
+    float totalSquaredVelocity = 0.0f;
+    float totalDeviation = 0.0f;
+    int minVelocity = INIConfig::Validation::MAX_MIDI_VELOCITY;
+    int maxVelocity = 0;
+
+    for (const auto& note : notes) {
+        const float velocity = static_cast<float>(note.velocity);
+        totalVelocity += velocity;
+        totalSquaredVelocity += velocity * velocity;
+        minVelocity = juce::jmin(minVelocity, static_cast<int>(note.velocity));
+        maxVelocity = juce::jmax(maxVelocity, static_cast<int>(note.velocity));
+        ++hitsPerNote[note.note];
+
+        // Offset from the nearest sixteenth, in steps
+        const float position = static_cast<float>(note.tick) / static_cast<float>(ticksPerStep);
+        const float nearest = std::round(position);
+        const auto step = static_cast<size_t>(static_cast<int>(nearest) % stepsPerBar);
+        stepOffsets[step] += position - nearest;
+        ++stepHits[step];
+        totalDeviation += std::abs(position - nearest);
+    }
+
+    if (!notes.empty()) {
+        const float numNotes = static_cast<float>(notes.size());
+        analysis.averageVelocity = totalVelocity / numNotes;
+        analysis.velocityRange = static_cast<float>(maxVelocity - minVelocity);
+        analysis.velocityVariation = std::sqrt(juce::jmax(0.0f, totalSquaredVelocity / numNotes
+                                                              - analysis.averageVelocity * analysis.averageVelocity));
+        analysis.timingDeviation = totalDeviation / numNotes;
+        analysis.grooveTightness = juce::jlimit(0.0f, 1.0f, 1.0f - 2.0f * analysis.timingDeviation);
+    }
+
+    analysis.microTiming.clearQuick();
+    for (size_t step = 0; step < stepOffsets.size(); ++step) {
+        analysis.microTiming.add(stepHits[step] > 0 ? stepOffsets[step] / static_cast<float>(stepHits[step]) : 0.0f);
+    }
+
+    analysis.noteDistribution.clearQuick();
+    for (const int hits : hitsPerNote) {
+        if (hits > 0) analysis.noteDistribution.add(hits);
+    }
+
+    candidate.matchScore = GrooveSimilarityIndex::getScore(analysis, variation.target);
+    return candidate;
+}
+
+juce::MidiMessageSequence PatternSuggestionEngine::Candidate::toSequence() const {
+    juce::MidiMessageSequence sequence;
+
+    for (const auto& note : notes) {
+        auto noteOn = juce::MidiMessage::noteOn(10, note.note, note.velocity);
+        noteOn.setTimeStamp(static_cast<double>(note.tick));
+        sequence.addEvent(noteOn);
+
+        auto noteOff = juce::MidiMessage::noteOff(10, note.note);
+        noteOff.setTimeStamp(static_cast<double>(note.tick + note.duration));
+        sequence.addEvent(noteOff);
+    }
+
+    sequence.updateMatchedPairs();
+    return sequence;
+}
+
+PatternSuggestionEngine::PatternSuggestion PatternSuggestionEngine::Candidate::toSuggestion() const {
+    PatternSuggestion suggestion;
+    suggestion.name = StringCache::getInstance().getPatternString(index + 1);
+    suggestion.pattern = toSequence();
+    suggestion.matchScore = matchScore;
+    suggestion.analysis = analysis;
+    return suggestion;
+}
+
+juce::ThreadPool& PatternSuggestionEngine::getPool() {
+    if (pool == nullptr) {
+        const int numThreads = juce::jlimit(1, INIConfig::MIDI::PATTERN_BATCH_MAX_THREADS, juce::SystemStats::getNumCpus());
+        pool = std::make_unique<juce::ThreadPool>(juce::ThreadPoolOptions{}
+                                                      .withThreadName("OTTO Pattern Generation")
+                                                      .withNumberOfThreads(numThreads));
+    }
+    return *pool;
+}
+
 juce::MidiMessageSequence PatternSuggestionEngine::generateDrumPattern(
     const GenreProfile& profile, int bars, int timeSignature) noexcept {
 
@@ -626,34 +1087,45 @@ juce::MidiMessageSequence PatternSuggestionEngine::transferStyle(
     }
 }
 
+void PatternSuggestionEngine::setGrooveLibrary(const juce::Array<MidiGrooveAnalysis>& library) noexcept {
+    clearError();
+
+    try {
+        grooveLibrary = library;
+        grooveIndex.clear();
+        grooveIndex.reserve(library.size());
+        for (const auto& groove : library) {
+            grooveIndex.add(groove);
+        }
+        grooveIndex.build();
+
+    } catch (const std::exception& e) {
+        grooveLibrary.clear();
+        grooveIndex.clear();
+        setError("Exception in setGrooveLibrary: " + juce::String(e.what()));
+        ErrorHandler::getInstance().reportError(ErrorHandler::ErrorLevel::Error,
+            "setGrooveLibrary failed: " + juce::String(e.what()), "PatternSuggestionEngine");
+    }
+}
+
 juce::Array<PatternSuggestionEngine::PatternSuggestion>
 PatternSuggestionEngine::findSimilarGrooves(const MidiGrooveAnalysis& targetGroove,
-                                           const juce::Array<MidiGrooveAnalysis>& library) noexcept {
+                                           int maxSuggestions) noexcept {
     clearError();
     juce::Array<PatternSuggestion> suggestions;
     
     try {
-        for (const auto& groove : library) {
-            float similarity = calculatePatternSimilarity(targetGroove, groove);
-
-            if (similarity > 0.5f) {
+        // Already closest first. A score of 0 is a whole unit of weighted distance or more,
+        // such as 90 BPM of tempo on its own, and no longer says how far off the groove is
+        for (const auto& match : grooveIndex.findNearest(targetGroove, maxSuggestions)) {
+            if (match.score > 0.0f) {
                 PatternSuggestion suggestion;
-                suggestion.matchScore = similarity;
-                suggestion.analysis = groove;
+                suggestion.matchScore = match.score;
+                suggestion.analysis = grooveLibrary.getReference(match.index);
                 suggestions.add(suggestion);
             }
         }
 
-        struct MatchScoreComparator {
-            int compareElements(const PatternSuggestion& a, const PatternSuggestion& b) const {
-                if (a.matchScore > b.matchScore) return -1;
-                if (a.matchScore < b.matchScore) return 1;
-                return 0;
-            }
-        };
-        MatchScoreComparator comparator;
-        suggestions.sort(comparator);
-
         return suggestions;
         
     } catch (const std::exception& e) {
@@ -669,35 +1141,6 @@ PatternSuggestionEngine::findSimilarGrooves(const MidiGrooveAnalysis& targetGroo
     }
 }
 
-float PatternSuggestionEngine::calculatePatternSimilarity(
-    const MidiGrooveAnalysis& a, const MidiGrooveAnalysis& b) const noexcept {
-    
-    try {
-
-        float swingDiff = std::abs(a.averageSwing - b.averageSwing) / 100.0f;
-        float velocityDiff = std::abs(a.averageVelocity - b.averageVelocity) /
-                            static_cast<float>(INIConfig::Validation::MAX_MIDI_VELOCITY);
-        float tightnessDiff = std::abs(a.grooveTightness - b.grooveTightness);
-        float tempoDiff = std::abs(a.tempo - b.tempo) / 200.0f;
-
-        float timeSigMatch = (a.timeSignatureNumerator == b.timeSignatureNumerator &&
-                             a.timeSignatureDenominator == b.timeSignatureDenominator) ? 1.0f : 0.5f;
-
-        float similarity = 1.0f - (swingDiff * 0.3f + velocityDiff * 0.2f +
-                                  tightnessDiff * 0.2f + tempoDiff * 0.2f +
-                                  (1.0f - timeSigMatch) * 0.1f);
-
-        return juce::jlimit(0.0f, 1.0f, similarity);
-        
-    } catch (const std::exception& e) {
-        setError("Exception in calculatePatternSimilarity: " + juce::String(e.what()));
-        return 0.0f; // Return no similarity
-    } catch (...) {
-        setError("Unknown error in calculatePatternSimilarity");
-        return 0.0f; // Return no similarity
-    }
-}
-
 bool PatternSuggestionEngine::adaptToPerformance(
     const juce::Array<float>& recentVelocities,
     const juce::Array<float>& recentTimings) noexcept {
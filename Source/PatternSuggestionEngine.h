@@ -1,7 +1,12 @@
 #pragma once
 #include <JuceHeader.h>
+#include <functional>
+#include <memory>
+#include <vector>
 #include "MidiAnalysisTypes.h"
 #include "MidiFileManager.h"
+#include "GrooveSimilarityIndex.h"
+#include "PatternBank.h"
 #include "INIConfig.h"
 #include "ErrorHandling.h"
 
@@ -36,12 +41,55 @@ public:
         MidiGrooveAnalysis analysis;
     };
 
+    // Batch generation: candidates are generated on a pool of worker threads, each from
+    // its own seed so that the same request always gives the same patterns, and ranked
+    // by groove similarity to a target
+    struct BatchRequest {
+        // Candidate i is generated from variations[i % variations.size()]; defaults if empty
+        juce::Array<SuggestionParams> variations;
+        int numCandidates = INIConfig::Defaults::DEFAULT_NUM_SUGGESTIONS;
+        juce::int64 seed = 0;
+        // Without a target, each candidate is scored against the groove its variation describes
+        bool hasTarget = false;
+        MidiGrooveAnalysis target;
+    };
+
+    struct Candidate {
+        int index = -1;
+        juce::int64 seed = 0;
+        SuggestionParams params;
+        // Sorted by tick, at the pattern bank's resolution
+        std::vector<PatternBank::Note> notes;
+        MidiGrooveAnalysis analysis;
+        float matchScore = INIConfig::Defaults::DEFAULT_MATCH_SCORE;
+
+        juce::MidiMessageSequence toSequence() const;
+        PatternSuggestion toSuggestion() const;
+    };
+
+    // Called on the calling thread with each candidate as it finishes; returning false cancels
+    using CandidateCallback = std::function<bool(const Candidate&)>;
+    // Called on the message thread with the ranked batch, best first
+    using BatchCallback = std::function<void(const juce::Array<Candidate>&)>;
+
     PatternSuggestionEngine();
-    ~PatternSuggestionEngine() = default;
+    ~PatternSuggestionEngine();
 
     // Exception-safe pattern generation methods
     juce::Array<PatternSuggestion> suggestPatterns(const SuggestionParams& params, int numSuggestions = INIConfig::Defaults::DEFAULT_NUM_SUGGESTIONS) noexcept;
     PatternSuggestion generatePattern(const SuggestionParams& params) noexcept;
+
+    // Best first; a cancelled batch returns whatever had finished
+    juce::Array<Candidate> generateBatch(const BatchRequest& request, const CandidateCallback& onCandidate = nullptr) noexcept;
+    // Message thread only. Runs the batch on a background thread and reports each candidate,
+    // then the ranked batch, on the message thread. Starting another batch cancels this one.
+    void generateBatchAsync(const BatchRequest& request, CandidateCallback onCandidate, BatchCallback onFinished) noexcept;
+    // Nothing more is reported for the batch once this returns
+    void cancelBatch() noexcept;
+    bool isGeneratingBatch() const noexcept { return batchThread != nullptr; }
+    // The candidate generateBatch() makes from that seed, scored against the groove params describe
+    Candidate generateCandidate(const SuggestionParams& params, juce::int64 seed) const noexcept;
+    static juce::int64 getCandidateSeed(juce::int64 batchSeed, int index) noexcept;
     
     // Fallback methods for when AI generation fails
     PatternSuggestion createFallbackPattern(const SuggestionParams& params) const noexcept;
@@ -51,8 +99,13 @@ public:
     juce::MidiMessageSequence transferStyle(const juce::MidiMessageSequence& source,
                                            const juce::MidiMessageSequence& styleReference) noexcept;
 
+    // The grooves findSimilarGrooves() searches, indexed here once rather than on every search
+    void setGrooveLibrary(const juce::Array<MidiGrooveAnalysis>& library) noexcept;
+    int getGrooveLibrarySize() const noexcept { return grooveLibrary.size(); }
+
+    // The closest grooves in the library, best first, leaving out any too far away to be alike
     juce::Array<PatternSuggestion> findSimilarGrooves(const MidiGrooveAnalysis& targetGroove,
-                                                      const juce::Array<MidiGrooveAnalysis>& library) noexcept;
+                                                      int maxSuggestions = INIConfig::Defaults::DEFAULT_NUM_SUGGESTIONS) noexcept;
 
     bool adaptToPerformance(const juce::Array<float>& recentVelocities,
                            const juce::Array<float>& recentTimings) noexcept;
@@ -78,8 +131,29 @@ private:
         juce::Array<int> commonNotes;
     };
 
+    // One variation of a batch, with everything the workers read prepared up front
+    struct Variation {
+        SuggestionParams params;
+        GenreProfile profile;
+        juce::Array<float> kick, snare, hiHat;
+        MidiGrooveAnalysis target;
+    };
+
+    struct Batch;
+    class GenerationJob;
+    class BatchThread;
+
     juce::Array<GenreProfile> genreProfiles;
     juce::Array<MidiGrooveAnalysis> patternLibrary;
+    // In the order added to grooveIndex, so a match's index finds its analysis
+    juce::Array<MidiGrooveAnalysis> grooveLibrary;
+    GrooveSimilarityIndex grooveIndex;
+    std::unique_ptr<juce::ThreadPool> pool;
+    std::unique_ptr<BatchThread> batchThread;
+    CandidateCallback onBatchCandidate;
+    BatchCallback onBatchFinished;
+    // Reports from a batch that was cancelled arrive late and are told apart by this
+    int batchNumber = 0;
     
     // Error state management
     mutable bool hasInternalError = false;
@@ -89,19 +163,28 @@ private:
     juce::MidiMessageSequence generateDrumPattern(const GenreProfile& profile,
                                                   int bars, int timeSignature) noexcept;
 
-    float calculatePatternSimilarity(const MidiGrooveAnalysis& a,
-                                   const MidiGrooveAnalysis& b) const noexcept;
-
     juce::Array<float> generateKickPattern(Genre genre, int steps) const noexcept;
     juce::Array<float> generateSnarePattern(Genre genre, int steps) const noexcept;
     juce::Array<float> generateHiHatPattern(Genre genre, int steps) const noexcept;
 
     void initializeGenreProfiles() noexcept;
+    const GenreProfile& getProfile(Genre genre) const noexcept;
+    Variation prepareVariation(const SuggestionParams& params) const;
+    // Thread-safe: reads only the variation
+    static Candidate makeCandidate(const Variation& variation, int index, juce::int64 seed);
+    // Reads the genre profiles, so runs on the thread that asked for the batch
+    std::unique_ptr<Batch> prepareBatch(const BatchRequest& request) const;
+    // Thread-safe: reads only the batch
+    static juce::Array<Candidate> runBatch(Batch& batch, juce::ThreadPool& workers, const CandidateCallback& onCandidate);
+    juce::ThreadPool& getPool();
+    void handleBatchCandidate(int number, const Candidate& candidate);
+    void handleBatchFinished(int number, const juce::Array<Candidate>& ranked, const juce::String& error);
     
     // Error handling utilities
     void setError(const juce::String& message) const noexcept;
     bool validateParams(const SuggestionParams& params) const noexcept;
     SuggestionParams sanitizeParams(const SuggestionParams& params) const noexcept;
 
+    JUCE_DECLARE_WEAK_REFERENCEABLE(PatternSuggestionEngine)
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PatternSuggestionEngine)
 };
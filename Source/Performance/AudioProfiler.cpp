@@ -5,10 +5,18 @@ AudioProfiler::AudioProfiler(MidiEngine& midiEngine, RenderOptimizer& renderOpti
 }
 
 void AudioProfiler::profilePatternSwitching() {
-    auto startTime = juce::Time::getHighResolutionTicks();
-    
-    auto endTime = juce::Time::getHighResolutionTicks();
-    lastPatternSwitchTime = (endTime - startTime) / juce::Time::getHighResolutionTicksPerSecond() * 1000.0;
+    // The slowest of the current player's buttons, as a press would find it
+    const int playerIndex = midiEngine.getCurrentPlayer();
+    lastPatternSwitchTime = 0.0;
+
+    for (int i = 0; i <= INIConfig::Validation::MAX_BUTTON_INDEX; ++i) {
+        auto startTime = juce::Time::getHighResolutionTicks();
+        midiEngine.preparePattern(playerIndex, i);
+        auto endTime = juce::Time::getHighResolutionTicks();
+
+        lastPatternSwitchTime = juce::jmax(lastPatternSwitchTime,
+                                           juce::Time::highResolutionTicksToSeconds(endTime - startTime) * 1000.0);
+    }
     
     jassert(lastPatternSwitchTime < 100.0);
     
@@ -203,6 +203,9 @@ OTTOAudioProcessorEditor::OTTOAudioProcessorEditor(OTTOAudioProcessor& p)
     resized();
     repaint();
 
+    // All mixer meters are refreshed together from this editor's display refresh
+    audioProcessor.getMixer().getMeteringService().attachToDisplay(this);
+
     startTimer(INIConfig::LayoutConstants::tapTempoDisplayMs / INIConfig::LayoutConstants::defaultMargin);
     isInitialized = true;
 }
@@ -210,6 +213,7 @@ OTTOAudioProcessorEditor::OTTOAudioProcessorEditor(OTTOAudioProcessor& p)
 OTTOAudioProcessorEditor::~OTTOAudioProcessorEditor()
 {
     stopTimer();
+    audioProcessor.getMixer().getMeteringService().detachFromDisplay();
 
     if (colorScheme)
         colorScheme->removeListener(this);
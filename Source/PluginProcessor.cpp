@@ -1,6 +1,7 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 #include "INIConfig.h"
+#include "INIDataManager.h"
 
 const juce::StringArray OTTOAudioProcessor::parameterIDs = {
     "masterVolume",
@@ -29,8 +30,13 @@ OTTOAudioProcessor::OTTOAudioProcessor()
 {
     initializeParameters();
     setupMidiEngine();
+    loadPatternChains();
     midiEngine.setTempo(INIConfig::Defaults::DEFAULT_TEMPO);
     mixer.setMasterVolume(INIConfig::Defaults::VOLUME);
+    mixer.onLatencyChanged = [this](int latencySamples) {
+        setLatencySamples(latencySamples);
+        midiOutputScheduler.setProcessingLatency(latencySamples);
+    };
     deviceManager.initialiseWithDefaultDevices(2, 2);
     refreshMidiDevices();
 
@@ -57,6 +63,12 @@ OTTOAudioProcessor::OTTOAudioProcessor()
     #endif
 }
 OTTOAudioProcessor::~OTTOAudioProcessor() {
+    for (const auto& route : parameterRoutes) {
+        if (route.parameter != nullptr) {
+            route.parameter->removeListener(this);
+        }
+    }
+
     if (midiInput) {
         midiInput->stop();
     }
@@ -66,6 +78,10 @@ void OTTOAudioProcessor::setupMidiEngine() {
     midiEngine.onMidiParameterChanged = [this](const juce::String& parameterID, float value) {
         handleMidiParameterChange(parameterID, value);
     };
+    midiEngine.setParameterResolver([this](const juce::String& parameterID) {
+        return parameters.getParameter(parameterID);
+    });
+    midiEngine.setMixer(&mixer);
 }
 
 void OTTOAudioProcessor::handleMidiParameterChange(const juce::String& parameterID, float value) {
@@ -81,28 +97,8 @@ void OTTOAudioProcessor::handleMidiParameterChange(const juce::String& parameter
         return;
     }
 
-    // Null-pointer safety: Check parameter exists before use
-    if (auto* param = parameters.getParameter(parameterID)) {
-        try {
-            const juce::MessageManagerLock mmLock;
-            // Null-pointer safety: Verify param is still valid after lock
-            if (param != nullptr) {
-                float normalizedValue = param->convertTo0to1(value);
-                // Additional validation for normalized value
-                if (std::isfinite(normalizedValue) && normalizedValue >= 0.0f && normalizedValue <= 1.0f) {
-                    param->setValueNotifyingHost(normalizedValue);
-                } else {
-                    DBG("AudioProcessor: Invalid normalized value for parameter: " + parameterID);
-                }
-            }
-        } catch (const std::exception& e) {
-            DBG("AudioProcessor: Exception in parameter change - " + juce::String(e.what()));
-        }
-    } else {
-        DBG("AudioProcessor: Parameter not found: " + parameterID);
-    }
-
-    // Handle special playback state parameter
+    // Host parameters are set straight from the MIDI engine's CC table; only
+    // mappings that do not resolve to one arrive here
     if (parameterID == "playState") {
         try {
             if (value > 0.5f) {
@@ -113,6 +109,8 @@ void OTTOAudioProcessor::handleMidiParameterChange(const juce::String& parameter
         } catch (const std::exception& e) {
             DBG("AudioProcessor: Exception in playback state change - " + juce::String(e.what()));
         }
+    } else {
+        DBG("AudioProcessor: Parameter not found: " + parameterID);
     }
 }
 
@@ -144,7 +142,7 @@ void OTTOAudioProcessor::refreshMidiDevices() {
 
     if (!outputStillAvailable) {
         currentMidiOutput.clear();
-        midiOutput.reset();
+        midiOutputScheduler.setOutput(nullptr);
     }
 }
 
@@ -218,9 +216,9 @@ void OTTOAudioProcessor::setMidiOutput(const juce::String& deviceName) {
     if (deviceName == currentMidiOutput) return;
 
     // Null-pointer safety: Safely reset existing MIDI output
-    if (midiOutput != nullptr) {
+    if (midiOutputScheduler.hasOutput()) {
         try {
-            midiOutput.reset();
+            midiOutputScheduler.setOutput(nullptr);
         } catch (const std::exception& e) {
             DBG("AudioProcessor: Error closing MIDI output - " + juce::String(e.what()));
         }
@@ -237,8 +235,9 @@ void OTTOAudioProcessor::setMidiOutput(const juce::String& deviceName) {
                 if (device.name == deviceName) {
                     deviceFound = true;
                     // Null-pointer safety: Try to open MIDI output device with error handling
-                    midiOutput = juce::MidiOutput::openDevice(device.identifier);
-                    if (midiOutput != nullptr) {
+                    auto opened = juce::MidiOutput::openDevice(device.identifier);
+                    if (opened != nullptr) {
+                        midiOutputScheduler.setOutput(std::move(opened));
                         DBG("AudioProcessor: Successfully opened MIDI output: " + deviceName);
                     } else {
                         DBG("AudioProcessor: Failed to open MIDI output device: " + deviceName);
@@ -306,104 +305,108 @@ juce::AudioProcessorValueTreeState::ParameterLayout OTTOAudioProcessor::createPa
 }
 
 void OTTOAudioProcessor::initializeParameters() {
-    parameters.addParameterListener("masterVolume", this);
-    parameters.addParameterListener("tempo", this);
-    parameters.addParameterListener("swing", this);
-    parameters.addParameterListener("energy", this);
+    // Resolve each parameter's destination once so value changes dispatch by index
+    auto route = [this](const juce::String& parameterID, ParameterTarget target, int playerIndex) {
+        if (auto* param = parameters.getParameter(parameterID)) {
+            const auto index = static_cast<size_t>(param->getParameterIndex());
+            if (index >= parameterRoutes.size()) {
+                parameterRoutes.resize(index + 1);
+            }
+            parameterRoutes[index] = { param, target, playerIndex };
+            param->addListener(this);
+        }
+    };
+
+    route("masterVolume", ParameterTarget::MasterVolume, INIConfig::Defaults::ZERO_VALUE);
+    route("tempo", ParameterTarget::Tempo, INIConfig::Defaults::ZERO_VALUE);
+    route("swing", ParameterTarget::Swing, INIConfig::Defaults::ZERO_VALUE);
+    route("energy", ParameterTarget::Energy, INIConfig::Defaults::ZERO_VALUE);
 
     for (int i = 1; i <= 8; ++i) {
-        parameters.addParameterListener("player" + juce::String(i) + "Volume", this);
-        parameters.addParameterListener("player" + juce::String(i) + "Pan", this);
+        route("player" + juce::String(i) + "Volume", ParameterTarget::PlayerVolume, i - 1);
+        route("player" + juce::String(i) + "Pan", ParameterTarget::PlayerPan, i - 1);
     }
 }
 
-void OTTOAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue) {
-    // Null-pointer safety: Validate parameter ID and value
-    if (parameterID.isEmpty()) {
-        DBG("AudioProcessor: Empty parameter ID in parameter change callback");
+void OTTOAudioProcessor::parameterValueChanged(int parameterIndex, float newValue) {
+    if (!juce::isPositiveAndBelow(parameterIndex, static_cast<int>(parameterRoutes.size()))) {
         return;
     }
 
+    const auto& route = parameterRoutes[static_cast<size_t>(parameterIndex)];
+    if (route.parameter == nullptr) {
+        return;
+    }
+
+    applyParameter(route, route.parameter->convertFrom0to1(newValue));
+}
+
+void OTTOAudioProcessor::applyParameter(const ParameterRoute& route, float newValue) {
     if (!std::isfinite(newValue)) {
-        DBG("AudioProcessor: Invalid parameter value: " + juce::String(newValue) + " for parameter: " + parameterID);
+        DBG("AudioProcessor: Invalid parameter value: " + juce::String(newValue) + " for parameter: " + route.parameter->getParameterID());
         return;
     }
 
     try {
-        if (parameterID == "masterVolume") {
-            // Validate volume range before applying
-            float clampedVolume = juce::jlimit(0.0f, 1.0f, newValue);
-            mixer.setMasterVolume(clampedVolume);
-        }
-        else if (parameterID == "tempo") {
-            // Validate tempo range before applying
-            float clampedTempo = juce::jlimit(
-                static_cast<float>(INIConfig::Validation::MIN_TEMPO),
-                static_cast<float>(INIConfig::Validation::MAX_TEMPO),
-                newValue
-            );
-            midiEngine.setTempo(clampedTempo);
-        }
-        else if (parameterID == "swing") {
-            // Null-pointer safety: Validate current player before use
-            int currentPlayer = midiEngine.getCurrentPlayer();
-            if (currentPlayer >= 0 && currentPlayer < 8) {  // Assuming 8 players max
-                float clampedSwing = juce::jlimit(
-                    INIConfig::Validation::MIN_SWING,
-                    INIConfig::Validation::MAX_SWING,
-                    newValue
-                );
-                midiEngine.setSwing(currentPlayer, clampedSwing);
-            } else {
-                DBG("AudioProcessor: Invalid current player index: " + juce::String(currentPlayer));
-            }
-        }
-        else if (parameterID == "energy") {
-            // Null-pointer safety: Validate current player before use
-            int currentPlayer = midiEngine.getCurrentPlayer();
-            if (currentPlayer >= 0 && currentPlayer < 8) {  // Assuming 8 players max
-                float clampedEnergy = juce::jlimit(
-                    INIConfig::Validation::MIN_ENERGY,
-                    INIConfig::Validation::MAX_ENERGY,
+        switch (route.target) {
+            case ParameterTarget::MasterVolume:
+                mixer.setMasterVolume(juce::jlimit(0.0f, 1.0f, newValue));
+                break;
+
+            case ParameterTarget::Tempo:
+                midiEngine.setTempo(juce::jlimit(
+                    static_cast<float>(INIConfig::Validation::MIN_TEMPO),
+                    static_cast<float>(INIConfig::Validation::MAX_TEMPO),
                     newValue
-                );
-                midiEngine.setEnergy(currentPlayer, clampedEnergy);
-            } else {
-                DBG("AudioProcessor: Invalid current player index: " + juce::String(currentPlayer));
-            }
-        }
-        else {
-            // Handle player-specific parameters with null-pointer safety
-            for (int i = 1; i <= 8; ++i) {
-                if (parameterID == "player" + juce::String(i) + "Volume") {
-                    // Validate player index and volume range
-                    int playerIndex = i - 1;
-                    if (playerIndex >= 0 && playerIndex < 8) {
-                        float clampedVolume = juce::jlimit(0.0f, 1.0f, newValue);
-                        mixer.setChannelVolume(playerIndex, clampedVolume);
-                    } else {
-                        DBG("AudioProcessor: Invalid player index: " + juce::String(playerIndex));
-                    }
-                    return;  // Exit loop early once parameter is found
+                ));
+                break;
+
+            case ParameterTarget::Swing:
+            case ParameterTarget::Energy: {
+                // Null-pointer safety: Validate current player before use
+                const int currentPlayer = midiEngine.getCurrentPlayer();
+                if (!INIConfig::isValidPlayerIndex(currentPlayer)) {
+                    DBG("AudioProcessor: Invalid current player index: " + juce::String(currentPlayer));
+                    break;
                 }
-                else if (parameterID == "player" + juce::String(i) + "Pan") {
-                    // Validate player index and pan range
-                    int playerIndex = i - 1;
-                    if (playerIndex >= 0 && playerIndex < 8) {
-                        float clampedPan = juce::jlimit(-1.0f, 1.0f, newValue);
-                        mixer.setChannelPan(playerIndex, clampedPan);
-                    } else {
-                        DBG("AudioProcessor: Invalid player index: " + juce::String(playerIndex));
+
+                // Off the message thread the engine's command queue and controls are out of reach
+                if (!juce::MessageManager::existsAndIsCurrentThread()) {
+                    if (!audioParameterChanges.push({ route.target, currentPlayer, newValue })) {
+                        DBG("AudioProcessor: Parameter change queue full, dropping change");
                     }
-                    return;  // Exit loop early once parameter is found
+                    break;
+                }
+
+                if (route.target == ParameterTarget::Swing) {
+                    midiEngine.setSwing(currentPlayer, juce::jlimit(INIConfig::Validation::MIN_SWING, INIConfig::Validation::MAX_SWING, newValue));
+                } else {
+                    midiEngine.setEnergy(currentPlayer, juce::jlimit(INIConfig::Validation::MIN_ENERGY, INIConfig::Validation::MAX_ENERGY, newValue));
                 }
+                break;
             }
-            // If we reach here, parameter wasn't recognized
-            DBG("AudioProcessor: Unrecognized parameter: " + parameterID);
+
+            case ParameterTarget::PlayerVolume:
+                mixer.setChannelVolume(route.playerIndex, juce::jlimit(0.0f, 1.0f, newValue));
+                break;
+
+            case ParameterTarget::PlayerPan:
+                mixer.setChannelPan(route.playerIndex, juce::jlimit(-1.0f, 1.0f, newValue));
+                break;
         }
     } catch (const std::exception& e) {
-        DBG("AudioProcessor: Exception in parameter change - " + juce::String(e.what()) + 
-            " for parameter: " + parameterID);
+        DBG("AudioProcessor: Exception in parameter change - " + juce::String(e.what()));
+    }
+}
+
+void OTTOAudioProcessor::applyAudioParameterChanges() {
+    ParameterChange change;
+    while (audioParameterChanges.pop(change)) {
+        if (change.target == ParameterTarget::Swing) {
+            midiEngine.automateSwing(change.playerIndex, change.value);
+        } else {
+            midiEngine.automateEnergy(change.playerIndex, change.value);
+        }
     }
 }
 
@@ -491,11 +494,25 @@ void OTTOAudioProcessor::prepareToPlay(double newSampleRate, int samplesPerBlock
         }
     #endif
 
+    // Offline hosts may bounce in blocks far larger than they announce
+    const int maxBlockSize = isNonRealtime() ? juce::jmax(samplesPerBlock, INIConfig::Audio::OFFLINE_RENDER_BLOCK_SIZE)
+                                             : samplesPerBlock;
+
     midiEngine.prepare(newSampleRate);
-    sfzEngine.prepare(newSampleRate, samplesPerBlock);
-    mixer.prepare(newSampleRate, samplesPerBlock);
+    sfzEngine.prepare(newSampleRate, maxBlockSize);
+    mixer.prepare(newSampleRate, maxBlockSize);
+    setLatencySamples(mixer.getLatencySamples());
     presetManager.prepare();
 
+    // MIDI out is delayed by everything between render and the speakers: the mixer's
+    // lookahead plus the device's output buffering, or one block when that is unknown
+    int outputLatency = samplesPerBlock;
+    if (auto* outputDevice = deviceManager.getCurrentAudioDevice()) {
+        outputLatency = outputDevice->getOutputLatencyInSamples() + outputDevice->getCurrentBufferSizeSamples();
+    }
+    midiOutputScheduler.prepare(newSampleRate, outputLatency);
+    midiOutputScheduler.setProcessingLatency(mixer.getLatencySamples());
+
     auto* device = deviceManager.getCurrentAudioDevice();
     if (device != nullptr) {
         auto setup = deviceManager.getAudioDeviceSetup();
@@ -716,9 +733,11 @@ void OTTOAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::Mi
         }
     }
 
+    applyAudioParameterChanges();
+
     // Process MIDI input - null-pointer safety handled in MidiEngine::process
     try {
-        midiEngine.process(midiMessages);
+        midiEngine.process(midiMessages, buffer.getNumSamples());
     } catch (const std::exception& e) {
         DBG("AudioProcessor: MIDI processing error - " + juce::String(e.what()));
         // Continue processing to avoid audio dropouts
@@ -742,16 +761,20 @@ void OTTOAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::Mi
         buffer.applyGain(0.1f);
     }
 
-    // Send MIDI output with null-pointer safety
-    if (midiOutput != nullptr && midiMessages.getNumEvents() > 0) {
-        try {
-            midiOutput->sendBlockOfMessages(midiMessages, juce::Time::getMillisecondCounterHiRes(), sampleRate);
-        } catch (const std::exception& e) {
-            DBG("AudioProcessor: MIDI output error - " + juce::String(e.what()));
-        }
+    // Hardware MIDI out is sent from the scheduler's thread, never from here; a bounce
+    // runs faster than real time and sends none
+    if (!isNonRealtime()) {
+        midiOutputScheduler.pushBlock(midiMessages, buffer.getNumSamples());
     }
 }
 
+void OTTOAudioProcessor::setNonRealtime(bool isNonRealtime) noexcept {
+    juce::AudioProcessor::setNonRealtime(isNonRealtime);
+
+    midiEngine.setOfflineRender(isNonRealtime);
+    mixer.setMeteringEnabled(!isNonRealtime);
+}
+
 bool OTTOAudioProcessor::hasEditor() const {
     return true;
 }
@@ -895,11 +918,26 @@ void OTTOAudioProcessor::loadStates(const ComponentState& state) {
     setMidiOutput(state.audioSettings.midiOutputDevice);
 
     midiEngine.loadStates(state);
+    loadPatternChains();
     sfzEngine.loadStates(state);
     presetManager.loadStates(state);
     mixer.loadState(state);
 }
 
+void OTTOAudioProcessor::loadPatternChains() {
+    INIDataManager dataManager;
+    juce::Array<SongArranger::Chain> chains;
+    if (!dataManager.loadPatternChains(chains)) return;
+
+    // A chain saved with the session wins over the one from PatternChains.ini
+    for (int i = 0; i < chains.size(); ++i) {
+        const auto& chain = chains.getReference(i);
+        if (!chain.steps.isEmpty() && !midiEngine.hasPatternChain(i)) {
+            midiEngine.setPatternChain(i, chain);
+        }
+    }
+}
+
 void OTTOAudioProcessor::updateParametersFromState(const ComponentState& state) {
     if (auto* tempoParam = parameters.getRawParameterValue("tempo")) {
         *tempoParam = static_cast<float>(state.globalSettings.tempo);
@@ -1,6 +1,8 @@
 #pragma once
 #include <JuceHeader.h>
+#include "LockFreeStructures.h"
 #include "MidiEngine.h"
+#include "MidiOutputScheduler.h"
 #include "SFZEngine.h"
 #include "PresetManager.h"
 #include "Mixer.h"
@@ -8,13 +10,14 @@
 #include "INIConfig.h"
 
 class OTTOAudioProcessor : public juce::AudioProcessor,
-                           public juce::AudioProcessorValueTreeState::Listener {
+                           public juce::AudioProcessorParameter::Listener {
 public:
     OTTOAudioProcessor();
     ~OTTOAudioProcessor() override;
 
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
+    void setNonRealtime(bool isNonRealtime) noexcept override;
 
     #ifndef JucePlugin_PreferredChannelConfigurations
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
@@ -45,13 +48,15 @@ public:
     SFZEngine& getSFZEngine() { return sfzEngine; }
     PresetManager& getPresetManager() { return presetManager; }
     Mixer& getMixer() { return mixer; }
+    MidiOutputScheduler& getMidiOutputScheduler() { return midiOutputScheduler; }
     juce::AudioProcessorValueTreeState& getValueTreeState() { return parameters; }
     juce::AudioDeviceManager& getDeviceManager() { return deviceManager; }
 
     void saveStates(ComponentState& state);
     void loadStates(const ComponentState& state);
 
-    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int, bool) override {}
 
     void refreshMidiDevices();
     juce::StringArray getAvailableMidiInputs() const;
@@ -72,18 +77,50 @@ private:
     juce::String currentMidiInput;
     juce::String currentMidiOutput;
     std::unique_ptr<juce::MidiInput> midiInput;
-    std::unique_ptr<juce::MidiOutput> midiOutput;
+    MidiOutputScheduler midiOutputScheduler;
 
     double sampleRate = static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE);
 
     static const juce::StringArray parameterIDs;
 
+    enum class ParameterTarget {
+        MasterVolume,
+        Tempo,
+        Swing,
+        Energy,
+        PlayerVolume,
+        PlayerPan
+    };
+
+    struct ParameterRoute {
+        juce::RangedAudioParameter* parameter = nullptr;
+        ParameterTarget target = ParameterTarget::MasterVolume;
+        int playerIndex = INIConfig::Defaults::ZERO_VALUE;
+    };
+
+    // Indexed by AudioProcessorParameter::getParameterIndex()
+    std::vector<ParameterRoute> parameterRoutes;
+
+    struct ParameterChange {
+        ParameterTarget target = ParameterTarget::Swing;
+        int playerIndex = INIConfig::Defaults::ZERO_VALUE;
+        float value = 0.0f;
+    };
+
+    // Swing and energy changes from off the message thread, which the engine picks up at
+    // the start of the next block. The audio thread (a learned CC) and any number of host
+    // automation threads push at once.
+    MpscFifo<ParameterChange, INIConfig::MIDI::AUTOMATION_QUEUE_SIZE> audioParameterChanges;
+
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     void initializeParameters();
     void updateParametersFromState(const ComponentState& state);
     void updateStateFromParameters(ComponentState& state);
     void handleMidiParameterChange(const juce::String& parameterID, float value);
+    void applyParameter(const ParameterRoute& route, float newValue);
+    void applyAudioParameterChanges();
     void setupMidiEngine();
+    void loadPatternChains();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OTTOAudioProcessor)
 };
@@ -4,7 +4,7 @@
 #include "INIConfig.h"
 
 class DrumKitMixerWindow::MixerContent : public juce::Component,
-                                         public juce::Timer {
+                                         public MeteringService::Listener {
 public:
     class DoubleClickFader : public juce::Slider {
     public:
@@ -384,11 +384,11 @@ public:
         setupMasterCallbacks();
         addAndMakeVisible(masterSection.get());
 
-        startTimerHz(INIConfig::LayoutConstants::mixerTimerHz);
+        mixer.getMeteringService().addListener(this);
     }
 
     ~MixerContent() override {
-        stopTimer();
+        mixer.getMeteringService().removeListener(this);
     }
 
     void paint(juce::Graphics& g) override {
@@ -410,14 +410,13 @@ public:
         }
     }
 
-    void timerCallback() override {
+    void meterFrameUpdated(const MeteringService::MeterFrame& frame) override {
         for (int i = 0; i < INIConfig::LayoutConstants::playerTabsCount; ++i) {
-            auto levels = mixer.getChannelLevels(i);
-            channelStrips[i]->updateMetering(levels.left, levels.right);
+            const auto& levels = frame.get(i);
+            channelStrips[i]->updateMetering(levels.peakLeft, levels.peakRight);
         }
 
-        auto masterLevels = mixer.getMasterLevels();
-        masterSection->updateMetering(masterLevels.left, masterLevels.right);
+        masterSection->updateMetering(frame.master.peakLeft, frame.master.peakRight);
     }
 
 private:
@@ -1,6 +1,7 @@
 #include "SFZEngine.h"
 #include "INIConfig.h"
 #include "ErrorHandling.h"
+#include "SampleKitImporter.h"
 
 SFZEngine::VelocityLayer* SFZEngine::Region::getLayerForVelocity(int velocity) {
     try {
@@ -66,7 +67,7 @@ SFZEngine::SFZEngine() {
         preAllocatedBuffers.add(new juce::AudioBuffer<float>(2, 4096));
     }
 
-    sfzFolder = getAssetsPath().getChildFile("Drumkits");
+    sfzFolder = getAssetsPath().getChildFile(INIConfig::DRUMKITS_FOLDER);
 
     if (sfzFolder.exists()) {
         scanDrumkitsFolder();
@@ -151,7 +152,15 @@ void SFZEngine::process(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi
             return;
         }
 
+        // Voices render up to each event, so a note starts on its own sample
+        const int numSamples = buffer.getNumSamples();
+        int position = 0;
+
         for (const auto midi : midiMessages) {
+            const int eventSample = juce::jlimit(position, numSamples, midi.samplePosition);
+            voiceAllocator.renderNextBlock(buffer, position, eventSample - position);
+            position = eventSample;
+
             auto msg = midi.getMessage();
 
         if (msg.isNoteOn()) {
@@ -182,7 +191,7 @@ void SFZEngine::process(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi
         }
         }
 
-        voiceAllocator.renderNextBlock(buffer);
+        voiceAllocator.renderNextBlock(buffer, position, numSamples - position);
     } catch (const std::exception& e) {
         ErrorHandler::getInstance().reportError(ErrorHandler::ErrorLevel::Error,
             "Failed to process audio buffer: " + juce::String(e.what()), "SFZEngine");
@@ -322,8 +331,7 @@ void SFZEngine::loadSFZFileFromPath(const juce::File& sfzFile) {
 
         if (trimmedLine.startsWith("<region>")) {
             if (currentRegion && !currentRegion->velocityLayers.empty()) {
-                int key = currentRegion->key;
-                regions[key] = std::move(currentRegion);
+                addRegion(std::move(currentRegion));
             }
 
             currentRegion = std::make_unique<Region>();
@@ -384,9 +392,22 @@ void SFZEngine::loadSFZFileFromPath(const juce::File& sfzFile) {
    }
 
    if (currentRegion && !currentRegion->velocityLayers.empty()) {
-       int key = currentRegion->key;
-       regions[key] = std::move(currentRegion);
+       addRegion(std::move(currentRegion));
+   }
+}
+
+void SFZEngine::addRegion(std::unique_ptr<Region> region) {
+   // Velocity layers and round robins of one drum arrive as separate regions on its key
+   auto& existing = regions[region->key];
+   if (existing == nullptr) {
+       existing = std::move(region);
+       return;
+   }
+
+   for (auto& layer : region->velocityLayers) {
+       existing->velocityLayers.push_back(std::move(layer));
    }
+   existing->roundRobinCount = juce::jmax(existing->roundRobinCount, region->roundRobinCount);
 }
 
 void SFZEngine::parseSFZOpcode(Region& region, const juce::String& opcode, const juce::String& value) {
@@ -430,25 +451,7 @@ void SFZEngine::createDefaultSFZMapping() {
        return;
    }
 
-   struct DefaultMapping {
-       juce::String filePattern;
-       int midiNote;
-       float volume;
-       SFZVoice::ADSRParameters adsr;
-   };
-
-   DefaultMapping mappings[] = {
-       {"kick", INIConfig::LayoutConstants::sfzBaseMidiNote, 0.8f, {0.001f, 0.5f, 0.0f, 0.1f}},
-       {"snare", INIConfig::LayoutConstants::sfzBaseMidiNote + 2, 0.7f, {0.001f, 0.2f, 0.0f, 0.15f}},
-       {"hihat", INIConfig::LayoutConstants::sfzBaseMidiNote + 6, 0.6f, {0.001f, 0.05f, 0.0f, 0.05f}},
-       {"hat", INIConfig::LayoutConstants::sfzBaseMidiNote + 6, 0.6f, {0.001f, 0.05f, 0.0f, 0.05f}},
-       {"crash", INIConfig::LayoutConstants::sfzBaseMidiNote + 13, 0.7f, {0.001f, 2.0f, 0.3f, 1.0f}},
-       {"ride", INIConfig::LayoutConstants::sfzBaseMidiNote + 15, 0.6f, {0.001f, 1.0f, 0.4f, 0.8f}},
-       {"tom", INIConfig::LayoutConstants::sfzBaseMidiNote + 7, 0.7f, {0.001f, 0.3f, 0.0f, 0.2f}},
-       {"clap", INIConfig::LayoutConstants::sfzBaseMidiNote + 3, 0.6f, {0.001f, 0.1f, 0.0f, 0.1f}},
-       {"perc", INIConfig::LayoutConstants::sfzBaseMidiNote + 1, 0.5f, {0.001f, 0.1f, 0.0f, 0.1f}}
-   };
-
+   // Names only, so nothing is decoded here; SampleKitImporter also listens to the samples
    int currentNote = INIConfig::LayoutConstants::sfzBaseMidiNote;
 
    for (const auto& audioFile : audioFiles) {
@@ -460,20 +463,14 @@ void SFZEngine::createDefaultSFZMapping() {
        layer.loVel = 0;
        layer.hiVel = INIConfig::Validation::MAX_MIDI_VELOCITY;
 
-       juce::String fileName = audioFile.getFileNameWithoutExtension().toLowerCase();
-       bool matched = false;
+       const auto type = SampleKitImporter::classifyName(audioFile.getFileNameWithoutExtension());
 
-       for (const auto& mapping : mappings) {
-           if (fileName.contains(mapping.filePattern)) {
-               region->key = mapping.midiNote;
-               layer.volume = mapping.volume;
-               region->adsr = mapping.adsr;
-               matched = true;
-               break;
-           }
-       }
-
-       if (!matched) {
+       if (type != SampleKitImporter::DrumType::Unknown) {
+           const auto voicing = SampleKitImporter::getVoicing(type);
+           region->key = voicing.note;
+           layer.volume = voicing.volume;
+           region->adsr = voicing.adsr;
+       } else {
            region->key = currentNote++;
            if (currentNote > INIConfig::Validation::MAX_MIDI_NOTE) currentNote = INIConfig::LayoutConstants::sfzBaseMidiNote;
        }
@@ -485,9 +482,14 @@ void SFZEngine::createDefaultSFZMapping() {
                layer.source->prepareToPlay(INIConfig::LayoutConstants::separatorComponentDefaultWidth * INIConfig::LayoutConstants::drumKitSectionBorderThickness * INIConfig::LayoutConstants::drumKitSpacing, sampleRate);
            }
            region->velocityLayers.push_back(std::move(layer));
-           regions[region->key] = std::move(region);
+           addRegion(std::move(region));
        }
    }
+
+   // Samples named for the same drum share its key and take turns
+   for (auto& entry : regions) {
+       entry.second->roundRobinCount = juce::jmax(entry.second->roundRobinCount, static_cast<int>(entry.second->velocityLayers.size()));
+   }
 }
 
 void SFZEngine::loadSFZFile() {
@@ -36,6 +36,8 @@ public:
 
     juce::String getCurrentDrumkitName() const { return currentDrumkitName; }
     juce::String getCurrentSFZFile() const { return currentSFZFile; }
+    // Regions of the SFZ file loaded last, each with at least one sample that could be opened
+    int getNumRegions() const { return static_cast<int>(regions.size()); }
 
     void setCurrentPlayer(int playerIndex);
     int getCurrentPlayer() const { return currentPlayerIndex; }
@@ -113,6 +115,7 @@ private:
    void initializeDefaultPlayerDrumkits();
    void loadPlayerDrumkitFromState(int playerIndex);
    void parseSFZOpcode(Region& region, const juce::String& opcode, const juce::String& value);
+   void addRegion(std::unique_ptr<Region> region);
 
    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SFZEngine)
 };
@@ -3,7 +3,12 @@
 #include "INIConfig.h"
 
 SFZVoice::SFZVoice() {
-    sourceBuffer.setSize(INIConfig::LayoutConstants::defaultOutputChannels, INIConfig::LayoutConstants::defaultBufferSize);
+    sourceBuffer.setSize(INIConfig::LayoutConstants::defaultOutputChannels, maxBlockSize);
+}
+
+void SFZVoice::prepare(int newMaxBlockSize) {
+    maxBlockSize = juce::jmax(INIConfig::Defaults::ONE_VALUE, newMaxBlockSize);
+    sourceBuffer.setSize(INIConfig::LayoutConstants::defaultOutputChannels, maxBlockSize);
 }
 
 void SFZVoice::startNote(int midiNote, float vel, double sr,
@@ -26,7 +31,7 @@ void SFZVoice::startNote(int midiNote, float vel, double sr,
     targetEnvelopeValue = 1.0f;
     calculateEnvelopeIncrement(targetEnvelopeValue, adsrParams.attackTime);
 
-    startTime = juce::Time::currentTimeMillis();
+    ageSamples = 0;
 }
 
 void SFZVoice::stopNote() {
@@ -51,31 +56,37 @@ void SFZVoice::renderNextBlock(juce::AudioBuffer<float>& buffer, int startSample
         return;
     }
 
-    int samplesToRead = std::min(numSamples, sourceBuffer.getNumSamples());
-    sourceBuffer.setSize(buffer.getNumChannels(), samplesToRead, false, false, true);
-    sourceBuffer.clear();
+    // Blocks longer than the prepared size are rendered a prepared block at a time
+    while (numSamples > 0 && audioSource != nullptr) {
+        const int samplesToRead = std::min(numSamples, maxBlockSize);
+        sourceBuffer.setSize(buffer.getNumChannels(), samplesToRead, false, false, true);
+        sourceBuffer.clear();
 
-    juce::AudioSourceChannelInfo info(&sourceBuffer, 0, samplesToRead);
-    audioSource->getNextAudioBlock(info);
+        juce::AudioSourceChannelInfo info(&sourceBuffer, 0, samplesToRead);
+        audioSource->getNextAudioBlock(info);
 
-    for (int sample = 0; sample < samplesToRead; ++sample) {
-        updateEnvelope();
+        for (int sample = 0; sample < samplesToRead; ++sample) {
+            updateEnvelope();
 
-        float gain = currentEnvelopeValue * velocity * baseVolume;
+            float gain = currentEnvelopeValue * velocity * baseVolume;
 
-        for (int channel = 0; channel < buffer.getNumChannels(); ++channel) {
-            if (channel < sourceBuffer.getNumChannels()) {
-                buffer.addSample(channel, startSample + sample,
-                                sourceBuffer.getSample(channel, sample) * gain);
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel) {
+                if (channel < sourceBuffer.getNumChannels()) {
+                    buffer.addSample(channel, startSample + sample,
+                                    sourceBuffer.getSample(channel, sample) * gain);
+                }
             }
         }
-    }
 
-    sourcePosition += samplesToRead;
+        sourcePosition += samplesToRead;
+        ageSamples += samplesToRead;
+        startSample += samplesToRead;
+        numSamples -= samplesToRead;
 
-    if (state == State::Finished ||
-        (audioSource->getTotalLength() > 0 && sourcePosition >= audioSource->getTotalLength())) {
-        reset();
+        if (state == State::Finished ||
+            (audioSource->getTotalLength() > 0 && sourcePosition >= audioSource->getTotalLength())) {
+            reset();
+        }
     }
 }
 
@@ -127,7 +138,8 @@ void SFZVoice::calculateEnvelopeIncrement(float targetValue, float timeInSeconds
 }
 
 bool SFZVoice::canBeStolen() const {
+    const auto stealThresholdSamples = static_cast<int64_t>(INIConfig::LayoutConstants::sfzVoiceStealThreshold * sampleRate / INIConfig::Defaults::MS_PER_SECOND);
+
     return state == State::Release ||
-           (state != State::Idle &&
-            juce::Time::currentTimeMillis() - startTime > INIConfig::LayoutConstants::sfzVoiceStealThreshold);
+           (state != State::Idle && ageSamples > stealThresholdSamples);
 }
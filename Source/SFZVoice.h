@@ -24,6 +24,7 @@ public:
     SFZVoice();
     ~SFZVoice() = default;
 
+    void prepare(int maxBlockSize);
     void startNote(int midiNote, float velocity, double sampleRate,
                    juce::AudioFormatReaderSource* source,
                    const ADSRParameters& adsr, float volumeDb);
@@ -38,17 +39,19 @@ public:
     int getCurrentNote() const { return currentNote; }
     float getVelocity() const { return velocity; }
     State getState() const { return state; }
-    int64_t getStartTime() const { return startTime; }
+    // Counted in rendered samples, so voice stealing does not depend on when the block ran
+    int64_t getAgeSamples() const { return ageSamples; }
 
 private:
     State state = State::Idle;
     int currentNote = INIConfig::MIDI::INACTIVE_PATTERN;
     float velocity = INIConfig::Validation::MIN_VOLUME;
-    int64_t startTime = INIConfig::Defaults::ZERO_VALUE;
+    int64_t ageSamples = INIConfig::Defaults::ZERO_VALUE;
     double sampleRate = static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE);
 
     juce::AudioFormatReaderSource* audioSource = nullptr;
     juce::AudioBuffer<float> sourceBuffer;
+    int maxBlockSize = INIConfig::LayoutConstants::defaultBufferSize;
     int64_t sourcePosition = INIConfig::Defaults::ZERO_VALUE;
 
     ADSRParameters adsrParams;
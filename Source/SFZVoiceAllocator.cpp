@@ -13,7 +13,10 @@ SFZVoiceAllocator::SFZVoiceAllocator() {
 
 void SFZVoiceAllocator::prepare(double sr, int samplesPerBlock) {
     sampleRate = sr;
-    juce::ignoreUnused(samplesPerBlock);
+
+    for (auto& voice : voices) {
+        voice->prepare(samplesPerBlock);
+    }
 }
 
 void SFZVoiceAllocator::reset() {
@@ -55,10 +58,12 @@ void SFZVoiceAllocator::releaseAllVoices() {
     }
 }
 
-void SFZVoiceAllocator::renderNextBlock(juce::AudioBuffer<float>& buffer) {
+void SFZVoiceAllocator::renderNextBlock(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) {
+    if (numSamples <= 0) return;
+
     for (auto& voice : voices) {
         if (voice->isActive()) {
-            voice->renderNextBlock(buffer, 0, buffer.getNumSamples());
+            voice->renderNextBlock(buffer, startSample, numSamples);
         }
     }
 }
@@ -111,12 +116,12 @@ SFZVoice* SFZVoiceAllocator::stealVoice() {
 
 SFZVoice* SFZVoiceAllocator::findOldestVoice() {
     SFZVoice* oldest = nullptr;
-    int64_t oldestTime = std::numeric_limits<int64_t>::max();
+    int64_t oldestAge = -1;
 
     for (auto& voice : voices) {
-        if (voice->isActive() && voice->getStartTime() < oldestTime) {
+        if (voice->isActive() && voice->getAgeSamples() > oldestAge) {
             oldest = voice.get();
-            oldestTime = voice->getStartTime();
+            oldestAge = voice->getAgeSamples();
         }
     }
 
@@ -19,7 +19,7 @@ public:
     void releaseVoicesForNote(int midiNote);
     void releaseAllVoices();
 
-    void renderNextBlock(juce::AudioBuffer<float>& buffer);
+    void renderNextBlock(juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
 
     int getActiveVoiceCount() const;
     void setMaxVoices(int maxVoices) {
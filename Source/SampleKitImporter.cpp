@@ -0,0 +1,626 @@
+#include "SampleKitImporter.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <unordered_set>
+
+namespace {
+    using DrumType = SampleKitImporter::DrumType;
+
+    constexpr int baseNote = INIConfig::LayoutConstants::sfzBaseMidiNote;
+    constexpr int numVelocities = INIConfig::Validation::MAX_MIDI_VELOCITY + 1;
+    constexpr const char* audioFileExtensions = "wav;aif;aiff;flac;ogg";
+
+    // Checked in order, so "hihat" is found before the "hat" in it
+    struct NamePattern {
+        const char* pattern;
+        DrumType type;
+    };
+
+    constexpr NamePattern namePatterns[] = {
+        { "kick", DrumType::Kick },
+        { "snare", DrumType::Snare },
+        { "hihat", DrumType::HiHat },
+        { "hat", DrumType::HiHat },
+        { "crash", DrumType::Crash },
+        { "ride", DrumType::Ride },
+        { "tom", DrumType::Tom },
+        { "clap", DrumType::Clap },
+        { "perc", DrumType::Percussion }
+    };
+
+    // Highest pitch first; toms beyond the sixth share the lowest
+    constexpr int tomNotes[] = {
+        INIConfig::GMDrums::HIGH_TOM, INIConfig::GMDrums::HI_MID_TOM, INIConfig::GMDrums::LOW_MID_TOM,
+        INIConfig::GMDrums::LOW_TOM, INIConfig::GMDrums::HIGH_FLOOR_TOM, INIConfig::GMDrums::LOW_FLOOR_TOM
+    };
+
+    float findPeak(const float* samples, int numSamples) {
+        const auto range = juce::FloatVectorOperations::findMinAndMax(samples, numSamples);
+        return juce::jmax(-range.getStart(), range.getEnd());
+    }
+
+    // Spaces would split the sample opcode, so the copies in the kit have none
+    juce::String getSampleName(const juce::File& file, const juce::StringArray& usedNames) {
+        const auto legal = juce::File::createLegalFileName(file.getFileName()).replaceCharacter(' ', '_');
+        const auto stem = legal.upToLastOccurrenceOf(".", false, false);
+        const auto extension = legal.fromLastOccurrenceOf(".", true, false);
+
+        auto name = legal;
+        for (int suffix = 2; usedNames.contains(name, true); ++suffix) {
+            name = stem + "_" + juce::String(suffix) + extension;
+        }
+        return name;
+    }
+
+    void writeFeatures(juce::OutputStream& stream, const SampleKitImporter::SampleFeatures& features) {
+        stream.writeDouble(features.sampleRate);
+        stream.writeInt64(features.lengthInSamples);
+        stream.writeFloat(features.peak);
+        stream.writeFloat(features.rms);
+        stream.writeFloat(features.onsetSeconds);
+        stream.writeFloat(features.decaySeconds);
+        stream.writeFloat(features.centroidHz);
+    }
+
+    void readFeatures(juce::InputStream& stream, SampleKitImporter::SampleFeatures& features) {
+        features.sampleRate = stream.readDouble();
+        features.lengthInSamples = stream.readInt64();
+        features.peak = stream.readFloat();
+        features.rms = stream.readFloat();
+        features.onsetSeconds = stream.readFloat();
+        features.decaySeconds = stream.readFloat();
+        features.centroidHz = stream.readFloat();
+    }
+}
+
+// One importKit() call. Workers claim files through nextIndex and each writes only the
+// slots it claimed; the calling thread reads them after every job has finished.
+struct SampleKitImporter::Batch {
+    juce::File kitFolder;
+    std::vector<Record> records;
+    std::vector<char> needsDecoding;
+    std::vector<char> finished;
+    std::atomic<int> nextIndex{0};
+    std::atomic<int> numDone{0};
+    std::atomic<int> numDecoded{0};
+    std::atomic<bool> cancelled{false};
+    juce::WaitableEvent fileDone;
+};
+
+class SampleKitImporter::ImportJob : public juce::ThreadPoolJob {
+public:
+    explicit ImportJob(Batch& batchToRun) : juce::ThreadPoolJob("Sample Import"), batch(batchToRun) {
+        formats.registerBasicFormats();
+    }
+
+    JobStatus runJob() override {
+        while (!shouldExit() && !batch.cancelled.load()) {
+            const int index = batch.nextIndex.fetch_add(1);
+            if (index >= static_cast<int>(batch.records.size())) break;
+
+            auto& record = batch.records[static_cast<size_t>(index)];
+            const juce::File source(record.sourcePath);
+
+            if (batch.needsDecoding[static_cast<size_t>(index)] != 0) {
+                record.features = analyzeFile(source, formats);
+                batch.numDecoded.fetch_add(1);
+            }
+
+            // Decoding can take a while; a cancelled import copies nothing more
+            if (batch.cancelled.load()) break;
+
+            if (record.features.isValid()) {
+                const auto copy = batch.kitFolder.getChildFile(record.sampleName);
+                const bool current = copy == source || (copy.existsAsFile() && copy.getSize() == record.size
+                                                        && batch.needsDecoding[static_cast<size_t>(index)] == 0);
+                if (!current && !source.copyFileTo(copy)) {
+                    record.features = {};
+                }
+            }
+
+            batch.finished[static_cast<size_t>(index)] = 1;
+            batch.numDone.fetch_add(1);
+            batch.fileDone.signal();
+        }
+        return jobHasFinished;
+    }
+
+private:
+    Batch& batch;
+    // Each worker has its own, so readers are created without sharing anything
+    juce::AudioFormatManager formats;
+};
+
+SampleKitImporter::SampleKitImporter(const juce::File& folder) : drumkitsFolder(folder) {
+}
+
+SampleKitImporter::~SampleKitImporter() = default;
+
+juce::File SampleKitImporter::getKitFolder(const juce::String& kitName) const {
+    return drumkitsFolder.getChildFile(juce::File::createLegalFileName(kitName));
+}
+
+juce::String SampleKitImporter::findKitName(const juce::String& wantedName) const {
+    const auto baseName = wantedName.isEmpty() ? juce::String("Imported Kit") : wantedName;
+    auto kitName = baseName;
+
+    for (int suffix = 2;; ++suffix) {
+        const auto kitFolder = getKitFolder(kitName);
+        if (!kitFolder.exists() || kitFolder.getChildFile(INIConfig::SAMPLE_KIT_CACHE_FILE).existsAsFile()) {
+            return kitName;
+        }
+        kitName = baseName + " " + juce::String(suffix);
+    }
+}
+
+SampleKitImporter::Result SampleKitImporter::importKit(const juce::String& kitName, const juce::Array<juce::File>& files,
+                                                       const ProgressCallback& progress) {
+    Result result;
+
+    const auto kitFolder = getKitFolder(kitName);
+    if (kitFolder.createDirectory().failed()) {
+        DBG("SampleKitImporter: Could not create " + kitFolder.getFullPathName());
+        return result;
+    }
+
+    const auto cacheFile = kitFolder.getChildFile(INIConfig::SAMPLE_KIT_CACHE_FILE);
+    auto kitRecords = readCache(cacheFile);
+
+    // Nothing already in the folder is overwritten by a sample of the same name
+    juce::StringArray usedNames;
+    for (const auto& entry : juce::RangedDirectoryIterator(kitFolder, false, "*", juce::File::findFiles)) {
+        usedNames.add(entry.getFile().getFileName());
+    }
+
+    // A file dropped again replaces its earlier copy, and is decoded again only if it changed
+    Batch batch;
+    batch.kitFolder = kitFolder;
+    std::unordered_set<juce::String> dropped;
+
+    for (const auto& file : files) {
+        if (!dropped.insert(file.getFullPathName()).second) continue;
+
+        Record record;
+        record.sourcePath = file.getFullPathName();
+        record.size = file.getSize();
+        record.modified = file.getLastModificationTime().toMilliseconds();
+        bool decode = true;
+
+        // The kit's own copies may be dropped too, and stand for the files they were copied from
+        const bool inKit = file.getParentDirectory() == kitFolder;
+        const auto previous = std::find_if(kitRecords.begin(), kitRecords.end(), [&](const Record& existing) {
+            return existing.sourcePath == record.sourcePath || (inKit && existing.sampleName == file.getFileName());
+        });
+
+        if (previous != kitRecords.end()) {
+            record.sampleName = previous->sampleName;
+            const bool unchanged = previous->sourcePath == record.sourcePath
+                                       ? previous->size == record.size && previous->modified == record.modified
+                                       : previous->size == record.size;
+            if (unchanged) {
+                record.features = previous->features;
+                decode = false;
+            }
+            kitRecords.erase(previous);
+        } else if (inKit) {
+            record.sampleName = file.getFileName();
+        } else {
+            record.sampleName = getSampleName(file, usedNames);
+            usedNames.add(record.sampleName);
+        }
+
+        batch.records.push_back(std::move(record));
+        batch.needsDecoding.push_back(decode ? 1 : 0);
+    }
+
+    const int total = static_cast<int>(batch.records.size());
+    batch.finished.assign(static_cast<size_t>(total), 0);
+
+    // Reported before any work starts, so the caller can back out for free
+    bool cancelled = progress != nullptr && !progress(0, total);
+
+    // The pool owns no jobs; every one is waited for before the batch goes out of scope
+    std::vector<std::unique_ptr<ImportJob>> jobs;
+    if (!cancelled && total > 0) {
+        auto& workers = getPool();
+        const int numJobs = juce::jmin(workers.getNumThreads(), total);
+
+        for (int i = 0; i < numJobs; ++i) {
+            jobs.push_back(std::make_unique<ImportJob>(batch));
+            workers.addJob(jobs.back().get(), false);
+        }
+    }
+
+    for (int done = 0; !cancelled && done < total;) {
+        batch.fileDone.wait(INIConfig::Audio::SAMPLE_IMPORT_PROGRESS_INTERVAL_MS);
+        done = batch.numDone.load();
+
+        if (progress != nullptr && !progress(done, total)) {
+            cancelled = true;
+            batch.cancelled.store(true);
+        }
+    }
+
+    for (const auto& job : jobs) {
+        pool->waitForJobToFinish(job.get(), -1);
+    }
+
+    result.numDecoded = batch.numDecoded.load();
+    if (cancelled) {
+        result.cancelled = true;
+        return result;
+    }
+
+    for (auto& record : batch.records) {
+        if (record.features.isValid()) {
+            kitRecords.push_back(std::move(record));
+        } else {
+            result.unreadable.add(record.sourcePath);
+        }
+    }
+
+    // Samples deleted from the kit's folder since the last drop leave it
+    kitRecords.erase(std::remove_if(kitRecords.begin(), kitRecords.end(), [&kitFolder](const Record& record) {
+        return !kitFolder.getChildFile(record.sampleName).existsAsFile();
+    }), kitRecords.end());
+
+    for (const auto& record : kitRecords) {
+        ImportedSample sample;
+        sample.source = juce::File(record.sourcePath);
+        sample.sampleName = record.sampleName;
+        sample.features = record.features;
+        sample.type = classify(sample.source.getFileNameWithoutExtension(), record.features);
+        result.samples.push_back(sample);
+    }
+    layoutKit(result.samples);
+
+    if (!writeCache(cacheFile, kitRecords)) {
+        DBG("SampleKitImporter: Could not write " + cacheFile.getFullPathName());
+    }
+
+    if (!result.samples.empty()) {
+        const auto sfzFile = kitFolder.getChildFile(juce::File::createLegalFileName(kitName) + ".sfz");
+        if (sfzFile.replaceWithText(createSFZ(kitName, result.samples))) {
+            result.sfzFile = sfzFile;
+        } else {
+            DBG("SampleKitImporter: Could not write " + sfzFile.getFullPathName());
+        }
+    }
+
+    return result;
+}
+
+juce::Array<juce::File> SampleKitImporter::findAudioFiles(const juce::StringArray& paths,
+                                                          const std::function<bool()>& keepGoing) {
+    juce::Array<juce::File> files;
+
+    for (const auto& path : paths) {
+        if (keepGoing != nullptr && !keepGoing()) break;
+        const juce::File dropped(path);
+
+        if (dropped.isDirectory()) {
+            // A dropped folder can be a whole sample library, so this is asked between files too
+            for (const auto& entry : juce::RangedDirectoryIterator(dropped, true, "*", juce::File::findFiles)) {
+                if (keepGoing != nullptr && !keepGoing()) return files;
+                if (isAudioFile(entry.getFile())) {
+                    files.add(entry.getFile());
+                }
+            }
+        } else if (isAudioFile(dropped)) {
+            files.add(dropped);
+        }
+    }
+
+    return files;
+}
+
+bool SampleKitImporter::isAudioFile(const juce::File& file) {
+    return file.existsAsFile() && file.hasFileExtension(audioFileExtensions);
+}
+
+SampleKitImporter::SampleFeatures SampleKitImporter::analyzeFile(const juce::File& file, juce::AudioFormatManager& formats) {
+    std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+    if (reader == nullptr || reader->sampleRate <= 0.0 || reader->lengthInSamples <= 0) return {};
+
+    // Long files are only ever measured from the start; a one-shot is over well before
+    const auto maxSamples = static_cast<juce::int64>(reader->sampleRate * INIConfig::Audio::SAMPLE_IMPORT_MAX_SECONDS);
+    const int numSamples = static_cast<int>(juce::jmin(reader->lengthInSamples, maxSamples));
+    const int numChannels = juce::jmax(1, static_cast<int>(reader->numChannels));
+
+    juce::AudioBuffer<float> buffer(numChannels, numSamples);
+    if (!reader->read(&buffer, 0, numSamples, 0, true, true)) return {};
+
+    // Folded to mono, so a hit panned to one side is measured all the same
+    for (int channel = 1; channel < numChannels; ++channel) {
+        buffer.addFrom(0, 0, buffer, channel, 0, numSamples);
+    }
+    buffer.applyGain(0, 0, numSamples, 1.0f / static_cast<float>(numChannels));
+
+    auto features = analyzeSamples(buffer.getReadPointer(0), numSamples, reader->sampleRate);
+    features.lengthInSamples = reader->lengthInSamples;
+    return features;
+}
+
+SampleKitImporter::SampleFeatures SampleKitImporter::analyzeSamples(const float* samples, int numSamples, double sampleRate) {
+    SampleFeatures features;
+    features.sampleRate = sampleRate;
+    features.lengthInSamples = numSamples;
+
+    if (samples == nullptr || numSamples <= 0 || sampleRate <= 0.0) return features;
+
+    const float peak = findPeak(samples, numSamples);
+    if (peak < INIConfig::Audio::SAMPLE_IMPORT_SILENCE_PEAK) return features;
+    features.peak = peak;
+
+    int onset = 0;
+    while (onset < numSamples && std::abs(samples[onset]) < peak * INIConfig::Audio::SAMPLE_IMPORT_ONSET_THRESHOLD) {
+        ++onset;
+    }
+    features.onsetSeconds = static_cast<float>(onset / sampleRate);
+
+    const int attackEnd = juce::jmin(numSamples, onset + juce::jmax(1, juce::roundToInt(sampleRate * INIConfig::Audio::SAMPLE_IMPORT_ATTACK_SECONDS)));
+    double power = 0.0;
+    for (int i = onset; i < attackEnd; ++i) {
+        power += samples[i] * samples[i];
+    }
+    features.rms = static_cast<float>(std::sqrt(power / (attackEnd - onset)));
+
+    // Peaks of short frames, so a tail that crosses zero is not taken for its end
+    const int hop = INIConfig::Audio::SAMPLE_IMPORT_ENVELOPE_HOP;
+    int lastAudible = onset;
+    for (int start = onset; start < numSamples; start += hop) {
+        const int length = juce::jmin(hop, numSamples - start);
+        if (findPeak(samples + start, length) >= peak * INIConfig::Audio::SAMPLE_IMPORT_DECAY_FLOOR) {
+            lastAudible = start + length;
+        }
+    }
+    features.decaySeconds = static_cast<float>((lastAudible - onset) / sampleRate);
+
+    // Half-overlapping windows over the attack, each weighted by how loud it is
+    const int fftSize = 1 << INIConfig::Audio::SAMPLE_IMPORT_FFT_ORDER;
+    juce::dsp::FFT fft(INIConfig::Audio::SAMPLE_IMPORT_FFT_ORDER);
+    juce::dsp::WindowingFunction<float> window(static_cast<size_t>(fftSize), juce::dsp::WindowingFunction<float>::hann, false);
+    std::vector<float> data(static_cast<size_t>(fftSize * 2), 0.0f);
+
+    const double binWidth = sampleRate / fftSize;
+    const int centroidEnd = juce::jmin(numSamples, onset + juce::roundToInt(sampleRate * INIConfig::Audio::SAMPLE_IMPORT_CENTROID_SECONDS));
+    double weightedSum = 0.0;
+    double magnitudeSum = 0.0;
+
+    for (int start = onset; start < juce::jmax(centroidEnd, onset + 1); start += fftSize / 2) {
+        const int length = juce::jmin(fftSize, numSamples - start);
+        std::fill(data.begin(), data.end(), 0.0f);
+        std::copy_n(samples + start, length, data.begin());
+        window.multiplyWithWindowingTable(data.data(), static_cast<size_t>(fftSize));
+        fft.performFrequencyOnlyForwardTransform(data.data(), true);
+
+        for (int bin = 1; bin <= fftSize / 2; ++bin) {
+            weightedSum += bin * binWidth * data[static_cast<size_t>(bin)];
+            magnitudeSum += data[static_cast<size_t>(bin)];
+        }
+    }
+    features.centroidHz = magnitudeSum > 0.0 ? static_cast<float>(weightedSum / magnitudeSum) : 0.0f;
+
+    return features;
+}
+
+SampleKitImporter::DrumType SampleKitImporter::classifyName(const juce::String& fileName) {
+    const auto name = fileName.toLowerCase();
+    for (const auto& pattern : namePatterns) {
+        if (name.contains(pattern.pattern)) {
+            return pattern.type;
+        }
+    }
+    return DrumType::Unknown;
+}
+
+SampleKitImporter::DrumType SampleKitImporter::classify(const juce::String& fileName, const SampleFeatures& features) {
+    const auto named = classifyName(fileName);
+    if (named != DrumType::Unknown || !features.isValid()) return named;
+
+    const float centroid = features.centroidHz;
+    const float decay = features.decaySeconds;
+
+    if (centroid < INIConfig::Audio::SAMPLE_IMPORT_KICK_MAX_CENTROID) return DrumType::Kick;
+    if (centroid < INIConfig::Audio::SAMPLE_IMPORT_TOM_MAX_CENTROID) return DrumType::Tom;
+
+    if (centroid >= INIConfig::Audio::SAMPLE_IMPORT_CYMBAL_MIN_CENTROID) {
+        if (decay >= INIConfig::Audio::SAMPLE_IMPORT_CRASH_MIN_DECAY) return DrumType::Crash;
+        if (decay >= INIConfig::Audio::SAMPLE_IMPORT_RIDE_MIN_DECAY) return DrumType::Ride;
+        return DrumType::HiHat;
+    }
+
+    return decay < INIConfig::Audio::SAMPLE_IMPORT_PERC_MAX_DECAY ? DrumType::Percussion : DrumType::Snare;
+}
+
+SampleKitImporter::Voicing SampleKitImporter::getVoicing(DrumType type) {
+    switch (type) {
+        case DrumType::Kick:       return { baseNote, 0.8f, { 0.001f, 0.5f, 0.0f, 0.1f } };
+        case DrumType::Snare:      return { baseNote + 2, 0.7f, { 0.001f, 0.2f, 0.0f, 0.15f } };
+        case DrumType::Clap:       return { baseNote + 3, 0.6f, { 0.001f, 0.1f, 0.0f, 0.1f } };
+        case DrumType::Tom:        return { baseNote + 7, 0.7f, { 0.001f, 0.3f, 0.0f, 0.2f } };
+        case DrumType::HiHat:      return { baseNote + 6, 0.6f, { 0.001f, 0.05f, 0.0f, 0.05f } };
+        case DrumType::Crash:      return { baseNote + 13, 0.7f, { 0.001f, 2.0f, 0.3f, 1.0f } };
+        case DrumType::Ride:       return { baseNote + 15, 0.6f, { 0.001f, 1.0f, 0.4f, 0.8f } };
+        case DrumType::Percussion: return { baseNote + 1, 0.5f, { 0.001f, 0.1f, 0.0f, 0.1f } };
+        case DrumType::Unknown:
+        default:                   return { baseNote, 0.8f, {} };
+    }
+}
+
+void SampleKitImporter::layoutKit(std::vector<ImportedSample>& samples) {
+    // Toms more than a few semitones apart are different drums, the highest on the high tom
+    std::vector<ImportedSample*> toms;
+    for (auto& sample : samples) {
+        sample.note = getVoicing(sample.type).note;
+        if (sample.type == DrumType::Tom) toms.push_back(&sample);
+    }
+
+    std::stable_sort(toms.begin(), toms.end(), [](const ImportedSample* a, const ImportedSample* b) {
+        return a->features.centroidHz > b->features.centroidHz;
+    });
+
+    int drum = -1;
+    float drumCentroid = 0.0f;
+    for (auto* tom : toms) {
+        if (drum < 0 || tom->features.centroidHz < drumCentroid / INIConfig::Audio::SAMPLE_IMPORT_TOM_PITCH_RATIO) {
+            ++drum;
+            drumCentroid = tom->features.centroidHz;
+        }
+        tom->note = tomNotes[juce::jmin(drum, static_cast<int>(std::size(tomNotes)) - 1)];
+    }
+
+    std::map<int, std::vector<ImportedSample*>> drums;
+    for (auto& sample : samples) {
+        drums[sample.note].push_back(&sample);
+    }
+
+    const float roundRobinRatio = juce::Decibels::decibelsToGain(INIConfig::Audio::SAMPLE_IMPORT_ROUND_ROBIN_DB);
+
+    for (auto& [note, hits] : drums) {
+        std::stable_sort(hits.begin(), hits.end(), [](const ImportedSample* a, const ImportedSample* b) {
+            return a->features.rms < b->features.rms;
+        });
+
+        // Hits about as loud as the quietest in a layer take turns in it
+        const int numHits = static_cast<int>(hits.size());
+        std::vector<int> layerStarts;
+        float layerRms = 0.0f;
+        for (int i = 0; i < numHits; ++i) {
+            if (layerStarts.empty() || hits[static_cast<size_t>(i)]->features.rms > layerRms * roundRobinRatio) {
+                layerStarts.push_back(i);
+                layerRms = hits[static_cast<size_t>(i)]->features.rms;
+            }
+        }
+
+        // Too many to give each a useful velocity range; split into even runs instead
+        const int maxLayers = INIConfig::Audio::SAMPLE_IMPORT_MAX_VELOCITY_LAYERS;
+        if (static_cast<int>(layerStarts.size()) > maxLayers) {
+            layerStarts.clear();
+            for (int layer = 0; layer < maxLayers; ++layer) {
+                layerStarts.push_back(layer * numHits / maxLayers);
+            }
+        }
+
+        const int numLayers = static_cast<int>(layerStarts.size());
+        for (int layer = 0; layer < numLayers; ++layer) {
+            const int begin = layerStarts[static_cast<size_t>(layer)];
+            const int end = layer + 1 < numLayers ? layerStarts[static_cast<size_t>(layer + 1)] : numHits;
+
+            for (int i = begin; i < end; ++i) {
+                auto* hit = hits[static_cast<size_t>(i)];
+                hit->loVel = layer * numVelocities / numLayers;
+                hit->hiVel = (layer + 1) * numVelocities / numLayers - 1;
+                hit->roundRobins = end - begin;
+                hit->roundRobinPosition = i - begin + 1;
+            }
+        }
+    }
+}
+
+juce::String SampleKitImporter::createSFZ(const juce::String& kitName, const std::vector<ImportedSample>& samples) {
+    std::vector<const ImportedSample*> ordered;
+    for (const auto& sample : samples) {
+        ordered.push_back(&sample);
+    }
+    std::stable_sort(ordered.begin(), ordered.end(), [](const ImportedSample* a, const ImportedSample* b) {
+        if (a->note != b->note) return a->note < b->note;
+        if (a->loVel != b->loVel) return a->loVel < b->loVel;
+        return a->features.rms < b->features.rms;
+    });
+
+    juce::String sfz;
+    sfz << "// Drum Kit: " << kitName << "\n";
+    sfz << "// Imported by OTTO from " << juce::String(static_cast<int>(samples.size())) << " samples\n\n";
+
+    // One line per region, as SFZEngine reads them; sustain is in the engine's own scale
+    for (const auto* sample : ordered) {
+        const auto voicing = getVoicing(sample->type);
+
+        sfz << "<region> sample=" << sample->sampleName
+            << " key=" << sample->note
+            << " lovel=" << sample->loVel
+            << " hivel=" << sample->hiVel;
+        if (sample->roundRobins > 1) {
+            sfz << " seq_length=" << sample->roundRobins
+                << " seq_position=" << sample->roundRobinPosition;
+        }
+        sfz << " volume=" << juce::String(juce::Decibels::gainToDecibels(voicing.volume), 2)
+            << " ampeg_attack=" << juce::String(voicing.adsr.attackTime)
+            << " ampeg_decay=" << juce::String(voicing.adsr.decayTime)
+            << " ampeg_sustain=" << juce::roundToInt(voicing.adsr.sustainLevel * INIConfig::LayoutConstants::sfzOffsetMultiplier)
+            << " ampeg_release=" << juce::String(voicing.adsr.releaseTime) << "\n";
+    }
+
+    return sfz;
+}
+
+std::vector<SampleKitImporter::Record> SampleKitImporter::readCache(const juce::File& cacheFile) {
+    std::vector<Record> records;
+
+    juce::MemoryBlock data;
+    if (!cacheFile.existsAsFile() || !cacheFile.loadFileAsData(data)) return records;
+
+    juce::MemoryInputStream stream(data, false);
+    if (stream.readInt() != INIConfig::Audio::SAMPLE_IMPORT_CACHE_MAGIC) return records;
+    if (stream.readInt() != INIConfig::Audio::SAMPLE_IMPORT_CACHE_VERSION) return records;
+
+    const int count = stream.readInt();
+    if (count < 0) return records;
+
+    for (int i = 0; i < count && !stream.isExhausted(); ++i) {
+        Record record;
+        record.sampleName = stream.readString();
+        record.sourcePath = stream.readString();
+        record.size = stream.readInt64();
+        record.modified = stream.readInt64();
+        readFeatures(stream, record.features);
+        records.push_back(std::move(record));
+    }
+
+    // Only a file written to the end carries the trailing magic
+    if (stream.readInt() != INIConfig::Audio::SAMPLE_IMPORT_CACHE_MAGIC) {
+        DBG("SampleKitImporter: Discarding unreadable cache " + cacheFile.getFullPathName());
+        records.clear();
+    }
+    return records;
+}
+
+bool SampleKitImporter::writeCache(const juce::File& cacheFile, const std::vector<Record>& records) {
+    // Written beside the cache and moved over it, so a crash never leaves half a file behind
+    juce::TemporaryFile temporary(cacheFile);
+    {
+        juce::FileOutputStream stream(temporary.getFile());
+        if (!stream.openedOk()) return false;
+
+        stream.writeInt(INIConfig::Audio::SAMPLE_IMPORT_CACHE_MAGIC);
+        stream.writeInt(INIConfig::Audio::SAMPLE_IMPORT_CACHE_VERSION);
+        stream.writeInt(static_cast<int>(records.size()));
+
+        for (const auto& record : records) {
+            stream.writeString(record.sampleName);
+            stream.writeString(record.sourcePath);
+            stream.writeInt64(record.size);
+            stream.writeInt64(record.modified);
+            writeFeatures(stream, record.features);
+        }
+
+        stream.writeInt(INIConfig::Audio::SAMPLE_IMPORT_CACHE_MAGIC);
+        stream.flush();
+        if (stream.getStatus().failed()) return false;
+    }
+
+    return temporary.overwriteTargetFileWithTemporary();
+}
+
+juce::ThreadPool& SampleKitImporter::getPool() {
+    if (pool == nullptr) {
+        const int numThreads = juce::jlimit(1, INIConfig::Audio::SAMPLE_IMPORT_MAX_THREADS, juce::SystemStats::getNumCpus());
+        pool = std::make_unique<juce::ThreadPool>(juce::ThreadPoolOptions{}
+                                                      .withThreadName("OTTO Sample Import")
+                                                      .withNumberOfThreads(numThreads));
+    }
+    return *pool;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "INIConfig.h"
+#include "SFZVoice.h"
+
+// Turns a drop of loose one-shots into a playable kit. Every file is decoded on a
+// bounded pool of worker threads, which measure its level, onset, decay and spectral
+// centroid and copy it into the kit's folder. The calling thread then puts each sample
+// on a drum by its name or, failing that, by its sound, stacks each drum's samples into
+// velocity layers by loudness and writes the SFZ file. The measurements are kept beside
+// it in a binary cache of the kit, so a later drop into the same kit adds to it and
+// decodes only the files that are new or have changed.
+class SampleKitImporter {
+public:
+    enum class DrumType { Unknown, Kick, Snare, Clap, Tom, HiHat, Crash, Ride, Percussion };
+
+    struct SampleFeatures {
+        double sampleRate = 0.0;
+        juce::int64 lengthInSamples = 0;
+        float peak = 0.0f;
+        // Level of the attack, which orders the velocity layers
+        float rms = 0.0f;
+        // Leading silence before the hit
+        float onsetSeconds = 0.0f;
+        // From the onset until the level stays 40 dB below the peak
+        float decaySeconds = 0.0f;
+        // Magnitude-weighted mean frequency of the attack
+        float centroidHz = 0.0f;
+
+        // False for files that could not be decoded or hold only silence
+        bool isValid() const { return peak > 0.0f; }
+    };
+
+    struct ImportedSample {
+        juce::File source;
+        // The copy in the kit's folder, as the SFZ file refers to it
+        juce::String sampleName;
+        SampleFeatures features;
+        DrumType type = DrumType::Unknown;
+        int note = INIConfig::LayoutConstants::sfzBaseMidiNote;
+        int loVel = INIConfig::Validation::MIN_MIDI_VELOCITY;
+        int hiVel = INIConfig::Validation::MAX_MIDI_VELOCITY;
+        // Hits taking turns in this one's velocity layer, and its turn among them from 1
+        int roundRobins = 1;
+        int roundRobinPosition = 1;
+    };
+
+    struct Result {
+        juce::File sfzFile;
+        // Every sample in the kit, including those from earlier drops
+        std::vector<ImportedSample> samples;
+        juce::StringArray unreadable;
+        int numDecoded = 0;
+        bool cancelled = false;
+
+        bool succeeded() const { return !cancelled && sfzFile.existsAsFile(); }
+    };
+
+    struct Voicing {
+        int note;
+        float volume;
+        SFZVoice::ADSRParameters adsr;
+    };
+
+    // Files done so far out of the total dropped; returning false cancels
+    using ProgressCallback = std::function<bool(int done, int total)>;
+
+    explicit SampleKitImporter(const juce::File& drumkitsFolder);
+    ~SampleKitImporter();
+
+    // Blocks until the kit is written. Cancelling leaves the kit's SFZ file and cache as they were.
+    Result importKit(const juce::String& kitName, const juce::Array<juce::File>& files,
+                     const ProgressCallback& progress = nullptr);
+
+    juce::File getKitFolder(const juce::String& kitName) const;
+    // The name itself, unless a kit that was not imported has it; those are never written to
+    juce::String findKitName(const juce::String& wantedName) const;
+
+    // The audio files among those dropped, and every one inside a dropped folder. Stops with
+    // whatever it has found once keepGoing returns false.
+    static juce::Array<juce::File> findAudioFiles(const juce::StringArray& paths,
+                                                  const std::function<bool()>& keepGoing = nullptr);
+    static bool isAudioFile(const juce::File& file);
+
+    static SampleFeatures analyzeFile(const juce::File& file, juce::AudioFormatManager& formats);
+    static SampleFeatures analyzeSamples(const float* samples, int numSamples, double sampleRate);
+
+    // Unknown unless the name says which drum it is
+    static DrumType classifyName(const juce::String& fileName);
+    // The name first; the sound decides when the name does not
+    static DrumType classify(const juce::String& fileName, const SampleFeatures& features);
+    static Voicing getVoicing(DrumType type);
+
+    // Notes, velocity ranges and round robins for samples that are already classified
+    static void layoutKit(std::vector<ImportedSample>& samples);
+    static juce::String createSFZ(const juce::String& kitName, const std::vector<ImportedSample>& samples);
+
+private:
+    struct Record {
+        juce::String sampleName;
+        juce::String sourcePath;
+        juce::int64 size = 0;
+        juce::int64 modified = 0;
+        SampleFeatures features;
+    };
+
+    struct Batch;
+    class ImportJob;
+
+    static std::vector<Record> readCache(const juce::File& cacheFile);
+    static bool writeCache(const juce::File& cacheFile, const std::vector<Record>& records);
+    juce::ThreadPool& getPool();
+
+    juce::File drumkitsFolder;
+    std::unique_ptr<juce::ThreadPool> pool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleKitImporter)
+};
@@ -0,0 +1,385 @@
+#include "SongArranger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+    bool isNoteOff(const SongArranger::Event& event) {
+        const int status = event.data[0] & 0xF0;
+        return status == 0x80 || (status == 0x90 && event.data[2] == 0);
+    }
+}
+
+SongArranger::SongArranger() : juce::Thread("OTTO Arranger") {
+    pool.resize(static_cast<size_t>(INIConfig::Defaults::MAX_PLAYERS * INIConfig::MIDI::SONG_SECTIONS_PER_PLAYER));
+
+    for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
+        auto& spares = spareSections[i];
+        spares.reserve(static_cast<size_t>(INIConfig::MIDI::SONG_SECTIONS_PER_PLAYER));
+
+        for (int s = 0; s < INIConfig::MIDI::SONG_SECTIONS_PER_PLAYER; ++s) {
+            spares.push_back(&pool[static_cast<size_t>(i * INIConfig::MIDI::SONG_SECTIONS_PER_PLAYER + s)]);
+        }
+    }
+}
+
+SongArranger::~SongArranger() {
+    stopThread(INIConfig::LayoutConstants::songArrangerThreadStopTimeoutMs);
+}
+
+void SongArranger::setChain(int playerIndex, const Chain& chain, int startBar) {
+    if (!INIConfig::isValidPlayerIndex(playerIndex)) return;
+
+    {
+        const juce::ScopedLock lock(chainLock);
+
+        // A rewind still pending happened first and must not move this chain's start
+        applyPendingRewind();
+
+        auto& target = chains[playerIndex];
+        target = chain;
+        for (auto& step : target.steps) {
+            step.bars = juce::jmax(INIConfig::Defaults::ONE_VALUE, step.bars);
+            step.repeats = juce::jmax(INIConfig::Defaults::ONE_VALUE, step.repeats);
+        }
+
+        resetCursor(playerIndex, juce::jmax(INIConfig::Defaults::ZERO_VALUE, startBar));
+
+        // Sections already prepared for the old chain are dropped by the audio thread
+        generations[playerIndex].fetch_add(1);
+        active[playerIndex].store(!target.steps.isEmpty());
+    }
+
+    if (!chain.steps.isEmpty() && !isThreadRunning()) {
+        startThread();
+    }
+}
+
+void SongArranger::setTempoMap(const TempoMap& map) {
+    const juce::ScopedLock lock(chainLock);
+    tempoMap = map;
+}
+
+void SongArranger::setPatternBank(std::shared_ptr<const PatternBank> bank) {
+    const juce::ScopedLock lock(chainLock);
+    patternBank = std::move(bank);
+}
+
+void SongArranger::rewind(int bar) noexcept {
+    const bool played = playedSinceRewind.exchange(false);
+    if (!played && rewindBar.load() == bar) return;
+
+    // The bar is stored before the epoch moves, so a pass that sees the new epoch sees the bar
+    rewindBar.store(bar);
+    playheadBar.store(bar);
+    epoch.fetch_add(1);
+}
+
+bool SongArranger::isActive(int playerIndex) const noexcept {
+    return INIConfig::isValidPlayerIndex(playerIndex) && active[playerIndex].load(std::memory_order_acquire);
+}
+
+bool SongArranger::isCurrent(int playerIndex, const Section& section) const noexcept {
+    return section.generation == generations[playerIndex].load(std::memory_order_acquire)
+        && section.epoch == epoch.load(std::memory_order_acquire);
+}
+
+SongArranger::Section* SongArranger::popSection(int playerIndex) noexcept {
+    Section* section = nullptr;
+    if (!readySections[playerIndex].pop(section)) return nullptr;
+
+    playedSinceRewind.store(true, std::memory_order_relaxed);
+    return section;
+}
+
+void SongArranger::retireSection(int playerIndex, Section* section) noexcept {
+    // Never full: a player only ever holds Sections from its own pool
+    if (section != nullptr) {
+        retiredSections[playerIndex].push(section);
+    }
+}
+
+void SongArranger::run() {
+    while (!threadShouldExit()) {
+        prepareSections();
+        wait(INIConfig::MIDI::SONG_ARRANGER_POLL_MS);
+    }
+}
+
+void SongArranger::prepareSections() {
+    const juce::ScopedLock prepare(prepareLock);
+
+    TempoMap map;
+    std::shared_ptr<const PatternBank> bank;
+    {
+        const juce::ScopedLock lock(chainLock);
+        map = tempoMap;
+        bank = patternBank;
+    }
+
+    for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
+        auto& spares = spareSections[i];
+
+        Section* retired = nullptr;
+        while (retiredSections[i].pop(retired)) {
+            spares.push_back(retired);
+        }
+
+        Work work;
+        while (!spares.empty() && takeNextWork(i, work)) {
+            Section* section = spares.back();
+            spares.pop_back();
+
+            // File I/O happens outside the chain lock so the message thread never waits on it
+            fillSection(*section, work, map, bank.get());
+
+            const juce::ScopedLock lock(chainLock);
+            const bool stale = work.generation != generations[i].load() || work.epoch != epoch.load();
+            if (stale || !readySections[i].push(section)) {
+                spares.push_back(section);
+            }
+        }
+    }
+}
+
+bool SongArranger::takeNextWork(int playerIndex, Work& work) {
+    const juce::ScopedLock lock(chainLock);
+
+    applyPendingRewind();
+
+    const auto& chain = chains[playerIndex];
+    auto& cursor = cursors[playerIndex];
+
+    if (chain.steps.isEmpty() || cursor.endQueued) return false;
+    if (cursor.nextBar > playheadBar.load(std::memory_order_relaxed) + INIConfig::MIDI::SONG_PREFETCH_BARS) return false;
+
+    work = Work();
+    work.generation = generations[playerIndex].load();
+    work.epoch = appliedEpoch;
+    work.startBar = cursor.nextBar;
+
+    if (cursor.finished) {
+        cursor.endQueued = true;
+        return true;
+    }
+
+    const auto& step = chain.steps.getReference(cursor.stepIndex);
+
+    if (cursor.inFill) {
+        work.patternIndex = step.fillPatternIndex;
+        work.midiFile = step.fillMidiFile;
+        work.bars = INIConfig::Defaults::ONE_VALUE;
+        work.isFill = true;
+    } else {
+        work.patternIndex = step.patternIndex;
+        work.midiFile = step.midiFile;
+        work.bars = getMainBars(step, cursor);
+    }
+
+    advanceCursor(playerIndex, work.bars);
+    return true;
+}
+
+void SongArranger::applyPendingRewind() {
+    // Epoch before bar, the reverse of the order rewind() stores them in
+    const int currentEpoch = epoch.load();
+    if (currentEpoch == appliedEpoch) return;
+
+    const int bar = rewindBar.load();
+    for (int i = 0; i < INIConfig::Defaults::MAX_PLAYERS; ++i) {
+        resetCursor(i, bar);
+    }
+    appliedEpoch = currentEpoch;
+}
+
+int SongArranger::getMainBars(const Step& step, const Cursor& cursor) {
+    const bool fillsLastBar = step.fillPatternIndex != INIConfig::MIDI::INACTIVE_PATTERN
+                           && cursor.repeat == step.repeats - 1;
+    return fillsLastBar ? step.bars - 1 : step.bars;
+}
+
+void SongArranger::resetCursor(int playerIndex, int bar) {
+    auto& cursor = cursors[playerIndex];
+    cursor = Cursor();
+    cursor.nextBar = bar;
+
+    const auto& chain = chains[playerIndex];
+
+    // A one-bar step with a fill is all fill
+    if (!chain.steps.isEmpty() && getMainBars(chain.steps.getReference(0), cursor) <= 0) {
+        cursor.inFill = true;
+    }
+}
+
+void SongArranger::advanceCursor(int playerIndex, int bars) {
+    const auto& chain = chains[playerIndex];
+    auto& cursor = cursors[playerIndex];
+    const auto& step = chain.steps.getReference(cursor.stepIndex);
+
+    cursor.nextBar += bars;
+
+    const bool fillNext = !cursor.inFill
+                       && step.fillPatternIndex != INIConfig::MIDI::INACTIVE_PATTERN
+                       && cursor.repeat == step.repeats - 1;
+    if (fillNext) {
+        cursor.inFill = true;
+        return;
+    }
+
+    cursor.inFill = false;
+    if (++cursor.repeat < step.repeats) return;
+
+    cursor.repeat = 0;
+    if (++cursor.stepIndex >= chain.steps.size()) {
+        cursor.stepIndex = 0;
+        cursor.finished = !chain.loop;
+    }
+
+    if (!cursor.finished && getMainBars(chain.steps.getReference(cursor.stepIndex), cursor) <= 0) {
+        cursor.inFill = true;
+    }
+}
+
+void SongArranger::fillSection(Section& section, const Work& work, const TempoMap& map, const PatternBank* bank) {
+    section.generation = work.generation;
+    section.epoch = work.epoch;
+    section.startBar = work.startBar;
+    section.bars = work.bars;
+    section.patternIndex = work.patternIndex;
+    section.isFill = work.isFill;
+    section.loopBeats = 0.0;
+    section.numEvents = 0;
+
+    if (work.bars <= 0 || work.patternIndex == INIConfig::MIDI::INACTIVE_PATTERN) return;
+
+    const double startBeat = map.getBarStartBeat(work.startBar);
+    const double sectionBeats = map.getBarStartBeat(work.startBar + work.bars) - startBeat;
+    const double barBeats = map.getBeatsPerBarAt(startBeat);
+
+    // Never longer than the section itself
+    loadLoop(section, getFlatPattern(work.midiFile, bank), barBeats, sectionBeats, work.midiFile);
+}
+
+void SongArranger::compilePattern(Section& section, const juce::File& file, double barBeats, const PatternBank* bank) {
+    section = Section();
+    loadLoop(section, flattenPattern(file, bank), barBeats, std::numeric_limits<double>::max(), file);
+}
+
+void SongArranger::loadLoop(Section& section, const FlatPattern& pattern, double barBeats, double maxBeats, const juce::File& file) {
+    // Whole bars of the pattern
+    const double patternBars = std::ceil(pattern.lengthBeats / barBeats - 1.0e-9);
+    section.loopBeats = juce::jlimit(barBeats, maxBeats, patternBars * barBeats);
+    section.numEvents = 0;
+
+    // Notes still sounding at the loop point are let go just before it
+    const double lastBeat = std::nextafter(section.loopBeats, 0.0);
+
+    for (const auto& event : pattern.events) {
+        const bool pastLoop = event.beat >= section.loopBeats;
+        if (pastLoop && !isNoteOff(event)) continue;
+
+        if (section.numEvents >= INIConfig::MIDI::MAX_SECTION_EVENTS) {
+            DBG("SongArranger: Pattern too dense, truncating " + file.getFileName());
+            break;
+        }
+
+        auto& target = section.events[static_cast<size_t>(section.numEvents++)];
+        target = event;
+        if (pastLoop) target.beat = lastBeat;
+    }
+}
+
+const SongArranger::FlatPattern& SongArranger::getFlatPattern(const juce::File& file, const PatternBank* bank) {
+    const auto key = file.getFullPathName();
+    const auto modified = file.getLastModificationTime();
+
+    auto cached = flatPatterns.find(key);
+    if (cached != flatPatterns.end() && cached->second.modified == modified) {
+        return cached->second;
+    }
+
+    auto& pattern = flatPatterns[key];
+    pattern = flattenPattern(file, bank);
+    pattern.modified = modified;
+    return pattern;
+}
+
+SongArranger::FlatPattern SongArranger::flattenPattern(const juce::File& file, const PatternBank* bank) {
+    const auto compiled = bank != nullptr ? bank->find(file) : PatternBank::Pattern();
+    if (!compiled.isComplete()) return flattenMidiFile(file);
+
+    // Notes were paired when the bank was compiled; each becomes a note-on and a note-off
+    const auto channel = static_cast<juce::uint8>(juce::jlimit(1, 16, static_cast<int>(compiled.header->channel)) - 1);
+    FlatPattern pattern;
+    pattern.events.reserve(static_cast<size_t>(compiled.getNumNotes()) * 2);
+
+    for (int i = 0; i < compiled.getNumNotes(); ++i) {
+        const auto& note = compiled.notes[i];
+
+        Event noteOn;
+        noteOn.beat = static_cast<double>(note.tick) / PatternBank::ticksPerBeat;
+        noteOn.data[0] = static_cast<juce::uint8>(0x90 | channel);
+        noteOn.data[1] = note.note;
+        noteOn.data[2] = note.velocity;
+        noteOn.size = 3;
+        pattern.events.push_back(noteOn);
+
+        Event noteOff;
+        noteOff.beat = static_cast<double>(note.tick + note.duration) / PatternBank::ticksPerBeat;
+        noteOff.data[0] = static_cast<juce::uint8>(0x80 | channel);
+        noteOff.data[1] = note.note;
+        noteOff.size = 3;
+        pattern.events.push_back(noteOff);
+    }
+
+    sortEvents(pattern.events);
+    pattern.lengthBeats = compiled.getLengthBeats();
+    return pattern;
+}
+
+SongArranger::FlatPattern SongArranger::flattenMidiFile(const juce::File& file) {
+    FlatPattern pattern;
+
+    juce::FileInputStream stream(file);
+    juce::MidiFile midiFile;
+    if (!stream.openedOk() || !midiFile.readFrom(stream)) {
+        DBG("SongArranger: Could not read " + file.getFullPathName());
+        return pattern;
+    }
+
+    const int ticksPerBeat = midiFile.getTimeFormat();
+    if (ticksPerBeat <= 0) {
+        DBG("SongArranger: SMPTE-timed MIDI files are not supported");
+        return pattern;
+    }
+
+    for (int t = 0; t < midiFile.getNumTracks(); ++t) {
+        for (const auto* holder : *midiFile.getTrack(t)) {
+            const auto& message = holder->message;
+            const auto* raw = message.getRawData();
+            const int size = message.getRawDataSize();
+
+            // Channel voice messages only; meta events and SysEx carry nothing to play
+            if (size < 1 || size > static_cast<int>(sizeof(Event::data)) || raw[0] < 0x80 || raw[0] >= 0xF0) continue;
+
+            Event event;
+            event.beat = message.getTimeStamp() / ticksPerBeat;
+            event.size = static_cast<juce::uint8>(size);
+            std::memcpy(event.data, raw, static_cast<size_t>(size));
+            pattern.events.push_back(event);
+        }
+    }
+
+    sortEvents(pattern.events);
+    pattern.lengthBeats = midiFile.getLastTimestamp() / ticksPerBeat;
+    return pattern;
+}
+
+void SongArranger::sortEvents(std::vector<Event>& events) {
+    // Note-offs go first at equal times so a re-struck note is not cut short
+    std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        if (a.beat != b.beat) return a.beat < b.beat;
+        return isNoteOff(a) && !isNoteOff(b);
+    });
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
+#include "INIConfig.h"
+#include "LockFreeStructures.h"
+#include "PatternBank.h"
+#include "TempoMap.h"
+
+// Song mode: each player follows its own chain of patterns, every step played for a
+// number of bars and repeated, optionally with a fill in its last bar. A background
+// thread walks the chains a few bars ahead of the playhead, flattens each upcoming
+// pattern into a preallocated Section, from the pattern bank when it is compiled there
+// and from its MIDI file otherwise, and queues it for the audio thread, which only swaps
+// Sections in on their bar line and hands the old ones back. No MIDI file is opened or
+// parsed on the audio thread, and a pattern that arrives late leaves the previous one
+// looping instead of dropping out.
+class SongArranger : private juce::Thread {
+public:
+    struct Step {
+        int patternIndex = INIConfig::MIDI::INACTIVE_PATTERN;
+        juce::File midiFile;
+        int bars = INIConfig::Defaults::ONE_VALUE;
+        int repeats = INIConfig::Defaults::ONE_VALUE;
+        // Replaces the last bar of the final repeat
+        int fillPatternIndex = INIConfig::MIDI::INACTIVE_PATTERN;
+        juce::File fillMidiFile;
+    };
+
+    struct Chain {
+        juce::Array<Step> steps;
+        bool loop = true;
+    };
+
+    struct Event {
+        // Quarter-note beats from the start of the pattern
+        double beat = 0.0;
+        juce::uint8 data[3] = {};
+        juce::uint8 size = 0;
+    };
+
+    // One stretch of the song for one player; a Section without a pattern ends the chain
+    struct Section {
+        int generation = INIConfig::Defaults::ZERO_VALUE;
+        int epoch = INIConfig::Defaults::ZERO_VALUE;
+        int startBar = INIConfig::Defaults::ZERO_VALUE;
+        int bars = INIConfig::Defaults::ZERO_VALUE;
+        int patternIndex = INIConfig::MIDI::INACTIVE_PATTERN;
+        bool isFill = false;
+        // The pattern repeats at this length until the next Section takes over
+        double loopBeats = 0.0;
+        int numEvents = INIConfig::Defaults::ZERO_VALUE;
+        std::array<Event, INIConfig::MIDI::MAX_SECTION_EVENTS> events{};
+    };
+
+    SongArranger();
+    ~SongArranger() override;
+
+    // Message thread. The chain starts at startBar of the song; an empty chain leaves song mode
+    void setChain(int playerIndex, const Chain& chain, int startBar);
+    void clearChain(int playerIndex) { setChain(playerIndex, {}, INIConfig::Defaults::ZERO_VALUE); }
+    void setTempoMap(const TempoMap& map);
+    // Patterns found current in the bank are taken from it instead of their MIDI files
+    void setPatternBank(std::shared_ptr<const PatternBank> bank);
+
+    // Prepares everything due now on the calling thread instead of waiting for the arranger thread
+    void prepareSections();
+
+    // Any thread. rewind() starts every chain over from bar; it is a no-op if nothing
+    // has played since the last rewind to the same bar.
+    void rewind(int bar) noexcept;
+    bool isActive(int playerIndex) const noexcept;
+
+    // Audio thread
+    bool isCurrent(int playerIndex, const Section& section) const noexcept;
+    // Next prepared Section in song order, or nullptr if none is ready yet
+    Section* popSection(int playerIndex) noexcept;
+    void retireSection(int playerIndex, Section* section) noexcept;
+    void setPlayheadBar(int bar) noexcept { playheadBar.store(bar, std::memory_order_relaxed); }
+
+    // Reads and flattens a pattern outside song mode, looping on whole bars of barBeats
+    static void compilePattern(Section& section, const juce::File& file, double barBeats, const PatternBank* bank = nullptr);
+
+private:
+    struct Cursor {
+        int stepIndex = INIConfig::Defaults::ZERO_VALUE;
+        int repeat = INIConfig::Defaults::ZERO_VALUE;
+        bool inFill = false;
+        bool finished = false;
+        bool endQueued = false;
+        int nextBar = INIConfig::Defaults::ZERO_VALUE;
+    };
+
+    struct Work {
+        int generation = INIConfig::Defaults::ZERO_VALUE;
+        int epoch = INIConfig::Defaults::ZERO_VALUE;
+        int startBar = INIConfig::Defaults::ZERO_VALUE;
+        int bars = INIConfig::Defaults::ZERO_VALUE;
+        int patternIndex = INIConfig::MIDI::INACTIVE_PATTERN;
+        bool isFill = false;
+        juce::File midiFile;
+    };
+
+    struct FlatPattern {
+        juce::Time modified;
+        double lengthBeats = 0.0;
+        std::vector<Event> events;
+    };
+
+    void run() override;
+    bool takeNextWork(int playerIndex, Work& work);
+    void applyPendingRewind();
+    void resetCursor(int playerIndex, int bar);
+    void advanceCursor(int playerIndex, int bars);
+    static int getMainBars(const Step& step, const Cursor& cursor);
+    void fillSection(Section& section, const Work& work, const TempoMap& map, const PatternBank* bank);
+    static void loadLoop(Section& section, const FlatPattern& pattern, double barBeats, double maxBeats, const juce::File& file);
+    const FlatPattern& getFlatPattern(const juce::File& file, const PatternBank* bank);
+    static FlatPattern flattenPattern(const juce::File& file, const PatternBank* bank);
+    static FlatPattern flattenMidiFile(const juce::File& file);
+    static void sortEvents(std::vector<Event>& events);
+
+    // Chains, cursors, the tempo map and the bank are shared with the message thread
+    juce::CriticalSection chainLock;
+    Chain chains[INIConfig::Defaults::MAX_PLAYERS];
+    Cursor cursors[INIConfig::Defaults::MAX_PLAYERS];
+    TempoMap tempoMap;
+    std::shared_ptr<const PatternBank> patternBank;
+    int appliedEpoch = INIConfig::Defaults::ZERO_VALUE;
+
+    std::atomic<int> generations[INIConfig::Defaults::MAX_PLAYERS] = {};
+    std::atomic<bool> active[INIConfig::Defaults::MAX_PLAYERS] = {};
+    std::atomic<int> epoch{0};
+    std::atomic<int> rewindBar{0};
+    std::atomic<bool> playedSinceRewind{false};
+    std::atomic<int> playheadBar{0};
+
+    // Only one prefetch pass runs at a time, on the arranger thread or through prepareSections()
+    juce::CriticalSection prepareLock;
+    std::vector<Section> pool;
+    std::vector<Section*> spareSections[INIConfig::Defaults::MAX_PLAYERS];
+    std::map<juce::String, FlatPattern> flatPatterns;
+
+    using SectionQueue = SpscFifo<Section*, INIConfig::MIDI::SONG_SECTION_QUEUE_SIZE>;
+    SectionQueue readySections[INIConfig::Defaults::MAX_PLAYERS];
+    SectionQueue retiredSections[INIConfig::Defaults::MAX_PLAYERS];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SongArranger)
+};
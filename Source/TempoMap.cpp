@@ -0,0 +1,248 @@
+#include "TempoMap.h"
+#include <cmath>
+
+void TempoMap::reset(double bpm) noexcept {
+    numTempoSegments = 1;
+    tempoSegments[0] = TempoSegment();
+    tempoSegments[0].startBpm = juce::jlimit(static_cast<double>(INIConfig::Validation::MIN_TEMPO),
+                                             static_cast<double>(INIConfig::Validation::MAX_TEMPO), bpm);
+
+    numMeterSegments = 1;
+    meterSegments[0] = MeterSegment();
+
+    cachedTempoSegment = 0;
+}
+
+bool TempoMap::addTempoChange(double beat, double bpm, bool rampToNext) noexcept {
+    TempoSegment segment;
+    segment.startBeat = juce::jmax(0.0, beat);
+    segment.startBpm = juce::jlimit(static_cast<double>(INIConfig::Validation::MIN_TEMPO),
+                                    static_cast<double>(INIConfig::Validation::MAX_TEMPO), bpm);
+    segment.rampToNext = rampToNext;
+
+    int position = 0;
+    while (position < numTempoSegments && tempoSegments[static_cast<size_t>(position)].startBeat < segment.startBeat - BOUNDARY_EPSILON) {
+        ++position;
+    }
+
+    if (position < numTempoSegments && std::abs(tempoSegments[static_cast<size_t>(position)].startBeat - segment.startBeat) <= BOUNDARY_EPSILON) {
+        tempoSegments[static_cast<size_t>(position)] = segment;
+    } else {
+        if (numTempoSegments >= INIConfig::MIDI::MAX_TEMPO_CHANGES) {
+            DBG("TempoMap: Too many tempo changes");
+            return false;
+        }
+
+        for (int i = numTempoSegments; i > position; --i) {
+            tempoSegments[static_cast<size_t>(i)] = tempoSegments[static_cast<size_t>(i - 1)];
+        }
+        tempoSegments[static_cast<size_t>(position)] = segment;
+        ++numTempoSegments;
+    }
+
+    rebuild();
+    return true;
+}
+
+bool TempoMap::addMeterChange(int bar, int numerator, int denominator) noexcept {
+    if (bar < 0 ||
+        numerator < 1 || numerator > INIConfig::MIDI::MAX_METER_NUMERATOR ||
+        denominator < 1 || denominator > INIConfig::MIDI::MAX_METER_DENOMINATOR ||
+        !juce::isPowerOfTwo(denominator)) {
+        return false;
+    }
+
+    MeterSegment meter;
+    meter.startBar = bar;
+    meter.numerator = numerator;
+    meter.denominator = denominator;
+
+    int position = 0;
+    while (position < numMeterSegments && meterSegments[static_cast<size_t>(position)].startBar < bar) {
+        ++position;
+    }
+
+    if (position < numMeterSegments && meterSegments[static_cast<size_t>(position)].startBar == bar) {
+        meterSegments[static_cast<size_t>(position)] = meter;
+    } else {
+        if (numMeterSegments >= INIConfig::MIDI::MAX_METER_CHANGES) {
+            DBG("TempoMap: Too many meter changes");
+            return false;
+        }
+
+        for (int i = numMeterSegments; i > position; --i) {
+            meterSegments[static_cast<size_t>(i)] = meterSegments[static_cast<size_t>(i - 1)];
+        }
+        meterSegments[static_cast<size_t>(position)] = meter;
+        ++numMeterSegments;
+    }
+
+    rebuild();
+    return true;
+}
+
+double TempoMap::getTempoAt(double beat) const noexcept {
+    const auto& segment = tempoSegments[static_cast<size_t>(findTempoSegmentByBeat(beat))];
+    return segment.startBpm + segment.slope * juce::jmax(0.0, beat - segment.startBeat);
+}
+
+double TempoMap::beatToSeconds(double beat) const noexcept {
+    const auto& segment = tempoSegments[static_cast<size_t>(findTempoSegmentByBeat(beat))];
+    return segment.startSeconds + secondsIntoSegment(segment, beat - segment.startBeat);
+}
+
+double TempoMap::secondsToBeat(double seconds) const noexcept {
+    const auto& segment = tempoSegments[static_cast<size_t>(findTempoSegmentBySeconds(seconds))];
+    return segment.startBeat + beatsIntoSegment(segment, seconds - segment.startSeconds);
+}
+
+TempoMap::BarPosition TempoMap::getBarPosition(double beat) const noexcept {
+    const auto& meter = meterSegments[static_cast<size_t>(findMeterSegmentByBeat(beat))];
+    const double length = beatsPerBar(meter);
+
+    // A beat a rounding error short of a bar line counts as on it
+    const int barsIn = static_cast<int>(std::floor((beat - meter.startBeat) / length + BOUNDARY_EPSILON));
+
+    BarPosition position;
+    position.bar = meter.startBar + barsIn;
+    position.barStartBeat = meter.startBeat + barsIn * length;
+    position.beatsPerBar = length;
+    position.numerator = meter.numerator;
+    position.denominator = meter.denominator;
+    return position;
+}
+
+double TempoMap::getBarStartBeat(int bar) const noexcept {
+    int index = 0;
+    while (index + 1 < numMeterSegments && meterSegments[static_cast<size_t>(index + 1)].startBar <= bar) {
+        ++index;
+    }
+
+    const auto& meter = meterSegments[static_cast<size_t>(index)];
+    return meter.startBeat + (bar - meter.startBar) * beatsPerBar(meter);
+}
+
+double TempoMap::getNextGridBoundary(double beat, int quantization) const noexcept {
+    if (quantization <= 0) return beat;
+
+    const auto position = getBarPosition(beat);
+    const double barEnd = position.barStartBeat + position.beatsPerBar;
+    const double gridBeats = quantization == 1
+        ? position.beatsPerBar
+        : INIConfig::Defaults::BEATS_PER_BAR / static_cast<double>(quantization);
+
+    const double next = position.barStartBeat
+                      + std::ceil((beat - position.barStartBeat - BOUNDARY_EPSILON) / gridBeats) * gridBeats;
+    return juce::jmin(next, barEnd);
+}
+
+double TempoMap::secondsIntoSegment(const TempoSegment& segment, double beats) noexcept {
+    // Before the first change the starting tempo simply holds
+    if (segment.slope == 0.0 || beats <= 0.0) {
+        return beats * INIConfig::Defaults::SECONDS_PER_MINUTE / segment.startBpm;
+    }
+
+    // Tempo linear in beats: dt = 60 db / (bpm0 + slope * b)
+    return INIConfig::Defaults::SECONDS_PER_MINUTE / segment.slope * std::log1p(segment.slope * beats / segment.startBpm);
+}
+
+double TempoMap::beatsIntoSegment(const TempoSegment& segment, double seconds) noexcept {
+    if (segment.slope == 0.0 || seconds <= 0.0) {
+        return seconds * segment.startBpm / INIConfig::Defaults::SECONDS_PER_MINUTE;
+    }
+
+    return segment.startBpm / segment.slope * std::expm1(segment.slope * seconds / INIConfig::Defaults::SECONDS_PER_MINUTE);
+}
+
+double TempoMap::beatsPerBar(const MeterSegment& meter) noexcept {
+    return meter.numerator * INIConfig::Defaults::BEATS_PER_BAR / meter.denominator;
+}
+
+void TempoMap::rebuild() noexcept {
+    for (int i = 0; i < numTempoSegments; ++i) {
+        auto& segment = tempoSegments[static_cast<size_t>(i)];
+
+        segment.slope = 0.0;
+        if (segment.rampToNext && i + 1 < numTempoSegments) {
+            const auto& next = tempoSegments[static_cast<size_t>(i + 1)];
+            segment.slope = (next.startBpm - segment.startBpm) / (next.startBeat - segment.startBeat);
+        }
+
+        if (i == 0) {
+            segment.startSeconds = segment.startBeat * INIConfig::Defaults::SECONDS_PER_MINUTE / segment.startBpm;
+        } else {
+            const auto& previous = tempoSegments[static_cast<size_t>(i - 1)];
+            segment.startSeconds = previous.startSeconds + secondsIntoSegment(previous, segment.startBeat - previous.startBeat);
+        }
+    }
+
+    for (int i = 1; i < numMeterSegments; ++i) {
+        const auto& previous = meterSegments[static_cast<size_t>(i - 1)];
+        auto& meter = meterSegments[static_cast<size_t>(i)];
+        meter.startBeat = previous.startBeat + (meter.startBar - previous.startBar) * beatsPerBar(previous);
+    }
+
+    cachedTempoSegment = 0;
+}
+
+int TempoMap::findTempoSegmentByBeat(double beat) const noexcept {
+    auto covers = [this, beat](int index) {
+        return index < numTempoSegments
+            && (index == 0 || tempoSegments[static_cast<size_t>(index)].startBeat <= beat)
+            && (index + 1 == numTempoSegments || beat < tempoSegments[static_cast<size_t>(index + 1)].startBeat);
+    };
+
+    // Playback moves forward, so the cached segment or the one after it nearly always matches
+    if (covers(cachedTempoSegment)) return cachedTempoSegment;
+    if (covers(cachedTempoSegment + 1)) return ++cachedTempoSegment;
+
+    int low = 0;
+    int high = numTempoSegments - 1;
+    while (low < high) {
+        const int mid = (low + high + 1) / 2;
+        if (tempoSegments[static_cast<size_t>(mid)].startBeat <= beat)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+
+    cachedTempoSegment = low;
+    return low;
+}
+
+int TempoMap::findTempoSegmentBySeconds(double seconds) const noexcept {
+    auto covers = [this, seconds](int index) {
+        return index < numTempoSegments
+            && (index == 0 || tempoSegments[static_cast<size_t>(index)].startSeconds <= seconds)
+            && (index + 1 == numTempoSegments || seconds < tempoSegments[static_cast<size_t>(index + 1)].startSeconds);
+    };
+
+    if (covers(cachedTempoSegment)) return cachedTempoSegment;
+    if (covers(cachedTempoSegment + 1)) return ++cachedTempoSegment;
+
+    int low = 0;
+    int high = numTempoSegments - 1;
+    while (low < high) {
+        const int mid = (low + high + 1) / 2;
+        if (tempoSegments[static_cast<size_t>(mid)].startSeconds <= seconds)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+
+    cachedTempoSegment = low;
+    return low;
+}
+
+int TempoMap::findMeterSegmentByBeat(double beat) const noexcept {
+    int low = 0;
+    int high = numMeterSegments - 1;
+    while (low < high) {
+        const int mid = (low + high + 1) / 2;
+        if (meterSegments[static_cast<size_t>(mid)].startBeat <= beat + BOUNDARY_EPSILON)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+    return low;
+}
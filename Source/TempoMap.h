@@ -0,0 +1,83 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include "INIConfig.h"
+
+// Tempo and meter over the song timeline, in quarter-note beats from the start of the
+// song. A tempo change holds until the next one or ramps linearly (per beat) into it.
+// Beat <-> time conversion is closed-form inside a segment and a binary search across
+// segments; the last segment found is cached because playback keeps asking about the
+// same neighbourhood. Meter changes fall on bar lines.
+// Fixed capacity and plain data, so a copy can be published to the audio thread; the
+// lookup cache means each copy has a single reader.
+class TempoMap {
+public:
+    struct BarPosition {
+        int bar = INIConfig::Defaults::ZERO_VALUE;
+        double barStartBeat = 0.0;
+        double beatsPerBar = INIConfig::Defaults::BEATS_PER_BAR;
+        int numerator = static_cast<int>(INIConfig::Defaults::BEATS_PER_BAR);
+        int denominator = static_cast<int>(INIConfig::Defaults::BEATS_PER_BAR);
+    };
+
+    TempoMap() noexcept { reset(INIConfig::Defaults::DEFAULT_TEMPO); }
+
+    // A single constant tempo in 4/4
+    void reset(double bpm) noexcept;
+
+    // A change at beat 0 replaces the starting tempo; rampToNext glides into the following change
+    bool addTempoChange(double beat, double bpm, bool rampToNext = false) noexcept;
+    // Meter from the start of bar on; the denominator must be a power of two
+    bool addMeterChange(int bar, int numerator, int denominator) noexcept;
+
+    bool hasTempoChanges() const noexcept { return numTempoSegments > 1; }
+    int getNumTempoChanges() const noexcept { return numTempoSegments; }
+    int getNumMeterChanges() const noexcept { return numMeterSegments; }
+
+    double getTempoAt(double beat) const noexcept;
+    double beatToSeconds(double beat) const noexcept;
+    double secondsToBeat(double seconds) const noexcept;
+
+    BarPosition getBarPosition(double beat) const noexcept;
+    double getBarStartBeat(int bar) const noexcept;
+    double getBeatsPerBarAt(double beat) const noexcept { return getBarPosition(beat).beatsPerBar; }
+
+    // Next multiple of a note division (4 = quarter, 16 = sixteenth) counted from the bar
+    // line and never past the next one; 1 is the next bar line and 0 is beat itself.
+    // A beat already on a boundary is its own boundary.
+    double getNextGridBoundary(double beat, int quantization) const noexcept;
+
+private:
+    struct TempoSegment {
+        double startBeat = 0.0;
+        double startSeconds = 0.0;
+        double startBpm = INIConfig::Defaults::DEFAULT_TEMPO;
+        double slope = 0.0;
+        bool rampToNext = false;
+    };
+
+    struct MeterSegment {
+        int startBar = INIConfig::Defaults::ZERO_VALUE;
+        double startBeat = 0.0;
+        int numerator = static_cast<int>(INIConfig::Defaults::BEATS_PER_BAR);
+        int denominator = static_cast<int>(INIConfig::Defaults::BEATS_PER_BAR);
+    };
+
+    static constexpr double BOUNDARY_EPSILON = 1.0e-9;
+
+    static double secondsIntoSegment(const TempoSegment& segment, double beats) noexcept;
+    static double beatsIntoSegment(const TempoSegment& segment, double seconds) noexcept;
+    static double beatsPerBar(const MeterSegment& meter) noexcept;
+
+    void rebuild() noexcept;
+    int findTempoSegmentByBeat(double beat) const noexcept;
+    int findTempoSegmentBySeconds(double seconds) const noexcept;
+    int findMeterSegmentByBeat(double beat) const noexcept;
+
+    std::array<TempoSegment, INIConfig::MIDI::MAX_TEMPO_CHANGES> tempoSegments{};
+    std::array<MeterSegment, INIConfig::MIDI::MAX_METER_CHANGES> meterSegments{};
+    int numTempoSegments = 0;
+    int numMeterSegments = 0;
+    mutable int cachedTempoSegment = 0;
+};
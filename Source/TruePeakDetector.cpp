@@ -0,0 +1,68 @@
+#include "TruePeakDetector.h"
+#include <cmath>
+
+const TruePeakDetector::Coefficients& TruePeakDetector::getCoefficients() {
+    static const Coefficients coefficients = [] {
+        constexpr int length = OVERSAMPLING * TAPS_PER_PHASE;
+        const double centre = (length - 1) * 0.5;
+
+        Coefficients taps{};
+        for (int n = 0; n < length; ++n) {
+            // Blackman-windowed sinc, cut off at the original Nyquist frequency
+            const double x = (n - centre) / OVERSAMPLING;
+            const double sinc = std::abs(x) < 1.0e-9 ? 1.0 : std::sin(juce::MathConstants<double>::pi * x) / (juce::MathConstants<double>::pi * x);
+            const double w = 0.42 - 0.5 * std::cos(juce::MathConstants<double>::twoPi * n / (length - 1))
+                                  + 0.08 * std::cos(2.0 * juce::MathConstants<double>::twoPi * n / (length - 1));
+            taps[static_cast<size_t>(n / OVERSAMPLING)].phase[n % OVERSAMPLING] = static_cast<float>(sinc * w);
+        }
+
+        // Unity DC gain per phase
+        for (int p = 0; p < OVERSAMPLING; ++p) {
+            float sum = 0.0f;
+            for (const auto& tap : taps)
+                sum += tap.phase[p];
+            for (auto& tap : taps)
+                tap.phase[p] /= sum;
+        }
+
+        return taps;
+    }();
+
+    return coefficients;
+}
+
+void TruePeakDetector::reset() noexcept {
+    history.fill(0.0f);
+    writePosition = 0;
+}
+
+float TruePeakDetector::processSample(float input) noexcept {
+    // History is stored twice so the newest TAPS_PER_PHASE samples are always contiguous
+    history[static_cast<size_t>(writePosition)] = input;
+    history[static_cast<size_t>(writePosition + TAPS_PER_PHASE)] = input;
+    writePosition = (writePosition + 1) % TAPS_PER_PHASE;
+
+    const float* window = history.data() + writePosition;
+    const auto& taps = getCoefficients();
+    float sums[OVERSAMPLING] = {};
+
+    for (int tap = 0; tap < TAPS_PER_PHASE; ++tap) {
+        const float x = window[tap];
+        const float* c = taps[static_cast<size_t>(tap)].phase;
+        for (int p = 0; p < OVERSAMPLING; ++p)
+            sums[p] += x * c[p];
+    }
+
+    float peak = 0.0f;
+    for (int p = 0; p < OVERSAMPLING; ++p)
+        peak = juce::jmax(peak, std::abs(sums[p]));
+
+    return peak;
+}
+
+float TruePeakDetector::process(const float* data, int numSamples) noexcept {
+    float peak = 0.0f;
+    for (int i = 0; i < numSamples; ++i)
+        peak = juce::jmax(peak, processSample(data[i]));
+    return peak;
+}
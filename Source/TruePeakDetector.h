@@ -0,0 +1,31 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+// 4x polyphase interpolator used to estimate inter-sample (true) peaks.
+// Coefficients are stored tap-major so each tap multiplies all four phases at once;
+// the inner loop is a single 4-wide multiply-add the compiler maps onto SSE/NEON.
+class TruePeakDetector {
+public:
+    static constexpr int OVERSAMPLING = 4;
+    static constexpr int TAPS_PER_PHASE = 12;
+
+    // Group delay of the interpolator, in input samples
+    static constexpr int getLatencySamples() noexcept { return TAPS_PER_PHASE / 2; }
+
+    void reset() noexcept;
+    float processSample(float input) noexcept;
+    float process(const float* data, int numSamples) noexcept;
+
+private:
+    struct alignas(16) TapCoefficients {
+        float phase[OVERSAMPLING];
+    };
+
+    using Coefficients = std::array<TapCoefficients, TAPS_PER_PHASE>;
+    static const Coefficients& getCoefficients();
+
+    std::array<float, TAPS_PER_PHASE * 2> history{};
+    int writePosition = 0;
+};
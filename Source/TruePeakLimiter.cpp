@@ -0,0 +1,168 @@
+#include "TruePeakLimiter.h"
+#include <cmath>
+
+int TruePeakLimiter::lookaheadToSamples(float lookaheadMs, double sampleRate) noexcept {
+    const float clampedMs = juce::jlimit(INIConfig::Audio::MIN_LIMITER_LOOKAHEAD_MS,
+                                         INIConfig::Audio::MAX_LIMITER_LOOKAHEAD_MS, lookaheadMs);
+    // The hold window has to cover the detector's own delay or peaks slip past it
+    return juce::jmax(TruePeakDetector::getLatencySamples() + 1,
+                      juce::roundToInt(clampedMs * 0.001 * sampleRate));
+}
+
+int TruePeakLimiter::calculateLatencySamples(float lookaheadMs, double sampleRate) noexcept {
+    return lookaheadToSamples(lookaheadMs, sampleRate) + TruePeakDetector::getLatencySamples() - 1;
+}
+
+void TruePeakLimiter::prepare(const juce::dsp::ProcessSpec& spec) {
+    sampleRate = spec.sampleRate;
+
+    // Size everything for the longest lookahead so changing it never allocates
+    capacity = calculateLatencySamples(INIConfig::Audio::MAX_LIMITER_LOOKAHEAD_MS, sampleRate) + 1;
+
+    for (auto& line : delayLines)
+        line.assign(static_cast<size_t>(capacity), 0.0f);
+
+    holdValues.assign(static_cast<size_t>(capacity), 1.0f);
+    holdIndices.assign(static_cast<size_t>(capacity), 0);
+    averageBuffer.assign(static_cast<size_t>(capacity), 1.0f);
+
+    lookaheadSamples = lookaheadToSamples(lookaheadMs, sampleRate);
+    delaySamples = calculateLatencySamples(lookaheadMs, sampleRate);
+
+    reset();
+}
+
+void TruePeakLimiter::reset() noexcept {
+    for (auto& detector : detectors)
+        detector.reset();
+
+    for (auto& line : delayLines)
+        std::fill(line.begin(), line.end(), 0.0f);
+    delayWritePosition = 0;
+
+    resetGainState();
+}
+
+void TruePeakLimiter::resetGainState() noexcept {
+    holdHead = 0;
+    holdSize = 0;
+    sampleCounter = 0;
+
+    std::fill(averageBuffer.begin(), averageBuffer.end(), 1.0f);
+    averagePosition = 0;
+    averageSum = static_cast<double>(lookaheadSamples);
+
+    envelope = 1.0f;
+}
+
+void TruePeakLimiter::setBypassed(bool shouldBeBypassed) noexcept {
+    // Detection is skipped while bypassed, so start clean rather than from stale gain
+    if (bypassed && !shouldBeBypassed) {
+        for (auto& detector : detectors)
+            detector.reset();
+        resetGainState();
+    }
+
+    bypassed = shouldBeBypassed;
+}
+
+void TruePeakLimiter::setThreshold(float thresholdDb) noexcept {
+    ceiling = juce::Decibels::decibelsToGain(thresholdDb);
+}
+
+void TruePeakLimiter::setRelease(float releaseMs) noexcept {
+    releaseCoeff = static_cast<float>(std::exp(-1.0 / (juce::jmax(1.0f, releaseMs) * 0.001 * sampleRate)));
+}
+
+void TruePeakLimiter::setLookahead(float newLookaheadMs) noexcept {
+    lookaheadMs = newLookaheadMs;
+
+    if (capacity == 0)
+        return;
+
+    const int newLookahead = lookaheadToSamples(lookaheadMs, sampleRate);
+    if (newLookahead == lookaheadSamples)
+        return;
+
+    // Latency changes with the lookahead, so the delay contents are no longer aligned
+    lookaheadSamples = newLookahead;
+    delaySamples = calculateLatencySamples(lookaheadMs, sampleRate);
+    reset();
+}
+
+float TruePeakLimiter::pushHold(float requiredGain) noexcept {
+    const int window = lookaheadSamples + 1;
+
+    while (holdSize > 0) {
+        const int back = (holdHead + holdSize - 1) % capacity;
+        if (holdValues[static_cast<size_t>(back)] < requiredGain)
+            break;
+        --holdSize;
+    }
+
+    const int tail = (holdHead + holdSize) % capacity;
+    holdValues[static_cast<size_t>(tail)] = requiredGain;
+    holdIndices[static_cast<size_t>(tail)] = sampleCounter;
+    ++holdSize;
+
+    while (holdIndices[static_cast<size_t>(holdHead)] <= sampleCounter - window) {
+        holdHead = (holdHead + 1) % capacity;
+        --holdSize;
+    }
+
+    ++sampleCounter;
+    return holdValues[static_cast<size_t>(holdHead)];
+}
+
+float TruePeakLimiter::pushAverage(float heldGain) noexcept {
+    averageSum += static_cast<double>(heldGain) - static_cast<double>(averageBuffer[static_cast<size_t>(averagePosition)]);
+    averageBuffer[static_cast<size_t>(averagePosition)] = heldGain;
+    averagePosition = (averagePosition + 1) % lookaheadSamples;
+
+    return static_cast<float>(averageSum / lookaheadSamples);
+}
+
+void TruePeakLimiter::process(juce::AudioBuffer<float>& buffer) noexcept {
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = juce::jmin(NUM_CHANNELS, buffer.getNumChannels());
+    if (capacity == 0 || numSamples <= 0 || numChannels <= 0)
+        return;
+
+    std::array<float*, NUM_CHANNELS> data{};
+    for (int ch = 0; ch < numChannels; ++ch)
+        data[static_cast<size_t>(ch)] = buffer.getWritePointer(ch);
+
+    const int delayLength = delaySamples + 1;
+
+    for (int i = 0; i < numSamples; ++i) {
+        const int readPosition = (delayWritePosition + delayLength - delaySamples) % delayLength;
+        float gain = 1.0f;
+
+        if (!bypassed) {
+            float peak = 0.0f;
+            for (int ch = 0; ch < numChannels; ++ch) {
+                const float x = data[static_cast<size_t>(ch)][i];
+                peak = juce::jmax(peak, std::abs(x), detectors[static_cast<size_t>(ch)].processSample(x));
+            }
+
+            const float required = peak > ceiling ? ceiling / peak : 1.0f;
+            const float smoothed = pushAverage(pushHold(required));
+
+            // Attack is handled by the lookahead ramp; only the recovery needs a release curve
+            envelope = smoothed < envelope ? smoothed : smoothed + releaseCoeff * (envelope - smoothed);
+            gain = envelope;
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch) {
+            auto& line = delayLines[static_cast<size_t>(ch)];
+            float* channelData = data[static_cast<size_t>(ch)];
+
+            const float delayed = line[static_cast<size_t>(readPosition)];
+            line[static_cast<size_t>(delayWritePosition)] = channelData[i];
+
+            channelData[i] = bypassed ? delayed : juce::jlimit(-ceiling, ceiling, delayed * gain);
+        }
+
+        delayWritePosition = (delayWritePosition + 1) % delayLength;
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <vector>
+#include "INIConfig.h"
+#include "TruePeakDetector.h"
+
+// Lookahead brickwall limiter working on 4x oversampled (true) peaks.
+// The gain needed to keep each detected peak under the ceiling is held for the
+// lookahead window and smoothed with a boxcar of the same length, so the gain has
+// fully ramped down by the time the delayed audio reaches it. Latency is constant
+// for a given lookahead, including while bypassed, so host compensation stays valid.
+class TruePeakLimiter {
+public:
+    static constexpr int NUM_CHANNELS = 2;
+
+    TruePeakLimiter() = default;
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset() noexcept;
+
+    void setThreshold(float thresholdDb) noexcept;
+    void setRelease(float releaseMs) noexcept;
+    void setLookahead(float lookaheadMs) noexcept;
+    void setBypassed(bool shouldBeBypassed) noexcept;
+
+    int getLatencySamples() const noexcept { return delaySamples; }
+    static int calculateLatencySamples(float lookaheadMs, double sampleRate) noexcept;
+
+    void process(juce::AudioBuffer<float>& buffer) noexcept;
+
+private:
+    static int lookaheadToSamples(float lookaheadMs, double sampleRate) noexcept;
+
+    void resetGainState() noexcept;
+    float pushHold(float requiredGain) noexcept;
+    float pushAverage(float heldGain) noexcept;
+
+    double sampleRate = static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE);
+    float lookaheadMs = static_cast<float>(INIConfig::Defaults::DEFAULT_LIMITER_LOOKAHEAD);
+    int lookaheadSamples = 0;
+    int delaySamples = 0;
+    int capacity = 0;
+
+    float ceiling = 1.0f;
+    float releaseCoeff = 0.0f;
+    float envelope = 1.0f;
+    bool bypassed = false;
+
+    std::array<TruePeakDetector, NUM_CHANNELS> detectors;
+
+    // Delay line for the audio path
+    std::array<std::vector<float>, NUM_CHANNELS> delayLines;
+    int delayWritePosition = 0;
+
+    // Sliding-window minimum over the lookahead (monotonic queue in a ring)
+    std::vector<float> holdValues;
+    std::vector<juce::int64> holdIndices;
+    int holdHead = 0;
+    int holdSize = 0;
+    juce::int64 sampleCounter = 0;
+
+    // Boxcar average over the lookahead
+    std::vector<float> averageBuffer;
+    int averagePosition = 0;
+    double averageSum = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TruePeakLimiter)
+};
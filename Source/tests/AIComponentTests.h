@@ -1,9 +1,13 @@
 #pragma once
 #include <JuceHeader.h>
 #include "../PatternSuggestionEngine.h"
+#include "../AdvancedAILearning.h"
+#include "../OnlineStatistics.h"
+#include "../GrooveSimilarityIndex.h"
 #include "../AIAssistantPanel.h"
 #include "../AutoMixAssistant.h"
 #include "../Mixer.h"
+#include "../SFZEngine.h"
 #include "../PatternManager.h"
 #include "../MidiAnalysisTypes.h"
 #include "../INIConfig.h"
@@ -29,9 +33,18 @@ public:
         beginTest("Pattern Similarity Matching");
         testPatternSimilarity();
 
+        beginTest("Groove Similarity Index");
+        testGrooveSimilarityIndex();
+
+        beginTest("Batch Pattern Generation");
+        testBatchGeneration();
+
         beginTest("Performance Adaptation");
         testPerformanceAdaptation();
 
+        beginTest("Online Learning Statistics");
+        testOnlineLearning();
+
         beginTest("Learning from Patterns");
         testPatternLearning();
 
@@ -41,6 +54,12 @@ public:
         beginTest("Mix Analysis Integration");
         testMixAnalysis();
 
+        beginTest("Measured Mix Analysis");
+        testMeasuredMixAnalysis();
+
+        beginTest("Measured Mix Suggestions");
+        testMeasuredMixSuggestions();
+
         beginTest("Pattern Suggestion UI");
         testPatternSuggestionUI();
 
@@ -175,17 +194,202 @@ private:
         groove3.grooveTightness = 0.5f;
         groove3.tempo = 180.0f;
         
+        // Twice as fast as anything else, which is too far away to be offered at all
+        MidiGrooveAnalysis groove4 = groove1;
+        groove4.tempo = 240.0f;
+        
         juce::Array<MidiGrooveAnalysis> library;
         library.add(groove2);
         library.add(groove3);
+        library.add(groove4);
+        engine->setGrooveLibrary(library);
+        expectEquals(engine->getGrooveLibrarySize(), library.size());
         
-        auto similarGrooves = engine->findSimilarGrooves(groove1, library);
+        auto similarGrooves = engine->findSimilarGrooves(groove1);
         expect(!similarGrooves.isEmpty(), "Should find similar grooves");
+        expectEquals(similarGrooves.size(), 2, "A groove at double the tempo should not be offered");
         
         if (similarGrooves.size() >= 2) {
             expect(similarGrooves[0].matchScore > similarGrooves[1].matchScore,
                    "More similar grooves should have higher match scores");
+            expectEquals(similarGrooves[0].analysis.tempo, groove2.tempo);
+        }
+
+        // The index is kept between searches
+        expectEquals(engine->findSimilarGrooves(groove1, 1).size(), 1);
+    }
+
+    void testGrooveSimilarityIndex() {
+        // Enough rows for the index to be exercised without slowing every debug load; the
+        // 100,000 groove timing check is the batch analyzer's --benchmark
+        juce::Random random(42);
+        const int numGrooves = 4000;
+        const int maxMatches = 10;
+
+        juce::Array<MidiGrooveAnalysis> grooves;
+        grooves.ensureStorageAllocated(numGrooves);
+        for (int i = 0; i < numGrooves; ++i) {
+            MidiGrooveAnalysis groove;
+            groove.tempo = 60.0f + random.nextFloat() * 120.0f;
+            groove.averageSwing = 50.0f + random.nextFloat() * 25.0f;
+            groove.grooveTightness = random.nextFloat();
+            groove.averageVelocity = 40.0f + random.nextFloat() * 80.0f;
+            groove.noteDensity = random.nextFloat() * 8.0f;
+            for (int note = 0; note < 6; ++note) {
+                groove.noteDistribution.add(random.nextInt(32));
+            }
+            grooves.add(groove);
+        }
+
+        GrooveSimilarityIndex index;
+        index.reserve(numGrooves);
+        for (const auto& groove : grooves) {
+            index.add(groove);
+        }
+        index.build();
+        expectEquals(index.size(), numGrooves);
+
+        // Against a direct comparison of every feature vector
+        const int targetIndex = 1234;
+        const auto matches = index.findNearest(grooves.getReference(targetIndex), maxMatches, targetIndex);
+        expectEquals(matches.size(), maxMatches);
+
+        auto squaredDistance = [&grooves, targetIndex](int i) {
+            float a[GrooveSimilarityIndex::numFeatures], b[GrooveSimilarityIndex::numFeatures];
+            GrooveSimilarityIndex::getFeatures(grooves.getReference(targetIndex), a);
+            GrooveSimilarityIndex::getFeatures(grooves.getReference(i), b);
+
+            float sum = 0.0f;
+            for (int f = 0; f < GrooveSimilarityIndex::numFeatures; ++f) {
+                sum += (a[f] - b[f]) * (a[f] - b[f]);
+            }
+            return sum;
+        };
+
+        std::vector<float> distances;
+        for (int i = 0; i < numGrooves; ++i) {
+            if (i != targetIndex) distances.push_back(squaredDistance(i));
+        }
+        std::nth_element(distances.begin(), distances.begin() + (maxMatches - 1), distances.end());
+        const float furthestExpected = distances[static_cast<size_t>(maxMatches - 1)];
+
+        bool exact = true;
+        for (int i = 0; i < matches.size(); ++i) {
+            exact = exact && matches[i].index != targetIndex
+                  && squaredDistance(matches[i].index) <= furthestExpected + 1.0e-4f
+                  && (i == 0 || matches[i].score <= matches[i - 1].score);
+        }
+        expect(exact, "The index should return the true nearest grooves, closest first");
+
+        const int numQueries = 20;
+        auto startTime = juce::Time::getHighResolutionTicks();
+        for (int q = 0; q < numQueries; ++q) {
+            const int queryIndex = (q * 997) % numGrooves;
+            index.findNearest(grooves.getReference(queryIndex), maxMatches, queryIndex);
+        }
+        auto endTime = juce::Time::getHighResolutionTicks();
+        double averageQueryMs = juce::Time::highResolutionTicksToSeconds(endTime - startTime) * 1000.0 / numQueries;
+
+        logMessage("Top-" + juce::String(maxMatches) + " of " + juce::String(numGrooves) + " grooves: "
+                   + juce::String(averageQueryMs, 3) + "ms");
+
+        // Coarse lists still find a groove that is in the index
+        const int coarseTarget = 3210;
+        index.build(true);
+        expect(index.usesCoarseLists());
+        const auto coarse = index.findNearest(grooves.getReference(coarseTarget), 1);
+        expect(coarse.size() == 1 && coarse[0].index == coarseTarget && coarse[0].score > 0.99f);
+    }
+
+    void testBatchGeneration() {
+        auto engine = std::make_unique<PatternSuggestionEngine>();
+
+        PatternSuggestionEngine::BatchRequest request;
+        for (int genre = 0; genre < 8; ++genre) {
+            PatternSuggestionEngine::SuggestionParams params;
+            params.genre = static_cast<PatternSuggestionEngine::Genre>(genre);
+            params.complexity = 0.5f;
+            params.humanization = 0.3f;
+            params.bars = 2;
+            request.variations.add(params);
+        }
+        request.numCandidates = 64;
+        request.seed = 1234;
+
+        juce::Array<int> streamed;
+        const auto ranked = engine->generateBatch(request, [&streamed](const PatternSuggestionEngine::Candidate& candidate) {
+            streamed.add(candidate.index);
+            return true;
+        });
+
+        expectEquals(ranked.size(), request.numCandidates);
+        expectEquals(streamed.size(), request.numCandidates);
+
+        bool ordered = true;
+        bool scored = true;
+        for (int i = 0; i < ranked.size(); ++i) {
+            ordered = ordered && (i == 0 || ranked[i].matchScore <= ranked[i - 1].matchScore);
+            scored = scored && !ranked[i].notes.empty() && ranked[i].matchScore > 0.0f && ranked[i].matchScore <= 1.0f;
+        }
+        expect(ordered, "Candidates should be ranked best first");
+        expect(scored, "Every candidate should have notes and a score");
+
+        // The same seed gives the same patterns, whichever thread made them
+        const auto& best = ranked.getReference(0);
+        const auto again = engine->generateCandidate(request.variations[best.index % request.variations.size()], best.seed);
+        bool same = again.notes.size() == best.notes.size();
+        for (size_t i = 0; same && i < best.notes.size(); ++i) {
+            same = again.notes[i].tick == best.notes[i].tick && again.notes[i].note == best.notes[i].note
+                && again.notes[i].velocity == best.notes[i].velocity;
+        }
+        expect(same, "A candidate should be reproducible from its seed");
+        expect(best.seed == PatternSuggestionEngine::getCandidateSeed(request.seed, best.index));
+        expectEquals(best.toSequence().getNumEvents(), static_cast<int>(best.notes.size()) * 2);
+
+        // Ranked against a target, the candidate built from it comes out on top
+        request.hasTarget = true;
+        request.target = best.analysis;
+        const auto targeted = engine->generateBatch(request);
+        expect(!targeted.isEmpty() && targeted[0].index == best.index, "The candidate matching the target should rank first");
+
+        // Cancelling stops the batch early
+        int reported = 0;
+        const auto cancelled = engine->generateBatch(request, [&reported](const PatternSuggestionEngine::Candidate&) {
+            return ++reported < 4;
+        });
+        expectEquals(reported, 4);
+        expect(cancelled.size() >= reported && cancelled.size() <= request.numCandidates);
+
+        // A batch run in the background reports only on the message thread, and nothing once cancelled
+        bool asyncReported = false;
+        engine->generateBatchAsync(request,
+            [&asyncReported](const PatternSuggestionEngine::Candidate&) { return asyncReported = true; },
+            [&asyncReported](const juce::Array<PatternSuggestionEngine::Candidate>&) { asyncReported = true; });
+        expect(engine->isGeneratingBatch(), "The batch should run in the background");
+        engine->cancelBatch();
+        expect(!engine->isGeneratingBatch());
+        expect(!asyncReported, "A batch should report only through the message loop");
+        expectEquals(engine->generateBatch(request).size(), request.numCandidates);
+
+        // Throughput against one suggestion at a time
+        request.numCandidates = INIConfig::MIDI::PATTERN_BATCH_MAX_CANDIDATES;
+        auto startTime = juce::Time::getHighResolutionTicks();
+        const auto batch = engine->generateBatch(request);
+        auto endTime = juce::Time::getHighResolutionTicks();
+        const double batchSeconds = juce::Time::highResolutionTicksToSeconds(endTime - startTime);
+
+        const int numSerial = 100;
+        startTime = juce::Time::getHighResolutionTicks();
+        for (int i = 0; i < numSerial; ++i) {
+            engine->generatePattern(request.variations[i % request.variations.size()]);
         }
+        endTime = juce::Time::getHighResolutionTicks();
+        const double serialSeconds = juce::Time::highResolutionTicksToSeconds(endTime - startTime);
+
+        expectEquals(batch.size(), request.numCandidates);
+        logMessage("Batch generation: " + juce::String(batch.size() / juce::jmax(batchSeconds, 1.0e-6), 0) + " patterns/sec, "
+                   + "one at a time: " + juce::String(numSerial / juce::jmax(serialSeconds, 1.0e-6), 0) + " patterns/sec");
+        expect(batchSeconds < 5.0, "A full batch should be generated within 5 seconds");
     }
 
     void testPerformanceAdaptation() {
@@ -209,6 +413,61 @@ private:
         expect(adaptedPattern.pattern.getNumEvents() > 0, "Adapted pattern should have events");
     }
 
+    void testOnlineLearning() {
+        RunningStatistics stats;
+        for (const double value : { 2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0 }) {
+            stats.add(value);
+        }
+        expectWithinAbsoluteError(stats.getMean(), 5.0, 1.0e-9);
+        expectWithinAbsoluteError(stats.getStandardDeviation(), 2.0, 1.0e-9);
+
+        // Every item is as likely to be kept as any other
+        int kept[100] = {};
+        for (int run = 0; run < 2000; ++run) {
+            ReservoirSample<int, 10> sample(run);
+            for (int i = 0; i < 100; ++i) {
+                sample.add(i);
+            }
+            expectEquals(sample.getSize(), 10);
+            for (const int item : sample) {
+                ++kept[item];
+            }
+        }
+        expect(kept[0] > 120 && kept[0] < 280 && kept[99] > 120 && kept[99] < 280);
+
+        // A long, steady performance at the default tempo
+        AdvancedAILearning learning;
+        learning.enableRealTimeAdaptation(true);
+
+        const double beat = 60.0 / INIConfig::Defaults::DEFAULT_TEMPO;
+        const int notes[] = { INIConfig::GMDrums::BASS_DRUM_1, INIConfig::GMDrums::CLOSED_HI_HAT,
+                              INIConfig::GMDrums::ACOUSTIC_SNARE, INIConfig::GMDrums::CLOSED_HI_HAT };
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int i = 0; i < 100000; ++i) {
+            learning.processNote(i * beat, notes[i % 4], 80);
+        }
+        const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        logMessage("Online learning: " + juce::String(100000.0 / juce::jmax(seconds, 1.0e-9), 0) + " notes/sec");
+
+        const auto state = learning.getCurrentAdaptationState();
+        expectWithinAbsoluteError(state.tempoTrend, 0.0f, 0.01f);
+        expect(state.averagePerformanceScore > 0.9f);
+        expect(state.adaptationConfidence > 0.5);
+        expectEquals(learning.getUserProfile().commonDrumNotes.size(), 3);
+
+        // However much is played, only a sample of it is kept
+        juce::MidiMessageSequence pattern;
+        pattern.addEvent(juce::MidiMessage::noteOn(10, INIConfig::GMDrums::BASS_DRUM_1, static_cast<juce::uint8>(90)));
+        for (int i = 0; i < 200; ++i) {
+            learning.updateUserProfile(pattern, PatternSuggestionEngine::Genre::Funk, 1.0);
+        }
+        for (const auto& genre : learning.getGenreLearningData()) {
+            if (genre.genre != PatternSuggestionEngine::Genre::Funk) continue;
+            expectEquals(genre.learnedPatterns.getSize(), AdvancedAILearning::MAX_LEARNED_PATTERNS);
+            expectEquals(genre.learnedPatterns.getNumSeen(), static_cast<juce::int64>(200));
+        }
+    }
+
     void testPatternLearning() {
         auto engine = std::make_unique<PatternSuggestionEngine>();
         
@@ -270,6 +529,141 @@ private:
         expect(aiPanel != nullptr, "Mix analysis components should be created");
     }
 
+    void testMeasuredMixAnalysis() {
+        constexpr double sampleRate = 44100.0;
+        constexpr int blockSize = 512;
+
+        // A kick in the middle and a hi-hat panned right, for half a second
+        MixAnalyzer analyzer;
+        analyzer.prepare(sampleRate);
+
+        for (int block = 0; block < 40; ++block) {
+            juce::AudioBuffer<float> kick(2, blockSize), hat(2, blockSize), master(2, blockSize);
+
+            for (int i = 0; i < blockSize; ++i) {
+                const double t = (block * blockSize + i) / sampleRate;
+                const float low = 0.5f * static_cast<float>(std::sin(juce::MathConstants<double>::twoPi * 80.0 * t));
+                const float high = 0.2f * static_cast<float>(std::sin(juce::MathConstants<double>::twoPi * 6000.0 * t));
+
+                kick.setSample(0, i, low);
+                kick.setSample(1, i, low);
+                hat.setSample(0, i, high * 0.3f);
+                hat.setSample(1, i, high);
+                master.setSample(0, i, low + high * 0.3f);
+                master.setSample(1, i, low + high);
+            }
+
+            analyzer.pushChannel(0, kick);
+            analyzer.pushChannel(1, kick);
+            analyzer.pushChannel(3, hat);
+            analyzer.pushMaster(master);
+
+            if (block % 8 == 7) {
+                expect(analyzer.analyze());
+            }
+        }
+        expect(!analyzer.analyze(), "Nothing new to analyze");
+
+        const auto& snapshot = analyzer.getLatestSnapshot();
+        expect(snapshot.isValid());
+
+        const auto& kickSpectrum = snapshot.channels[0];
+        const auto& hatSpectrum = snapshot.channels[3];
+        expect(kickSpectrum.active && hatSpectrum.active && !snapshot.channels[2].active);
+        expect(kickSpectrum.getBandShare(1) > 0.9f, "80 Hz falls in the 60-120 Hz band");
+        expect(hatSpectrum.getBandShare(MixAnalyzer::NUM_BANDS - 1) > 0.9f, "6 kHz falls in the top band");
+        expectWithinAbsoluteError(kickSpectrum.crestFactor, 3.0f, 0.5f);
+        expectWithinAbsoluteError(kickSpectrum.correlation, 1.0f, 0.01f);
+        expect(kickSpectrum.stereoWidth < 0.01f && hatSpectrum.stereoWidth > 0.4f);
+
+        expect(snapshot.masking[0][1] > 0.9f, "Two kicks mask each other");
+        expect(snapshot.masking[0][3] < 0.1f, "Kick and hi-hat do not");
+        expect(snapshot.masking[0][2] == 0.0f, "A silent channel masks nothing");
+
+        // Fed from the mixer only while active and metering, so offline bounces skip it
+        Mixer mixer;
+        mixer.prepare(sampleRate, blockSize);
+        auto& mixAnalyzer = mixer.getMixAnalyzer();
+
+        auto renderAndWait = [&] {
+            const auto before = mixAnalyzer.getLatestSnapshot().frameIndex;
+            for (int block = 0; block < 8; ++block) {
+                juce::AudioBuffer<float> buffer(2, blockSize);
+                for (int i = 0; i < blockSize; ++i) {
+                    const float sample = 0.5f * std::sin(juce::MathConstants<float>::twoPi * 200.0f * static_cast<float>(i) / blockSize);
+                    buffer.setSample(0, i, sample);
+                    buffer.setSample(1, i, sample);
+                }
+                mixer.processBlock(buffer);
+            }
+            for (int wait = 0; wait < 40 && mixAnalyzer.getLatestSnapshot().frameIndex == before; ++wait) {
+                juce::Thread::sleep(INIConfig::Audio::MIX_ANALYSIS_INTERVAL_MS);
+            }
+            return mixAnalyzer.getLatestSnapshot().frameIndex != before;
+        };
+
+        mixAnalyzer.setActive(true);
+        mixer.setMeteringEnabled(false);
+        expect(!renderAndWait(), "Offline renders are not analyzed");
+        mixer.setMeteringEnabled(true);
+        expect(renderAndWait(), "Live audio is analyzed in the background");
+        mixAnalyzer.setActive(false);
+    }
+
+    void testMeasuredMixSuggestions() {
+        constexpr double sampleRate = 44100.0;
+        constexpr int blockSize = 512;
+
+        Mixer mixer;
+        mixer.prepare(sampleRate, blockSize);
+        SFZEngine sfzEngine;
+        AutoMixAssistant assistant(mixer, sfzEngine);
+        auto& mixAnalyzer = mixer.getMixAnalyzer();
+
+        // A tone on channel 0, which the mixer passes on to channel 1, until the smoothed
+        // spectrum has settled on it
+        double phase = 0.0;
+        auto suggestFor = [&](double frequency) {
+            for (int pass = 0; pass < 16; ++pass) {
+                const auto before = mixAnalyzer.getLatestSnapshot().frameIndex;
+                for (int block = 0; block < 8; ++block) {
+                    juce::AudioBuffer<float> buffer(2, blockSize);
+                    for (int i = 0; i < blockSize; ++i) {
+                        const float sample = 0.5f * static_cast<float>(std::sin(phase));
+                        phase += juce::MathConstants<double>::twoPi * frequency / sampleRate;
+                        buffer.setSample(0, i, sample);
+                        buffer.setSample(1, i, sample);
+                    }
+                    mixer.processBlock(buffer);
+                }
+                for (int wait = 0; wait < 40 && mixAnalyzer.getLatestSnapshot().frameIndex == before; ++wait) {
+                    juce::Thread::sleep(INIConfig::Audio::MIX_ANALYSIS_INTERVAL_MS);
+                }
+            }
+            return assistant.analyzeMix();
+        };
+
+        const int low = static_cast<int>(Mixer::EQBand::Low);
+        const int high = static_cast<int>(Mixer::EQBand::High);
+
+        mixAnalyzer.setActive(true);
+        const auto bass = suggestFor(80.0);
+        const auto treble = suggestFor(6000.0);
+        expect(mixAnalyzer.getLatestSnapshot().isValid());
+
+        expect(bass.eqSettings[0][low] < -1.0f && bass.eqSettings[0][high] == 0.0f,
+               "Too much low end is taken out of the channel carrying it");
+        expect(treble.eqSettings[0][high] < -1.0f && treble.eqSettings[0][low] == 0.0f,
+               "The same channel playing high is cut in the high band instead");
+        expect(bass.channelPans[0] == 0.0f && treble.channelPans[0] != 0.0f,
+               "A mono mix of high sounds is spread out");
+        expectEquals(treble.compressionSettings[0], 0.2f, "A sine has no dynamics to control");
+
+        // Without a measurement the channel settings decide, and channel 0 is taken to be low
+        mixAnalyzer.setActive(false);
+        expectEquals(assistant.analyzeMix().eqSettings[0][high], 0.0f);
+    }
+
     void testPatternSuggestionUI() {
         auto mixer = std::make_unique<Mixer>();
         auto patternEngine = std::make_unique<PatternSuggestionEngine>();
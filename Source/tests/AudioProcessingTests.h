@@ -4,7 +4,10 @@
 #include "../SFZEngine.h"
 #include "../Mixer.h"
 #include "../MidiEngine.h"
+#include "../TruePeakLimiter.h"
+#include "../SampleKitImporter.h"
 #include "../INIConfig.h"
+#include "TestMidiFixtures.h"
 
 class AudioProcessingTests : public juce::UnitTest {
 public:
@@ -29,6 +32,21 @@ public:
         beginTest("Effects Processing");
         testEffectsProcessing();
 
+        beginTest("Mixer Insert Chains");
+        testMixerInsertChains();
+
+        beginTest("Mixer Metering Frame");
+        testMixerMeteringFrame();
+
+        beginTest("Mixer EQ Parameter Updates");
+        testMixerEQParameterUpdates();
+
+        beginTest("Master True Peak Limiter");
+        testMasterTruePeakLimiter();
+
+        beginTest("Mixer Snapshot Morphing");
+        testMixerSnapshotMorphing();
+
         beginTest("Automation Parameter Changes");
         testAutomationParameters();
 
@@ -38,8 +56,17 @@ public:
         beginTest("Buffer Size Changes");
         testBufferSizeChanges();
 
+        beginTest("MIDI Output Latency");
+        testMidiOutputLatency();
+
         beginTest("CPU Performance");
         testCPUPerformance();
+
+        beginTest("Offline Render Determinism");
+        testOfflineRenderDeterminism();
+
+        beginTest("Sample Kit Import");
+        testSampleKitImport();
     }
 
 private:
@@ -129,6 +156,10 @@ private:
         processor->processBlock(buffer, midiBuffer);
 
         expect(!midiEngine.isMidiLearnActive(), "MIDI learn should complete after receiving CC");
+
+        midiEngine.dispatchEngineEvents();
+        expectEquals(midiEngine.getMidiMapping("masterVolume").ccNumber, cc.getControllerNumber(),
+                     "Learned mapping should be added on the message thread");
     }
 
     void testSFZEnginePlayback() {
@@ -166,14 +197,20 @@ private:
         mixer.prepare(sampleRate, blockSize);
 
         juce::AudioBuffer<float> buffer(INIConfig::Defaults::DEFAULT_OUTPUT_CHANNELS, blockSize);
-
-        for (int ch = 0; ch < INIConfig::Defaults::MAX_PLAYERS; ++ch) {
+        auto fillBuffer = [&]() {
             buffer.clear();
-
             for (int i = 0; i < blockSize; ++i) {
                 buffer.setSample(INIConfig::Defaults::ZERO_VALUE, i, INIConfig::Defaults::DEFAULT_ROOM_SIZE);
                 buffer.setSample(INIConfig::Defaults::ONE_VALUE, i, INIConfig::Defaults::DEFAULT_ROOM_SIZE);
             }
+        };
+
+        // Fill the limiter's lookahead so every measured block is steady state
+        fillBuffer();
+        mixer.processBlock(buffer);
+
+        for (int ch = 0; ch < INIConfig::Defaults::MAX_PLAYERS; ++ch) {
+            fillBuffer();
 
             mixer.setChannelVolume(ch, INIConfig::Defaults::DEFAULT_SNARE_VOLUME);
             mixer.setChannelPan(ch, INIConfig::Audio::DEFAULT_PAN);
@@ -191,7 +228,7 @@ private:
         buffer.setSample(INIConfig::Defaults::ZERO_VALUE, INIConfig::Defaults::ZERO_VALUE, INIConfig::Validation::MAX_VOLUME);
         mixer.processBlock(buffer);
 
-        expect(buffer.getSample(INIConfig::Defaults::ZERO_VALUE, INIConfig::Defaults::ZERO_VALUE) == INIConfig::Validation::MIN_VOLUME, "Muted channel should produce no output");
+        expect(buffer.getSample(INIConfig::Defaults::ZERO_VALUE, mixer.getLatencySamples()) == INIConfig::Validation::MIN_VOLUME, "Muted channel should produce no output");
 
         mixer.setChannelMute(INIConfig::Defaults::ZERO_VALUE, false);
         mixer.setChannelSolo(INIConfig::Defaults::ONE_VALUE, true);
@@ -261,6 +298,255 @@ private:
         expect(outputLevel < inputLevel, "Compressor should reduce loud signal levels");
     }
 
+    void testMixerInsertChains() {
+        Mixer mixer;
+        const int blockSize = INIConfig::Defaults::DEFAULT_BUFFER_SIZE * INIConfig::Audio::NUM_SEND_TYPES;
+        mixer.prepare(static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE), blockSize);
+        mixer.setLimiterEnabled(false);
+
+        juce::AudioBuffer<float> buffer(INIConfig::Defaults::DEFAULT_OUTPUT_CHANNELS, blockSize);
+        auto fillBuffer = [&]() {
+            buffer.clear();
+            for (int i = 0; i < blockSize; ++i) {
+                buffer.setSample(INIConfig::Defaults::ZERO_VALUE, i, INIConfig::Defaults::DEFAULT_KICK_VOLUME);
+            }
+        };
+
+        fillBuffer();
+        mixer.processBlock(buffer);
+        float bypassedLevel = buffer.getRMSLevel(INIConfig::Defaults::ZERO_VALUE, INIConfig::Defaults::ZERO_VALUE, blockSize);
+
+        expect(!mixer.isChannelInsertEnabled(INIConfig::Defaults::ZERO_VALUE, InsertEffects::Type::Compressor), "Inserts should be bypassed by default");
+
+        auto settings = mixer.getChannelInsertChain(INIConfig::Defaults::ZERO_VALUE);
+        settings.setEnabled(InsertEffects::Type::Compressor, true);
+        settings.compThreshold = INIConfig::Audio::DEFAULT_INSERT_GATE_THRESHOLD;
+        settings.compRatio = INIConfig::Audio::DEFAULT_INSERT_COMP_RATIO;
+        mixer.setChannelInsertChain(INIConfig::Defaults::ZERO_VALUE, settings);
+
+        for (int block = 0; block < INIConfig::Audio::NUM_INSERT_SLOTS; ++block) {
+            fillBuffer();
+            mixer.processBlock(buffer);
+        }
+        float compressedLevel = buffer.getRMSLevel(INIConfig::Defaults::ZERO_VALUE, INIConfig::Defaults::ZERO_VALUE, blockSize);
+
+        expect(compressedLevel < bypassedLevel, "Insert compressor should reduce channel level");
+
+        ComponentState state;
+        mixer.saveState(state);
+
+        Mixer restored;
+        restored.loadState(state);
+        auto restoredSettings = restored.getChannelInsertChain(INIConfig::Defaults::ZERO_VALUE);
+
+        expect(restoredSettings.isEnabled(InsertEffects::Type::Compressor), "Insert bypass state should be restored");
+        expect(!restoredSettings.isEnabled(InsertEffects::Type::Gate), "Disabled inserts should stay bypassed");
+        expectWithinAbsoluteError(restoredSettings.compThreshold, INIConfig::Audio::DEFAULT_INSERT_GATE_THRESHOLD, static_cast<float>(INIConfig::Defaults::BEAT_THRESHOLD));
+    }
+
+    void testMixerMeteringFrame() {
+        Mixer mixer;
+        const int blockSize = INIConfig::Defaults::DEFAULT_BUFFER_SIZE * INIConfig::Audio::NUM_SEND_TYPES;
+        mixer.prepare(static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE), blockSize);
+
+        juce::AudioBuffer<float> buffer(INIConfig::Defaults::DEFAULT_OUTPUT_CHANNELS, blockSize);
+        buffer.clear();
+        for (int i = 0; i < blockSize; ++i) {
+            buffer.setSample(INIConfig::Defaults::ZERO_VALUE, i, std::sin(juce::MathConstants<float>::halfPi * static_cast<float>(i) + juce::MathConstants<float>::pi * 0.25f));
+        }
+
+        mixer.setChannelMute(INIConfig::Defaults::ONE_VALUE, true);
+        mixer.processBlock(buffer);
+
+        const auto& frame = mixer.getMeteringService().getLatestFrame();
+        const auto& channel = frame.get(INIConfig::Defaults::ZERO_VALUE);
+
+        expect(frame.frameIndex > 0, "A metering frame should be published per block");
+        expect(channel.peakLeft > INIConfig::Validation::MIN_VOLUME, "Active channel should report a peak level");
+        expect(channel.rmsLeft <= channel.peakLeft, "RMS should not exceed the sample peak");
+        expect(channel.truePeakLeft > channel.peakLeft, "Inter-sample peaks should exceed the sample peak for a quarter-rate sine");
+        expect(frame.get(INIConfig::Defaults::ONE_VALUE).peakLeft == INIConfig::Validation::MIN_VOLUME, "Muted channel should read as silent");
+
+        auto levels = mixer.getChannelLevels(INIConfig::Defaults::ZERO_VALUE);
+        expectWithinAbsoluteError(levels.left, channel.peakLeft, static_cast<float>(INIConfig::Defaults::BEAT_THRESHOLD));
+    }
+
+    void testMixerEQParameterUpdates() {
+        Mixer mixer;
+        const double sampleRate = static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE);
+        const int blockSize = INIConfig::Defaults::DEFAULT_BUFFER_SIZE * INIConfig::Audio::NUM_SEND_TYPES;
+        mixer.prepare(sampleRate, blockSize);
+        mixer.setLimiterEnabled(false);
+
+        juce::AudioBuffer<float> buffer(INIConfig::Defaults::DEFAULT_OUTPUT_CHANNELS, blockSize);
+        int phase = 0;
+        auto renderBlock = [&]() {
+            buffer.clear();
+            for (int i = 0; i < blockSize; ++i, ++phase) {
+                buffer.setSample(INIConfig::Defaults::ZERO_VALUE, i, 0.1f * std::sin(juce::MathConstants<float>::twoPi * 60.0f * static_cast<float>(phase) / static_cast<float>(sampleRate)));
+            }
+            mixer.processBlock(buffer);
+            return buffer.getRMSLevel(INIConfig::Defaults::ZERO_VALUE, INIConfig::Defaults::ZERO_VALUE, blockSize);
+        };
+
+        for (int block = 0; block < INIConfig::Audio::NUM_INSERT_SLOTS; ++block) {
+            renderBlock();
+        }
+        const float flatLevel = renderBlock();
+
+        mixer.setChannelEQ(INIConfig::Defaults::ZERO_VALUE, Mixer::EQBand::Low, 12.0f);
+
+        float previousLevel = flatLevel;
+        float largestStep = 0.0f;
+        for (int block = 0; block < INIConfig::UI::MAX_TOGGLE_STATES; ++block) {
+            const float level = renderBlock();
+            largestStep = juce::jmax(largestStep, level - previousLevel);
+            previousLevel = level;
+        }
+
+        expect(previousLevel > flatLevel * 2.0f, "Low shelf boost should reach the audio thread");
+        expect(largestStep < previousLevel - flatLevel, "EQ gain change should be spread over several blocks");
+    }
+
+    void testMasterTruePeakLimiter() {
+        const double sampleRate = static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE);
+        const int blockSize = INIConfig::Defaults::DEFAULT_BUFFER_SIZE * INIConfig::Audio::NUM_SEND_TYPES;
+        const float thresholdDb = -1.0f;
+        const float ceiling = juce::Decibels::decibelsToGain(thresholdDb);
+        const juce::dsp::ProcessSpec spec{sampleRate, static_cast<juce::uint32>(blockSize), static_cast<juce::uint32>(INIConfig::Defaults::DEFAULT_OUTPUT_CHANNELS)};
+
+        TruePeakLimiter limiter;
+        limiter.setLookahead(static_cast<float>(INIConfig::Defaults::DEFAULT_LIMITER_LOOKAHEAD));
+        limiter.prepare(spec);
+        limiter.setThreshold(thresholdDb);
+        limiter.setRelease(INIConfig::Defaults::DEFAULT_LIMITER_RELEASE);
+
+        const int latency = limiter.getLatencySamples();
+        expect(latency == TruePeakLimiter::calculateLatencySamples(static_cast<float>(INIConfig::Defaults::DEFAULT_LIMITER_LOOKAHEAD), sampleRate), "Reported latency should match the lookahead");
+        expect(latency < blockSize, "Default lookahead should fit in one block");
+
+        juce::AudioBuffer<float> buffer(INIConfig::Defaults::DEFAULT_OUTPUT_CHANNELS, blockSize);
+        buffer.clear();
+        buffer.setSample(INIConfig::Defaults::ZERO_VALUE, INIConfig::Defaults::ZERO_VALUE, INIConfig::Defaults::DEFAULT_ROOM_SIZE);
+        limiter.process(buffer);
+
+        expectWithinAbsoluteError(buffer.getSample(INIConfig::Defaults::ZERO_VALUE, latency), INIConfig::Defaults::DEFAULT_ROOM_SIZE, static_cast<float>(INIConfig::Defaults::BEAT_THRESHOLD));
+
+        // Quarter-rate sine offset by 45 degrees: every sample sits under the ceiling
+        // while the reconstructed waveform peaks well above it
+        const float amplitude = 1.2f;
+        int phase = 0;
+        auto fillSine = [&](juce::AudioBuffer<float>& target) {
+            for (int i = 0; i < blockSize; ++i, ++phase) {
+                const float sample = amplitude * std::sin(juce::MathConstants<float>::halfPi * static_cast<float>(phase) + juce::MathConstants<float>::pi * 0.25f);
+                for (int ch = 0; ch < target.getNumChannels(); ++ch)
+                    target.setSample(ch, i, sample);
+            }
+        };
+
+        limiter.reset();
+        TruePeakDetector outputDetector;
+        float outputTruePeak = 0.0f;
+        for (int block = 0; block < INIConfig::UI::MAX_TOGGLE_STATES; ++block) {
+            fillSine(buffer);
+            expect(buffer.getMagnitude(INIConfig::Defaults::ZERO_VALUE, blockSize) <= ceiling, "Input sample peaks should stay under the ceiling");
+            limiter.process(buffer);
+            outputTruePeak = juce::jmax(outputTruePeak, outputDetector.process(buffer.getReadPointer(INIConfig::Defaults::ZERO_VALUE), blockSize));
+        }
+
+        expect(outputTruePeak <= ceiling * 1.01f, "Limiter should hold inter-sample peaks under the ceiling");
+
+        Mixer mixer;
+        mixer.prepare(sampleRate, blockSize);
+        int reportedLatency = -1;
+        mixer.onLatencyChanged = [&reportedLatency](int samples) { reportedLatency = samples; };
+        mixer.setLimiterLookahead(INIConfig::Audio::MAX_LIMITER_LOOKAHEAD_MS);
+
+        expect(reportedLatency == mixer.getLatencySamples(), "Lookahead changes should report the new latency");
+        expect(reportedLatency > latency, "Longer lookahead should add latency");
+
+        // Benchmark against the juce::dsp::Limiter the master bus used previously
+        juce::dsp::Limiter<float> referenceLimiter;
+        referenceLimiter.prepare(spec);
+        referenceLimiter.setThreshold(thresholdDb);
+        referenceLimiter.setRelease(INIConfig::Defaults::DEFAULT_LIMITER_RELEASE);
+
+        const int numBlocks = INIConfig::Defaults::DEFAULT_AUTO_SAVE_INTERVAL * INIConfig::UI::MAX_TOGGLE_STATES;
+        auto timeBlocks = [&](auto&& processBuffer) {
+            double seconds = 0.0;
+            for (int block = 0; block < numBlocks; ++block) {
+                fillSine(buffer);
+                const auto start = juce::Time::getHighResolutionTicks();
+                processBuffer(buffer);
+                seconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+            }
+            return seconds;
+        };
+
+        const double truePeakTime = timeBlocks([&limiter](juce::AudioBuffer<float>& b) { limiter.process(b); });
+        const double referenceTime = timeBlocks([&referenceLimiter](juce::AudioBuffer<float>& b) {
+            juce::dsp::AudioBlock<float> block(b);
+            referenceLimiter.process(juce::dsp::ProcessContextReplacing<float>(block));
+        });
+        const double audioTime = (numBlocks * static_cast<double>(blockSize)) / sampleRate;
+
+        expect(truePeakTime < audioTime, "True peak limiter should run faster than real time");
+
+        logMessage("True peak limiter: " + juce::String(truePeakTime / audioTime * 100.0, 3) + "% CPU, juce::dsp::Limiter: "
+                   + juce::String(referenceTime / audioTime * 100.0, 3) + "% CPU");
+    }
+
+    void testMixerSnapshotMorphing() {
+        Mixer mixer;
+        const double sampleRate = static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE);
+        const int blockSize = INIConfig::Defaults::DEFAULT_BUFFER_SIZE * INIConfig::Audio::NUM_SEND_TYPES;
+        mixer.prepare(sampleRate, blockSize);
+        mixer.setLimiterEnabled(false);
+
+        const auto from = mixer.captureSnapshot();
+        auto to = from;
+        to.channels[0].volume = from.channels[0].volume * 0.25f;
+        to.reverb.enabled = false;
+
+        const auto halfway = Mixer::Snapshot::interpolate(from, to, 0.5f);
+        expectWithinAbsoluteError(halfway.channels[0].volume, from.channels[0].volume * 0.625f, 1.0e-6f);
+        expect(halfway.reverb.enabled, "Reverb should stay enabled while its return fades out");
+
+        juce::AudioBuffer<float> buffer(INIConfig::Defaults::DEFAULT_OUTPUT_CHANNELS, blockSize);
+        int phase = 0;
+        auto renderBlock = [&]() {
+            buffer.clear();
+            for (int i = 0; i < blockSize; ++i, ++phase) {
+                buffer.setSample(INIConfig::Defaults::ZERO_VALUE, i, 0.1f * std::sin(juce::MathConstants<float>::twoPi * 440.0f * static_cast<float>(phase) / static_cast<float>(sampleRate)));
+            }
+            mixer.processBlock(buffer);
+            return buffer.getRMSLevel(INIConfig::Defaults::ZERO_VALUE, INIConfig::Defaults::ZERO_VALUE, blockSize);
+        };
+
+        for (int block = 0; block < INIConfig::Audio::NUM_INSERT_SLOTS; ++block) {
+            renderBlock();
+        }
+        const float startLevel = renderBlock();
+
+        mixer.applySnapshot(to, 100.0f);
+        expect(juce::approximatelyEqual(mixer.getChannelVolume(INIConfig::Defaults::ZERO_VALUE), to.channels[0].volume), "Snapshot should be visible to getters immediately");
+
+        float previousLevel = renderBlock();
+        expect(mixer.isMorphing(), "Audio thread should pick up the morph on the next block");
+
+        float largestStep = startLevel - previousLevel;
+        for (int block = 0; block < INIConfig::UI::MAX_TOGGLE_STATES; ++block) {
+            const float level = renderBlock();
+            largestStep = juce::jmax(largestStep, previousLevel - level);
+            previousLevel = level;
+        }
+
+        expect(!mixer.isMorphing(), "Morph should complete within its duration");
+        expect(previousLevel < startLevel * 0.5f, "Morph should arrive at the target volume");
+        expect(largestStep < startLevel - previousLevel, "Volume change should be spread over the morph");
+        expect(!mixer.getReverbState().enabled.load(), "Target reverb state should be applied");
+    }
+
     void testAutomationParameters() {
         auto processor = std::make_unique<OTTOAudioProcessor>();
         processor->prepareToPlay(static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE), INIConfig::Defaults::DEFAULT_BUFFER_SIZE * INIConfig::Audio::NUM_SEND_TYPES);
@@ -341,6 +627,259 @@ private:
         }
     }
 
+    void testMidiOutputLatency() {
+        auto processor = std::make_unique<OTTOAudioProcessor>();
+        const double sampleRate = static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE);
+        processor->prepareToPlay(sampleRate, INIConfig::Defaults::DEFAULT_BUFFER_SIZE);
+
+        auto& mixer = processor->getMixer();
+        auto& scheduler = processor->getMidiOutputScheduler();
+        const int latency = mixer.getLatencySamples();
+        const double delayMs = scheduler.getOutputDelayMs(INIConfig::Defaults::ZERO_VALUE);
+
+        // A lookahead change while playing moves MIDI out with the audio it now lines up with
+        mixer.setLimiterLookahead(INIConfig::Audio::MAX_LIMITER_LOOKAHEAD_MS);
+        const int newLatency = mixer.getLatencySamples();
+        expect(newLatency > latency, "Longer lookahead should add latency");
+        expectEquals(processor->getLatencySamples(), newLatency);
+
+        const double expectedShiftMs = (newLatency - latency) * INIConfig::Defaults::MS_PER_SECOND / sampleRate;
+        expectWithinAbsoluteError(scheduler.getOutputDelayMs(INIConfig::Defaults::ZERO_VALUE) - delayMs, expectedShiftMs, 1.0e-6);
+
+        const int eventSample = INIConfig::Defaults::DEFAULT_BUFFER_SIZE / 2;
+        expectWithinAbsoluteError(scheduler.getOutputDelayMs(eventSample) - scheduler.getOutputDelayMs(INIConfig::Defaults::ZERO_VALUE),
+                                  eventSample * INIConfig::Defaults::MS_PER_SECOND / sampleRate, 1.0e-6);
+
+        // Preparing again keeps the mixer's share
+        processor->prepareToPlay(sampleRate, INIConfig::Defaults::DEFAULT_BUFFER_SIZE);
+        expectWithinAbsoluteError(scheduler.getOutputDelayMs(INIConfig::Defaults::ZERO_VALUE) - delayMs, expectedShiftMs, 1.0e-6);
+    }
+
+    void testOfflineRenderDeterminism() {
+        const double sampleRate = static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE);
+        const int blockSize = INIConfig::Defaults::DEFAULT_BUFFER_SIZE * INIConfig::Audio::NUM_SEND_TYPES;
+        const int numChannels = INIConfig::Defaults::DEFAULT_OUTPUT_CHANNELS;
+        const int ticksPerBeat = INIConfig::Defaults::MIDI_TICKS_PER_QUARTER_NOTE;
+        const int hitsPerBar = 16;
+        const int numBlocks = 256;
+        const float inputPeriodSamples = 100.0f;
+
+        // A bar of sixteenths on player 0, fully humanized
+        const double spacing = ticksPerBeat * INIConfig::Defaults::BEATS_PER_BAR / hitsPerBar;
+        const auto patternFile = TestMidiFixtures::writeMidiFile(
+            juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("otto_offline_render.mid"),
+            { TestMidiFixtures::makeHits(INIConfig::GMDrums::CLOSED_HI_HAT, hitsPerBar, spacing, spacing / 2,
+                                         INIConfig::Defaults::FIXED_VELOCITY) },
+            ticksPerBeat);
+
+        SongArranger::Chain chain;
+        SongArranger::Step step;
+        step.patternIndex = INIConfig::Defaults::ZERO_VALUE;
+        step.midiFile = patternFile;
+        chain.steps.add(step);
+
+        // FNV-1a over every MIDI event and every output sample
+        auto render = [&](juce::Array<int>& velocities) {
+            auto processor = std::make_unique<OTTOAudioProcessor>();
+            processor->setNonRealtime(true);
+            processor->prepareToPlay(sampleRate, blockSize);
+
+            auto& midiEngine = processor->getMidiEngine();
+            midiEngine.setPatternChain(INIConfig::Defaults::ZERO_VALUE, chain);
+            midiEngine.applyHumanization(INIConfig::Defaults::ZERO_VALUE, 1.0f);
+            midiEngine.startPlayback();
+
+            juce::uint64 hash = 14695981039346656037ull;
+            auto mix = [&hash](const void* data, size_t size) {
+                const auto* bytes = static_cast<const juce::uint8*>(data);
+                for (size_t i = 0; i < size; ++i) {
+                    hash ^= bytes[i];
+                    hash *= 1099511628211ull;
+                }
+            };
+
+            juce::AudioBuffer<float> buffer(numChannels, blockSize);
+            for (int block = 0; block < numBlocks; ++block) {
+                for (int ch = 0; ch < numChannels; ++ch) {
+                    for (int i = 0; i < blockSize; ++i) {
+                        buffer.setSample(ch, i, std::sin(juce::MathConstants<float>::twoPi * static_cast<float>(block * blockSize + i) / inputPeriodSamples));
+                    }
+                }
+
+                juce::MidiBuffer midiBuffer;
+                processor->processBlock(buffer, midiBuffer);
+
+                for (const auto metadata : midiBuffer) {
+                    mix(&metadata.samplePosition, sizeof(metadata.samplePosition));
+                    mix(metadata.data, static_cast<size_t>(metadata.numBytes));
+
+                    const auto message = metadata.getMessage();
+                    if (message.isNoteOn())
+                        velocities.add(message.getVelocity());
+                }
+
+                for (int ch = 0; ch < numChannels; ++ch) {
+                    mix(buffer.getReadPointer(ch), sizeof(float) * static_cast<size_t>(blockSize));
+                }
+            }
+
+            expect(processor->getMixer().getMeteringService().getLatestFrame().frameIndex == 0,
+                   "Offline renders should skip metering");
+            return hash;
+        };
+
+        juce::Array<int> firstVelocities, secondVelocities;
+        const auto firstHash = render(firstVelocities);
+        const auto secondHash = render(secondVelocities);
+
+        expect(firstVelocities.size() > hitsPerBar, "The pattern should play through the render");
+        expect(firstHash == secondHash, "Two offline renders should be bit-identical");
+        expect(firstVelocities == secondVelocities, "Humanized velocities should repeat from the seed");
+
+        int distinctVelocities = 0;
+        for (int i = 0; i < firstVelocities.size(); ++i) {
+            if (firstVelocities.indexOf(firstVelocities[i]) == i) ++distinctVelocities;
+        }
+        expect(distinctVelocities > 1, "Humanization should still vary the velocity");
+
+        patternFile.deleteFile();
+    }
+
+    void testSampleKitImport() {
+        using DrumType = SampleKitImporter::DrumType;
+        const double sampleRate = static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE);
+
+        auto root = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("otto_sample_import");
+        root.deleteRecursively();
+        const auto dropFolder = root.getChildFile("Drops").getChildFile("Session One");
+        const auto kitsFolder = root.getChildFile("Drumkits");
+        dropFolder.createDirectory();
+        kitsFolder.createDirectory();
+
+        juce::Random random(INIConfig::MIDI::HUMANIZE_SEED);
+        auto writeHit = [&](const juce::String& name, double seconds, const std::function<float(double)>& signal) {
+            juce::AudioBuffer<float> buffer(1, juce::roundToInt(seconds * sampleRate));
+            for (int i = 0; i < buffer.getNumSamples(); ++i) {
+                buffer.setSample(0, i, signal(i / sampleRate));
+            }
+
+            juce::WavAudioFormat wav;
+            std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(new juce::FileOutputStream(dropFolder.getChildFile(name)),
+                                                                                sampleRate, 1, 24, {}, 0));
+            expect(writer != nullptr, "Should be able to write " + name);
+            if (writer != nullptr) writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+        };
+
+        auto tone = [](double frequency, double tau, float gain) {
+            return [=](double t) { return gain * static_cast<float>(std::sin(juce::MathConstants<double>::twoPi * frequency * t) * std::exp(-t / tau)); };
+        };
+        auto noise = [&random](double tau, float gain) {
+            return [=, &random](double t) { return gain * (random.nextFloat() * 2.0f - 1.0f) * static_cast<float>(std::exp(-t / tau)); };
+        };
+
+        // Named for nothing but the last, so the sound decides
+        writeHit("hit_a.wav", 1.0, tone(55.0, 0.08, 0.9f));
+        writeHit("hit_b.wav", 1.0, tone(55.0, 0.08, 0.3f));
+        writeHit("hit_c.wav", 1.0, tone(55.0, 0.08, 0.31f));
+        writeHit("hit_d.wav", 0.3, noise(0.01, 0.5f));
+        writeHit("hit_e.wav", 3.5, noise(0.6, 0.5f));
+        writeHit("hit_f.wav", 1.0, [](double t) {
+            return 0.4f * static_cast<float>((std::sin(juce::MathConstants<double>::twoPi * 1000.0 * t)
+                                              + std::sin(juce::MathConstants<double>::twoPi * 3000.0 * t)) * std::exp(-t / 0.05));
+        });
+        writeHit("silence.wav", 0.5, [](double) { return 0.0f; });
+        writeHit("My Snare Top.wav", 0.3, noise(0.01, 0.5f));
+        dropFolder.getChildFile("notes.txt").replaceWithText("Not a sample");
+
+        SampleKitImporter importer(kitsFolder);
+        const auto files = SampleKitImporter::findAudioFiles({ dropFolder.getParentDirectory().getFullPathName() });
+        expectEquals(files.size(), 8, "Folders should be searched for audio files only");
+        expect(SampleKitImporter::findAudioFiles({ dropFolder.getFullPathName() }, [] { return false; }).isEmpty(),
+               "A stopped scan should not go on looking");
+
+        const auto kitName = importer.findKitName(dropFolder.getFileName());
+        expectEquals(kitName, juce::String("Session One"));
+
+        int lastDone = -1;
+        bool progressInOrder = true;
+        const auto result = importer.importKit(kitName, files, [&](int done, int total) {
+            progressInOrder = progressInOrder && done >= lastDone && done <= total && total == files.size();
+            lastDone = done;
+            return true;
+        });
+
+        expect(result.succeeded(), "The import should write an SFZ file");
+        expect(progressInOrder && lastDone == files.size(), "Progress should count up to every file");
+        expectEquals(result.numDecoded, 8);
+        expectEquals(result.unreadable.size(), 1, "Silence should not make it into the kit");
+        expectEquals(static_cast<int>(result.samples.size()), 7);
+
+        auto find = [&result](const juce::String& name) {
+            for (const auto& sample : result.samples) {
+                if (sample.source.getFileName() == name) return sample;
+            }
+            return SampleKitImporter::ImportedSample();
+        };
+
+        const auto loudKick = find("hit_a.wav");
+        const auto softKick = find("hit_b.wav");
+        const auto softKickAgain = find("hit_c.wav");
+        expect(loudKick.type == DrumType::Kick && softKick.type == DrumType::Kick, "A low thud should be a kick");
+        expect(find("hit_d.wav").type == DrumType::HiHat, "A short burst of noise should be a hi-hat");
+        expect(find("hit_e.wav").type == DrumType::Crash, "A long wash of noise should be a crash");
+        expect(find("hit_f.wav").type == DrumType::Snare, "A bright, short hit should be a snare");
+        expect(find("My Snare Top.wav").type == DrumType::Snare, "The name should win over the sound");
+        expectEquals(find("My Snare Top.wav").sampleName, juce::String("My_Snare_Top.wav"));
+
+        expect(softKick.features.onsetSeconds < 0.001f, "The hit should start at the top of the file");
+        expect(softKick.hiVel < loudKick.loVel, "Quieter hits should sit on lower velocities");
+        expect(softKick.loVel == softKickAgain.loVel && softKick.hiVel == softKickAgain.hiVel,
+               "Hits of the same loudness should share a layer");
+        expectEquals(softKick.roundRobins, 2, "Hits sharing a layer should alternate");
+        expectEquals(softKick.roundRobinPosition + softKickAgain.roundRobinPosition, 1 + 2, "Each should have a turn of its own");
+        expectEquals(loudKick.roundRobins, 1, "A hit alone in its layer should play every time");
+
+        const auto sfz = result.sfzFile.loadFileAsString();
+        expect(sfz.contains("seq_length=2 seq_position=1") && sfz.contains("seq_length=2 seq_position=2"),
+               "Every region in a round robin should say which turn it takes");
+
+        SFZEngine engine;
+        engine.setSFZFolder(kitsFolder);
+        engine.loadDrumkit(kitName, kitName);
+        expectEquals(engine.getNumRegions(), 4, "Kick, snare, hi-hat and crash should each be a region");
+
+        engine.prepare(sampleRate, INIConfig::Defaults::DEFAULT_BUFFER_SIZE);
+        juce::AudioBuffer<float> buffer(INIConfig::Defaults::DEFAULT_OUTPUT_CHANNELS, INIConfig::Defaults::DEFAULT_BUFFER_SIZE);
+        juce::MidiBuffer midiBuffer;
+        midiBuffer.addEvent(juce::MidiMessage::noteOn(INIConfig::Validation::MIN_MIDI_CHANNEL, INIConfig::GMDrums::BASS_DRUM_1,
+                                                      static_cast<juce::uint8>(INIConfig::Validation::MAX_MIDI_VELOCITY)), 0);
+        buffer.clear();
+        engine.process(buffer, midiBuffer);
+        expect(engine.getActiveVoiceCount() > 0, "The imported kick should play");
+
+        // Dropped again, only the silent file is looked at again; a new file is added to what is there
+        const auto again = importer.importKit(kitName, files);
+        expectEquals(again.numDecoded, 1, "Unchanged samples should come from the kit's cache");
+        expectEquals(static_cast<int>(again.samples.size()), 7);
+
+        writeHit("hit_g.wav", 1.0, tone(400.0, 0.1, 0.6f));
+        const auto added = importer.importKit(kitName, { dropFolder.getChildFile("hit_g.wav") });
+        expectEquals(added.numDecoded, 1);
+        expectEquals(static_cast<int>(added.samples.size()), 8);
+
+        int tomNote = -1;
+        for (const auto& sample : added.samples) {
+            if (sample.type == DrumType::Tom) tomNote = sample.note;
+        }
+        expectEquals(tomNote, INIConfig::GMDrums::HIGH_TOM, "A lone tom should go on the high tom");
+
+        // A kit that was not imported is never written to
+        kitsFolder.getChildFile("Factory").getChildFile("Factory.sfz").create();
+        expectEquals(importer.findKitName("Factory"), juce::String("Factory 2"));
+
+        root.deleteRecursively();
+    }
+
     void testCPUPerformance() {
         auto processor = std::make_unique<OTTOAudioProcessor>();
         processor->prepareToPlay(static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE), INIConfig::Defaults::DEFAULT_BUFFER_SIZE * INIConfig::Audio::NUM_SEND_TYPES);
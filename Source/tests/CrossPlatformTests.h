@@ -2,6 +2,12 @@
 #include <JuceHeader.h>
 #include "../FontManager.h"
 #include "../INIConfig.h"
+#include "../MidiLibraryCatalog.h"
+#include "../MidiAnalysisCache.h"
+#include "../PatternBank.h"
+#include "../PatternPreloader.h"
+#include "../SongArranger.h"
+#include "TestMidiFixtures.h"
 
 class CrossPlatformTests : public juce::UnitTest {
 public:
@@ -29,6 +35,21 @@ public:
         beginTest("File System Permissions");
         testFileSystemPermissions();
 
+        beginTest("MIDI Library Catalog");
+        testMidiLibraryCatalog();
+
+        beginTest("MIDI Analysis Cache");
+        testMidiAnalysisCache();
+
+        beginTest("Pattern Bank");
+        testPatternBank();
+
+        beginTest("Prebuilt Library Caches");
+        testPrebuiltLibraryCaches();
+
+        beginTest("Pattern Preloading");
+        testPatternPreloading();
+
         beginTest("Unicode Support");
         testUnicodeSupport();
 
@@ -274,6 +295,442 @@ private:
         }
     }
 
+    void testMidiLibraryCatalog() {
+        auto root = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("OTTOLibraryCatalogTest");
+        root.deleteRecursively();
+
+        auto rock = root.getChildFile("Rock");
+        auto funk = root.getChildFile("Funk");
+        rock.createDirectory();
+        funk.createDirectory();
+        rock.getChildFile("Beat.mid").replaceWithText("x");
+        rock.getChildFile("Beat.midi").replaceWithText("x");
+        funk.getChildFile("Beat.mid").replaceWithText("x");
+        funk.getChildFile("Slap.MID").replaceWithText("x");
+        funk.getChildFile("notes.txt").replaceWithText("x");
+
+        MidiLibraryCatalog catalog;
+        catalog.setRoot(root);
+
+        expectEquals(catalog.getNumFiles(), 3, "One entry per name and directory, MIDI files only");
+        expectEquals(catalog.getSubdirectories(root).size(), 2);
+        expect(catalog.find("Beat") != nullptr && catalog.find("Beat")->file == funk.getChildFile("Beat.mid"),
+               "A library-wide lookup should take the first directory in path order");
+        expect(catalog.find(rock, "Beat") != nullptr && catalog.find(rock, "Beat")->file == rock.getChildFile("Beat.mid"),
+               ".mid should win over .midi");
+        expect(catalog.find(funk, "Slap") != nullptr);
+        expect(catalog.find("Missing") == nullptr);
+
+        // New files and removed directories come in without a full rescan
+        auto waitFor = [&catalog](const std::function<bool()>& condition) {
+            const int maxAttempts = 40;
+            for (int attempt = 0; attempt < maxAttempts && !condition(); ++attempt) {
+                juce::Thread::sleep(INIConfig::MIDI::LIBRARY_WATCH_POLL_MS / 4);
+                catalog.refresh();
+            }
+            return condition();
+        };
+
+        juce::Thread::sleep(INIConfig::MIDI::LIBRARY_WATCH_POLL_MS / 4);
+        rock.getChildFile("Shuffle.mid").replaceWithText("x");
+        expect(waitFor([&] { return catalog.find("Shuffle") != nullptr; }), "A file added later should be found");
+
+        funk.deleteRecursively();
+        expect(waitFor([&] { return catalog.find(funk, "Slap") == nullptr; }), "A removed directory should drop its files");
+        expect(catalog.find("Beat") != nullptr && catalog.find("Beat")->file == rock.getChildFile("Beat.mid"),
+               "A name should fall back to the next directory holding it");
+        expectEquals(catalog.getNumFiles(), 2);
+
+        root.deleteRecursively();
+    }
+
+    void testMidiAnalysisCache() {
+        auto root = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("OTTOAnalysisCacheTest");
+        root.deleteRecursively();
+
+        auto library = root.getChildFile("Library");
+        auto cacheFile = root.getChildFile(INIConfig::CACHE_FOLDER).getChildFile(INIConfig::MIDI_ANALYSIS_BINARY_CACHE_FILE);
+        library.createDirectory();
+
+        auto writePattern = [](const juce::File& file, int hits) {
+            const double ticksPerBeat = INIConfig::Defaults::MIDI_TICKS_PER_QUARTER_NOTE;
+            TestMidiFixtures::writeMidiFile(file, { TestMidiFixtures::makeHits(36, hits, ticksPerBeat * 0.5, ticksPerBeat * 0.25, 64, 1) });
+        };
+
+        const int numFiles = 24;
+        for (int i = 0; i < numFiles; ++i) {
+            writePattern(library.getChildFile("Groove" + juce::String(i) + ".mid"), 4 + i);
+        }
+
+        MidiLibraryCatalog catalog;
+        catalog.setRoot(library);
+        auto entries = catalog.getEntries();
+        expectEquals(entries.size(), numFiles);
+
+        // Progress reports how far along the whole request is, including what was cached
+        auto analyze = [&entries](MidiAnalysisCache& cache, int& firstDone, bool cancel = false) {
+            firstDone = -1;
+            int lastDone = -1;
+            bool ordered = true;
+
+            const bool finished = cache.analyze(entries, [&](int done, int total) {
+                if (firstDone < 0) firstDone = done;
+                ordered = ordered && done >= lastDone && total == entries.size();
+                lastDone = done;
+                return !cancel;
+            });
+            return finished && ordered && lastDone == entries.size();
+        };
+
+        int firstDone = -1;
+        {
+            MidiAnalysisCache cache(cacheFile);
+            expect(analyze(cache, firstDone), "Analysis should run to the end with progress in order");
+
+            bool matches = true;
+            for (const auto& entry : entries) {
+                const auto* analysis = cache.find(entry);
+                const auto direct = MidiAnalysisCache::analyzeFile(entry.file);
+                matches = matches && analysis != nullptr
+                       && analysis->tempo == direct.tempo
+                       && analysis->averageVelocity == direct.averageVelocity
+                       && analysis->noteDistribution == direct.noteDistribution;
+            }
+            expect(matches, "Workers should produce the same analysis as the calling thread");
+            expect(cacheFile.existsAsFile(), "Analysis should be written to the cache file");
+        }
+
+        // A new session reads the cache instead of parsing, and parses only what changed
+        {
+            MidiAnalysisCache cache(cacheFile);
+            expectEquals(cache.getNumAnalyses(), numFiles);
+            expect(analyze(cache, firstDone));
+            expectEquals(firstDone, numFiles, "Nothing should be parsed again");
+
+            // Rewritten in place, which the catalog may not have noticed yet
+            auto& rewritten = entries.getReference(0);
+            writePattern(rewritten.file, 40);
+            rewritten = { rewritten.file, rewritten.file.getSize(), rewritten.file.getLastModificationTime() };
+
+            expect(analyze(cache, firstDone));
+            expectEquals(firstDone, numFiles - 1, "Only the rewritten file should be parsed again");
+            expect(cache.find(rewritten) != nullptr && cache.find(rewritten)->noteDistribution.getFirst() == 40);
+        }
+
+        // Cancelling at the first report stops before any file is parsed
+        cacheFile.deleteFile();
+        {
+            MidiAnalysisCache cache(cacheFile);
+            expect(!analyze(cache, firstDone, true), "A cancelled analysis should say so");
+            expectEquals(cache.getNumAnalyses(), 0);
+            expect(analyze(cache, firstDone));
+            expectEquals(cache.getNumAnalyses(), numFiles);
+        }
+
+        // A damaged cache is thrown away rather than trusted
+        juce::MemoryBlock data;
+        cacheFile.loadFileAsData(data);
+        cacheFile.replaceWithData(data.getData(), data.getSize() / 2);
+        {
+            MidiAnalysisCache cache(cacheFile);
+            expectEquals(cache.getNumAnalyses(), 0);
+        }
+
+        root.deleteRecursively();
+    }
+
+    void testPatternBank() {
+        auto root = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("OTTOPatternBankTest");
+        root.deleteRecursively();
+
+        auto library = root.getChildFile("Library");
+        auto bankFile = root.getChildFile(INIConfig::CACHE_FOLDER).getChildFile(INIConfig::PATTERN_BANK_FILE);
+        library.createDirectory();
+
+        // Hits on alternating kick and snare over two tracks, at a resolution other than the bank's
+        const int fileTicksPerBeat = 480;
+        auto writePattern = [fileTicksPerBeat](const juce::File& file, int hits, bool heldNote, bool controller) {
+            // Kick on the even hits, snare on the odd ones, each a half beat apart
+            auto kick = TestMidiFixtures::makeHits(36, (hits + 1) / 2, fileTicksPerBeat, fileTicksPerBeat / 4, 64, 2);
+            auto snare = TestMidiFixtures::makeHits(38, hits / 2, fileTicksPerBeat, fileTicksPerBeat / 4, 65, 2);
+            snare.addTimeToMessages(fileTicksPerBeat / 2);
+
+            // No note-off at all
+            if (heldNote) {
+                kick.addEvent(juce::MidiMessage::noteOn(10, 49, static_cast<juce::uint8>(100)), 0.0);
+            }
+
+            // Hi-hat pedal, which the bank does not keep
+            if (controller) {
+                snare.addEvent(juce::MidiMessage::controllerEvent(INIConfig::Defaults::DEFAULT_MIDI_CHANNEL, 4, 90), fileTicksPerBeat / 4.0);
+            }
+
+            TestMidiFixtures::writeMidiFile(file, { kick, snare }, fileTicksPerBeat);
+        };
+
+        const int numFiles = 12;
+        for (int i = 0; i < numFiles; ++i) {
+            writePattern(library.getChildFile("Groove" + juce::String(i) + ".mid"), 8 + i, i == 0, i == 7);
+        }
+
+        MidiLibraryCatalog catalog;
+        catalog.setRoot(library);
+        auto entries = catalog.getEntries();
+        MidiAnalysisCache analyses(root.getChildFile(INIConfig::MIDI_ANALYSIS_BINARY_CACHE_FILE));
+
+        expect(PatternBank::compile(bankFile, entries, analyses), "The library should compile into a bank");
+
+        PatternBank bank;
+        expect(bank.open(bankFile), "A freshly compiled bank should open");
+        expectEquals(bank.getNumPatterns(), numFiles);
+
+        // Pairing and rescaling happened once, at compile time
+        const auto pattern = bank.find(library.getChildFile("Groove0.mid"));
+        expect(pattern.isValid());
+        expectEquals(pattern.getNumNotes(), 8 + 1);
+        expectEquals(pattern.getLengthBeats(), 3.75);
+
+        const int beatTicks = PatternBank::ticksPerBeat;
+        bool paired = true;
+        for (int i = 0; i < pattern.getNumNotes(); ++i) {
+            const auto& note = pattern.notes[i];
+            const bool held = note.note == 49;
+            paired = paired && note.duration == (held ? pattern.header->lengthTicks : static_cast<juce::uint32>(beatTicks / 4))
+                            && (held || note.tick % (beatTicks / 2) == 0)
+                            && (i == 0 || pattern.notes[i - 1].tick <= note.tick);
+        }
+        expect(paired, "Notes should be sorted, at the bank's resolution and matched with their note-offs");
+
+        bool sorted = true;
+        for (int i = 1; i < bank.getNumPatterns(); ++i) {
+            sorted = sorted && bank.getPath(i - 1).toStdString() < bank.getPath(i).toStdString();
+            sorted = sorted && bank.indexOf(juce::File(bank.getPath(i))) == i;
+        }
+        expect(sorted, "Patterns should be found by path");
+        expectEquals(static_cast<int>(pattern.header->timeSignatureNumerator),
+                     MidiAnalysisCache::analyzeFile(library.getChildFile("Groove0.mid")).timeSignatureNumerator);
+
+        // Played from the bank, a pattern is the same as played from its MIDI file, down to the channel
+        const double barBeats = INIConfig::Defaults::BEATS_PER_BAR;
+        auto fromFile = std::make_unique<SongArranger::Section>();
+        auto fromBank = std::make_unique<SongArranger::Section>();
+        auto playsLikeFile = [&](const juce::File& file) {
+            SongArranger::compilePattern(*fromFile, file, barBeats);
+            SongArranger::compilePattern(*fromBank, file, barBeats, &bank);
+
+            bool same = fromFile->numEvents == fromBank->numEvents && fromFile->loopBeats == fromBank->loopBeats;
+            for (int i = 0; same && i < fromFile->numEvents; ++i) {
+                const auto& a = fromFile->events[static_cast<size_t>(i)];
+                const auto& b = fromBank->events[static_cast<size_t>(i)];
+                same = std::abs(a.beat - b.beat) < 1.0e-9 && a.size == b.size
+                    && a.data[0] == b.data[0] && a.data[1] == b.data[1] && a.data[2] == b.data[2];
+            }
+            return same;
+        };
+
+        expect(bank.find(library.getChildFile("Groove3.mid")).isComplete());
+        expect(playsLikeFile(library.getChildFile("Groove3.mid")), "A compiled pattern should play like its MIDI file");
+
+        // Anything besides notes on one channel is played from the file
+        const auto withController = library.getChildFile("Groove7.mid");
+        expect(!bank.find(withController).isComplete(), "A pattern with a controller should not be played from the bank");
+        expectEquals(bank.find(withController).getNumNotes(), 8 + 7);
+        expect(playsLikeFile(withController), "A pattern with a controller should still play like its MIDI file");
+
+        bool hasController = false;
+        for (int i = 0; i < fromBank->numEvents; ++i) {
+            hasController = hasController || (fromBank->events[static_cast<size_t>(i)].data[0] & 0xF0) == 0xB0;
+        }
+        expect(hasController, "The controller should be played");
+
+        // A file changed since is not served from the bank until it is compiled again
+        auto rewritten = library.getChildFile("Groove5.mid");
+        writePattern(rewritten, 40, false, false);
+        expect(!bank.find(rewritten).isValid(), "A changed file should not be served from the bank");
+
+        entries = catalog.getEntries();
+        for (auto& entry : entries) {
+            entry = { entry.file, entry.file.getSize(), entry.file.getLastModificationTime() };
+        }
+        expect(PatternBank::compile(bankFile, entries, analyses, &bank));
+
+        PatternBank recompiled;
+        expect(recompiled.open(bankFile));
+        expectEquals(recompiled.find(rewritten).getNumNotes(), 40);
+        expectEquals(recompiled.find(library.getChildFile("Groove0.mid")).getNumNotes(), 8 + 1);
+        recompiled.close();
+        bank.close();
+
+        // A damaged bank does not open
+        juce::MemoryBlock data;
+        bankFile.loadFileAsData(data);
+        bankFile.replaceWithData(data.getData(), data.getSize() - 1);
+        expect(!bank.open(bankFile), "A truncated bank should not open");
+        expect(!bank.isOpen());
+
+        root.deleteRecursively();
+    }
+
+    void testPrebuiltLibraryCaches() {
+        auto root = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("OTTOPrebuiltCacheTest");
+        root.deleteRecursively();
+
+        auto built = root.getChildFile("BuildServer").getChildFile(INIConfig::MIDI_LIBRARY_FOLDER);
+        auto prebuilt = root.getChildFile("BuildServer").getChildFile(INIConfig::PREBUILT_CACHE_FOLDER);
+        auto installed = root.getChildFile("Installed").getChildFile(INIConfig::MIDI_LIBRARY_FOLDER);
+        auto prebuiltCache = prebuilt.getChildFile(INIConfig::MIDI_ANALYSIS_BINARY_CACHE_FILE);
+        auto prebuiltBank = prebuilt.getChildFile(INIConfig::PATTERN_BANK_FILE);
+        built.getChildFile("Rock").createDirectory();
+
+        auto writePattern = [](const juce::File& file, int hits, int firstVelocity) {
+            const double ticksPerBeat = INIConfig::Defaults::MIDI_TICKS_PER_QUARTER_NOTE;
+            TestMidiFixtures::writeMidiFile(file, { TestMidiFixtures::makeHits(36, hits, ticksPerBeat * 0.5, ticksPerBeat * 0.25, firstVelocity, 1) });
+        };
+
+        const int numFiles = 6;
+        for (int i = 0; i < numFiles; ++i) {
+            const auto name = "Groove" + juce::String(i) + ".mid";
+            writePattern(i % 2 == 0 ? built.getChildFile("Rock").getChildFile(name) : built.getChildFile(name), 4 + i, 64);
+        }
+
+        // Built offline, as the batch analyzer does
+        MidiLibraryCatalog builtCatalog;
+        builtCatalog.setRoot(built);
+        const auto builtEntries = builtCatalog.getEntries();
+        {
+            MidiAnalysisCache cache(prebuiltCache, built);
+            expect(cache.analyze(builtEntries));
+            expect(PatternBank::compile(prebuiltBank, builtEntries, cache, nullptr, built));
+        }
+
+        // Installed somewhere else by writing the contents out again, so every file gets a
+        // modification time of its own, as from an installer that does not keep them
+        juce::Time newestBuilt;
+        for (const auto& entry : builtEntries) {
+            newestBuilt = juce::jmax(newestBuilt, entry.modified);
+        }
+        while (juce::Time::getCurrentTime() <= newestBuilt) {
+            juce::Thread::sleep(1);
+        }
+
+        bool timesDiffer = true;
+        for (const auto& entry : builtEntries) {
+            const auto copy = installed.getChildFile(entry.file.getRelativePathFrom(built));
+            juce::MemoryBlock data;
+            expect(entry.file.loadFileAsData(data) && copy.getParentDirectory().createDirectory().wasOk()
+                   && copy.replaceWithData(data.getData(), data.getSize()));
+            timesDiffer = timesDiffer && copy.getLastModificationTime() != entry.modified;
+        }
+        expect(timesDiffer, "The installed files should not keep the build server's modification times");
+
+        // The same size, but not the same groove
+        const auto changed = installed.getChildFile("Groove3.mid");
+        const auto changedSize = changed.getSize();
+        writePattern(changed, 4 + 3, 65);
+        expectEquals(changed.getSize(), changedSize);
+
+        MidiLibraryCatalog installedCatalog;
+        installedCatalog.setRoot(installed);
+        const auto installedEntries = installedCatalog.getEntries();
+        expectEquals(installedEntries.size(), numFiles);
+
+        auto userCache = root.getChildFile("User").getChildFile(INIConfig::MIDI_ANALYSIS_BINARY_CACHE_FILE);
+        auto countCached = [&installedEntries](MidiAnalysisCache& cache) {
+            int firstDone = -1;
+            cache.analyze(installedEntries, [&firstDone](int done, int) {
+                if (firstDone < 0) firstDone = done;
+                return true;
+            });
+            return firstDone;
+        };
+        {
+            MidiAnalysisCache cache(userCache, installed, prebuiltCache);
+            expectEquals(countCached(cache), numFiles - 1, "Only the changed file should be parsed; the rest match the prebuilt cache by contents");
+            expect(userCache.existsAsFile(), "The matches should be kept under the installed modification times");
+        }
+        {
+            MidiAnalysisCache cache(userCache, installed);
+            expectEquals(countCached(cache), numFiles, "The user's cache should match every installed file");
+        }
+
+        PatternBank bank;
+        expect(bank.open(prebuiltBank, installed), "The prebuilt bank should open against the installed library");
+        expectEquals(bank.getNumPatterns(), numFiles);
+
+        bool found = true;
+        for (const auto& entry : installedEntries) {
+            found = found && (entry.file == changed || bank.find(entry.file).isValid());
+        }
+        expect(found, "Every unchanged installed file should be served from the prebuilt bank");
+        expect(!bank.find(changed).isValid(), "A file with other contents should not be served from the prebuilt bank");
+        expect(juce::File(bank.getPath(0)).isAChildOf(installed));
+        expect(!bank.find(built.getChildFile("Groove1.mid")).isValid(), "Paths should match within the library, not where it was built");
+
+        bank.close();
+        root.deleteRecursively();
+    }
+
+    void testPatternPreloading() {
+        auto library = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("OTTOPatternPreloadTest");
+        library.deleteRecursively();
+        library.createDirectory();
+
+        juce::Array<juce::File> files;
+        for (int i = 0; i < 6; ++i) {
+            files.add(TestMidiFixtures::writeMidiFile(library.getChildFile("Groove" + juce::String(i) + ".mid"),
+                                                      { TestMidiFixtures::makeHits(36, 4 + i, 240, 120, 100) }, 480));
+        }
+
+        auto waitFor = [](const std::function<bool()>& condition) {
+            const auto deadline = juce::Time::getMillisecondCounter() + 5000;
+            while (!condition() && juce::Time::getMillisecondCounter() < deadline) {
+                juce::Thread::sleep(5);
+            }
+            return condition();
+        };
+
+        // Stands in for the engine: only the pinned pattern is playing
+        std::atomic<const SongArranger::Section*> pinned{nullptr};
+        PatternPreloader preloader([&pinned](const SongArranger::Section* section) { return section == pinned.load(); }, 4);
+        expectEquals(preloader.getCapacity(), 4);
+
+        preloader.prefetch({ files[0], files[1] });
+        expect(waitFor([&] { return preloader.isLoaded(files[0]) && preloader.isLoaded(files[1]); }),
+               "Prefetched patterns should load in the background");
+
+        const auto* first = preloader.getPattern(files[0]);
+        expect(first != nullptr);
+        expect(preloader.getPattern(files[0]) == first, "A preloaded pattern should be served from memory");
+
+        SongArranger::Section direct;
+        SongArranger::compilePattern(direct, files[0], INIConfig::Defaults::BEATS_PER_BAR);
+        expectEquals(first->numEvents, direct.numEvents);
+        expectEquals(first->loopBeats, direct.loopBeats);
+
+        // More files than room: the pool stops at its capacity and the pinned pattern stays
+        pinned.store(first);
+        preloader.prefetch(files);
+        expect(waitFor([&] { return preloader.getNumLoaded() == preloader.getCapacity(); }));
+        juce::Thread::sleep(50);
+        expectEquals(preloader.getNumLoaded(), preloader.getCapacity());
+
+        const auto* last = preloader.getPattern(files.getLast());
+        expect(last != nullptr && last != first, "A pattern asked for should replace one that is not playing");
+        expect(preloader.isLoaded(files.getLast()));
+        expect(preloader.isLoaded(files[0]), "A playing pattern should not be evicted");
+        expectEquals(preloader.getNumLoaded(), preloader.getCapacity());
+
+        // At another bar length a pattern is loaded again, leaving the playing copy alone
+        preloader.setBarBeats(3.0);
+        expect(!preloader.isLoaded(files[0]));
+        const auto* reloaded = preloader.getPattern(files[0]);
+        expect(reloaded != nullptr && reloaded != first, "A playing pattern should not be overwritten");
+        expectEquals(first->numEvents, direct.numEvents);
+        expectEquals(first->loopBeats, direct.loopBeats);
+
+        library.deleteRecursively();
+    }
+
     void testUnicodeSupport() {
         // Test Unicode in file names
         auto tempDir = juce::File::getSpecialLocation(juce::File::tempDirectory);
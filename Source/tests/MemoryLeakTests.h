@@ -190,6 +190,15 @@ private:
             fileManager.reset();
         }
 
+        // Going away mid-analysis stops the background thread, and nothing is reported after
+        bool reported = false;
+        auto fileManager = std::make_unique<MidiFileManager>();
+        fileManager->organizeFilesByTempo([&reported](int, int) { return reported = true; },
+                                          [&reported] { reported = true; });
+        expect(fileManager->isAnalyzingLibrary(), "Library analysis should run in the background");
+        fileManager.reset();
+        expect(!reported, "Analysis should report only through the message loop");
+
         expect(true, "File manager memory test completed");
     }
 
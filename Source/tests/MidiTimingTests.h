@@ -1,8 +1,14 @@
 #pragma once
 #include <JuceHeader.h>
+#include <array>
+#include <thread>
+#include <vector>
+#include "../LockFreeStructures.h"
 #include "../MidiEngine.h"
 #include "../MidiFileManager.h"
+#include "../Mixer.h"
 #include "../INIConfig.h"
+#include "TestMidiFixtures.h"
 
 class MidiTimingTests : public juce::UnitTest {
 public:
@@ -38,6 +44,30 @@ public:
 
         beginTest("Host Sync");
         testHostSync();
+
+        beginTest("CC Mapping Dispatch");
+        testCCMappingDispatch();
+
+        beginTest("Command Queue Handoff");
+        testCommandQueueHandoff();
+
+        beginTest("Sample-Accurate Launch");
+        testSampleAccurateLaunch();
+
+        beginTest("MIDI Clock Input Tracking");
+        testMidiClockInputTracking();
+
+        beginTest("Live Recording Ring");
+        testLiveRecordingRing();
+
+        beginTest("Tempo Map");
+        testTempoMap();
+
+        beginTest("Song Arranger");
+        testSongArranger();
+
+        beginTest("Precompiled Scene Launch");
+        testSceneLaunch();
     }
 
 private:
@@ -52,14 +82,18 @@ private:
 
         const double msPerSample = static_cast<double>(INIConfig::Defaults::MS_PER_SECOND) / static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE);
         const int samplesPerBeat = static_cast<int>(static_cast<double>(INIConfig::Defaults::MS_PER_MINUTE / INIConfig::Defaults::DEFAULT_TEMPO) / msPerSample);
+        const int samplesPerPulse = samplesPerBeat / INIConfig::MIDI::CLOCK_PPQN;
+        const int blockSize = 1024;
 
         int clockCount = INIConfig::Defaults::ZERO_VALUE;
-        for (int i = 0; i < samplesPerBeat; ++i) {
+        for (int blockStart = 0; blockStart < samplesPerBeat; blockStart += blockSize) {
             midiBuffer.clear();
-            engine.process(midiBuffer);
+            engine.process(midiBuffer, juce::jmin(blockSize, samplesPerBeat - blockStart));
 
             for (const auto metadata : midiBuffer) {
                 if (metadata.getMessage().isMidiClock()) {
+                    expectEquals(blockStart + metadata.samplePosition, clockCount * samplesPerPulse,
+                                 "Clock pulses should land on exact sample positions");
                     clockCount++;
                 }
             }
@@ -437,6 +471,679 @@ private:
         }
     }
 
+    void testCCMappingDispatch() {
+        MidiEngine engine;
+        engine.prepare(static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE));
+        engine.startPlayback();
+
+        juce::AudioParameterFloat volume(juce::ParameterID("player1Volume", 1), "Player 1 Volume",
+                                         juce::NormalisableRange<float>(0.0f, 1.0f), INIConfig::Defaults::VOLUME);
+        engine.setParameterResolver([&volume](const juce::String& parameterID) -> juce::RangedAudioParameter* {
+            return parameterID == volume.getParameterID() ? &volume : nullptr;
+        });
+
+        juce::StringArray unresolvedIDs;
+        engine.onMidiParameterChanged = [&unresolvedIDs](const juce::String& parameterID, float) {
+            unresolvedIDs.add(parameterID);
+        };
+
+        const int volumeCC = INIConfig::MIDI::DEFAULT_CC_NUMBER + INIConfig::Defaults::MAX_PLAYERS;
+
+        MidiEngine::MidiMapping volumeMapping;
+        volumeMapping.ccNumber = volumeCC;
+        volumeMapping.channel = INIConfig::Validation::MIN_MIDI_CHANNEL;
+        volumeMapping.parameterID = volume.getParameterID();
+        engine.addMidiMapping(volumeMapping);
+
+        MidiEngine::MidiMapping playMapping;
+        playMapping.ccNumber = volumeCC;
+        playMapping.channel = INIConfig::MIDI::OMNI_CHANNEL;
+        playMapping.parameterID = "playState";
+        playMapping.minValue = INIConfig::Validation::MAX_VOLUME;
+        engine.addMidiMapping(playMapping);
+
+        auto sendCC = [&engine](int channel, int ccNumber, int value) {
+            juce::MidiBuffer buffer;
+            buffer.addEvent(juce::MidiMessage::controllerEvent(channel, ccNumber, value), INIConfig::Defaults::ZERO_VALUE);
+            engine.process(buffer);
+        };
+
+        sendCC(INIConfig::Validation::MAX_MIDI_CHANNEL, volumeCC, INIConfig::LayoutConstants::midiEngineMaxMidiVelocity);
+        expectWithinAbsoluteError(volume.get(), INIConfig::Defaults::VOLUME, 1.0e-6f);
+        expect(unresolvedIDs.size() == 1 && unresolvedIDs[0] == "playState", "Omni mapping should fire on any channel");
+
+        sendCC(INIConfig::Validation::MIN_MIDI_CHANNEL, volumeCC, INIConfig::Defaults::ZERO_VALUE);
+        expectWithinAbsoluteError(volume.get(), 0.0f, 1.0e-6f);
+        expectEquals(unresolvedIDs.size(), 2);
+
+        engine.setMidiMappingEnabled(volume.getParameterID(), false);
+        sendCC(INIConfig::Validation::MIN_MIDI_CHANNEL, volumeCC, INIConfig::LayoutConstants::midiEngineMaxMidiVelocity);
+        expectWithinAbsoluteError(volume.get(), 0.0f, 1.0e-6f);
+        expectEquals(unresolvedIDs.size(), 3);
+
+        engine.clearAllMidiMappings();
+        sendCC(INIConfig::Validation::MIN_MIDI_CHANNEL, volumeCC, INIConfig::LayoutConstants::midiEngineMaxMidiVelocity);
+        expectEquals(unresolvedIDs.size(), 3, "Cleared mappings should no longer dispatch");
+    }
+
+    void testCommandQueueHandoff() {
+        MidiEngine engine;
+        engine.prepare(static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE));
+
+        juce::Array<MidiEngine::EngineEvent> events;
+        engine.onEngineEvent = [&events](const MidiEngine::EngineEvent& event) {
+            events.add(event);
+        };
+
+        const int playerIndex = INIConfig::Defaults::ONE_VALUE;
+        const int patternIndex = INIConfig::Defaults::MAX_PLAYERS;
+        const int channel = INIConfig::Validation::MAX_MIDI_CHANNEL;
+
+        engine.setSwing(playerIndex, INIConfig::Validation::MAX_SWING);
+        engine.setPlayerOutputChannel(playerIndex, channel);
+        expectEquals(engine.getSwing(playerIndex), INIConfig::Validation::MAX_SWING, "Getters should reflect changes immediately");
+        expectEquals(engine.getPlayerOutputChannel(playerIndex), channel);
+
+        engine.queueClipChange(playerIndex, patternIndex, INIConfig::Defaults::ZERO_VALUE);
+        expectEquals(engine.getQueuedChanges().size(), 1);
+
+        engine.dispatchEngineEvents();
+        expect(events.isEmpty(), "Nothing should be reported before the audio thread runs");
+
+        engine.startPlayback();
+        juce::MidiBuffer buffer;
+        engine.process(buffer);
+        engine.dispatchEngineEvents();
+
+        expectEquals(events.size(), 1);
+        if (events.size() == 1) {
+            expect(events[0].type == MidiEngine::EngineEvent::Type::PatternStarted);
+            expectEquals(events[0].playerIndex, playerIndex);
+            expectEquals(events[0].index, patternIndex);
+        }
+        expect(engine.getQueuedChanges().isEmpty(), "Launched clip should leave the queue");
+
+        events.clear();
+        engine.loadScene(INIConfig::Defaults::ZERO_VALUE);
+        engine.process(buffer);
+        engine.dispatchEngineEvents();
+
+        expect(events.size() == 1 && events[0].type == MidiEngine::EngineEvent::Type::SceneLaunched,
+               "Scene launch should be reported back to the message thread");
+        expectEquals(engine.getActiveSceneIndex(), static_cast<int>(INIConfig::Defaults::ZERO_VALUE));
+
+        // Audio-thread automation bypasses the command queue and reports back instead
+        events.clear();
+        engine.automateEnergy(playerIndex, INIConfig::Validation::MIN_ENERGY);
+        expectEquals(engine.getEnergy(playerIndex), INIConfig::Defaults::ENERGY, "Controls belong to the message thread");
+
+        engine.dispatchEngineEvents();
+        expect(events.size() == 1 && events[0].type == MidiEngine::EngineEvent::Type::EnergyAutomated);
+        expectEquals(engine.getEnergy(playerIndex), INIConfig::Validation::MIN_ENERGY,
+                     "Automated energy should reach the message thread's controls");
+
+        // Start and stop move the transport only once the audio thread drains them
+        engine.process(buffer, static_cast<int>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE));
+        engine.stopPlayback();
+        expect(engine.isPlaybackActive(), "Stop should wait for the audio thread");
+        engine.process(buffer, INIConfig::Defaults::ZERO_VALUE);
+        expect(!engine.isPlaybackActive());
+
+        engine.startPlayback();
+        expect(!engine.isPlaybackActive(), "Start should wait for the audio thread");
+        engine.process(buffer, INIConfig::Defaults::ZERO_VALUE);
+        expect(engine.isPlaybackActive());
+        expectEquals(engine.getCurrentBeat(), 0.0f, "Start should rewind the transport on the audio thread");
+
+        engine.stopPlayback();
+
+        // Automation arrives from the audio thread and host threads at once
+        struct Change { int producer; int sequence; };
+        constexpr int numProducers = 4;
+        constexpr int changesPerProducer = 20000;
+        MpscFifo<Change, INIConfig::MIDI::AUTOMATION_QUEUE_SIZE> changes;
+
+        std::vector<std::thread> producers;
+        for (int producer = 0; producer < numProducers; ++producer) {
+            producers.emplace_back([&changes, producer] {
+                for (int sequence = 0; sequence < changesPerProducer; ++sequence) {
+                    while (!changes.push({ producer, sequence })) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        std::array<int, numProducers> nextSequence{};
+        int received = 0;
+        bool inOrder = true;
+        Change change;
+        while (received < numProducers * changesPerProducer) {
+            if (!changes.pop(change)) {
+                std::this_thread::yield();
+                continue;
+            }
+            inOrder = inOrder && change.sequence == nextSequence[static_cast<size_t>(change.producer)];
+            nextSequence[static_cast<size_t>(change.producer)] = change.sequence + 1;
+            ++received;
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+
+        expect(inOrder, "Each producer's changes should arrive whole and in order");
+        expect(!changes.pop(change), "Nothing should be left over");
+    }
+
+    void testSampleAccurateLaunch() {
+        const double sampleRate = static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE);
+        const float tempo = static_cast<float>(INIConfig::Defaults::DEFAULT_TEMPO);
+        const double samplesPerBeat = sampleRate * INIConfig::Defaults::SECONDS_PER_MINUTE / tempo;
+        const int beatQuantize = static_cast<int>(INIConfig::Defaults::BEATS_PER_BAR);
+        const int barQuantize = INIConfig::Defaults::ONE_VALUE;
+
+        const int blockSizes[] = { 1, 64, 333, 4096 };
+
+        for (auto blockSize : blockSizes) {
+            MidiEngine engine;
+            engine.prepare(sampleRate);
+            engine.setTempo(tempo);
+            engine.startPlayback();
+
+            juce::Array<MidiEngine::EngineEvent> events;
+            engine.onEngineEvent = [&events](const MidiEngine::EngineEvent& event) {
+                events.add(event);
+            };
+
+            juce::MidiBuffer buffer;
+            engine.process(buffer, blockSize);
+
+            // Requested mid-beat: the clip starts on the next beat, the scene on the next bar
+            engine.queueClipChange(INIConfig::Defaults::ONE_VALUE, INIConfig::Defaults::MAX_PLAYERS, beatQuantize);
+            engine.queueSceneChange(INIConfig::Defaults::ONE_VALUE, barQuantize);
+
+            const auto totalSamples = static_cast<juce::int64>(samplesPerBeat * INIConfig::Defaults::BEATS_PER_BAR) + blockSize;
+            for (juce::int64 processed = blockSize; processed <= totalSamples; processed += blockSize) {
+                engine.process(buffer, blockSize);
+            }
+            engine.dispatchEngineEvents();
+
+            expectEquals(events.size(), 2, "Both launches should fire with block size " + juce::String(blockSize));
+            if (events.size() != 2) continue;
+
+            const auto expectedClipSample = static_cast<juce::int64>(std::ceil(blockSize / samplesPerBeat) * samplesPerBeat);
+            expect(events[0].type == MidiEngine::EngineEvent::Type::PatternStarted);
+            expectEquals(events[0].samplePosition, expectedClipSample, "Clip should start on the beat");
+
+            expect(events[1].type == MidiEngine::EngineEvent::Type::SceneLaunched);
+            expectEquals(events[1].samplePosition, static_cast<juce::int64>(samplesPerBeat * INIConfig::Defaults::BEATS_PER_BAR),
+                         "Scene should launch on the bar");
+        }
+    }
+
+    void testMidiClockInputTracking() {
+        const double sampleRate = static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE);
+        const double externalTempo = static_cast<double>(INIConfig::Defaults::DEFAULT_TEMPO) * 1.1;
+        const double samplesPerTick = sampleRate * INIConfig::Defaults::SECONDS_PER_MINUTE / (externalTempo * INIConfig::MIDI::CLOCK_PPQN);
+        const double jitterSamples = sampleRate * 0.002;
+        const int blockSize = 512;
+
+        MidiEngine engine;
+        engine.prepare(sampleRate);
+        engine.setReceiveMidiClock(true);
+
+        juce::Random random(INIConfig::Defaults::ONE_VALUE);
+        juce::int64 blockStart = 0;
+        int nextTick = 0;
+        double maxPhaseErrorMs = 0.0;
+
+        const int beatsToRun = INIConfig::Defaults::MAX_PLAYERS * 2;
+        while (nextTick < beatsToRun * INIConfig::MIDI::CLOCK_PPQN) {
+            juce::MidiBuffer buffer;
+            if (blockStart == 0) {
+                buffer.addEvent(juce::MidiMessage::midiStart(), 0);
+            }
+
+            // Ticks are timestamped with up to +/-2 ms of jitter, as from a USB interface
+            for (;;) {
+                const double idealTime = nextTick * samplesPerTick;
+                const auto tickTime = static_cast<juce::int64>(idealTime + (random.nextDouble() * 2.0 - 1.0) * jitterSamples) + static_cast<juce::int64>(jitterSamples);
+                if (tickTime >= blockStart + blockSize) break;
+
+                buffer.addEvent(juce::MidiMessage::midiClock(), static_cast<int>(juce::jmax(juce::int64(0), tickTime - blockStart)));
+                ++nextTick;
+            }
+
+            engine.process(buffer, blockSize);
+            blockStart += blockSize;
+
+            // Skip the pull-in over the first few beats
+            if (nextTick > INIConfig::MIDI::CLOCK_PPQN * INIConfig::Defaults::MAX_PLAYERS) {
+                const double idealBeat = (blockStart - jitterSamples) / (samplesPerTick * INIConfig::MIDI::CLOCK_PPQN);
+                const double phaseErrorMs = std::abs(engine.getTransportBeat() - idealBeat)
+                                          * INIConfig::Defaults::MS_PER_MINUTE / externalTempo;
+                maxPhaseErrorMs = juce::jmax(maxPhaseErrorMs, phaseErrorMs);
+            }
+        }
+
+        expectWithinAbsoluteError(engine.getTempo(), static_cast<float>(externalTempo), 0.5f);
+        expectLessThan(static_cast<float>(maxPhaseErrorMs), 1.0f);
+
+        // A dropout restarts the loop wide, and it narrows again once it has pulled back in
+        MidiClockTracker tracker;
+        tracker.reset(externalTempo);
+        const double tickSeconds = samplesPerTick / sampleRate;
+        double tickTime = 0.0;
+        auto runTicks = [&](int numTicks) {
+            for (int i = 0; i < numTicks; ++i) {
+                tracker.processTick(tickTime);
+                tickTime += tickSeconds;
+            }
+        };
+
+        runTicks(INIConfig::MIDI::CLOCK_LOCK_TICKS * 2);
+        expect(tracker.isLocked(), "Clock should lock after the pull-in");
+
+        tickTime += tickSeconds * INIConfig::MIDI::CLOCK_TIMEOUT_TICKS * 2;
+        runTicks(INIConfig::Defaults::ONE_VALUE);
+        expect(!tracker.isLocked(), "A dropout should restart the loop");
+
+        runTicks(INIConfig::MIDI::CLOCK_LOCK_TICKS);
+        expect(tracker.isLocked(), "Clock should lock again after a restart");
+    }
+
+    void testLiveRecordingRing() {
+        const double sampleRate = static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE);
+        const float tempo = static_cast<float>(INIConfig::Defaults::DEFAULT_TEMPO);
+        const double samplesPerBeat = sampleRate * INIConfig::Defaults::SECONDS_PER_MINUTE / tempo;
+        const auto samplesPerLoop = static_cast<juce::int64>(samplesPerBeat * INIConfig::Defaults::BEATS_PER_BAR * INIConfig::Defaults::BEATS_PER_BAR);
+        const int blockSize = 333;
+        const int note = INIConfig::GMDrums::HI_MID_TOM;
+        const auto velocity = static_cast<juce::uint8>(INIConfig::Defaults::FIXED_VELOCITY);
+
+        // Input timestamps are absolute sample positions, delivered through fixed-size blocks
+        auto playInput = [blockSize](MidiEngine& engine, const juce::MidiMessageSequence& input, juce::int64 totalSamples) {
+            for (juce::int64 blockStart = 0; blockStart < totalSamples; blockStart += blockSize) {
+                juce::MidiBuffer buffer;
+                for (const auto* event : input) {
+                    const auto sample = static_cast<juce::int64>(event->message.getTimeStamp());
+                    if (sample >= blockStart && sample < blockStart + blockSize)
+                        buffer.addEvent(event->message, static_cast<int>(sample - blockStart));
+                }
+                engine.process(buffer, blockSize);
+            }
+        };
+
+        {
+            MidiEngine engine;
+            engine.prepare(sampleRate);
+            engine.setTempo(tempo);
+            engine.startLiveRecording(false);
+            engine.startPlayback();
+
+            juce::MidiMessageSequence input;
+            input.addEvent(juce::MidiMessage::noteOn(INIConfig::Validation::MIN_MIDI_CHANNEL, note, velocity), 10000.0);
+            input.addEvent(juce::MidiMessage::noteOff(INIConfig::Validation::MIN_MIDI_CHANNEL, note), 22000.0);
+            playInput(engine, input, static_cast<juce::int64>(samplesPerBeat * 2.0));
+            engine.stopLiveRecording();
+
+            const auto& recorded = engine.getRecordedSequence();
+            expectEquals(recorded.getNumEvents(), 2);
+            if (recorded.getNumEvents() == 2) {
+                expectWithinAbsoluteError(static_cast<float>(recorded.getEventTime(0)), static_cast<float>(10000.0 / samplesPerBeat), 1.0e-6f);
+                expectWithinAbsoluteError(static_cast<float>(recorded.getEventTime(1)), static_cast<float>(22000.0 / samplesPerBeat), 1.0e-6f);
+            }
+        }
+
+        {
+            MidiEngine engine;
+            engine.prepare(sampleRate);
+            engine.setTempo(tempo);
+            engine.setQuantize(INIConfig::Defaults::DEFAULT_QUANTIZE_VALUE);
+            engine.setQuantizeRecording(true);
+            engine.startLiveRecording(false);
+            engine.startPlayback();
+
+            // On at beat 0.3 snaps to the sixteenth at 0.25; the off keeps the note length
+            juce::MidiMessageSequence input;
+            input.addEvent(juce::MidiMessage::noteOn(INIConfig::Validation::MIN_MIDI_CHANNEL, note, velocity), samplesPerBeat * 0.3);
+            input.addEvent(juce::MidiMessage::noteOff(INIConfig::Validation::MIN_MIDI_CHANNEL, note), samplesPerBeat * 0.5);
+            playInput(engine, input, static_cast<juce::int64>(samplesPerBeat));
+            engine.stopLiveRecording();
+
+            const auto& recorded = engine.getRecordedSequence();
+            expectEquals(recorded.getNumEvents(), 2);
+            if (recorded.getNumEvents() == 2) {
+                expectWithinAbsoluteError(static_cast<float>(recorded.getEventTime(0)), 0.25f, 1.0e-6f);
+                expectWithinAbsoluteError(static_cast<float>(recorded.getEventTime(1)), 0.45f, 1.0e-6f);
+            }
+        }
+
+        {
+            MidiEngine engine;
+            engine.prepare(sampleRate);
+            engine.setTempo(tempo);
+            engine.setLoopRecordingMode(true);
+            engine.startLiveRecording(false);
+            engine.startPlayback();
+
+            // The first pass becomes the pattern; the take restarts from the loop boundary
+            juce::MidiMessageSequence input;
+            input.addEvent(juce::MidiMessage::noteOn(INIConfig::Validation::MIN_MIDI_CHANNEL, note, velocity), samplesPerBeat * 0.5);
+            input.addEvent(juce::MidiMessage::noteOn(INIConfig::Validation::MIN_MIDI_CHANNEL, note, velocity), static_cast<double>(samplesPerLoop) + samplesPerBeat * 0.25);
+            playInput(engine, input, samplesPerLoop + static_cast<juce::int64>(samplesPerBeat));
+
+            const auto& recorded = engine.getRecordedSequence();
+            expectEquals(recorded.getNumEvents(), 1);
+            if (recorded.getNumEvents() == 1) {
+                expectWithinAbsoluteError(static_cast<float>(recorded.getEventTime(0)), 0.25f, 1.0e-6f);
+            }
+
+            expect(engine.getCurrentEngineState().patterns.size() > 0, "The finished pass should be published as the player's pattern");
+            engine.stopLiveRecording();
+        }
+
+        {
+            MidiEngine engine;
+            engine.prepare(sampleRate);
+            engine.setTempo(tempo);
+            engine.setReceiveMidiClock(true);
+
+            // Start, clock and one note, then Stop two beats in
+            auto clockedTake = [&](int takeNote, double noteBeat) {
+                juce::MidiMessageSequence input;
+                input.addEvent(juce::MidiMessage::midiStart(), 0.0);
+                for (int tick = 0; tick < INIConfig::MIDI::CLOCK_PPQN * 2; ++tick)
+                    input.addEvent(juce::MidiMessage::midiClock(), tick * samplesPerBeat / INIConfig::MIDI::CLOCK_PPQN);
+                input.addEvent(juce::MidiMessage::noteOn(INIConfig::Validation::MIN_MIDI_CHANNEL, takeNote, velocity), samplesPerBeat * noteBeat);
+                input.addEvent(juce::MidiMessage::noteOff(INIConfig::Validation::MIN_MIDI_CHANNEL, takeNote), samplesPerBeat * (noteBeat + 0.25));
+                input.addEvent(juce::MidiMessage::midiStop(), samplesPerBeat * 2.0);
+                playInput(engine, input, static_cast<juce::int64>(samplesPerBeat * 2.0) + blockSize);
+            };
+
+            engine.startLiveRecording(false);
+            clockedTake(note, 0.5);
+            engine.dispatchEngineEvents();
+
+            expect(!engine.isLiveRecording(), "MIDI Stop should close the take");
+            const auto firstTake = engine.getRecordedSequence();
+            expectEquals(firstTake.getNumEvents(), 2);
+
+            engine.startLiveRecording(false);
+            clockedTake(note + 1, 1.0);
+            engine.dispatchEngineEvents();
+
+            const auto& secondTake = engine.getRecordedSequence();
+            expect(!engine.isLiveRecording(), "MIDI Stop should close the second take");
+            expectEquals(secondTake.getNumEvents(), 2, "The second take should hold only its own notes");
+            if (secondTake.getNumEvents() == 2) {
+                expectEquals(secondTake.getEventPointer(0)->message.getNoteNumber(), note + 1);
+                expectWithinAbsoluteError(static_cast<float>(secondTake.getEventTime(0)), 1.0f, 0.05f);
+            }
+        }
+    }
+
+    void testTempoMap() {
+        const double sampleRate = static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE);
+
+        // 3/4, ramping from 120 to 180 BPM over the first 8 beats, then holding
+        TempoMap map;
+        map.addTempoChange(0.0, INIConfig::Defaults::DEFAULT_TEMPO, true);
+        map.addTempoChange(8.0, INIConfig::Defaults::DEFAULT_TEMPO * 1.5);
+        map.addMeterChange(0, 3, 4);
+
+        // Closed form of the ramp: 60 / slope * ln(180 / 120) seconds
+        expectWithinAbsoluteError(static_cast<float>(map.beatToSeconds(8.0)), static_cast<float>(8.0 * std::log(1.5)), 1.0e-6f);
+        expectWithinAbsoluteError(static_cast<float>(map.secondsToBeat(map.beatToSeconds(5.25))), 5.25f, 1.0e-6f);
+        expectWithinAbsoluteError(static_cast<float>(map.getBarStartBeat(2)), 6.0f, 1.0e-6f);
+        expectWithinAbsoluteError(static_cast<float>(map.getNextGridBoundary(3.1, 1)), 6.0f, 1.0e-6f);
+
+        const int blockSizes[] = { 64, 333, 1024 };
+
+        for (auto blockSize : blockSizes) {
+            MidiEngine engine;
+            engine.prepare(sampleRate);
+            engine.setTempoMap(map);
+            engine.setSendMidiClock(true);
+            engine.setMetronomeEnabled(true);
+            engine.startPlayback();
+
+            juce::Array<MidiEngine::EngineEvent> events;
+            engine.onEngineEvent = [&events](const MidiEngine::EngineEvent& event) {
+                events.add(event);
+            };
+
+            juce::Array<juce::int64> pulseSamples;
+            int downbeats = 0;
+            juce::int64 blockStart = 0;
+
+            while (engine.getTransportBeat() < 10.5) {
+                juce::MidiBuffer buffer;
+                engine.process(buffer, blockSize);
+
+                for (const auto metadata : buffer) {
+                    const auto message = metadata.getMessage();
+                    if (message.isMidiClock())
+                        pulseSamples.add(blockStart + metadata.samplePosition);
+                    else if (message.isNoteOn() && message.getNoteNumber() == INIConfig::LayoutConstants::midiEngineMetronomeHighNote)
+                        ++downbeats;
+                }
+
+                if (blockStart == 0) {
+                    engine.queueSceneChange(INIConfig::Defaults::ONE_VALUE, INIConfig::Defaults::ONE_VALUE);
+                }
+                blockStart += blockSize;
+            }
+            engine.dispatchEngineEvents();
+
+            // Every pulse sits on the sample the ramp puts it on
+            int misplacedPulses = 0;
+            for (int i = 0; i < pulseSamples.size(); ++i) {
+                const double pulseBeat = i / static_cast<double>(INIConfig::MIDI::CLOCK_PPQN);
+                const auto expected = static_cast<juce::int64>(std::ceil(map.beatToSeconds(pulseBeat) * sampleRate - 1.0e-6));
+                if (pulseSamples[i] != expected) ++misplacedPulses;
+            }
+            expectEquals(misplacedPulses, 0, "Clock pulses should follow the ramp with block size " + juce::String(blockSize));
+
+            // Bars of 3: accents on beats 0, 3, 6 and 9
+            expectEquals(downbeats, 4);
+
+            expectEquals(events.size(), 1);
+            if (events.size() == 1) {
+                const auto expectedSample = static_cast<juce::int64>(std::ceil(map.beatToSeconds(3.0) * sampleRate - 1.0e-6));
+                expectEquals(events[0].samplePosition, expectedSample, "The scene should launch on the 3/4 bar line");
+            }
+        }
+    }
+
+    void testSongArranger() {
+        const double sampleRate = static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE);
+        const float tempo = static_cast<float>(INIConfig::Defaults::DEFAULT_TEMPO);
+        const double samplesPerBeat = sampleRate * INIConfig::Defaults::SECONDS_PER_MINUTE / tempo;
+        const int ticksPerBeat = INIConfig::Defaults::MIDI_TICKS_PER_QUARTER_NOTE;
+        const int kick = INIConfig::GMDrums::BASS_DRUM_1;
+        const int snare = INIConfig::GMDrums::ACOUSTIC_SNARE;
+
+        auto tempDir = juce::File::getSpecialLocation(juce::File::tempDirectory);
+
+        auto writePattern = [&](const juce::String& name, int note, int hitsPerBar) {
+            const int spacing = ticksPerBeat * static_cast<int>(INIConfig::Defaults::BEATS_PER_BAR) / hitsPerBar;
+            return TestMidiFixtures::writeMidiFile(tempDir.getChildFile(name),
+                                                   { TestMidiFixtures::makeHits(note, hitsPerBar, spacing, spacing / 2, 100) }, ticksPerBeat);
+        };
+
+        auto groove = writePattern("otto_song_groove.mid", kick, 4);
+        auto fill = writePattern("otto_song_fill.mid", snare, 8);
+
+        // Two bars of groove, the second replaced by the fill, looping
+        SongArranger::Chain chain;
+        SongArranger::Step step;
+        step.patternIndex = 0;
+        step.midiFile = groove;
+        step.bars = 2;
+        step.fillPatternIndex = 1;
+        step.fillMidiFile = fill;
+        chain.steps.add(step);
+
+        const int blockSizes[] = { 64, 333, 4096 };
+        const double endBeat = 4.0 * INIConfig::Defaults::BEATS_PER_BAR;
+        const auto endSample = static_cast<juce::int64>(std::ceil(endBeat * samplesPerBeat - 1.0e-6));
+
+        for (auto blockSize : blockSizes) {
+            MidiEngine engine;
+            engine.prepare(sampleRate);
+            engine.setTempo(tempo);
+            engine.setPatternChain(0, chain);
+            expect(engine.hasPatternChain(0));
+
+            engine.prepareSongSections();
+            engine.startPlayback();
+
+            juce::Array<juce::int64> kickSamples;
+            int snares = 0;
+            juce::int64 blockStart = 0;
+
+            while (engine.getTransportBeat() < endBeat) {
+                juce::MidiBuffer buffer;
+                engine.process(buffer, blockSize);
+                engine.prepareSongSections();
+
+                // The last block runs past bar 3 into the chain's next loop
+                for (const auto metadata : buffer) {
+                    const auto message = metadata.getMessage();
+                    const auto sample = blockStart + metadata.samplePosition;
+                    if (!message.isNoteOn() || sample >= endSample) continue;
+
+                    if (message.getNoteNumber() == kick)
+                        kickSamples.add(sample);
+                    else if (message.getNoteNumber() == snare)
+                        ++snares;
+                }
+                blockStart += blockSize;
+            }
+
+            // Bars 0 and 2 play the groove, bars 1 and 3 the fill
+            const int expectedBeats[] = { 0, 1, 2, 3, 8, 9, 10, 11 };
+            expectEquals(kickSamples.size(), 8, "Groove bars should play with block size " + juce::String(blockSize));
+            expectEquals(snares, 16, "Fill bars should play with block size " + juce::String(blockSize));
+
+            for (int i = 0; i < juce::jmin(kickSamples.size(), 8); ++i) {
+                const auto expected = static_cast<juce::int64>(std::ceil(expectedBeats[i] * samplesPerBeat - 1.0e-6));
+                expectEquals(kickSamples[i], expected, "Each hit should land on its own sample");
+            }
+
+            engine.clearPatternChain(0);
+            expect(!engine.hasPatternChain(0));
+        }
+
+        groove.deleteFile();
+        fill.deleteFile();
+    }
+
+    void testSceneLaunch() {
+        const double sampleRate = static_cast<double>(INIConfig::Defaults::DEFAULT_SAMPLE_RATE);
+        const float tempo = static_cast<float>(INIConfig::Defaults::DEFAULT_TEMPO);
+        const double samplesPerBeat = sampleRate * INIConfig::Defaults::SECONDS_PER_MINUTE / tempo;
+        const int ticksPerBeat = INIConfig::Defaults::MIDI_TICKS_PER_QUARTER_NOTE;
+        const int kick = INIConfig::GMDrums::BASS_DRUM_1;
+        const int snare = INIConfig::GMDrums::ACOUSTIC_SNARE;
+        const int blockSize = 333;
+
+        auto tempDir = juce::File::getSpecialLocation(juce::File::tempDirectory);
+
+        auto writePattern = [&](const juce::String& name, int note, int hitsPerBar) {
+            const int spacing = ticksPerBeat * static_cast<int>(INIConfig::Defaults::BEATS_PER_BAR) / hitsPerBar;
+            return TestMidiFixtures::writeMidiFile(tempDir.getChildFile(name),
+                                                   { TestMidiFixtures::makeHits(note, hitsPerBar, spacing, spacing / 2, 100) }, ticksPerBeat);
+        };
+
+        auto groove = writePattern("otto_scene_groove.mid", kick, 4);
+        auto fill = writePattern("otto_scene_fill.mid", snare, 8);
+
+        Mixer mixer;
+        MidiEngine engine;
+        engine.prepare(sampleRate);
+        engine.setTempo(tempo);
+        engine.setMixer(&mixer);
+
+        // Every slot filled: even scenes play the groove, odd ones the fill at their own level
+        for (int s = 0; s < INIConfig::Defaults::MAX_SCENES; ++s) {
+            MidiEngine::Scene scene;
+            scene.tempo = tempo;
+            scene.hasMixerLevels = true;
+            scene.clips[0].active = true;
+            scene.clips[0].patternIndex = s % 2;
+            scene.clips[0].midiFile = s % 2 == 0 ? groove : fill;
+            scene.clips[0].mixerVolume = static_cast<float>(s + 1) / INIConfig::Defaults::MAX_SCENES;
+            engine.setScene(s, scene);
+        }
+
+        const int fillScene = INIConfig::Defaults::MAX_SCENES - 1;
+        const int grooveScene = INIConfig::Defaults::MAX_SCENES - 2;
+
+        engine.startPlayback();
+
+        const double endBeat = 3.0 * INIConfig::Defaults::BEATS_PER_BAR;
+        const auto endSample = static_cast<juce::int64>(std::ceil(endBeat * samplesPerBeat - 1.0e-6));
+
+        juce::Array<juce::int64> kickSamples;
+        juce::Array<juce::int64> snareSamples;
+        juce::int64 blockStart = 0;
+        float fillVolume = 0.0f;
+        bool fillQueued = false;
+        bool grooveQueued = false;
+
+        while (engine.getTransportBeat() < endBeat) {
+            // Bar 1 plays the fill scene, bar 2 the groove scene, each from its bar line
+            if (!fillQueued && engine.getTransportBeat() > 0.0) {
+                engine.queueSceneChange(fillScene, 1);
+                fillQueued = true;
+            } else if (!grooveQueued && engine.getTransportBeat() > INIConfig::Defaults::BEATS_PER_BAR) {
+                fillVolume = mixer.getChannelVolume(0);
+                engine.queueSceneChange(grooveScene, 1);
+                grooveQueued = true;
+            }
+
+            juce::MidiBuffer buffer;
+            engine.process(buffer, blockSize);
+
+            for (const auto metadata : buffer) {
+                const auto message = metadata.getMessage();
+                const auto sample = blockStart + metadata.samplePosition;
+                if (!message.isNoteOn() || sample >= endSample) continue;
+
+                if (message.getNoteNumber() == kick)
+                    kickSamples.add(sample);
+                else if (message.getNoteNumber() == snare)
+                    snareSamples.add(sample);
+            }
+            blockStart += blockSize;
+        }
+
+        expectEquals(snareSamples.size(), 8, "The fill scene should play its pattern for one bar");
+        expectEquals(kickSamples.size(), 4, "The groove scene should take over on the next bar");
+
+        for (int i = 0; i < juce::jmin(snareSamples.size(), 8); ++i) {
+            const double beat = INIConfig::Defaults::BEATS_PER_BAR + i * 0.5;
+            expectEquals(snareSamples[i], static_cast<juce::int64>(std::ceil(beat * samplesPerBeat - 1.0e-6)),
+                         "Fill hits should start on the launch sample");
+        }
+
+        for (int i = 0; i < juce::jmin(kickSamples.size(), 4); ++i) {
+            const double beat = 2.0 * INIConfig::Defaults::BEATS_PER_BAR + i;
+            expectEquals(kickSamples[i], static_cast<juce::int64>(std::ceil(beat * samplesPerBeat - 1.0e-6)),
+                         "Groove hits should start on the launch sample");
+        }
+
+        expectWithinAbsoluteError(fillVolume, static_cast<float>(fillScene + 1) / INIConfig::Defaults::MAX_SCENES, 1.0e-6f,
+                                  "The fill scene should bring its mixer level");
+        expectWithinAbsoluteError(mixer.getChannelVolume(0), static_cast<float>(grooveScene + 1) / INIConfig::Defaults::MAX_SCENES, 1.0e-6f,
+                                  "The groove scene should bring its mixer level");
+
+        groove.deleteFile();
+        fill.deleteFile();
+    }
+
     void expectWithinAbsoluteError(float actual, float expected, float tolerance) {
         expect(std::abs(actual - expected) <= tolerance,
                "Expected " + juce::String(expected) + " but got " + juce::String(actual));
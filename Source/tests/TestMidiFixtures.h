@@ -0,0 +1,36 @@
+#pragma once
+#include <JuceHeader.h>
+#include <initializer_list>
+#include "../INIConfig.h"
+
+// MIDI files written by the tests as stand-ins for a pattern library
+namespace TestMidiFixtures {
+
+    // Evenly spaced hits of one drum on the GM drum channel. Each hit is velocityStep
+    // louder than the one before it, so patterns of the same length can still be told apart.
+    inline juce::MidiMessageSequence makeHits(int note, int numHits, double spacingTicks, double lengthTicks,
+                                              int firstVelocity, int velocityStep = 0) {
+        juce::MidiMessageSequence track;
+        for (int hit = 0; hit < numHits; ++hit) {
+            const auto velocity = static_cast<juce::uint8>(juce::jlimit(1, 127, firstVelocity + hit * velocityStep));
+            track.addEvent(juce::MidiMessage::noteOn(INIConfig::Defaults::DEFAULT_MIDI_CHANNEL, note, velocity), hit * spacingTicks);
+            track.addEvent(juce::MidiMessage::noteOff(INIConfig::Defaults::DEFAULT_MIDI_CHANNEL, note), hit * spacingTicks + lengthTicks);
+        }
+        return track;
+    }
+
+    // Replaces whatever file was there
+    inline juce::File writeMidiFile(const juce::File& file, std::initializer_list<juce::MidiMessageSequence> tracks,
+                                    int ticksPerBeat = INIConfig::Defaults::MIDI_TICKS_PER_QUARTER_NOTE) {
+        juce::MidiFile midiFile;
+        midiFile.setTicksPerQuarterNote(ticksPerBeat);
+        for (const auto& track : tracks) {
+            midiFile.addTrack(track);
+        }
+
+        file.deleteFile();
+        juce::FileOutputStream stream(file);
+        midiFile.writeTo(stream);
+        return file;
+    }
+}
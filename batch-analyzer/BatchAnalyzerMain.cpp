@@ -0,0 +1,371 @@
+#include <JuceHeader.h>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "../Source/INIConfig.h"
+#include "../Source/MidiLibraryCatalog.h"
+#include "../Source/MidiAnalysisCache.h"
+#include "../Source/GrooveSimilarityIndex.h"
+#include "../Source/PatternBank.h"
+#include "../Source/SFZEngine.h"
+
+//==============================================================================
+// OTTO Batch Analyzer - Headless Library Preprocessing
+// Builds the groove analysis cache and pattern bank for an assets folder ahead of
+// time, so the plugin finds them in Assets/Cache instead of building them on first
+// launch, and loads every drum kit to catch missing samples before they ship
+//==============================================================================
+
+namespace {
+    constexpr int maxIndexQueries = 1000;
+
+    // The size of library a similarity search has to stay interactive on
+    constexpr int benchmarkGrooves = 100000;
+    constexpr int benchmarkQueries = 200;
+    constexpr double maxBenchmarkQueryMs = 5.0;
+
+    double secondsSince(double startMs) {
+        return (juce::Time::getMillisecondCounterHiRes() - startMs) / 1000.0;
+    }
+
+    void printThroughput(const juce::String& stage, int items, const juce::String& unit,
+                         juce::int64 bytes, double seconds) {
+        const double elapsed = juce::jmax(seconds, 1.0e-6);
+        juce::String line = stage.paddedRight(' ', 12) + juce::String(items) + " " + unit
+                          + " in " + juce::String(seconds, 2) + " s, "
+                          + juce::String(items / elapsed, 1) + " " + unit + "/s";
+        if (bytes > 0) {
+            line << ", " << juce::String(static_cast<double>(bytes) / (1024.0 * 1024.0) / elapsed, 1) << " MB/s";
+        }
+        std::cout << line << std::endl;
+    }
+
+    //==========================================================================
+    // Drum kits, loaded on worker threads with one SFZEngine per worker
+    //==========================================================================
+
+    struct KitLoad {
+        juce::String kitName;
+        juce::String sfzName;
+        juce::int64 bytes = 0;
+        int numRegions = 0;
+    };
+
+    struct KitBatch {
+        juce::File kitsFolder;
+        std::vector<KitLoad> loads;
+        std::atomic<int> nextIndex{0};
+    };
+
+    class KitLoadJob : public juce::ThreadPoolJob {
+    public:
+        explicit KitLoadJob(KitBatch& batchToRun) : juce::ThreadPoolJob("Kit Load"), batch(batchToRun) {}
+
+        JobStatus runJob() override {
+            SFZEngine engine;
+            engine.setSFZFolder(batch.kitsFolder);
+
+            while (!shouldExit()) {
+                const int index = batch.nextIndex.fetch_add(1);
+                if (index >= static_cast<int>(batch.loads.size())) break;
+
+                auto& load = batch.loads[static_cast<size_t>(index)];
+                engine.loadDrumkit(load.kitName, load.sfzName);
+                load.numRegions = engine.getNumRegions();
+            }
+            return jobHasFinished;
+        }
+
+    private:
+        KitBatch& batch;
+    };
+
+    //==========================================================================
+    // Stages
+    //==========================================================================
+
+    juce::Array<MidiLibraryCatalog::Entry> scanLibrary(MidiLibraryCatalog& catalog, const juce::File& library) {
+        const double start = juce::Time::getMillisecondCounterHiRes();
+        catalog.setRoot(library);
+        const auto entries = catalog.getEntries();
+
+        juce::int64 bytes = 0;
+        for (const auto& entry : entries) {
+            bytes += entry.size;
+        }
+        printThroughput("Scan", entries.size(), "files", bytes, secondsSince(start));
+        return entries;
+    }
+
+    void analyzeLibrary(MidiAnalysisCache& cache, const juce::Array<MidiLibraryCatalog::Entry>& entries) {
+        // Throughput of the files actually parsed; the rest come from the cache
+        int numToParse = 0;
+        juce::int64 bytesToParse = 0;
+        for (const auto& entry : entries) {
+            if (cache.find(entry) == nullptr) {
+                ++numToParse;
+                bytesToParse += entry.size;
+            }
+        }
+
+        int lastDecile = -1;
+        const double start = juce::Time::getMillisecondCounterHiRes();
+        cache.analyze(entries, [&lastDecile](int done, int total) {
+            const int decile = total > 0 ? done * 10 / total : 10;
+            if (decile != lastDecile) {
+                std::cout << "  analyzed " << done << " of " << total << std::endl;
+                lastDecile = decile;
+            }
+            return true;
+        });
+        const double seconds = secondsSince(start);
+
+        if (!cache.save()) {
+            juce::ConsoleApplication::fail("Could not write the analysis cache");
+        }
+
+        printThroughput("Analysis", numToParse, "files", bytesToParse, seconds);
+        std::cout << "  " << (entries.size() - numToParse) << " already cached" << std::endl;
+    }
+
+    void compileBank(const juce::File& bankFile, const juce::File& library,
+                     const juce::Array<MidiLibraryCatalog::Entry>& entries, MidiAnalysisCache& cache) {
+        const double start = juce::Time::getMillisecondCounterHiRes();
+
+        // Patterns unchanged since the last run are copied across rather than read again
+        PatternBank previous;
+        previous.open(bankFile, library);
+
+        bool compiled = PatternBank::compile(bankFile, entries, cache, &previous, library);
+        if (!compiled && previous.isOpen()) {
+            // Where a mapped file cannot be replaced, compiled again from scratch
+            previous.close();
+            compiled = PatternBank::compile(bankFile, entries, cache, nullptr, library);
+        }
+        previous.close();
+
+        PatternBank bank;
+        if (!compiled || !bank.open(bankFile, library)) {
+            juce::ConsoleApplication::fail("Could not compile " + bankFile.getFullPathName());
+        }
+
+        juce::int64 numNotes = 0;
+        for (int i = 0; i < bank.getNumPatterns(); ++i) {
+            numNotes += bank.getPattern(i).getNumNotes();
+        }
+        printThroughput("Bank", bank.getNumPatterns(), "patterns", bankFile.getSize(), secondsSince(start));
+        std::cout << "  " << numNotes << " notes, " << (entries.size() - bank.getNumPatterns()) << " unreadable files" << std::endl;
+    }
+
+    // Not written out: the plugin builds it from the cached analyses in one pass
+    void checkSimilarityIndex(MidiAnalysisCache& cache, const juce::Array<MidiLibraryCatalog::Entry>& entries) {
+        const double buildStart = juce::Time::getMillisecondCounterHiRes();
+
+        juce::Array<MidiGrooveAnalysis> grooves;
+        grooves.ensureStorageAllocated(entries.size());
+        GrooveSimilarityIndex index;
+        index.reserve(entries.size());
+
+        for (const auto& entry : entries) {
+            const auto analysis = cache.getAnalysis(entry);
+            index.add(analysis);
+            grooves.add(analysis);
+        }
+        index.build();
+        printThroughput("Index", index.size(), "grooves", 0, secondsSince(buildStart));
+
+        const int numQueries = juce::jmin(index.size(), maxIndexQueries);
+        const double queryStart = juce::Time::getMillisecondCounterHiRes();
+        for (int i = 0; i < numQueries; ++i) {
+            index.findNearest(grooves.getReference(i), INIConfig::Defaults::DEFAULT_NUM_SUGGESTIONS, i);
+        }
+        printThroughput("Queries", numQueries, "queries", 0, secondsSince(queryStart));
+    }
+
+    // Kits that load with no playable region
+    juce::StringArray loadKits(const juce::File& kitsFolder) {
+        SFZEngine scanner;
+        scanner.setSFZFolder(kitsFolder);
+
+        KitBatch batch;
+        batch.kitsFolder = kitsFolder;
+        for (const auto& kit : scanner.getAvailableDrumkits()) {
+            for (const auto& sfzName : kit.sfzFiles) {
+                KitLoad load;
+                load.kitName = kit.name;
+                load.sfzName = sfzName;
+                load.bytes = juce::File(kit.folderPath).getChildFile(sfzName + ".sfz").getSize();
+                batch.loads.push_back(load);
+            }
+        }
+
+        const double start = juce::Time::getMillisecondCounterHiRes();
+        const int numLoads = static_cast<int>(batch.loads.size());
+        const int numThreads = juce::jlimit(1, INIConfig::MIDI::ANALYSIS_MAX_THREADS, juce::SystemStats::getNumCpus());
+        {
+            juce::ThreadPool pool(juce::ThreadPoolOptions{}
+                                      .withThreadName("OTTO Kit Load")
+                                      .withNumberOfThreads(numThreads));
+
+            std::vector<std::unique_ptr<KitLoadJob>> jobs;
+            for (int i = 0; i < juce::jmin(numThreads, numLoads); ++i) {
+                jobs.push_back(std::make_unique<KitLoadJob>(batch));
+                pool.addJob(jobs.back().get(), false);
+            }
+            for (const auto& job : jobs) {
+                pool.waitForJobToFinish(job.get(), -1);
+            }
+        }
+        const double seconds = secondsSince(start);
+
+        juce::StringArray failed;
+        juce::int64 bytes = 0;
+        for (const auto& load : batch.loads) {
+            const auto name = load.kitName + "/" + load.sfzName;
+            std::cout << "  " << name << ": " << load.numRegions << " regions" << std::endl;
+            bytes += load.bytes;
+            if (load.numRegions == 0) failed.add(name);
+        }
+        printThroughput("Kits", numLoads, "kits", bytes, seconds);
+        return failed;
+    }
+
+    //==========================================================================
+    // Benchmark
+    //==========================================================================
+
+    // Random grooves spread over the ranges real ones fall in
+    juce::Array<MidiGrooveAnalysis> makeBenchmarkGrooves(int numGrooves) {
+        juce::Random random(42);
+        juce::Array<MidiGrooveAnalysis> grooves;
+        grooves.ensureStorageAllocated(numGrooves);
+
+        for (int i = 0; i < numGrooves; ++i) {
+            MidiGrooveAnalysis groove;
+            groove.tempo = 60.0f + random.nextFloat() * 120.0f;
+            groove.averageSwing = 50.0f + random.nextFloat() * 25.0f;
+            groove.grooveTightness = random.nextFloat();
+            groove.averageVelocity = 40.0f + random.nextFloat() * 80.0f;
+            groove.noteDensity = random.nextFloat() * 8.0f;
+            for (int note = 0; note < 6; ++note) {
+                groove.noteDistribution.add(random.nextInt(32));
+            }
+            grooves.add(groove);
+        }
+        return grooves;
+    }
+
+    // Too slow for the plugin's own test run in a debug build, so checked here against an optimized one
+    void runBenchmark(const juce::ArgumentList&) {
+        const auto grooves = makeBenchmarkGrooves(benchmarkGrooves);
+
+        const double buildStart = juce::Time::getMillisecondCounterHiRes();
+        GrooveSimilarityIndex index;
+        index.reserve(grooves.size());
+        for (const auto& groove : grooves) {
+            index.add(groove);
+        }
+        index.build();
+        printThroughput("Index", index.size(), "grooves", 0, secondsSince(buildStart));
+
+        const double queryStart = juce::Time::getMillisecondCounterHiRes();
+        for (int q = 0; q < benchmarkQueries; ++q) {
+            const int queryIndex = (q * 997) % grooves.size();
+            index.findNearest(grooves.getReference(queryIndex), INIConfig::Defaults::DEFAULT_NUM_SUGGESTIONS, queryIndex);
+        }
+        const double seconds = secondsSince(queryStart);
+        printThroughput("Queries", benchmarkQueries, "queries", 0, seconds);
+
+        const double averageQueryMs = seconds * 1000.0 / benchmarkQueries;
+        std::cout << "  " << juce::String(averageQueryMs, 3) << " ms per query" << std::endl;
+
+        if (averageQueryMs >= maxBenchmarkQueryMs) {
+            juce::ConsoleApplication::fail("Similarity search over " + juce::String(benchmarkGrooves) + " grooves took "
+                                           + juce::String(averageQueryMs, 3) + " ms, over the "
+                                           + juce::String(maxBenchmarkQueryMs, 1) + " ms allowed");
+        }
+    }
+
+    //==========================================================================
+    // Command
+    //==========================================================================
+
+    void runBatch(const juce::ArgumentList& args) {
+        if (args.size() == 0 || args[0].isOption()) {
+            juce::ConsoleApplication::fail("Expected an assets folder; see --help");
+        }
+
+        const auto assets = args[0].resolveAsExistingFolder();
+        const auto library = assets.getChildFile(INIConfig::MIDI_LIBRARY_FOLDER);
+        const auto kits = assets.getChildFile(INIConfig::DRUMKITS_FOLDER);
+        const auto output = args.containsOption("--output") ? args.getFileForOption("--output")
+                                                            : assets.getChildFile(INIConfig::PREBUILT_CACHE_FOLDER);
+
+        const auto cacheFile = output.getChildFile(INIConfig::MIDI_ANALYSIS_BINARY_CACHE_FILE);
+        const auto bankFile = output.getChildFile(INIConfig::PATTERN_BANK_FILE);
+
+        if (args.containsOption("--rebuild")) {
+            cacheFile.deleteFile();
+            bankFile.deleteFile();
+        }
+
+        if (!library.isDirectory()) {
+            juce::ConsoleApplication::fail("No MIDI library at " + library.getFullPathName());
+        }
+
+        const double start = juce::Time::getMillisecondCounterHiRes();
+        {
+            MidiLibraryCatalog catalog;
+            const auto entries = scanLibrary(catalog, library);
+
+            // Paths inside the library are stored relative to it, so both match wherever it is installed
+            MidiAnalysisCache cache(cacheFile, library);
+            analyzeLibrary(cache, entries);
+            compileBank(bankFile, library, entries, cache);
+            checkSimilarityIndex(cache, entries);
+        }
+
+        juce::StringArray failedKits;
+        if (kits.isDirectory()) {
+            failedKits = loadKits(kits);
+        }
+
+        std::cout << "Done in " << juce::String(secondsSince(start), 2) << " s" << std::endl;
+        std::cout << "  " << cacheFile.getFullPathName() << " (" << juce::File::descriptionOfSizeInBytes(cacheFile.getSize()) << ")" << std::endl;
+        std::cout << "  " << bankFile.getFullPathName() << " (" << juce::File::descriptionOfSizeInBytes(bankFile.getSize()) << ")" << std::endl;
+
+        if (!failedKits.isEmpty()) {
+            juce::ConsoleApplication::fail("No playable regions in " + failedKits.joinIntoString(", "));
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ConsoleApplication app;
+    app.addHelpCommand("--help|-h", "OTTO Batch Analyzer", true);
+    app.addVersionCommand("--version|-v", "OTTO Batch Analyzer 1.0.0");
+
+    app.addCommand({
+        "--benchmark",
+        "--benchmark",
+        "Times similarity searches over a large generated groove library",
+        "Indexes " + juce::String(benchmarkGrooves) + " random grooves and fails unless a search for the closest "
+        "averages under " + juce::String(maxBenchmarkQueryMs, 1) + " ms. Run it on a release build.",
+        runBenchmark
+    });
+
+    app.addDefaultCommand({
+        "",
+        "<assets folder> [--output <folder>] [--rebuild]",
+        "Prebuilds the groove analysis cache and pattern bank for an assets folder and checks its drum kits",
+        "Reads " + INIConfig::MIDI_LIBRARY_FOLDER + " and " + INIConfig::DRUMKITS_FOLDER + " under the assets folder "
+        "and writes into its " + INIConfig::PREBUILT_CACHE_FOLDER + " folder unless --output says otherwise, "
+        "reusing whatever is still current there unless --rebuild is given.",
+        runBatch
+    });
+
+    return app.findAndRunCommand(argc, argv);
+}